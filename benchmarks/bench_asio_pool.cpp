@@ -0,0 +1,222 @@
+#include "common.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <boost/asio.hpp>
+#include <cc/asio/helper.h>
+#include <cc/asio/pool.h>
+#include <cc/latency_histogram.h>
+#include <cc/stopwatch.h>
+#include <fmt/format.h>
+
+namespace {
+
+using tcp = net::ip::tcp;
+
+constexpr int kThreadCounts[] = {1, 2, 4, 8, 16, 32};
+
+// 每个线程8条post链, 每条链在自己的executor上反复post自己
+constexpr int kChainsPerThread = 8;
+constexpr int kHops            = 20000;
+
+struct chain_t {
+    net::any_io_executor ex;
+    int left;
+    std::atomic<int>* chains;
+    cc::AsioPool* pool;
+
+    void operator()() {
+        if (--left > 0) {
+            net::post(ex, std::move(*this));
+        } else if (--*chains == 0) {
+            pool->shutdown();
+        }
+    }
+};
+
+/// 分片模式下线程不会自己退出, 两种模式都由最后一条链结束时shutdown
+void run_post(cc::AsioPool& pool, int threads) {
+    std::atomic<int> chains{threads * kChainsPerThread};
+    for (int i = 0; i < threads * kChainsPerThread; i++) {
+        auto& ctx = pool.get_io_context();
+        net::post(ctx, chain_t{ctx.get_executor(), kHops, &chains, &pool});
+    }
+    pool.run(threads);
+}
+
+// 回环上的HTTP/1.1 keep-alive请求-响应: 每个线程8个连接, 每个连接串行发kRequests个请求
+constexpr int kConnsPerThread         = 8;
+constexpr int kRequests               = 200;
+constexpr std::string_view kRequest   = "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n";
+constexpr std::string_view kResponse  = "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok";
+
+net::awaitable<void> serve(tcp::socket sock) {
+    std::string buf;
+    try {
+        for (;;) {
+            auto n = co_await net::async_read_until(sock, net::dynamic_buffer(buf), "\r\n\r\n",
+                                                    net::use_awaitable);
+            buf.erase(0, n);
+            co_await net::async_write(sock, net::buffer(kResponse), net::use_awaitable);
+        }
+    } catch (const std::exception&) {
+    }
+}
+
+net::awaitable<void> listen(cc::AsioPool& pool, tcp::acceptor& acceptor, int conns) {
+    for (int i = 0; i < conns; i++) {
+        // 共用模式下所有连接都在同一个io_context, 分片模式下按placement分到各分片
+        auto& ctx = pool.next_io_context();
+        auto sock = co_await acceptor.async_accept(ctx, net::use_awaitable);
+        net::co_spawn(ctx, serve(std::move(sock)), net::detached);
+    }
+}
+
+net::awaitable<void> client(cc::AsioPool& pool, tcp::endpoint ep, std::atomic<int>& conns) {
+    tcp::socket sock(co_await net::this_coro::executor);
+    co_await sock.async_connect(ep, net::use_awaitable);
+    std::string buf;
+    for (int i = 0; i < kRequests; i++) {
+        co_await net::async_write(sock, net::buffer(kRequest), net::use_awaitable);
+        auto n = co_await net::async_read_until(sock, net::dynamic_buffer(buf), "ok",
+                                                net::use_awaitable);
+        buf.erase(0, n);
+    }
+    sock.close();
+    if (--conns == 0) {
+        pool.shutdown();
+    }
+}
+
+void run_http(cc::AsioPool& pool, int threads) {
+    auto conns = threads * kConnsPerThread;
+    tcp::acceptor acceptor(pool.get_io_context(0), {net::ip::address_v4::loopback(), 0});
+    auto ep = acceptor.local_endpoint();
+    std::atomic<int> left{conns};
+    net::co_spawn(acceptor.get_executor(), listen(pool, acceptor, conns), net::detached);
+    for (int i = 0; i < conns; i++) {
+        net::co_spawn(pool.next_io_context(), client(pool, ep, left), net::detached);
+    }
+    pool.run(threads);
+}
+
+// 处理器延迟: 池外线程向各分片post带时间戳的处理器, 记录从post到开始执行的时间.
+// 同时有同样多的不绑核的忙循环线程争抢CPU, 未绑核的分片线程会被迁移
+constexpr int kLatencyShards  = 4;
+constexpr int kLatencySamples = 20000;
+
+cc::LatencyHistogram::snapshot_t run_latency(cc::affinity_e mode) {
+    cc::AsioPool pool(cc::sharded, kLatencyShards);
+    pool.set_affinity({mode});
+    cc::LatencyHistogram hist;
+
+    std::atomic<bool> done{false};
+    std::vector<std::thread> noise;
+    for (int i = 0; i < kLatencyShards; i++) {
+        noise.emplace_back([&] {
+            std::uint64_t x = 0;
+            while (!done.load(std::memory_order_relaxed)) {
+                bench::doNotOptimizeAway(x = x * 6364136223846793005ULL + 1);
+            }
+        });
+    }
+
+    std::thread producer([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        for (int i = 0; i < kLatencySamples; i++) {
+            auto t0 = cc::SteadyClock::now();
+            net::post(pool.get_io_context(i % kLatencyShards),
+                      [&hist, t0] { hist.record(cc::SteadyClock::now() - t0); });
+            if (i % 64 == 63) {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+        }
+        // 各分片按FIFO执行, 最后一个收尾处理器执行时样本都已记录
+        auto left = std::make_shared<std::atomic<int>>(kLatencyShards);
+        for (int i = 0; i < kLatencyShards; i++) {
+            net::post(pool.get_io_context(i), [&pool, left] {
+                if (--*left == 0) {
+                    pool.shutdown();
+                }
+            });
+        }
+    });
+    pool.run();
+
+    producer.join();
+    done = true;
+    for (auto& th : noise) {
+        th.join();
+    }
+    return hist.snapshot();
+}
+
+}  // namespace
+
+static void bench_asio_pool(bench::Bench& b) {
+    b.epochs(1).epochIterations(1);
+
+    b.title("AsioPool: post throughput, 8 chains per thread");
+    for (int n : kThreadCounts) {
+        b.batch(n * kChainsPerThread * kHops).unit("post");
+        b.run(fmt::format("shared io_context     {:>2} threads", n), [&] {
+            cc::AsioPool pool;
+            run_post(pool, n);
+        });
+        b.run(fmt::format("sharded round-robin   {:>2} threads", n), [&] {
+            cc::AsioPool pool(cc::sharded, n);
+            run_post(pool, n);
+        });
+    }
+
+    // 监测的开销: 每个处理器两次读时钟和一次直方图记录
+    b.title("AsioPool: post throughput with loop monitor, 4 threads");
+    b.batch(4 * kChainsPerThread * kHops).unit("post");
+    b.run("sharded round-robin            ", [&] {
+        cc::AsioPool pool(cc::sharded, 4);
+        run_post(pool, 4);
+    });
+    b.run("sharded round-robin + monitor  ", [&] {
+        cc::AsioPool pool(cc::sharded, 4);
+        pool.enable_monitor({.lag_interval_ms = 10, .slow_handler_ms = 100});
+        run_post(pool, 4);
+    });
+
+    b.title("AsioPool: loopback HTTP/1.1 keep-alive, 8 connections per thread");
+    for (int n : kThreadCounts) {
+        b.batch(n * kConnsPerThread * kRequests).unit("request");
+        b.run(fmt::format("shared io_context     {:>2} threads", n), [&] {
+            cc::AsioPool pool;
+            run_http(pool, n);
+        });
+        b.run(fmt::format("sharded round-robin   {:>2} threads", n), [&] {
+            cc::AsioPool pool(cc::sharded, n);
+            run_http(pool, n);
+        });
+        b.run(fmt::format("sharded least-loaded  {:>2} threads", n), [&] {
+            cc::AsioPool pool(cc::sharded, n, cc::placement_e::LEAST_LOADED);
+            run_http(pool, n);
+        });
+    }
+
+    b.title(fmt::format("AsioPool: post-to-run latency, {} shards + {} busy threads",
+                        kLatencyShards, kLatencyShards));
+    b.batch(kLatencySamples).unit("handler");
+    for (auto [name, mode] : {std::pair{"affinity NONE     ", cc::affinity_e::NONE},
+                              std::pair{"affinity CPU      ", cc::affinity_e::CPU},
+                              std::pair{"affinity NUMA_NODE", cc::affinity_e::NUMA_NODE}}) {
+        cc::LatencyHistogram::snapshot_t snap;
+        b.run(name, [&] { snap = run_latency(mode); });
+        fmt::print("  p50 {:.1f}us, p99 {:.1f}us, max {:.1f}us\n", snap.percentile(50) / 1e3,
+                   snap.percentile(99) / 1e3, snap.max / 1e3);
+    }
+
+    b.batch(1).unit("op");
+    b.epochs(11).epochIterations(0);
+}
+
+BENCHMARK_REGISTE(bench_asio_pool);
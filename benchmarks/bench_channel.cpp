@@ -0,0 +1,447 @@
+#include "common.h"
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/asio.hpp>
+#include <cc/asio/broadcast.h>
+#include <cc/asio/channel.h>
+#include <cc/asio/condvar.h>
+#include <cc/asio/select.h>
+#include <cc/signal.h>
+#include <fmt/format.h>
+
+#ifdef __GLIBC__
+#    include <malloc.h>
+#endif
+
+namespace {
+
+struct sample_t {
+    char data[256];
+};
+
+inline void spin(int n) {
+    for (int i = 0; i < n; i++) {
+        bench::doNotOptimizeAway(i);
+    }
+}
+
+// 生产者和消费者各一个线程, 消费者每个元素的处理耗时是生产者的10倍
+constexpr int kItems       = 100000;
+constexpr int kProduceWork = 20;
+constexpr int kConsumeWork = 10 * kProduceWork;
+
+/// @return 消费者一次取到的最大元素数, 即通道内的峰值积压
+std::size_t run_mpsc() {
+    net::io_context pi, ci;
+    std::size_t peak = 0;
+    do {
+        auto [tx, rx] = cc::chan::mpsc::make<sample_t>();
+        net::co_spawn(
+            pi,
+            [tx = tx]() mutable -> net::awaitable<void> {
+                for (int i = 0; i < kItems; i++) {
+                    spin(kProduceWork);
+                    (*tx)(sample_t{});
+                }
+                co_return;
+            },
+            net::detached);
+        net::co_spawn(
+            ci,
+            [rx = std::move(rx), &peak]() mutable -> net::awaitable<void> {
+                for (;;) {
+                    auto items = co_await (*rx)();
+                    if (items.empty()) {
+                        break;
+                    }
+                    peak = std::max(peak, items.size());
+                    spin(kConsumeWork * static_cast<int>(items.size()));
+                }
+            },
+            net::detached);
+    } while (0);
+
+    std::thread t([&] { ci.run(); });
+    pi.run();
+    t.join();
+    return peak;
+}
+
+std::size_t run_bounded(std::size_t capacity, cc::chan::overflow_e policy) {
+    net::io_context pi, ci;
+    std::size_t peak = 0;
+    do {
+        auto [tx, rx] = cc::chan::bounded::make<sample_t>(capacity, policy);
+        net::co_spawn(
+            pi,
+            [tx = tx]() mutable -> net::awaitable<void> {
+                for (int i = 0; i < kItems; i++) {
+                    spin(kProduceWork);
+                    co_await tx.send(sample_t{});
+                }
+            },
+            net::detached);
+        net::co_spawn(
+            ci,
+            [rx = std::move(rx), &peak]() mutable -> net::awaitable<void> {
+                std::vector<sample_t> items;
+                items.reserve(rx.capacity());
+                while (co_await rx.recv_many(items)) {
+                    peak = std::max(peak, items.size());
+                    spin(kConsumeWork * static_cast<int>(items.size()));
+                    items.clear();
+                }
+            },
+            net::detached);
+    } while (0);
+
+    std::thread t([&] { ci.run(); });
+    pi.run();
+    t.join();
+    return peak;
+}
+
+// 对比: 原mpsc实现, send加锁入队后notify_all
+struct MutexMpsc {
+    std::mutex mtx_;
+    cc::CondVar<std::mutex> cv_;
+    std::deque<int> queue_;
+    bool stopped_ = false;
+
+    void send(int v) {
+        do {
+            std::lock_guard<std::mutex> _lck{mtx_};
+            queue_.emplace_back(v);
+        } while (0);
+        cv_.notify_all();
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> _lck{mtx_};
+        stopped_ = true;
+        cv_.notify_all();
+    }
+
+    net::awaitable<std::deque<int>> recv() {
+        std::deque<int> ret;
+        do {
+            std::lock_guard<std::mutex> _lck{mtx_};
+            if (!stopped_) {
+                if (queue_.size()) {
+                    ret = std::move(queue_);
+                    co_return ret;
+                }
+            } else {
+                co_return ret;
+            }
+        } while (0);
+
+        co_await cv_.wait();
+        std::lock_guard<std::mutex> _lck{mtx_};
+        ret = std::move(queue_);
+        co_return ret;
+    }
+};
+
+constexpr int kSends = 200000;
+
+/// n个线程各send kSends次, 一个消费者线程取空
+template <typename Send, typename Close, typename Recv>
+void run_producers(int n, Send&& send, Close&& close, Recv&& recv) {
+    net::io_context ci;
+    std::size_t total = 0;
+    net::co_spawn(
+        ci,
+        [&]() -> net::awaitable<void> {
+            for (;;) {
+                auto items = co_await recv();
+                if (items.empty()) {
+                    break;
+                }
+                total += items.size();
+            }
+        },
+        net::detached);
+    std::thread consumer([&] { ci.run(); });
+
+    std::vector<std::thread> producers;
+    for (int t = 0; t < n; t++) {
+        producers.emplace_back([&] {
+            for (int i = 0; i < kSends; i++) {
+                send(i);
+            }
+        });
+    }
+    for (auto& t : producers) {
+        t.join();
+    }
+
+    // 在消费者线程上关闭: 原实现解锁后才登记等待, 从其他线程close可能丢失唤醒
+    net::post(ci, std::forward<Close>(close));
+    consumer.join();
+    bench::doNotOptimizeAway(total);
+}
+
+/// n个线程上各跑一个消费者协程, 每个任务CPU计算kJobWork次
+constexpr int kJobs    = 20000;
+constexpr int kJobWork = 2000;
+
+void run_consumer_pool(int n) {
+    net::io_context ioc;
+    do {
+        auto [tx, rx] = cc::chan::mpmc::make<int>();
+        for (int c = 0; c < n; c++) {
+            net::co_spawn(
+                ioc,
+                [rx = rx]() mutable -> net::awaitable<void> {
+                    for (;;) {
+                        auto jobs = co_await rx.recv(16);
+                        if (jobs.empty()) {
+                            break;
+                        }
+                        spin(kJobWork * static_cast<int>(jobs.size()));
+                    }
+                },
+                net::detached);
+        }
+        for (int i = 0; i < kJobs; i++) {
+            tx.send(i);
+        }
+    } while (0);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < n; t++) {
+        threads.emplace_back([&] { ioc.run(); });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+}
+
+/// 堆上已分配的字节数
+inline std::size_t heap_in_use() {
+#ifdef __GLIBC__
+    return mallinfo2().uordblks;
+#else
+    return 0;
+#endif
+}
+
+// 1万个订阅者, 每条消息256字节; 先全部发布再让订阅者读取,
+// 测量从订阅前到发布完成时的堆增量(订阅者本身 + 积压的消息)
+constexpr int kSubscribers = 10000;
+constexpr int kMessages    = 100;
+
+/// @return 发布完kMessages条消息后的堆增量
+std::size_t run_signal_stream() {
+    auto before = heap_in_use();
+    net::io_context ioc;
+    cc::ConcurrentSignal sig;
+    for (int i = 0; i < kSubscribers; i++) {
+        auto [id, rx] = sig.stream<std::string>("tick");
+        net::co_spawn(
+            ioc,
+            [rx = std::move(rx)]() mutable -> net::awaitable<void> {
+                for (;;) {
+                    auto items = co_await (*rx)();
+                    if (items.empty()) {
+                        break;
+                    }
+                    bench::doNotOptimizeAway(items);
+                }
+            },
+            net::detached);
+    }
+    ioc.poll();
+
+    std::string msg(256, 'x');
+    for (int i = 0; i < kMessages; i++) {
+        sig.pub("tick", msg);
+    }
+    auto delta = heap_in_use() - before;
+    ioc.poll();
+    sig.unsub("tick");
+    ioc.run();
+    return delta;
+}
+
+std::size_t run_broadcast() {
+    auto before = heap_in_use();
+    net::io_context ioc;
+    std::size_t delta = 0;
+    do {
+        auto [tx, rx0] = cc::chan::broadcast::make<std::string>(kMessages);
+        for (int i = 0; i < kSubscribers; i++) {
+            net::co_spawn(
+                ioc,
+                [rx = tx.subscribe()]() mutable -> net::awaitable<void> {
+                    while (auto v = co_await rx.recv()) {
+                        bench::doNotOptimizeAway(*v);
+                    }
+                },
+                net::detached);
+        }
+        ioc.poll();
+
+        std::string msg(256, 'x');
+        for (int i = 0; i < kMessages; i++) {
+            tx.send(msg);
+        }
+        delta = heap_in_use() - before;
+        ioc.poll();
+    } while (0);
+    ioc.run();
+    return delta;
+}
+
+// 4个通道轮流各发一条, 每条之后让出一次; 消费者每轮等待4个通道之一或1秒超时
+constexpr int kSelectItems   = 100000;
+constexpr int kSelectTimeout = 1000;
+
+using select_rx_t = cc::chan::bounded::Receiver<int>;
+using select_tx_t = cc::chan::bounded::Sender<int>;
+
+template <typename Notify>
+net::awaitable<void> select_producer(std::vector<select_tx_t> txs, Notify notify) {
+    auto ex = co_await net::this_coro::executor;
+    for (int i = 0; i < kSelectItems; i++) {
+        txs[i % txs.size()].try_send(i);
+        notify();
+        co_await net::post(ex, net::use_awaitable);
+    }
+}
+
+/// Select<4>复用一个定时器和4个钩子, 返回后只从触发的通道取
+void run_select() {
+    net::io_context ioc;
+    std::vector<select_tx_t> txs;
+    std::vector<select_rx_t> rxs;
+    for (int i = 0; i < 4; i++) {
+        auto [tx, rx] = cc::chan::bounded::make<int>(16);
+        txs.emplace_back(std::move(tx));
+        rxs.emplace_back(std::move(rx));
+    }
+    net::co_spawn(ioc, select_producer(std::move(txs), [] {}), net::detached);
+    net::co_spawn(
+        ioc,
+        [&]() -> net::awaitable<void> {
+            cc::chan::Select<4> sel;
+            for (int n = 0; n < kSelectItems;) {
+                auto i = co_await sel.wait_for(kSelectTimeout, rxs[0], rxs[1], rxs[2], rxs[3]);
+                if (i < 4 && rxs[i].try_recv()) {
+                    n++;
+                }
+            }
+            ioc.stop();
+        },
+        net::detached);
+    ioc.run();
+}
+
+/// 对比: 通道之外再用CondVar通知, 每轮 async_sleep(timeout) || wait()
+void run_select_operators() {
+    net::io_context ioc;
+    cc::CondVar<> cv;
+    std::vector<select_tx_t> txs;
+    std::vector<select_rx_t> rxs;
+    for (int i = 0; i < 4; i++) {
+        auto [tx, rx] = cc::chan::bounded::make<int>(16);
+        txs.emplace_back(std::move(tx));
+        rxs.emplace_back(std::move(rx));
+    }
+    net::co_spawn(ioc, select_producer(std::move(txs), [&] { cv.notify_all(); }), net::detached);
+    net::co_spawn(
+        ioc,
+        [&]() -> net::awaitable<void> {
+            for (int n = 0; n < kSelectItems;) {
+                bool got = false;
+                for (auto& rx : rxs) {
+                    if (rx.try_recv()) {
+                        n++;
+                        got = true;
+                    }
+                }
+                if (!got) {
+                    co_await cv.wait_until(kSelectTimeout);
+                }
+            }
+            ioc.stop();
+        },
+        net::detached);
+    ioc.run();
+}
+
+}  // namespace
+
+static void bench_channel(bench::Bench& b) {
+    using cc::chan::overflow_e;
+
+    b.title("channel: 1 producer, consumer 10x slower");
+    b.epochs(1).epochIterations(1).batch(kItems).unit("item");
+
+    std::vector<std::pair<std::string, std::size_t>> peaks;
+    auto run = [&](const std::string& name, auto&& fn) {
+        std::size_t peak = 0;
+        b.run(name, [&] { peak = fn(); });
+        peaks.emplace_back(name, peak);
+    };
+    run("mpsc (unbounded)", [] { return run_mpsc(); });
+    run("bounded(1024) BLOCK", [] { return run_bounded(1024, overflow_e::BLOCK); });
+    run("bounded(1024) DROP_OLDEST", [] { return run_bounded(1024, overflow_e::DROP_OLDEST); });
+    run("bounded(1024) DROP_NEWEST", [] { return run_bounded(1024, overflow_e::DROP_NEWEST); });
+
+    for (auto& [name, peak] : peaks) {
+        fmt::print("  {:<28} peak backlog {:>7} items, {:>8} KB\n", name, peak,
+                   peak * sizeof(sample_t) / 1024);
+    }
+
+    b.title("channel: send throughput, n producers");
+    for (int n : {1, 2, 4, 8, 16, 32}) {
+        b.batch(n * kSends).unit("send");
+        b.run("mutex + deque + CondVar " + std::to_string(n) + " producers", [&] {
+            MutexMpsc ch;
+            run_producers(
+                n, [&](int v) { ch.send(v); }, [&] { ch.close(); }, [&] { return ch.recv(); });
+        });
+        b.run("mpsc (lock-free) " + std::to_string(n) + " producers", [&] {
+            auto [tx, rx] = cc::chan::mpsc::make<int>();
+            run_producers(
+                n, [&](int v) { (*tx)(v); }, [&] { tx.reset(); }, [&] { return (*rx)(); });
+        });
+    }
+
+    // 理想情况下耗时随消费者线程数线性下降. 线程数超过CPU核数时测不出扩展性, 跳过
+    b.title("channel: mpmc consumer pool, CPU-bound jobs");
+    b.batch(kJobs).unit("job");
+    const int cores = static_cast<int>(std::thread::hardware_concurrency());
+    for (int n : {1, 2, 4, 8}) {
+        if (n > 1 && n > cores) {
+            continue;
+        }
+        b.run("mpmc " + std::to_string(n) + " consumers", [&] { run_consumer_pool(n); });
+    }
+
+    // 每条消息的发布+投递耗时, 以及发布完成、订阅者尚未读取时的内存积压
+    b.title("channel: fan-out to 10k subscribers");
+    b.batch(kMessages).unit("msg");
+    std::size_t stream_bytes = 0, broadcast_bytes = 0;
+    b.run("Signal::stream (mpsc per subscriber)", [&] { stream_bytes = run_signal_stream(); });
+    b.run("broadcast", [&] { broadcast_bytes = run_broadcast(); });
+    fmt::print("  heap after {} msgs: Signal::stream {} KB, broadcast {} KB\n", kMessages,
+               stream_bytes / 1024, broadcast_bytes / 1024);
+
+    // 单线程, 每条消息一次等待+唤醒
+    b.title("channel: 4-way select with timeout");
+    b.batch(kSelectItems).unit("msg");
+    b.run("async_sleep || CondVar::wait", [] { run_select_operators(); });
+    b.run("Select<4>::wait_for", [] { run_select(); });
+    b.batch(1).unit("op");
+    b.epochs(11).epochIterations(0);
+}
+
+BENCHMARK_REGISTE(bench_channel);
@@ -0,0 +1,121 @@
+#include "common.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <thread>
+#include <vector>
+#include <boost/asio.hpp>
+#include <cc/asio/compute_pool.h>
+#include <cc/asio/helper.h>
+
+namespace {
+
+constexpr int kWorkers = 4;
+
+// 小任务: kCallers个协程在一个io_context上, 各串行提交kTasks个计算任务
+constexpr int kCallers = 64;
+constexpr int kTasks   = 1000;
+
+std::uint64_t small_work(std::uint64_t seed) {
+    std::uint64_t x = seed;
+    for (int i = 0; i < 256; i++) {
+        x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+    }
+    return x;
+}
+
+/// kWorkers个线程运行的普通io_context, 即schedule(ioc, f)的做法
+struct worker_ioc_t {
+    net::io_context ctx;
+    net::executor_work_guard<net::io_context::executor_type> guard{ctx.get_executor()};
+    std::vector<std::thread> threads;
+
+    worker_ioc_t() {
+        for (int i = 0; i < kWorkers; i++) {
+            threads.emplace_back([this] { ctx.run(); });
+        }
+    }
+
+    ~worker_ioc_t() {
+        guard.reset();
+        for (auto& th : threads) {
+            th.join();
+        }
+    }
+};
+
+/// @param submit 以协程帧里的seed调用, schedule按引用保存参数
+template <typename Submit>
+void run_small_tasks(Submit&& submit) {
+    net::io_context ioc;
+    for (int c = 0; c < kCallers; c++) {
+        net::co_spawn(
+            ioc,
+            [&, c]() -> net::awaitable<void> {
+                for (int i = 0; i < kTasks; i++) {
+                    std::uint64_t seed = c * kTasks + i;
+                    bench::doNotOptimizeAway(co_await submit(seed));
+                }
+            },
+            net::detached);
+    }
+    ioc.run();
+}
+
+// fork-join: 深度kDepth的二叉树, 每个节点拆成两个子任务, 一个提交给池, 一个自己接着做
+constexpr int kDepth = 16;
+
+template <typename Post>
+void run_fork_join(Post&& post) {
+    std::atomic<int> left{1};
+    std::promise<void> done;
+    std::function<void(int)> split = [&](int d) {
+        while (d > 0) {
+            left.fetch_add(1, std::memory_order_relaxed);
+            post([&split, d] { split(d - 1); });
+            d--;
+        }
+        bench::doNotOptimizeAway(small_work(d));
+        if (left.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            done.set_value();
+        }
+    };
+    post([&split] { split(kDepth); });
+    done.get_future().wait();
+}
+
+}  // namespace
+
+static void bench_compute_pool(bench::Bench& b) {
+    b.epochs(1).epochIterations(1);
+
+    b.title("offload: 64 coroutines x 1000 small tasks, 4 worker threads");
+    b.batch(kCallers * kTasks).unit("task");
+    b.run("schedule(io_context)", [&] {
+        worker_ioc_t worker;
+        run_small_tasks([&](std::uint64_t& seed) {
+            return cc::schedule(worker.ctx, small_work, seed);
+        });
+    });
+    b.run("offload(ComputePool)", [&] {
+        cc::ComputePool pool(kWorkers);
+        run_small_tasks([&](std::uint64_t& seed) { return cc::offload(pool, small_work, seed); });
+    });
+
+    b.title("fork-join: binary tree of depth 16, 4 worker threads");
+    b.batch(1 << kDepth).unit("leaf");
+    b.run("net::post(io_context)", [&] {
+        worker_ioc_t worker;
+        run_fork_join([&](auto f) { net::post(worker.ctx, std::move(f)); });
+    });
+    b.run("ComputePool::post", [&] {
+        cc::ComputePool pool(kWorkers);
+        run_fork_join([&](auto f) { pool.post(std::move(f)); });
+    });
+
+    b.batch(1).unit("op");
+    b.epochs(11).epochIterations(0);
+}
+
+BENCHMARK_REGISTE(bench_compute_pool);
@@ -0,0 +1,322 @@
+#include "common.h"
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+#include <boost/asio.hpp>
+#include <cc/asio/condvar.h>
+#include <cc/asio/pool.h>
+#include <cc/asio/semaphore.h>
+#include <cc/latency_histogram.h>
+#include <cc/stopwatch.h>
+#include <fmt/format.h>
+
+// 统计本线程的operator new次数. 替换的是整个benchmark程序的全局operator new,
+// 对其他用例只多一次thread_local自增
+namespace {
+thread_local std::size_t allocs_ = 0;
+}
+
+void* operator new(std::size_t n) {
+    allocs_++;
+    if (auto* p = std::malloc(n ? n : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+
+// 对比: 原实现, 每次等待一个shared_ptr<steady_timer>, 唤醒时cancel定时器
+class LegacyCondVar : boost::noncopyable {
+    std::vector<std::function<void()>> handles_;
+
+public:
+    net::task<void> wait() {
+        using time_point                         = net::steady_timer::clock_type::time_point;
+        auto ctx                                 = co_await net::this_coro::executor;
+        std::shared_ptr<net::steady_timer> timer = std::make_shared<net::steady_timer>(ctx);
+        timer->expires_at(time_point::max());
+        std::weak_ptr<net::steady_timer> weak_timer(timer);
+        handles_.emplace_back([weak_timer] {
+            if (auto timer = weak_timer.lock()) {
+                timer->cancel();
+            }
+        });
+        co_await timer->async_wait(net::as_tuple(net::use_awaitable));
+    }
+
+    void notify_one() noexcept {
+        if (!handles_.empty()) {
+            auto f = std::move(handles_.front());
+            handles_.erase(handles_.begin());
+            f();
+        }
+    }
+};
+
+class LegacySemaphore : boost::noncopyable {
+    std::size_t permits_;
+    std::list<std::function<void()>> handles_;
+
+public:
+    explicit LegacySemaphore(std::size_t permits) : permits_(permits) {}
+
+    net::awaitable<void> acquire() {
+        if (permits_ > 0) {
+            permits_--;
+            co_return;
+        }
+        using time_point = net::steady_timer::clock_type::time_point;
+        std::shared_ptr<net::steady_timer> timer =
+            std::make_shared<net::steady_timer>(co_await net::this_coro::executor);
+        timer->expires_at(time_point::max());
+        std::weak_ptr<net::steady_timer> weak_timer(timer);
+        handles_.emplace_back([weak_timer] {
+            if (auto timer = weak_timer.lock()) {
+                timer->cancel();
+            }
+        });
+        co_await timer->async_wait(net::as_tuple(net::use_awaitable));
+    }
+
+    void release() {
+        permits_++;
+        if (permits_ > 0 && !handles_.empty()) {
+            permits_--;
+            auto f = handles_.front();
+            handles_.pop_front();
+            f();
+        }
+    }
+};
+
+constexpr int kRounds = 100000;
+
+/// 两个协程在同一线程上轮流wait/notify, 每轮两次等待
+/// @return 每次等待的operator new次数
+template <typename CV>
+double run_condvar_pingpong() {
+    net::io_context ioc;
+    CV ping, pong;
+    net::co_spawn(
+        ioc,
+        [&]() -> net::awaitable<void> {
+            for (int i = 0; i < kRounds; i++) {
+                co_await ping.wait();
+                pong.notify_one();
+            }
+        },
+        net::detached);
+    net::co_spawn(
+        ioc,
+        [&]() -> net::awaitable<void> {
+            for (int i = 0; i < kRounds; i++) {
+                ping.notify_one();
+                co_await pong.wait();
+            }
+        },
+        net::detached);
+    ioc.poll_one();  // 预热: 两个协程各自走到第一次等待
+
+    auto before = allocs_;
+    ioc.run();
+    return static_cast<double>(allocs_ - before) / (2.0 * kRounds);
+}
+
+/// 两个初始为0的信号量互相release/acquire
+template <typename Sem>
+double run_semaphore_pingpong() {
+    net::io_context ioc;
+    Sem ping(0), pong(0);
+    net::co_spawn(
+        ioc,
+        [&]() -> net::awaitable<void> {
+            for (int i = 0; i < kRounds; i++) {
+                co_await ping.acquire();
+                pong.release();
+            }
+        },
+        net::detached);
+    net::co_spawn(
+        ioc,
+        [&]() -> net::awaitable<void> {
+            for (int i = 0; i < kRounds; i++) {
+                ping.release();
+                co_await pong.acquire();
+            }
+        },
+        net::detached);
+    ioc.poll_one();
+
+    auto before = allocs_;
+    ioc.run();
+    return static_cast<double>(allocs_ - before) / (2.0 * kRounds);
+}
+
+// kWaiters个协程反复等待同一个CondVar, 每次notify_one之后让出一次
+constexpr int kWaiters    = 1000;
+constexpr int kNotifies   = 100000;
+constexpr int kPriorities = 4;
+
+struct starvation_t {
+    cc::LatencyHistogram wait_ns;  // 每次从开始等待到被唤醒
+    int never_woken = 0;
+};
+
+void run_starvation(cc::wake_e policy, starvation_t& r) {
+    net::io_context ioc;
+    cc::CondVar<> cv(policy);
+    std::vector<int> wakes(kWaiters);
+    bool stop = false;
+    for (int i = 0; i < kWaiters; i++) {
+        net::co_spawn(
+            ioc,
+            [&, i]() -> net::awaitable<void> {
+                while (!stop) {
+                    cc::StopWatch sw;
+                    co_await cv.wait(i % kPriorities);
+                    if (!stop) {
+                        r.wait_ns.record(sw.elapsed_ns());
+                        wakes[i]++;
+                    }
+                }
+            },
+            net::detached);
+    }
+    net::co_spawn(
+        ioc,
+        [&]() -> net::awaitable<void> {
+            auto ex = co_await net::this_coro::executor;
+            for (int i = 0; i < kNotifies; i++) {
+                cv.notify_one();
+                co_await net::post(ex, net::use_awaitable);
+            }
+            stop = true;
+            cv.notify_all();
+        },
+        net::detached);
+    ioc.run();
+    r.never_woken = static_cast<int>(std::count(wakes.begin(), wakes.end(), 0));
+}
+
+// kWorkers个协程分布在kPoolThreads个AsioPool线程上争抢kPermits个许可
+constexpr int kPoolThreads = 4;
+constexpr int kWorkers     = 64;
+constexpr int kAcquires    = 2000;
+constexpr int kPermits     = 4;
+
+/// @param weight 第i个协程每次取(i % weight + 1)个许可
+template <typename Fn>
+void run_semaphore_contention(std::size_t weight, Fn&& body) {
+    cc::AsioPool pool;
+    cc::Semaphore<std::mutex> sem(kPermits);
+    for (int i = 0; i < kWorkers; i++) {
+        std::size_t n = i % weight + 1;
+        net::co_spawn(
+            pool.get_io_context(),
+            [&, n]() -> net::awaitable<void> {
+                auto ex = co_await net::this_coro::executor;
+                for (int k = 0; k < kAcquires; k++) {
+                    co_await body(sem, n);
+                    co_await net::post(ex, net::use_awaitable);
+                }
+            },
+            net::detached);
+    }
+    pool.run(kPoolThreads);
+}
+
+}  // namespace
+
+static void bench_condvar(bench::Bench& b) {
+    std::vector<std::pair<std::string, double>> allocs;
+    auto run = [&](const std::string& name, auto&& fn) {
+        double n = 0;
+        b.run(name, [&] { n = fn(); });
+        allocs.emplace_back(name, n);
+    };
+
+    b.title("asio waiters: ping-pong wait/notify");
+    b.epochs(1).epochIterations(1).batch(2 * kRounds).unit("wait");
+    run("CondVar (shared_ptr<steady_timer>)", [] {
+        return run_condvar_pingpong<LegacyCondVar>();
+    });
+    run("CondVar<NonMutex>", [] { return run_condvar_pingpong<cc::CondVar<>>(); });
+    run("CondVar<std::mutex>", [] { return run_condvar_pingpong<cc::CondVar<std::mutex>>(); });
+    run("Semaphore (shared_ptr<steady_timer>)", [] {
+        return run_semaphore_pingpong<LegacySemaphore>();
+    });
+    run("Semaphore<NonMutex>", [] { return run_semaphore_pingpong<cc::Semaphore<>>(); });
+    run("Semaphore<std::mutex>", [] {
+        return run_semaphore_pingpong<cc::Semaphore<std::mutex>>();
+    });
+
+    for (auto& [name, n] : allocs) {
+        fmt::print("  {:<40} {:>5.2f} allocs/wait\n", name, n);
+    }
+
+    // 释放时在锁外恢复等待者, 被唤醒的线程不会立刻撞上还没放开的锁
+    b.title("asio Semaphore: 64 coroutines on 4 AsioPool threads, 4 permits");
+    b.batch(kWorkers * kAcquires).unit("acquire");
+    b.run("acquire/release", [] {
+        run_semaphore_contention(1, [](auto& sem, std::size_t) -> net::awaitable<void> {
+            co_await sem.acquire();
+            sem.release();
+        });
+    });
+    b.run("guard (RAII)", [] {
+        run_semaphore_contention(1, [](auto& sem, std::size_t) -> net::awaitable<void> {
+            auto permit = co_await sem.guard();
+        });
+    });
+    b.run("guard, weighted 1..3", [] {
+        run_semaphore_contention(3, [](auto& sem, std::size_t n) -> net::awaitable<void> {
+            auto permit = co_await sem.guard(n);
+        });
+    });
+    b.run("try_acquire, else guard_for(10ms)", [] {
+        run_semaphore_contention(1, [](auto& sem, std::size_t) -> net::awaitable<void> {
+            if (sem.try_acquire()) {
+                sem.release();
+                co_return;
+            }
+            auto permit = co_await sem.guard_for(10);
+        });
+    });
+
+    // 等待者远多于唤醒速度时各策略的公平性: FIFO下每个等待者的延迟相同, LIFO和
+    // PRIORITY(优先级按i%4)下有等待者一直得不到唤醒
+    b.title("asio waiters: 1000 waiters, notify_one");
+    b.batch(kNotifies).unit("notify");
+    std::vector<std::pair<std::string, std::unique_ptr<starvation_t>>> results;
+    for (auto [name, policy] : {std::make_pair("FIFO", cc::wake_e::FIFO),
+                                std::make_pair("LIFO", cc::wake_e::LIFO),
+                                std::make_pair("PRIORITY", cc::wake_e::PRIORITY)}) {
+        auto r = std::make_unique<starvation_t>();
+        b.run(std::string("CondVar ") + name, [&] {
+            r->wait_ns.reset();
+            run_starvation(policy, *r);
+        });
+        results.emplace_back(name, std::move(r));
+    }
+    for (auto& [name, r] : results) {
+        auto snap = r->wait_ns.snapshot();
+        fmt::print("  {:<9} wait p50 {:>9} ns, p99 {:>9} ns, max {:>10} ns, never woken {}/{}\n",
+                   name, snap.percentile(50), snap.percentile(99), snap.max, r->never_woken,
+                   kWaiters);
+    }
+    b.batch(1).unit("op");
+    b.epochs(11).epochIterations(0);
+}
+
+BENCHMARK_REGISTE(bench_condvar);
@@ -0,0 +1,73 @@
+#ifdef CC_WITH_SQLITE3
+
+#    include "common.h"
+#    include <filesystem>
+#    include <string>
+#    include <vector>
+#    include <cc/historian.h>
+
+static void bench_historian(bench::Bench& b) {
+    constexpr int kTags = 5000;
+    constexpr int kHz   = 100;
+
+    auto dir = std::filesystem::temp_directory_path() / "cc_bench_historian";
+    std::filesystem::remove_all(dir);
+
+    do {
+        cc::HistorianOptions opts;
+        opts.flush_interval_ms = 3600000;  // 由benchmark显式flush
+        cc::Historian h((dir / "hist.db").string(), opts);
+
+        std::vector<cc::Historian::tag_t> tags;
+        for (int i = 0; i < kTags; i++) {
+            tags.push_back(h.tag("tag" + std::to_string(i)));
+        }
+
+        // 每次迭代写入1秒的数据(5000 tags * 100Hz)并落盘
+        std::int64_t ts = cc::Historian::now_ms();
+        ts -= ts % 3600000;
+        b.title("historian");
+        b.batch(kTags * kHz).unit("sample");
+        b.run("ingest 5000 tags@100Hz (append + flush)", [&] {
+            for (int k = 0; k < kHz; k++) {
+                for (int i = 0; i < kTags; i++) {
+                    h.append(tags[i], ts, i + k * 0.01);
+                }
+                ts += 1000 / kHz;
+            }
+            h.flush();
+        });
+
+        b.batch(1).unit("op");
+        auto from = ts - 60000;
+        b.run("query raw (1 tag, last 10s)", [&] {
+            auto r = h.query(tags[42], ts - 10000, ts);
+            bench::doNotOptimizeAway(r.data());
+        });
+        b.run("query rollup 1s (1 tag, last 60s)", [&] {
+            auto r = h.rollup(tags[42], cc::Historian::SECOND, from, ts);
+            bench::doNotOptimizeAway(r.data());
+        });
+        b.run("query rollup 1min (1 tag)", [&] {
+            auto r = h.rollup(tags[42], cc::Historian::MINUTE, from, ts);
+            bench::doNotOptimizeAway(r.data());
+        });
+    } while (0);
+
+    // 对比: 逐行execute(每次prepare + 自动提交)
+    do {
+        cc::Sqlite3pp db((dir / "baseline.db").string());
+        db.execute("CREATE TABLE raw(tag INTEGER, ts INTEGER, value REAL);");
+        std::int64_t ts = 0;
+        b.batch(1).unit("sample");
+        b.run("baseline: Sqlite3pp::execute per sample", [&] {
+            db.execute("INSERT INTO raw(tag, ts, value) VALUES(?, ?, ?);", 1, ts++, 1.0);
+        });
+    } while (0);
+
+    std::filesystem::remove_all(dir);
+}
+
+BENCHMARK_REGISTE(bench_historian);
+
+#endif
@@ -0,0 +1,68 @@
+#include "common.h"
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cc/latency_histogram.h>
+
+static void bench_latency_histogram(bench::Bench& b) {
+    constexpr int kSamples = 1000000;
+
+    b.title("latency histogram");
+    do {
+        cc::LatencyHistogram h;
+        std::int64_t v = 0;
+        b.run("record", [&] { h.record((v++ * 7919) & 0xfffff); });
+        b.run("scope", [&] { auto _t = h.scope(); });
+        b.run("scope<TscClock>", [&] { auto _t = h.scope<cc::TscClock>(); });
+        b.run("snapshot + p99", [&] { bench::doNotOptimizeAway(h.percentile(99)); });
+    } while (0);
+
+    // 多线程并发记录, 每个线程kSamples个样本. 线程数超过CPU核数时测不出竞争, 跳过
+    const int cores = static_cast<int>(std::thread::hardware_concurrency());
+    b.epochs(1).epochIterations(1);
+    for (int n : {1, 4, 8}) {
+        if (n > 1 && n > cores) {
+            continue;
+        }
+        b.batch(n * kSamples).unit("sample");
+        b.run("LatencyHistogram::record " + std::to_string(n) + " threads", [&] {
+            cc::LatencyHistogram h;
+            std::vector<std::thread> threads;
+            for (int t = 0; t < n; t++) {
+                threads.emplace_back([&] {
+                    for (int i = 0; i < kSamples; i++) {
+                        h.record(i & 0xfffff);
+                    }
+                });
+            }
+            for (auto& t : threads) {
+                t.join();
+            }
+        });
+
+        // 对比: 现有做法, 加锁累计平均值
+        b.run("mutex + sum/count " + std::to_string(n) + " threads", [&] {
+            std::mutex mtx;
+            std::int64_t sum = 0, count = 0;
+            std::vector<std::thread> threads;
+            for (int t = 0; t < n; t++) {
+                threads.emplace_back([&] {
+                    for (int i = 0; i < kSamples; i++) {
+                        std::lock_guard<std::mutex> _lck{mtx};
+                        sum += i & 0xfffff;
+                        count++;
+                    }
+                });
+            }
+            for (auto& t : threads) {
+                t.join();
+            }
+            bench::doNotOptimizeAway(sum);
+        });
+    }
+    b.batch(1).unit("op");
+    b.epochs(11).epochIterations(0);
+}
+
+BENCHMARK_REGISTE(bench_latency_histogram);
@@ -0,0 +1,94 @@
+#include "common.h"
+#include <array>
+#include <atomic>
+#include <memory>
+#include <string_view>
+#include <thread>
+#include <boost/asio.hpp>
+#include <cc/asio/helper.h>
+#include <cc/asio/pool.h>
+#include <cc/lit/server.h>
+#include <fmt/format.h>
+
+namespace {
+
+using tcp = net::ip::tcp;
+
+// 短连接建连速率: kClients个客户端协程, 每个串行建kConnects次连接, 每次一个请求
+constexpr int kServerThreads = 4;
+constexpr int kClients       = 64;
+constexpr int kConnects      = 100;
+constexpr std::string_view kRequest =
+    "GET / HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n";
+
+net::awaitable<void> client(tcp::endpoint ep) {
+    auto ex = co_await net::this_coro::executor;
+    std::array<char, 512> buf;
+    for (int i = 0; i < kConnects; i++) {
+        tcp::socket sock(ex);
+        co_await sock.async_connect(ep, net::use_awaitable);
+        co_await net::async_write(sock, net::buffer(kRequest), net::use_awaitable);
+        // 读到服务端关闭连接
+        for (;;) {
+            auto [ec, n] = co_await sock.async_read_some(net::buffer(buf),
+                                                         net::as_tuple(net::use_awaitable));
+            if (ec) {
+                break;
+            }
+        }
+    }
+}
+
+/// @param make_app 在服务端pool上创建App
+template <typename MakeApp>
+void run_connect(cc::AsioPool& server, MakeApp&& make_app) {
+    std::unique_ptr<cc::lit::App> app = make_app(server);
+    app->Get("/", [](const auto& req, auto& resp) { resp.set_content("ok", "text/plain"); });
+    app->start();
+    std::thread th([&] { server.run(kServerThreads); });
+
+    // 负载端单独一个pool, 不与服务端抢io_context
+    cc::AsioPool load(cc::sharded, kServerThreads);
+    tcp::endpoint ep{net::ip::address_v4::loopback(), app->port()};
+    std::atomic<int> left{kClients};
+    for (int i = 0; i < kClients; i++) {
+        net::co_spawn(load.get_io_context(), client(ep), [&](std::exception_ptr) {
+            if (--left == 0) {
+                load.shutdown();
+            }
+        });
+    }
+    load.run(kServerThreads);
+    server.shutdown();
+    th.join();
+}
+
+}  // namespace
+
+static void bench_lit(bench::Bench& b) {
+    b.title(fmt::format("lit::App: connection rate, {} server threads, {} clients",
+                        kServerThreads, kClients));
+    b.epochs(1).epochIterations(1).batch(kClients * kConnects).unit("conn");
+    b.run("shared io_context, 1 acceptor", [&] {
+        cc::AsioPool server;
+        run_connect(server, [](cc::AsioPool& pool) {
+            return std::make_unique<cc::lit::App>(pool.get_io_context(), "127.0.0.1", 0);
+        });
+    });
+    b.run("sharded, 1 acceptor", [&] {
+        cc::AsioPool server(cc::sharded, kServerThreads);
+        run_connect(server, [](cc::AsioPool& pool) {
+            return std::make_unique<cc::lit::App>(pool.get_io_context(0), "127.0.0.1", 0);
+        });
+    });
+    b.run("sharded, SO_REUSEPORT acceptor per shard", [&] {
+        cc::AsioPool server(cc::sharded, kServerThreads);
+        run_connect(server, [](cc::AsioPool& pool) {
+            return std::make_unique<cc::lit::App>(pool, "127.0.0.1", 0);
+        });
+    });
+    b.batch(1).unit("op");
+    b.epochs(11).epochIterations(0);
+}
+
+BENCHMARK_REGISTE(bench_lit);
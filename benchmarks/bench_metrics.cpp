@@ -0,0 +1,23 @@
+#include "common.h"
+#include <atomic>
+#include <cc/metrics.h>
+
+static void bench_metrics(bench::Bench& b) {
+    auto& r = cc::metrics::Registry::instance();
+    auto& c = r.counter("bench_counter_total", "bench");
+    auto& g = r.gauge("bench_gauge", "bench");
+    auto& h = r.histogram("bench_latency_seconds", "bench");
+    std::atomic<std::uint64_t> shared{0};
+
+    b.title("metrics");
+    b.run("std::atomic fetch_add", [&] { shared.fetch_add(1, std::memory_order_relaxed); });
+    b.run("Counter::inc", [&] { c.inc(); });
+    b.run("Gauge::add", [&] { g.add(1); });
+    b.run("Histogram::observe", [&] { h.observe(1234567); });
+    b.run("Registry::counter(lookup)", [&] {
+        bench::doNotOptimizeAway(&r.counter("bench_counter_total", "bench"));
+    });
+    b.run("Registry::scrape", [&] { bench::doNotOptimizeAway(r.scrape().size()); });
+}
+
+BENCHMARK_REGISTE(bench_metrics);
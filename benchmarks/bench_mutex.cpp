@@ -0,0 +1,135 @@
+#include "common.h"
+#include <array>
+#include <cstddef>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <boost/asio.hpp>
+#include <cc/asio/mutex.h>
+#include <cc/asio/pool.h>
+
+namespace {
+
+// kWorkers个协程分布在kPoolThreads个AsioPool线程上, 各做kOps次读或写
+constexpr int kPoolThreads = 4;
+constexpr int kWorkers     = 64;
+constexpr int kOps         = 5000;
+
+struct shared_t {
+    std::array<std::size_t, 64> slots{};
+
+    std::size_t read() const {
+        std::size_t sum = 0;
+        for (auto v : slots) {
+            sum += v;
+        }
+        return sum;
+    }
+
+    void write(std::size_t i) { slots[i % slots.size()]++; }
+};
+
+/// @param write_pct 写操作的百分比
+template <typename Op>
+void run_mix(int write_pct, Op&& op) {
+    cc::AsioPool pool;
+    shared_t data;
+    for (int i = 0; i < kWorkers; i++) {
+        net::co_spawn(
+            pool.get_io_context(),
+            [&, i]() -> net::awaitable<void> {
+                auto ex = co_await net::this_coro::executor;
+                for (int k = 0; k < kOps; k++) {
+                    bool write = (i * 7 + k) % 100 < write_pct;
+                    co_await op(data, write, static_cast<std::size_t>(k));
+                    co_await net::post(ex, net::use_awaitable);
+                }
+            },
+            net::detached);
+    }
+    pool.run(kPoolThreads);
+}
+
+// 临界区内不挂起, 与线程锁对比的是加解锁本身的开销
+template <typename SharedMutex>
+struct thread_lock_op {
+    SharedMutex mtx;
+
+    net::awaitable<void> operator()(shared_t& d, bool write, std::size_t k) {
+        if (write) {
+            std::unique_lock _lck{mtx};
+            d.write(k);
+        } else {
+            std::shared_lock _lck{mtx};
+            bench::doNotOptimizeAway(d.read());
+        }
+        co_return;
+    }
+};
+
+struct async_lock_op {
+    cc::AsyncSharedMutex<std::mutex> mtx;
+
+    net::awaitable<void> operator()(shared_t& d, bool write, std::size_t k) {
+        if (write) {
+            auto _lck = co_await mtx.guard();
+            d.write(k);
+        } else {
+            auto _lck = co_await mtx.shared_guard();
+            bench::doNotOptimizeAway(d.read());
+        }
+    }
+};
+
+struct async_mutex_op {
+    cc::AsyncMutex<std::mutex> mtx;
+
+    net::awaitable<void> operator()(shared_t& d, bool write, std::size_t k) {
+        auto _lck = co_await mtx.guard();
+        if (write) {
+            d.write(k);
+        } else {
+            bench::doNotOptimizeAway(d.read());
+        }
+    }
+};
+
+// 临界区内有一次co_await(如查询后写回), 线程锁做不到, 只能用协程锁
+struct async_lock_yield_op {
+    cc::AsyncSharedMutex<std::mutex> mtx;
+
+    net::awaitable<void> operator()(shared_t& d, bool write, std::size_t k) {
+        auto ex = co_await net::this_coro::executor;
+        if (write) {
+            auto _lck = co_await mtx.guard();
+            co_await net::post(ex, net::use_awaitable);
+            d.write(k);
+        } else {
+            auto _lck = co_await mtx.shared_guard();
+            co_await net::post(ex, net::use_awaitable);
+            bench::doNotOptimizeAway(d.read());
+        }
+    }
+};
+
+}  // namespace
+
+static void bench_mutex(bench::Bench& b) {
+    b.epochs(1).epochIterations(1).batch(kWorkers * kOps).unit("op");
+    for (int write_pct : {5, 50}) {
+        b.title("asio mutex: 64 coroutines on 4 AsioPool threads, " + std::to_string(write_pct)
+                + "% writes");
+        b.run("std::shared_mutex", [&] {
+            run_mix(write_pct, thread_lock_op<std::shared_mutex>{});
+        });
+        b.run("cc::AsyncSharedMutex", [&] { run_mix(write_pct, async_lock_op{}); });
+        b.run("cc::AsyncMutex", [&] { run_mix(write_pct, async_mutex_op{}); });
+        b.run("cc::AsyncSharedMutex, co_await inside", [&] {
+            run_mix(write_pct, async_lock_yield_op{});
+        });
+    }
+    b.batch(1).unit("op");
+    b.epochs(11).epochIterations(0);
+}
+
+BENCHMARK_REGISTE(bench_mutex);
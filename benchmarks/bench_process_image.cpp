@@ -0,0 +1,63 @@
+#include "common.h"
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cc/st/process_image.h>
+
+static void bench_process_image(bench::Bench& b) {
+    constexpr int kTags    = 1024;
+    constexpr int kWriters = 4;
+
+    cc::st::ConcurrentProcessImage pi;
+    std::vector<cc::st::InputTag<double>> inputs;
+    std::vector<cc::st::OutputTag<double>> outputs;
+    for (int i = 0; i < kTags; i++) {
+        inputs.emplace_back(pi.declare_input<double>("in" + std::to_string(i)));
+        outputs.emplace_back(pi.declare_output<double>("out" + std::to_string(i)));
+    }
+
+    auto scan_once = [&] {
+        auto scan  = pi.begin_scan();
+        double sum = 0;
+        for (int i = 0; i < kTags; i++) {
+            auto v = scan.get(inputs[i]);
+            sum += v;
+            scan.set(outputs[i], v * 2);
+        }
+        bench::doNotOptimizeAway(sum);
+    };
+
+    b.title("process image");
+    b.run("scan(1024 tags) idle", scan_once);
+
+    // IO线程持续高频更新输入
+    std::atomic<bool> stop{false};
+    std::atomic<long> updates{0};
+    std::vector<std::thread> writers;
+    for (int t = 0; t < kWriters; t++) {
+        writers.emplace_back([&, t] {
+            double v = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                pi.write_inputs([&](auto& w) {
+                    for (int i = t; i < kTags; i += kWriters) {
+                        w.set(inputs[i], v);
+                    }
+                });
+                pi.get_output(outputs[t]);
+                v += 1;
+                updates.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+
+    b.run("scan(1024 tags) with 4 io writers", scan_once);
+
+    stop = true;
+    for (auto& th : writers) {
+        th.join();
+    }
+    bench::doNotOptimizeAway(updates.load());
+}
+
+BENCHMARK_REGISTE(bench_process_image);
@@ -0,0 +1,78 @@
+#include "common.h"
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cc/singleton_provider.h>
+#include <cc/st.h>
+
+namespace {
+
+// 对比: 每次instance()都进入call_once的旧实现
+struct CallOnceProvider {
+    static inline std::unique_ptr<cc::StFactory<std::mutex>> ins_;
+    static inline std::once_flag flag_;
+
+    static cc::StFactory<std::mutex>& instance() {
+        std::call_once(flag_, [] { ins_ = std::make_unique<cc::StFactory<std::mutex>>(); });
+        return *ins_;
+    }
+};
+
+template <typename Fn>
+void run_threads(int n, Fn&& fn) {
+    std::vector<std::thread> threads;
+    for (int t = 0; t < n; t++) {
+        threads.emplace_back(fn);
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+}
+
+}  // namespace
+
+static void bench_provider(bench::Bench& b) {
+    constexpr int kOps = 200000;
+
+    b.title("singleton provider");
+    b.run("call_once instance()",
+          [&] { bench::doNotOptimizeAway(&CallOnceProvider::instance()); });
+    b.run("SingletonProvider::instance()",
+          [&] { bench::doNotOptimizeAway(&cc::ConcurrentStFactoryProvider::instance()); });
+    b.run("ShardedProvider::instance()",
+          [&] { bench::doNotOptimizeAway(&cc::ShardedStFactoryProvider::instance()); });
+
+    // 多线程各自kOps次 instance().r_trig(name)(clk)
+    b.epochs(1).epochIterations(1);
+    for (int n : {1, 4, 16, 64}) {
+        b.batch(n * kOps).unit("op");
+        b.run("call_once + StFactory<mutex> " + std::to_string(n) + " threads", [&] {
+            run_threads(n, [] {
+                for (int i = 0; i < kOps; i++) {
+                    bench::doNotOptimizeAway(CallOnceProvider::instance().r_trig("bench")(i & 1));
+                }
+            });
+        });
+        b.run("SingletonProvider<StFactory<mutex>> " + std::to_string(n) + " threads", [&] {
+            run_threads(n, [] {
+                for (int i = 0; i < kOps; i++) {
+                    auto& f = cc::ConcurrentStFactoryProvider::instance();
+                    bench::doNotOptimizeAway(f.r_trig("bench")(i & 1));
+                }
+            });
+        });
+        b.run("ShardedProvider<StFactory<mutex>> " + std::to_string(n) + " threads", [&] {
+            run_threads(n, [] {
+                for (int i = 0; i < kOps; i++) {
+                    auto& f = cc::ShardedStFactoryProvider::instance();
+                    bench::doNotOptimizeAway(f.r_trig("bench")(i & 1));
+                }
+            });
+        });
+    }
+    b.batch(1).unit("op");
+    b.epochs(11).epochIterations(0);
+}
+
+BENCHMARK_REGISTE(bench_provider);
@@ -0,0 +1,103 @@
+#include "common.h"
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/asio.hpp>
+#include <cc/asio/rate_limiter.h>
+#include <cc/signal.h>
+#include <cc/stopwatch.h>
+#include <fmt/format.h>
+
+namespace {
+
+constexpr int kThreads      = 4;
+constexpr int kOpsPerThread = 1000000;
+constexpr int kKeys         = 10000;
+
+template <typename Fn>
+void run_threads(Fn&& fn) {
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; t++) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < kOpsPerThread; i++) {
+                fn(t, i);
+            }
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+}
+
+// 1000个请求按10000/s整形, 桶容量1(漏桶)
+constexpr int kShaped       = 1000;
+constexpr double kShapeRate = 10000;
+
+/// @return 实际达到的速率(个/秒)
+double run_shaping() {
+    net::io_context ioc;
+    cc::TokenBucket bucket(kShapeRate, 1);
+    cc::StopWatch sw;
+    for (int i = 0; i < kShaped; i++) {
+        net::co_spawn(
+            ioc, [&]() -> net::awaitable<void> { co_await bucket.acquire(); }, net::detached);
+    }
+    ioc.run();
+    return kShaped / sw.elapsed();
+}
+
+}  // namespace
+
+static void bench_rate_limiter(bench::Bench& b) {
+    // 限速本身的开销: 速率设得足够大, 都总是放行
+    b.title("rate limiter: admit check, 1 thread");
+    do {
+        cc::detail::TimeTracker<std::mutex> tracker(0.0, 1000);
+        b.run("Signal TimeTracker<std::mutex>", [&] {
+            bench::doNotOptimizeAway(tracker.track());
+        });
+    } while (0);
+    do {
+        cc::TokenBucket bucket(1e9, 1e9);
+        b.run("TokenBucket::try_acquire", [&] { bench::doNotOptimizeAway(bucket.try_acquire()); });
+    } while (0);
+    do {
+        auto global = std::make_shared<cc::TokenBucket>(1e9, 1e9);
+        cc::KeyedRateLimiter<int, std::mutex> keyed(1e9, 1e9, global);
+        int i = 0;
+        b.run("KeyedRateLimiter(10k keys + global)::try_acquire", [&] {
+            bench::doNotOptimizeAway(keyed.try_acquire(i++ % kKeys));
+        });
+    } while (0);
+
+    b.title("rate limiter: admit check, 4 threads");
+    b.epochs(1).epochIterations(1).batch(kThreads * kOpsPerThread);
+    b.run("Signal TimeTracker<std::mutex>", [&] {
+        cc::detail::TimeTracker<std::mutex> tracker(0.0, 1000);
+        run_threads([&](int, int) { bench::doNotOptimizeAway(tracker.track()); });
+    });
+    b.run("TokenBucket::try_acquire", [&] {
+        cc::TokenBucket bucket(1e9, 1e9);
+        run_threads([&](int, int) { bench::doNotOptimizeAway(bucket.try_acquire()); });
+    });
+    b.run("KeyedRateLimiter(10k keys)::try_acquire", [&] {
+        cc::KeyedRateLimiter<int, std::mutex> keyed(1e9, 1e9);
+        run_threads([&](int t, int i) {
+            bench::doNotOptimizeAway(keyed.try_acquire((t * kOpsPerThread + i) % kKeys));
+        });
+    });
+
+    // 整形精度: 超出速率的请求被延迟而不是丢弃, 实际速率应接近设定值
+    b.title("rate limiter: shape 1000 acquires at 10000/s");
+    b.batch(kShaped).unit("acquire");
+    double achieved = 0;
+    b.run("TokenBucket::acquire (burst 1)", [&] { achieved = run_shaping(); });
+    fmt::print("  target {:.0f}/s, achieved {:.0f}/s\n", kShapeRate, achieved);
+
+    b.batch(1).unit("op");
+    b.epochs(11).epochIterations(0);
+}
+
+BENCHMARK_REGISTE(bench_rate_limiter);
@@ -0,0 +1,43 @@
+#include "common.h"
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <cc/st.h>
+#include <cc/st/retainer.h>
+
+static void bench_st_retain(bench::Bench& b) {
+    constexpr int kBlocks = 100000;
+
+    cc::StFactory<> f;
+    for (int i = 0; i < kBlocks / 4; i++) {
+        auto name = std::to_string(i);
+        f.ton("t" + name)(1, 1000);
+        f.ctu("c" + name)(1, 0, 10);
+        f.sr("l" + name)(1, 0);
+        f.r_trig("r" + name)(1);
+    }
+
+    std::vector<char> buf;
+    f.snapshot(buf);
+
+    b.title("st retain(100k blocks, " + std::to_string(buf.size() / 1024) + "KB)");
+    b.run("StFactory::snapshot", [&] {
+        f.snapshot(buf);
+        bench::doNotOptimizeAway(buf.data());
+    });
+    b.run("StFactory::restore", [&] {
+        cc::StFactory<> f2;
+        f2.restore(buf);
+        bench::doNotOptimizeAway(f2.size());
+    });
+
+    // 扫描线程上的均摊开销: 每100次扫描做一次快照, 由后台线程写入mmap文件
+    auto path = std::filesystem::temp_directory_path() / "cc_bench_st_retain.bin";
+    do {
+        cc::st::Retainer<cc::st::MmapRetainStore> retainer(100, path.string());
+        b.run("Retainer::on_scan(every=100, mmap)", [&] { retainer.on_scan(f); });
+    } while (0);
+    std::filesystem::remove(path);
+}
+
+BENCHMARK_REGISTE(bench_st_retain);
@@ -0,0 +1,87 @@
+#include "common.h"
+#include <string>
+#include <vector>
+#include <cc/st.h>
+#include <cc/st/compiler.h>
+#include <fmt/core.h>
+
+static constexpr int kStatements = 10000;
+static constexpr int kVars       = 100;
+
+// 每10条语句中9条算术赋值, 1条条件复位
+static std::string gen_program() {
+    std::string src = "PROGRAM bench\nVAR\n";
+    for (int i = 0; i < kVars; i++) {
+        src += fmt::format("  x{} : INT;\n", i);
+    }
+    src += "END_VAR\n";
+    for (int i = 0; i < kStatements; i++) {
+        int a = i % kVars;
+        int b = (i + 1) % kVars;
+        if (i % 10 == 9) {
+            src += fmt::format("IF x{} > 100000 THEN x{} := 0; END_IF;\n", a, a);
+        } else {
+            src += fmt::format("x{} := x{} + {} * 3;\n", a, b, i % 13);
+        }
+    }
+    src += "END_PROGRAM\n";
+    return src;
+}
+
+static void native_program(std::int64_t* x) {
+    for (int i = 0; i < kStatements; i++) {
+        int a = i % kVars;
+        int b = (i + 1) % kVars;
+        if (i % 10 == 9) {
+            if (x[a] > 100000) x[a] = 0;
+        } else {
+            x[a] = x[b] + (i % 13) * 3;
+        }
+    }
+}
+
+static void bench_st_vm(bench::Bench& b) {
+    auto src = gen_program();
+    cc::st::Vm vm(cc::st::compile(src));
+    std::vector<std::int64_t> x(kVars, 0);
+
+    b.title("st vm");
+    b.run("compile 10k statements", [&] {
+        auto prog = cc::st::compile(src);
+        bench::doNotOptimizeAway(prog);
+    });
+    b.run("vm scan 10k statements", [&] { vm.scan(); });
+    b.run("c++ 10k statements", [&] {
+        native_program(x.data());
+        bench::doNotOptimizeAway(x);
+    });
+
+    // 1000个TON: VM原生调用 vs 按名字查找StFactory
+    std::string ton_src = "VAR\n  run : BOOL := TRUE;\n";
+    for (int i = 0; i < 1000; i++) {
+        ton_src += fmt::format("  t{} : TON;\n  q{} : BOOL;\n", i, i);
+    }
+    ton_src += "END_VAR\n";
+    for (int i = 0; i < 1000; i++) {
+        ton_src += fmt::format("t{}(IN := run, PT := T#1h); q{} := t{}.Q;\n", i, i, i);
+    }
+    cc::st::Vm ton_vm(cc::st::compile(ton_src));
+
+    cc::StFactory<> factory;
+    std::vector<std::string> names;
+    for (int i = 0; i < 1000; i++) {
+        names.emplace_back(fmt::format("t{}", i));
+    }
+    std::vector<int> q(1000);
+
+    b.run("vm scan 1000 TON", [&] { ton_vm.scan(); });
+    b.run("c++ StFactory::ton 1000", [&] {
+        for (int i = 0; i < 1000; i++) {
+            auto [q0, et] = factory.ton(names[i])(1, 3600000);
+            q[i]          = q0;
+        }
+        bench::doNotOptimizeAway(q);
+    });
+}
+
+BENCHMARK_REGISTE(bench_st_vm);
@@ -1,24 +1,40 @@
 #include "common.h"
 #include <cc/stopwatch.h>
+#include <string>
 #include <time.h>
 
 #if defined(__linux__)
 #    include <sys/time.h>
 #endif
 
-static void bench_stopwatch(bench::Bench& b) {
-    cc::StopWatch stopwatch;
-    b.title("Stopwatch");
-    auto old = b.epochIterations();
-    b.minEpochIterations(522527);
-    b.run("ctor", [] {
-        cc::StopWatch stopwatch;
+template <typename SW>
+static void bench_stopwatch_impl(bench::Bench& b, const std::string& name) {
+    SW stopwatch;
+    b.run(name + " ctor", [] {
+        SW stopwatch;
         bench::doNotOptimizeAway(stopwatch);
     });
-    b.run("elapsed", [&] {
+    b.run(name + " elapsed", [&] {
         auto e = stopwatch.elapsed();
         bench::doNotOptimizeAway(e);
     });
+    b.run(name + " elapsed_ticks", [&] {
+        auto e = stopwatch.elapsed_ticks();
+        bench::doNotOptimizeAway(e);
+    });
+    b.run(name + " elapsed_ns", [&] {
+        auto e = stopwatch.elapsed_ns();
+        bench::doNotOptimizeAway(e);
+    });
+}
+
+static void bench_stopwatch(bench::Bench& b) {
+    cc::TscClock::calibrate();
+    b.title(std::string("Stopwatch(tsc=") + (cc::TscClock::is_tsc() ? "on" : "off") + ")");
+    auto old = b.epochIterations();
+    b.minEpochIterations(522527);
+    bench_stopwatch_impl<cc::StopWatch>(b, "steady");
+    bench_stopwatch_impl<cc::TscStopWatch>(b, "tsc");
     b.run("time(null)", [] {
         auto now = time(NULL);
         bench::doNotOptimizeAway(now);
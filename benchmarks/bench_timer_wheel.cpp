@@ -0,0 +1,72 @@
+#include "common.h"
+#include <memory>
+#include <vector>
+#include <boost/asio.hpp>
+#include <cc/asio/pool.h>
+#include <cc/asio/timer_wheel.h>
+
+static void bench_timer_wheel(bench::Bench& b) {
+    constexpr int kPending = 1000000;
+
+    // 1M个等待中的会话超时, 测量再启动/取消一个定时器的开销
+    b.title("timer: arm+cancel with 1M pending");
+
+    do {
+        cc::AsioPool ap;
+        std::vector<cc::AsioPool::timer_t> timers;
+        timers.reserve(kPending);
+        for (int i = 0; i < kPending; i++) {
+            timers.emplace_back(ap.set_timeout(30000 + i % 60000, [] {}));
+        }
+        b.run("AsioPool::set_timeout(steady_timer)", [&] {
+            auto t = ap.set_timeout(45000, [] {});
+            ap.clear_timeout(t);
+        });
+        for (auto& t : timers) {
+            ap.clear_timeout(t);
+        }
+    } while (0);
+
+    do {
+        cc::AsioPool ap;
+        std::vector<cc::AsioPool::wheel_timer_t> timers;
+        timers.reserve(kPending);
+        for (int i = 0; i < kPending; i++) {
+            timers.emplace_back(ap.set_timeout(30000 + i % 60000, [] {}, cc::use_wheel));
+        }
+        b.run("AsioPool::set_timeout(use_wheel)", [&] {
+            auto t = ap.set_timeout(45000, [] {}, cc::use_wheel);
+            ap.clear_timeout(t);
+        });
+        for (auto& t : timers) {
+            ap.clear_timeout(t);
+        }
+    } while (0);
+
+    do {
+        cc::TimerWheel<> w;
+        for (int i = 0; i < kPending; i++) {
+            w.set_timeout(30000 + i % 60000, [] {});
+        }
+        b.run("TimerWheel<NonMutex>", [&] { w.cancel(w.set_timeout(45000, [] {})); });
+    } while (0);
+
+    // 批量启动1M个定时器的总耗时
+    b.title("timer: arm 1M");
+    b.epochs(1).epochIterations(1);
+    b.run("AsioPool::set_timeout(steady_timer)", [&] {
+        cc::AsioPool ap;
+        for (int i = 0; i < kPending; i++) {
+            ap.set_timeout(30000 + i % 60000, [] {});
+        }
+    });
+    b.run("AsioPool::set_timeout(use_wheel)", [&] {
+        cc::AsioPool ap;
+        for (int i = 0; i < kPending; i++) {
+            ap.set_timeout(30000 + i % 60000, [] {}, cc::use_wheel);
+        }
+    });
+    b.epochs(11).epochIterations(0);
+}
+
+BENCHMARK_REGISTE(bench_timer_wheel);
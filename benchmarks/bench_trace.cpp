@@ -0,0 +1,17 @@
+#include "common.h"
+#include <cc/trace.h>
+
+static void bench_trace(bench::Bench& b) {
+    b.title("trace");
+    cc::trace::enable(false);
+    b.run("CC_TRACE_SCOPE(disabled)", [] { CC_TRACE_SCOPE("bench"); });
+    b.run("CC_TRACE_CO_SCOPE(disabled)", [] { CC_TRACE_CO_SCOPE("bench"); });
+
+    cc::trace::enable();
+    b.run("CC_TRACE_SCOPE(enabled)", [] { CC_TRACE_SCOPE("bench"); });
+    b.run("CC_TRACE_CO_SCOPE(enabled)", [] { CC_TRACE_CO_SCOPE("bench"); });
+    cc::trace::enable(false);
+    cc::trace::clear();
+}
+
+BENCHMARK_REGISTE(bench_trace);
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#    include <pthread.h>
+#    include <sched.h>
+#endif
+
+namespace cc {
+
+/// CPU编号列表
+using cpu_list_t = std::vector<int>;
+
+/// 解析内核的cpulist格式, 如"0-3,8,10-11", 结果升序去重
+inline cpu_list_t parse_cpulist(std::string_view s) {
+    cpu_list_t cpus;
+    while (!s.empty()) {
+        auto comma = s.find(',');
+        auto item  = s.substr(0, comma);
+        s          = comma == std::string_view::npos ? std::string_view{} : s.substr(comma + 1);
+
+        if (item.find_first_of("0123456789") == std::string_view::npos) {
+            continue;
+        }
+        auto dash = item.find('-');
+        int first = std::atoi(std::string(item.substr(0, dash)).c_str());
+        int last  = dash == std::string_view::npos
+                        ? first
+                        : std::atoi(std::string(item.substr(dash + 1)).c_str());
+        for (int c = first; c <= last; c++) {
+            cpus.push_back(c);
+        }
+    }
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    return cpus;
+}
+
+/// 当前线程允许运行的CPU(受taskset/cgroup cpuset限制).
+/// 非Linux返回0到hardware_concurrency()-1
+inline cpu_list_t allowed_cpus() {
+    cpu_list_t cpus;
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int c = 0; c < CPU_SETSIZE; c++) {
+            if (CPU_ISSET(c, &set)) {
+                cpus.push_back(c);
+            }
+        }
+        return cpus;
+    }
+#endif
+    auto n = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned c = 0; c < n; c++) {
+        cpus.push_back(static_cast<int>(c));
+    }
+    return cpus;
+}
+
+/// NUMA节点上的CPU, 已与allowed_cpus()取交集. 从sysfs读取, 不依赖libnuma;
+/// 没有NUMA信息时节点0为全部可用CPU
+inline cpu_list_t numa_node_cpus(int node) {
+    auto allowed = allowed_cpus();
+    std::ifstream in("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    std::string line;
+    if (!in || !std::getline(in, line)) {
+        return node == 0 ? allowed : cpu_list_t{};
+    }
+    auto node_cpus = parse_cpulist(line);
+    cpu_list_t cpus;
+    std::set_intersection(allowed.begin(), allowed.end(), node_cpus.begin(), node_cpus.end(),
+                          std::back_inserter(cpus));
+    return cpus;
+}
+
+/// NUMA节点数, 没有NUMA信息时为1
+inline int numa_nodes() {
+    std::ifstream in("/sys/devices/system/node/online");
+    std::string line;
+    if (!in || !std::getline(in, line)) {
+        return 1;
+    }
+    auto nodes = parse_cpulist(line);
+    return nodes.empty() ? 1 : nodes.back() + 1;
+}
+
+/// 把当前线程绑定到cpus. 之后该线程首次写入的内存(如asio的每线程缓存)按内核的
+/// first-touch策略分配在所在节点上
+///
+/// @return 成功时返回true; cpus为空或非Linux时返回false
+inline bool pin_thread(const cpu_list_t& cpus) {
+#ifdef __linux__
+    if (cpus.empty()) {
+        return false;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int c : cpus) {
+        if (c >= 0 && c < CPU_SETSIZE) {
+            CPU_SET(c, &set);
+        }
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpus;
+    return false;
+#endif
+}
+
+/// 把当前线程绑定到一个CPU, 如把st扫描线程放到AsioPool保留的核上
+inline bool pin_thread(int cpu) { return pin_thread(cpu_list_t{cpu}); }
+
+/// 当前线程正运行在哪个CPU上, 不支持时返回-1
+inline int current_cpu() {
+#ifdef __linux__
+    return sched_getcpu();
+#else
+    return -1;
+#endif
+}
+
+}  // namespace cc
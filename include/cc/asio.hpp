@@ -3,8 +3,13 @@
 #include <cc/asio/pool.h>
 
 #ifdef CC_ENABLE_COROUTINE
+#    include <cc/asio/broadcast.h>
 #    include <cc/asio/channel.h>
+#    include <cc/asio/compute_pool.h>
 #    include <cc/asio/condvar.h>
 #    include <cc/asio/helper.h>
+#    include <cc/asio/mutex.h>
+#    include <cc/asio/rate_limiter.h>
+#    include <cc/asio/select.h>
 #    include <cc/asio/semaphore.h>
 #endif
@@ -0,0 +1,443 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include <boost/core/noncopyable.hpp>
+#include <boost/system/system_error.hpp>
+#include <cc/asio/helper.h>
+#include <cc/asio/select.h>
+#include <cc/asio/waiter.h>
+#include <gsl/gsl>
+
+namespace cc {
+namespace chan {
+
+/// 广播接收者落后超过缓冲容量, 中间的消息已被覆盖
+class lagged_error : public std::runtime_error {
+    std::uint64_t skipped_;
+
+public:
+    explicit lagged_error(std::uint64_t skipped)
+      : std::runtime_error("broadcast receiver lagged by " + std::to_string(skipped))
+      , skipped_(skipped) {}
+
+    /// 丢失的消息条数
+    inline std::uint64_t skipped() const noexcept { return skipped_; }
+};
+
+namespace detail {
+
+/// 等待者列表, 节点在等待者的协程帧里
+class WaiterList : boost::noncopyable {
+    std::mutex mtx_;
+    cc::detail::WaitQueue waiters_;
+
+public:
+    void add(cc::detail::WaitNode& n) {
+        std::lock_guard<std::mutex> _lck{mtx_};
+        waiters_.push_back(n);
+    }
+
+    bool remove(cc::detail::WaitNode& n) {
+        std::lock_guard<std::mutex> _lck{mtx_};
+        return waiters_.erase(n);
+    }
+
+    void notify_all() {
+        cc::detail::WaitNode* head = nullptr;
+        do {
+            std::lock_guard<std::mutex> _lck{mtx_};
+            head = waiters_.take_all();
+        } while (0);
+        cc::detail::WaitQueue::resume_all(head);
+    }
+};
+
+/// 所有接收者共享一个环形缓冲, 每条消息只存一份, 每个接收者只持有自己的读位置
+///
+/// 发送持写锁, 读取持读锁. 接收者在读锁内确认没有新消息后登记等待, 发送方拿到写锁时
+/// 登记已完成, 所以不会丢失唤醒.
+template <typename T,                                             //
+          typename MutexPolicy              = std::shared_mutex,  //
+          template <class> class WriterLock = std::unique_lock,   //
+          template <class> class ReaderLock = std::shared_lock>   //
+class BroadcastContext : boost::noncopyable {
+    MutexPolicy mtx_;
+    std::vector<std::optional<T>> ring_;
+    const std::uint64_t mask_;
+    std::uint64_t tail_ = 0;  // 下一条消息的序号
+    bool closed_        = false;
+    std::atomic<std::size_t> receivers_{0};
+    WaiterList waiters_;
+    SelectHooks hooks_;
+
+public:
+    explicit BroadcastContext(std::size_t capacity)
+      : ring_(std::bit_ceil(std::max<std::size_t>(capacity, 1)))
+      , mask_(ring_.size() - 1) {}
+
+    /// @return 当前的接收者个数
+    template <typename A>
+    std::size_t send(A&& a) {
+        do {
+            WriterLock<MutexPolicy> _lck{mtx_};
+            ring_[tail_ & mask_] = std::forward<A>(a);
+            tail_++;
+            hooks_.fire_all();
+        } while (0);
+        waiters_.notify_all();
+        return receivers_.load(std::memory_order_relaxed);
+    }
+
+    void close() {
+        do {
+            WriterLock<MutexPolicy> _lck{mtx_};
+            closed_ = true;
+            hooks_.fire_all();
+        } while (0);
+        waiters_.notify_all();
+    }
+
+    std::uint64_t tail() {
+        ReaderLock<MutexPolicy> _lck{mtx_};
+        return tail_;
+    }
+
+    inline std::size_t capacity() const noexcept { return ring_.size(); }
+
+    inline void attach() noexcept { receivers_.fetch_add(1, std::memory_order_relaxed); }
+    inline void detach() noexcept { receivers_.fetch_sub(1, std::memory_order_relaxed); }
+
+    /// 读取序号为next的消息并推进next
+    ///
+    /// @param closed   输出通道是否已关闭
+    /// @return         尚无该消息时返回nullopt
+    /// @throw lagged_error 该消息已被覆盖, next跳到缓冲中最旧的消息
+    std::optional<T> try_read(std::uint64_t& next, bool& closed) {
+        ReaderLock<MutexPolicy> _lck{mtx_};
+        closed = closed_;
+        if (next >= tail_) {
+            return std::nullopt;
+        }
+        auto oldest = tail_ > ring_.size() ? tail_ - ring_.size() : 0;
+        if (GSL_UNLIKELY(next < oldest)) {
+            auto skipped = oldest - next;
+            next         = oldest;
+            throw lagged_error(skipped);
+        }
+        return ring_[next++ & mask_];
+    }
+
+    /// 挂起直到序号next的消息已写入或通道关闭
+    ///
+    /// @throw boost::system::system_error(operation_aborted) 等待被取消
+    net::awaitable<void> wait(std::uint64_t next) {
+        auto enqueue = [this, next](cc::detail::WaitNode& n) {
+            ReaderLock<MutexPolicy> _lck{mtx_};
+            if (next < tail_ || closed_) {
+                return false;
+            }
+            waiters_.add(n);
+            return true;
+        };
+        cc::detail::WaitNode node;
+        co_await cc::detail::park<&BroadcastContext::unlink>(node, this, enqueue);
+        if (GSL_UNLIKELY(node.cancelled)) {
+            throw boost::system::system_error(net::error::operation_aborted);
+        }
+    }
+
+    /// 供Select使用: 序号next的消息已写入或已关闭时立即触发, 否则登记到下一次send
+    void select_watch(SelectHook& h, std::uint64_t next) {
+        bind_hook(h, this);
+        WriterLock<MutexPolicy> _lck{mtx_};
+        if (next < tail_ || closed_) {
+            h.fire();
+        } else {
+            hooks_.push(h);
+        }
+    }
+
+    void select_unwatch(SelectHook& h) {
+        WriterLock<MutexPolicy> _lck{mtx_};
+        hooks_.erase(h);
+    }
+
+private:
+    bool unlink(cc::detail::WaitNode& n) { return waiters_.remove(n); }
+};
+
+/// 只保存最新值的通道, 版本号随每次send递增
+template <typename T,                                             //
+          typename MutexPolicy              = std::shared_mutex,  //
+          template <class> class WriterLock = std::unique_lock,   //
+          template <class> class ReaderLock = std::shared_lock>   //
+class WatchContext : boost::noncopyable {
+    MutexPolicy mtx_;
+    T value_;
+    std::uint64_t version_ = 0;
+    bool closed_           = false;
+    WaiterList waiters_;
+    SelectHooks hooks_;
+
+public:
+    template <typename A>
+    explicit WatchContext(A&& init) : value_(std::forward<A>(init)) {}
+
+    template <typename A>
+    void send(A&& a) {
+        do {
+            WriterLock<MutexPolicy> _lck{mtx_};
+            value_ = std::forward<A>(a);
+            version_++;
+            hooks_.fire_all();
+        } while (0);
+        waiters_.notify_all();
+    }
+
+    void close() {
+        do {
+            WriterLock<MutexPolicy> _lck{mtx_};
+            closed_ = true;
+            hooks_.fire_all();
+        } while (0);
+        waiters_.notify_all();
+    }
+
+    /// @return (当前值, 版本号)
+    std::tuple<T, std::uint64_t> get() {
+        ReaderLock<MutexPolicy> _lck{mtx_};
+        return std::make_tuple(value_, version_);
+    }
+
+    std::uint64_t version() {
+        ReaderLock<MutexPolicy> _lck{mtx_};
+        return version_;
+    }
+
+    /// 挂起直到版本号不等于seen
+    ///
+    /// @return 新的版本号, 通道关闭且没有新版本时返回nullopt
+    /// @throw boost::system::system_error(operation_aborted) 等待被取消
+    net::awaitable<std::optional<std::uint64_t>> changed(std::uint64_t seen) {
+        auto enqueue = [this, seen](cc::detail::WaitNode& n) {
+            ReaderLock<MutexPolicy> _lck{mtx_};
+            if (version_ != seen || closed_) {
+                return false;
+            }
+            waiters_.add(n);
+            return true;
+        };
+        cc::detail::WaitNode node;
+        co_await cc::detail::park<&WatchContext::unlink>(node, this, enqueue);
+        if (GSL_UNLIKELY(node.cancelled)) {
+            throw boost::system::system_error(net::error::operation_aborted);
+        }
+        std::optional<std::uint64_t> ret;
+        ReaderLock<MutexPolicy> _lck{mtx_};
+        if (version_ != seen) {
+            ret = version_;
+        }
+        co_return ret;
+    }
+
+    /// 供Select使用: 版本号不等于seen或已关闭时立即触发, 否则登记到下一次send
+    void select_watch(SelectHook& h, std::uint64_t seen) {
+        bind_hook(h, this);
+        WriterLock<MutexPolicy> _lck{mtx_};
+        if (version_ != seen || closed_) {
+            h.fire();
+        } else {
+            hooks_.push(h);
+        }
+    }
+
+    void select_unwatch(SelectHook& h) {
+        WriterLock<MutexPolicy> _lck{mtx_};
+        hooks_.erase(h);
+    }
+
+private:
+    bool unlink(cc::detail::WaitNode& n) { return waiters_.remove(n); }
+};
+
+}  // namespace detail
+
+namespace broadcast {
+
+/// 可拷贝, 拷贝出的接收者从同一位置开始各自读取
+template <typename T, typename Context = detail::BroadcastContext<T>>
+class Receiver {
+    std::shared_ptr<Context> ctx_;
+    std::uint64_t next_;
+
+public:
+    Receiver(std::shared_ptr<Context> ctx, std::uint64_t next)
+      : ctx_(std::move(ctx))
+      , next_(next) {
+        ctx_->attach();
+    }
+
+    Receiver(const Receiver& o) : ctx_(o.ctx_), next_(o.next_) {
+        if (ctx_) {
+            ctx_->attach();
+        }
+    }
+    Receiver(Receiver&& o) noexcept : ctx_(std::move(o.ctx_)), next_(o.next_) {}
+
+    Receiver& operator=(Receiver o) noexcept {
+        std::swap(ctx_, o.ctx_);
+        std::swap(next_, o.next_);
+        return *this;
+    }
+
+    ~Receiver() {
+        if (ctx_) {
+            ctx_->detach();
+        }
+    }
+
+    /// @return 通道关闭且已读完时返回nullopt
+    /// @throw lagged_error 落后超过缓冲容量, 之后从缓冲中最旧的消息继续读
+    /// @throw boost::system::system_error(operation_aborted) 等待被取消
+    net::awaitable<std::optional<T>> recv() {
+        for (;;) {
+            bool closed = false;
+            auto v      = ctx_->try_read(next_, closed);
+            if (v || closed) {
+                co_return v;
+            }
+            co_await ctx_->wait(next_);
+        }
+    }
+
+    std::optional<T> try_recv() {
+        bool closed = false;
+        return ctx_->try_read(next_, closed);
+    }
+
+    inline void select_watch(detail::SelectHook& h) { ctx_->select_watch(h, next_); }
+    inline void select_unwatch(detail::SelectHook& h) { ctx_->select_unwatch(h); }
+};
+
+/// 可拷贝, 最后一个Sender析构时关闭通道
+template <typename T, typename Context = detail::BroadcastContext<T>>
+class Sender {
+    std::shared_ptr<Context> ctx_;
+    std::shared_ptr<gsl::final_action<std::function<void()>>> closer_;
+
+public:
+    explicit Sender(std::shared_ptr<Context> ctx)
+      : ctx_(ctx)
+      , closer_(std::make_shared<gsl::final_action<std::function<void()>>>(
+            [ctx] { ctx->close(); })) {}
+
+    /// 不挂起, 缓冲写满后覆盖最旧的消息
+    ///
+    /// @return 当前的接收者个数
+    template <typename A>
+    inline std::size_t send(A&& a) {
+        return ctx_->send(std::forward<A>(a));
+    }
+
+    /// 新的接收者只收到订阅之后的消息
+    inline Receiver<T, Context> subscribe() const { return {ctx_, ctx_->tail()}; }
+
+    inline std::size_t capacity() const noexcept { return ctx_->capacity(); }
+};
+
+/// 广播通道, 每条消息只存一份, 大消息可用std::shared_ptr<const X>作为T避免读取时的拷贝
+///
+/// @param capacity 缓冲容量(向上取整到2的幂), 落后超过容量的接收者会收到lagged_error
+template <typename T>
+auto make(std::size_t capacity) {
+    using ctx_t = detail::BroadcastContext<T>;
+    auto ctx    = std::make_shared<ctx_t>(capacity);
+    return std::make_tuple(Sender<T, ctx_t>(ctx), Receiver<T, ctx_t>(ctx, 0));
+}
+
+}  // namespace broadcast
+
+namespace watch {
+
+template <typename T, typename Context = detail::WatchContext<T>>
+class Receiver {
+    std::shared_ptr<Context> ctx_;
+    std::uint64_t seen_;
+
+public:
+    Receiver(std::shared_ptr<Context> ctx, std::uint64_t seen)
+      : ctx_(std::move(ctx))
+      , seen_(seen) {}
+
+    /// 当前值, 并标记为已看到
+    T get() {
+        auto [v, version] = ctx_->get();
+        seen_             = version;
+        return v;
+    }
+
+    /// 挂起直到有未看到的新值, 并标记为已看到. 中间的多次send只通知一次
+    ///
+    /// @return 通道关闭且没有新值时返回false
+    /// @throw boost::system::system_error(operation_aborted) 等待被取消
+    net::awaitable<bool> changed() {
+        auto version = co_await ctx_->changed(seen_);
+        if (version) {
+            seen_ = *version;
+        }
+        co_return version.has_value();
+    }
+
+    /// Select返回后用get()取值
+    inline void select_watch(detail::SelectHook& h) { ctx_->select_watch(h, seen_); }
+    inline void select_unwatch(detail::SelectHook& h) { ctx_->select_unwatch(h); }
+};
+
+/// 可拷贝, 最后一个Sender析构时关闭通道
+template <typename T, typename Context = detail::WatchContext<T>>
+class Sender {
+    std::shared_ptr<Context> ctx_;
+    std::shared_ptr<gsl::final_action<std::function<void()>>> closer_;
+
+public:
+    explicit Sender(std::shared_ptr<Context> ctx)
+      : ctx_(ctx)
+      , closer_(std::make_shared<gsl::final_action<std::function<void()>>>(
+            [ctx] { ctx->close(); })) {}
+
+    template <typename A>
+    inline void send(A&& a) {
+        ctx_->send(std::forward<A>(a));
+    }
+
+    /// 新的接收者把当前值视为已看到
+    inline Receiver<T, Context> subscribe() const { return {ctx_, ctx_->version()}; }
+};
+
+/// 只保存最新值的通道
+///
+/// @param init 初值, 视为已被第一个接收者看到
+template <typename T, typename A>
+auto make(A&& init) {
+    using ctx_t = detail::WatchContext<T>;
+    auto ctx    = std::make_shared<ctx_t>(std::forward<A>(init));
+    return std::make_tuple(Sender<T, ctx_t>(ctx), Receiver<T, ctx_t>(ctx, 0));
+}
+
+}  // namespace watch
+
+}  // namespace chan
+}  // namespace cc
@@ -1,61 +1,192 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <deque>
 #include <functional>
+#include <iterator>
 #include <memory>
 #include <mutex>
+#include <optional>
+#include <thread>
 #include <tuple>
+#include <utility>
+#include <vector>
+#include <boost/core/noncopyable.hpp>
+#include <boost/system/system_error.hpp>
 #include <cc/asio/condvar.h>
 #include <cc/asio/helper.h>
+#include <cc/asio/select.h>
+#include <cc/asio/waiter.h>
 #include <gsl/gsl>
 
 namespace cc {
 namespace chan {
 
+/// 有界通道写满时的处理方式
+enum class overflow_e : std::uint8_t {
+    BLOCK,        // send挂起直到有空位, try_send返回false
+    DROP_OLDEST,  // 覆盖最旧的元素
+    DROP_NEWEST,  // 丢弃新元素
+};
+
 namespace detail {
 
-template <typename T,                               //
-          typename MutexPolicy        = NonMutex,   //
-          template <class> class Lock = LockGuard>  //
-struct mpsc_context_t {
-    MutexPolicy mtx_;
-    CondVar<MutexPolicy> cv_;
-    std::deque<T> queue_;
-    bool stopped_ = false;
+/// 无锁多生产者单消费者队列, 按段分配: 每段kBlockCap个槽位, 每kBlockCap次send才分配一次内存.
+///
+/// 生产者CAS推进tail_索引领取槽位, 领到段内最后一个槽位的生产者负责挂上下一段;
+/// 写完后置槽位的ready. 索引的第kBlockCap个值是哨兵, 表示正在换段, 不对应槽位.
+///
+/// 消费者挂起前先登记完成处理器再置parked_, 然后重新检查队列; 生产者入队后只有看到
+/// parked_才去交换它并唤醒, 消费者忙碌时send不碰任何锁.
+template <typename T>
+class mpsc_context_t : boost::noncopyable {
+    enum : std::size_t { kLap = 64, kBlockCap = kLap - 1 };
+
+    struct slot_t {
+        std::atomic<bool> ready{false};
+        std::optional<T> value;
+    };
+
+    struct block_t {
+        std::atomic<block_t*> next{nullptr};
+        std::array<slot_t, kBlockCap> slots;
+    };
+
+    // 生产者共享
+    alignas(64) std::atomic<std::size_t> tail_{0};
+    std::atomic<block_t*> tail_block_;
+
+    // 只有消费者访问
+    alignas(64) std::size_t head_ = 0;
+    block_t* head_block_;
+
+    std::atomic<bool> parked_{false};
+    std::atomic<bool> stopped_{false};
+    std::function<void()> waiter_;
+
+public:
+    mpsc_context_t() : tail_block_(new block_t), head_block_(tail_block_.load()) {}
+
+    ~mpsc_context_t() {
+        while (head_block_) {
+            delete std::exchange(head_block_, head_block_->next.load(std::memory_order_relaxed));
+        }
+    }
 
     template <typename A>
-    void send(A&& a) noexcept {
-        do {
-            Lock<MutexPolicy> _lck{mtx_};
-            queue_.emplace_back(std::forward<A>(a));
-        } while (0);
-        cv_.notify_all();
+    void send(A&& a) {
+        auto tail  = tail_.load(std::memory_order_acquire);
+        auto block = tail_block_.load(std::memory_order_acquire);
+        std::unique_ptr<block_t> next;
+        for (unsigned step = 0;; backoff(step)) {
+            auto offset = tail % kLap;
+            if (offset == kBlockCap) {
+                // 其他生产者正在挂下一段
+                tail  = tail_.load(std::memory_order_acquire);
+                block = tail_block_.load(std::memory_order_acquire);
+                continue;
+            }
+            if (offset + 1 == kBlockCap && !next) {
+                next = std::make_unique<block_t>();
+            }
+            if (!tail_.compare_exchange_weak(tail, tail + 1, std::memory_order_seq_cst,
+                                             std::memory_order_acquire)) {
+                block = tail_block_.load(std::memory_order_acquire);
+                continue;
+            }
+
+            if (offset + 1 == kBlockCap) {
+                auto* n = next.release();
+                tail_block_.store(n, std::memory_order_release);
+                tail_.fetch_add(1, std::memory_order_release);  // 跳过哨兵
+                block->next.store(n, std::memory_order_release);
+            }
+            auto& slot = block->slots[offset];
+            slot.value.emplace(std::forward<A>(a));
+            slot.ready.store(true, std::memory_order_release);
+            break;
+        }
+        wake();
     }
 
     void close() noexcept {
-        Lock<MutexPolicy> _lck{mtx_};
-        stopped_ = true;
-        cv_.notify_all();
+        stopped_.store(true, std::memory_order_seq_cst);
+        wake();
     }
 
+    /// 只能由一个消费者调用. 通道关闭且队列取空后返回空
     net::awaitable<std::deque<T>> recv() {
         std::deque<T> ret;
-        do {
-            Lock<MutexPolicy> _lck{mtx_};
-            if (!stopped_) {
-                if (queue_.size()) {
-                    ret = std::move(queue_);
-                    co_return ret;
-                }
-            } else {
+        for (;;) {
+            drain(ret);
+            if (!ret.empty() || stopped_.load(std::memory_order_acquire)) {
                 co_return ret;
             }
-        } while (0);
+            co_await park();
+        }
+    }
 
-        co_await cv_.wait();
-        Lock<MutexPolicy> _lck{mtx_};
-        ret = std::move(queue_);
-        co_return ret;
+private:
+    /// 先忙等, 之后让出CPU(等待的生产者可能被抢占了)
+    static inline void backoff(unsigned& step) {
+        if (step++ >= 16) {
+            std::this_thread::yield();
+        }
+    }
+
+    inline void wake() {
+        if (parked_.load(std::memory_order_seq_cst) &&
+            parked_.exchange(false, std::memory_order_acq_rel)) {
+            std::exchange(waiter_, nullptr)();
+        }
+    }
+
+    void drain(std::deque<T>& out) {
+        auto tail = tail_.load(std::memory_order_acquire);
+        while (head_ != tail) {
+            auto offset = head_ % kLap;
+            if (offset == kBlockCap) {
+                block_t* n = nullptr;
+                for (unsigned step = 0; !(n = head_block_->next.load(std::memory_order_acquire));
+                     backoff(step)) {
+                }
+                delete std::exchange(head_block_, n);
+                head_++;
+                continue;
+            }
+
+            auto& slot = head_block_->slots[offset];
+            for (unsigned step = 0; !slot.ready.load(std::memory_order_acquire); backoff(step)) {
+            }
+            out.emplace_back(std::move(*slot.value));
+            slot.value.reset();
+            head_++;
+        }
+    }
+
+    inline bool ready() const noexcept {
+        return head_ != tail_.load(std::memory_order_seq_cst) ||
+               stopped_.load(std::memory_order_seq_cst);
+    }
+
+    net::awaitable<void> park() {
+        co_await net::async_initiate<decltype(net::use_awaitable), void()>(
+            [this](auto handler) {
+                using handler_t = decltype(handler);
+                auto h          = std::make_shared<handler_t>(std::move(handler));
+                waiter_         = [h] { net::post(std::move(*h)); };
+                parked_.store(true, std::memory_order_seq_cst);
+
+                // 置位前入队的生产者看不到parked_, 这里自己检查; 与生产者抢exchange,
+                // 谁抢到谁唤醒
+                if (ready() && parked_.exchange(false, std::memory_order_acq_rel)) {
+                    std::exchange(waiter_, nullptr)();
+                }
+            },
+            net::use_awaitable);
     }
 };
 
@@ -102,6 +233,426 @@ public:
     }
 };
 
+
+/// 定长环形缓冲的多生产者单消费者通道
+///
+/// 等待者在通道的锁内检查条件并登记(async_initiate的发起函数里), 不会丢失唤醒;
+/// 唤醒时把完成处理器post回等待者自己的executor.
+template <typename T,                               //
+          typename MutexPolicy        = NonMutex,   //
+          template <class> class Lock = LockGuard>  //
+class BoundedContext : boost::noncopyable {
+    using waiter_t = std::function<void()>;
+
+    MutexPolicy mtx_;
+    std::vector<T> ring_;
+    std::size_t head_ = 0;
+    std::size_t size_ = 0;
+    const overflow_e policy_;
+    bool closed_           = false;
+    std::uint64_t dropped_ = 0;
+
+    waiter_t receiver_;
+    std::deque<waiter_t> senders_;
+    SelectHooks hooks_;
+
+public:
+    BoundedContext(std::size_t capacity, overflow_e policy)
+      : ring_(std::max<std::size_t>(capacity, 1))
+      , policy_(policy) {}
+
+    /// @return 元素是否进入了缓冲; 通道已关闭或按DROP_NEWEST丢弃时返回false
+    net::awaitable<bool> send(T v) {
+        for (;;) {
+            std::optional<bool> ok;
+            waiter_t wake;
+            do {
+                Lock<MutexPolicy> _lck{mtx_};
+                if (closed_) {
+                    co_return false;
+                }
+                if (size_ < ring_.size() || policy_ != overflow_e::BLOCK) {
+                    ok = push(std::move(v));
+                    std::swap(wake, receiver_);
+                    hooks_.fire_all();
+                }
+            } while (0);
+
+            if (ok) {
+                if (wake) {
+                    wake();
+                }
+                co_return *ok;
+            }
+            co_await wait([this] { return closed_ || size_ < ring_.size(); }, senders_);
+        }
+    }
+
+    /// 不挂起, 缓冲满且策略为BLOCK时返回false
+    bool try_send(T v) {
+        waiter_t wake;
+        bool ok = false;
+        do {
+            Lock<MutexPolicy> _lck{mtx_};
+            if (closed_ || (size_ == ring_.size() && policy_ == overflow_e::BLOCK)) {
+                return false;
+            }
+            ok = push(std::move(v));
+            std::swap(wake, receiver_);
+            hooks_.fire_all();
+        } while (0);
+        if (wake) {
+            wake();
+        }
+        return ok;
+    }
+
+    /// @return 通道关闭且缓冲为空时返回nullopt
+    net::awaitable<std::optional<T>> recv() {
+        for (;;) {
+            std::optional<T> r;
+            waiter_t wake;
+            do {
+                Lock<MutexPolicy> _lck{mtx_};
+                if (size_) {
+                    r    = pop();
+                    wake = take_sender();
+                } else if (closed_) {
+                    co_return r;
+                }
+            } while (0);
+
+            if (r) {
+                if (wake) {
+                    wake();
+                }
+                co_return r;
+            }
+            co_await wait([this] { return closed_ || size_ > 0; }, receiver_);
+        }
+    }
+
+    std::optional<T> try_recv() {
+        std::optional<T> r;
+        waiter_t wake;
+        do {
+            Lock<MutexPolicy> _lck{mtx_};
+            if (size_) {
+                r    = pop();
+                wake = take_sender();
+            }
+        } while (0);
+        if (wake) {
+            wake();
+        }
+        return r;
+    }
+
+    /// 等到至少一个元素后一次取出缓冲中的全部元素(追加到out)
+    ///
+    /// @return 取出的个数, 通道关闭且缓冲为空时返回0
+    net::awaitable<std::size_t> recv_many(std::vector<T>& out) {
+        for (;;) {
+            std::size_t n = 0;
+            std::deque<waiter_t> wake;
+            do {
+                Lock<MutexPolicy> _lck{mtx_};
+                n = size_;
+                while (size_) {
+                    out.emplace_back(pop());
+                }
+                if (n) {
+                    n < senders_.size() ? wake_n(wake, n) : std::swap(wake, senders_);
+                } else if (closed_) {
+                    co_return 0;
+                }
+            } while (0);
+
+            if (n) {
+                for (auto& fn : wake) {
+                    fn();
+                }
+                co_return n;
+            }
+            co_await wait([this] { return closed_ || size_ > 0; }, receiver_);
+        }
+    }
+
+    void close() noexcept {
+        waiter_t r;
+        std::deque<waiter_t> s;
+        do {
+            Lock<MutexPolicy> _lck{mtx_};
+            closed_ = true;
+            std::swap(r, receiver_);
+            std::swap(s, senders_);
+            hooks_.fire_all();
+        } while (0);
+        if (r) {
+            r();
+        }
+        for (auto& fn : s) {
+            fn();
+        }
+    }
+
+    std::size_t size() {
+        Lock<MutexPolicy> _lck{mtx_};
+        return size_;
+    }
+
+    inline std::size_t capacity() const noexcept { return ring_.size(); }
+
+    std::uint64_t dropped() {
+        Lock<MutexPolicy> _lck{mtx_};
+        return dropped_;
+    }
+
+    /// 供Select使用: 有元素或已关闭时立即触发, 否则登记到变为可读
+    void select_watch(SelectHook& h) {
+        bind_hook(h, this);
+        Lock<MutexPolicy> _lck{mtx_};
+        if (size_ || closed_) {
+            h.fire();
+        } else {
+            hooks_.push(h);
+        }
+    }
+
+    void select_unwatch(SelectHook& h) {
+        Lock<MutexPolicy> _lck{mtx_};
+        hooks_.erase(h);
+    }
+
+private:
+    // 以下在锁内调用
+    bool push(T&& v) {
+        if (size_ == ring_.size()) {
+            dropped_++;
+            if (policy_ == overflow_e::DROP_NEWEST) {
+                return false;
+            }
+            head_ = head_ + 1 == ring_.size() ? 0 : head_ + 1;  // DROP_OLDEST
+            size_--;
+        }
+        auto tail = head_ + size_;
+        if (tail >= ring_.size()) {
+            tail -= ring_.size();
+        }
+        ring_[tail] = std::move(v);
+        size_++;
+        return true;
+    }
+
+    T pop() {
+        T v   = std::move(ring_[head_]);
+        head_ = head_ + 1 == ring_.size() ? 0 : head_ + 1;
+        size_--;
+        return v;
+    }
+
+    waiter_t take_sender() {
+        waiter_t w;
+        if (!senders_.empty()) {
+            w = std::move(senders_.front());
+            senders_.pop_front();
+        }
+        return w;
+    }
+
+    void wake_n(std::deque<waiter_t>& out, std::size_t n) {
+        for (; n && !senders_.empty(); n--) {
+            out.emplace_back(std::move(senders_.front()));
+            senders_.pop_front();
+        }
+    }
+
+    static void add_waiter(waiter_t& slot, waiter_t w) { slot = std::move(w); }
+
+    static void add_waiter(std::deque<waiter_t>& slots, waiter_t w) {
+        slots.emplace_back(std::move(w));
+    }
+
+    /// 挂起直到ready()成立. ready()在锁内求值, 已成立时立即恢复
+    template <typename Ready, typename Slot>
+    net::awaitable<void> wait(Ready ready, Slot& slot) {
+        co_await net::async_initiate<decltype(net::use_awaitable), void()>(
+            [this, ready, &slot](auto handler) {
+                using handler_t = decltype(handler);
+                auto h          = std::make_shared<handler_t>(std::move(handler));
+                waiter_t w      = [h] { net::post(std::move(*h)); };
+                do {
+                    Lock<MutexPolicy> _lck{mtx_};
+                    if (!ready()) {
+                        add_waiter(slot, std::move(w));
+                        return;
+                    }
+                } while (0);
+                w();
+            },
+            net::use_awaitable);
+    }
+};
+
+/// 多生产者多消费者通道, 每个元素只交给一个消费者
+///
+/// 有消费者在等时send直接把元素交到队首等待者手里再唤醒它(FIFO), 一个元素只唤醒一个
+/// 消费者, 被唤醒的一定拿得到元素; 没有等待者时元素进队列.
+/// 等待可以取消: 只有在锁内赢得唤醒(WaitNode::claim)的等待者才会收到元素, 已被取消的
+/// 等待者被跳过, 元素留给下一个
+template <typename T,                                //
+          typename MutexPolicy        = std::mutex,  //
+          template <class> class Lock = LockGuard>   //
+class MpmcContext : public std::enable_shared_from_this<MpmcContext<T, MutexPolicy, Lock>>,
+                    boost::noncopyable {
+    /// 放在recv的协程帧里, count为max_n
+    struct waiter_t : cc::detail::WaitNode {
+        std::vector<T> items;
+    };
+
+    MutexPolicy mtx_;
+    std::deque<T> queue_;
+    cc::detail::WaitQueue waiters_;
+    bool closed_ = false;
+    SelectHooks hooks_;
+
+public:
+    /// @return 通道已关闭时返回false
+    template <typename A>
+    bool send(A&& a) {
+        cc::detail::WaitNode* w = nullptr;
+        do {
+            Lock<MutexPolicy> _lck{mtx_};
+            if (closed_) {
+                return false;
+            }
+            w = waiters_.pop_front();
+            if (!w) {
+                queue_.emplace_back(std::forward<A>(a));
+                hooks_.fire_all();
+                return true;
+            }
+            static_cast<waiter_t*>(w)->items.emplace_back(std::forward<A>(a));
+        } while (0);
+        w->resume();
+        return true;
+    }
+
+    void close() noexcept {
+        cc::detail::WaitNode* ws = nullptr;
+        do {
+            Lock<MutexPolicy> _lck{mtx_};
+            closed_ = true;
+            ws      = waiters_.take_all();
+            hooks_.fire_all();
+        } while (0);
+        cc::detail::WaitQueue::resume_all(ws);
+    }
+
+    /// 等到至少一个元素, 最多取max_n个. 等待节点放在协程帧里
+    ///
+    /// @return 通道关闭且队列为空时返回空
+    /// @throw boost::system::system_error(operation_aborted) 等待被取消, 没有取走元素
+    net::awaitable<std::vector<T>> recv(std::size_t max_n) {
+        auto self = this->shared_from_this();  // 下面的requeue可能在协程帧销毁时执行
+        waiter_t w;
+        w.count      = std::max<std::size_t>(max_n, 1);
+        auto enqueue = [this, &w](cc::detail::WaitNode&) {
+            Lock<MutexPolicy> _lck{mtx_};
+            if (queue_.empty() && !closed_) {
+                waiters_.push_back(w);
+                return true;
+            }
+            take(w.items, w.count);
+            return false;
+        };
+        // 交到手里之后协程没能恢复(executor已停止, 处理器被销毁)时放回队首, 再像send一样
+        // 交给其他等待者或触发Select
+        auto requeue = gsl::finally([this, &w] {
+            if (GSL_UNLIKELY(!w.items.empty())) {
+                cc::detail::WaitNode* ws = nullptr;
+                do {
+                    Lock<MutexPolicy> _lck{mtx_};
+                    queue_.insert(queue_.begin(), std::make_move_iterator(w.items.begin()),
+                                  std::make_move_iterator(w.items.end()));
+                    ws = hand_over();
+                } while (0);
+                cc::detail::WaitQueue::resume_all(ws);
+            }
+        });
+        co_await cc::detail::park<&MpmcContext::unlink>(w, this, enqueue);
+        if (GSL_UNLIKELY(w.cancelled)) {
+            throw boost::system::system_error(net::error::operation_aborted);
+        }
+        std::vector<T> ret = std::move(w.items);
+        co_return ret;
+    }
+
+    std::vector<T> try_recv(std::size_t max_n) {
+        std::vector<T> out;
+        Lock<MutexPolicy> _lck{mtx_};
+        take(out, max_n);
+        return out;
+    }
+
+    std::size_t size() {
+        Lock<MutexPolicy> _lck{mtx_};
+        return queue_.size();
+    }
+
+    /// 供Select使用: 队列非空或已关闭时立即触发, 否则登记到有元素入队
+    ///
+    /// 有recv在等时元素直接交给它, 不进队列, 也就不触发Select
+    void select_watch(SelectHook& h) {
+        bind_hook(h, this);
+        Lock<MutexPolicy> _lck{mtx_};
+        if (!queue_.empty() || closed_) {
+            h.fire();
+        } else {
+            hooks_.push(h);
+        }
+    }
+
+    void select_unwatch(SelectHook& h) {
+        Lock<MutexPolicy> _lck{mtx_};
+        hooks_.erase(h);
+    }
+
+private:
+    bool unlink(cc::detail::WaitNode& w) {
+        Lock<MutexPolicy> _lck{mtx_};
+        return waiters_.erase(w);
+    }
+
+    /// 需持有锁: 队列里的元素依次交给等待者, 还有剩余时触发Select
+    ///
+    /// @return 拿到元素的等待者, 以next串起, 在锁外用WaitQueue::resume_all恢复
+    cc::detail::WaitNode* hand_over() {
+        cc::detail::WaitNode* head = nullptr;
+        cc::detail::WaitNode* tail = nullptr;
+        while (!queue_.empty()) {
+            auto* n = waiters_.pop_front();
+            if (!n) {
+                hooks_.fire_all();
+                break;
+            }
+            take(static_cast<waiter_t*>(n)->items, n->count);
+            (tail ? tail->next : head) = n;
+            tail                       = n;
+        }
+        return head;
+    }
+
+    void take(std::vector<T>& out, std::size_t max_n) {
+        auto n = std::min(max_n, queue_.size());
+        out.reserve(n);
+        for (std::size_t i = 0; i < n; i++) {
+            out.emplace_back(std::move(queue_.front()));
+            queue_.pop_front();
+        }
+    }
+};
+
 }  // namespace detail
 
 namespace mpsc {
@@ -112,33 +663,159 @@ using Sender = std::shared_ptr<std::function<void(const T&)>>;
 template <typename T>
 using Receiver = std::unique_ptr<std::function<net::awaitable<std::deque<T>>()>>;
 
+/// @param threadsafe    保留参数, 队列本身无锁, 两种取值行为相同
 template <typename T, bool threadsafe = true>
 auto make() -> std::tuple<Sender<T>, Receiver<T>> {
-    using Sender   = Sender<T>;
-    using Receiver = Receiver<T>;
-#define MAKE_MPSC_IMPL(ctx)                                                                      \
-    do {                                                                                         \
-        auto defer =                                                                             \
-            std::make_shared<gsl::final_action<std::function<void()>>>([ctx] { ctx->close(); }); \
-        Sender sender0 = std::make_shared<typename Sender::element_type>(                        \
-            [ctx, defer](auto&& a) { ctx->send(std::forward<decltype(a)>(a)); });                \
-        Receiver receiver0 = std::make_unique<typename Receiver::element_type>(                  \
-            [ctx]() -> net::task<std::deque<T>> { co_return co_await ctx->recv(); });            \
-        return std::make_tuple(sender0, std::move(receiver0));                                   \
-    } while (0)
+    using ctx_t = detail::mpsc_context_t<T>;
+    auto ctx    = std::make_shared<ctx_t>();
+    auto defer =
+        std::make_shared<gsl::final_action<std::function<void()>>>([ctx] { ctx->close(); });
+    Sender<T> sender = std::make_shared<typename Sender<T>::element_type>(
+        [ctx, defer](auto&& a) { ctx->send(std::forward<decltype(a)>(a)); });
+    Receiver<T> receiver = std::make_unique<typename Receiver<T>::element_type>(
+        [ctx]() -> net::task<std::deque<T>> { co_return co_await ctx->recv(); });
+    return std::make_tuple(sender, std::move(receiver));
+}
 
-    if constexpr (threadsafe) {
-        using ctx_t = detail::mpsc_context_t<T, std::mutex>;
-        auto ctx    = std::make_shared<ctx_t>();
-        MAKE_MPSC_IMPL(ctx);
-    } else {
-        using ctx_t = detail::mpsc_context_t<T>;
-        auto ctx    = std::make_shared<ctx_t>();
-        MAKE_MPSC_IMPL(ctx);
+}  // namespace mpsc
+
+namespace bounded {
+
+/// 可拷贝, 最后一个Sender析构时关闭通道
+template <typename T, typename Context = detail::BoundedContext<T, std::mutex>>
+class Sender {
+    std::shared_ptr<Context> ctx_;
+    std::shared_ptr<gsl::final_action<std::function<void()>>> closer_;
+
+public:
+    explicit Sender(std::shared_ptr<Context> ctx)
+      : ctx_(ctx)
+      , closer_(std::make_shared<gsl::final_action<std::function<void()>>>(
+            [ctx] { ctx->close(); })) {}
+
+    /// 写满且策略为BLOCK时挂起
+    ///
+    /// @return 元素是否进入了缓冲
+    inline net::awaitable<bool> send(T v) { return ctx_->send(std::move(v)); }
+
+    inline bool try_send(T v) { return ctx_->try_send(std::move(v)); }
+
+    inline std::size_t size() const { return ctx_->size(); }
+    inline std::size_t capacity() const noexcept { return ctx_->capacity(); }
+
+    /// 按溢出策略丢弃的元素个数
+    inline std::uint64_t dropped() const { return ctx_->dropped(); }
+};
+
+/// 只能移动, 析构时关闭通道, 挂起中的send返回false
+template <typename T, typename Context = detail::BoundedContext<T, std::mutex>>
+class Receiver {
+    std::shared_ptr<Context> ctx_;
+
+public:
+    explicit Receiver(std::shared_ptr<Context> ctx) : ctx_(std::move(ctx)) {}
+    Receiver(const Receiver&)            = delete;
+    Receiver& operator=(const Receiver&) = delete;
+    Receiver(Receiver&&) noexcept = default;
+    Receiver& operator=(Receiver&&) noexcept = default;
+
+    ~Receiver() {
+        if (ctx_) {
+            ctx_->close();
+        }
+    }
+
+    inline net::awaitable<std::optional<T>> recv() { return ctx_->recv(); }
+    inline std::optional<T> try_recv() { return ctx_->try_recv(); }
+
+    inline net::awaitable<std::size_t> recv_many(std::vector<T>& out) {
+        return ctx_->recv_many(out);
     }
+
+    inline void select_watch(detail::SelectHook& h) { ctx_->select_watch(h); }
+    inline void select_unwatch(detail::SelectHook& h) { ctx_->select_unwatch(h); }
+
+    inline std::size_t size() const { return ctx_->size(); }
+    inline std::size_t capacity() const noexcept { return ctx_->capacity(); }
+};
+
+/// 有界通道
+///
+/// @param capacity 缓冲容量, 内存在创建时一次分配
+/// @param policy   写满时的处理方式
+template <typename T, bool threadsafe = true>
+auto make(std::size_t capacity, overflow_e policy = overflow_e::BLOCK) {
+    using ctx_t = std::conditional_t<threadsafe, detail::BoundedContext<T, std::mutex>,
+                                     detail::BoundedContext<T>>;
+    auto ctx    = std::make_shared<ctx_t>(capacity, policy);
+    return std::make_tuple(Sender<T, ctx_t>(ctx), Receiver<T, ctx_t>(ctx));
 }
 
-}  // namespace mpsc
+}  // namespace bounded
+
+namespace mpmc {
+
+/// 可拷贝, 最后一个Sender析构时关闭通道
+template <typename T, typename Context = detail::MpmcContext<T>>
+class Sender {
+    std::shared_ptr<Context> ctx_;
+    std::shared_ptr<gsl::final_action<std::function<void()>>> closer_;
+
+public:
+    explicit Sender(std::shared_ptr<Context> ctx)
+      : ctx_(ctx)
+      , closer_(std::make_shared<gsl::final_action<std::function<void()>>>(
+            [ctx] { ctx->close(); })) {}
+
+    /// 不挂起, 通道已关闭或Receiver都已析构时返回false
+    template <typename A>
+    inline bool send(A&& a) {
+        return ctx_->send(std::forward<A>(a));
+    }
+
+    inline std::size_t size() const { return ctx_->size(); }
+};
+
+/// 可拷贝, 每个消费者协程持有一份. 最后一个Receiver析构时关闭通道, 之后send返回false
+template <typename T, typename Context = detail::MpmcContext<T>>
+class Receiver {
+    std::shared_ptr<Context> ctx_;
+    std::shared_ptr<gsl::final_action<std::function<void()>>> closer_;
+
+public:
+    explicit Receiver(std::shared_ptr<Context> ctx)
+      : ctx_(ctx)
+      , closer_(std::make_shared<gsl::final_action<std::function<void()>>>(
+            [ctx] { ctx->close(); })) {}
+
+    /// @return 通道关闭且队列为空时返回nullopt
+    /// @throw boost::system::system_error(operation_aborted) 等待被取消
+    net::awaitable<std::optional<T>> recv() {
+        std::optional<T> ret;
+        auto items = co_await ctx_->recv(1);
+        if (!items.empty()) {
+            ret.emplace(std::move(items.front()));
+        }
+        co_return ret;
+    }
+
+    /// 批量接收, 等到至少一个元素后最多取max_n个
+    inline net::awaitable<std::vector<T>> recv(std::size_t max_n) { return ctx_->recv(max_n); }
+
+    inline std::vector<T> try_recv(std::size_t max_n = 1) { return ctx_->try_recv(max_n); }
+
+    inline void select_watch(detail::SelectHook& h) { ctx_->select_watch(h); }
+    inline void select_unwatch(detail::SelectHook& h) { ctx_->select_unwatch(h); }
+};
+
+template <typename T>
+auto make() {
+    using ctx_t = detail::MpmcContext<T>;
+    auto ctx    = std::make_shared<ctx_t>();
+    return std::make_tuple(Sender<T, ctx_t>(ctx), Receiver<T, ctx_t>(ctx));
+}
+
+}  // namespace mpmc
 
 namespace oneshot {
 
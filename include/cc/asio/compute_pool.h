@@ -0,0 +1,265 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <boost/asio.hpp>
+#include <boost/core/noncopyable.hpp>
+#include <cc/asio/helper.h>
+#include <cc/asio/pool.h>
+#include <cc/util.h>
+
+namespace cc {
+
+namespace detail {
+
+/// 只能移动的void()任务, 可以装下只能移动的完成处理器
+class ComputeTask {
+    struct base_t {
+        virtual ~base_t()  = default;
+        virtual void run() = 0;
+    };
+
+    template <typename Fn>
+    struct impl_t final : base_t {
+        Fn fn;
+        explicit impl_t(Fn&& f) : fn(std::move(f)) {}
+        void run() override { fn(); }
+    };
+
+    std::unique_ptr<base_t> impl_;
+
+public:
+    ComputeTask() = default;
+
+    template <typename Fn,
+              typename = std::enable_if_t<!std::is_same_v<std::decay_t<Fn>, ComputeTask>>>
+    ComputeTask(Fn&& f)  // NOLINT
+      : impl_(std::make_unique<impl_t<std::decay_t<Fn>>>(std::decay_t<Fn>(std::forward<Fn>(f)))) {}
+
+    inline explicit operator bool() const noexcept { return impl_ != nullptr; }
+    inline void operator()() { impl_->run(); }
+};
+
+}  // namespace detail
+
+/// 工作窃取线程池, 用于CPU密集或阻塞的任务(压缩, 大文档序列化, sqlite查询等),
+/// 不占用AsioPool的net#N线程
+///
+/// 每个工作线程一个双端队列: 池内提交的任务放进本线程队列的尾部, 本线程从尾部取(LIFO,
+/// 刚拆出的子任务数据还在缓存里), 空闲线程从别的队列头部窃取(FIFO, 偷走较大的任务).
+/// 池外提交的任务轮流放进各线程的队列. 线程没有任务时休眠, 提交时只在有线程休眠时才唤醒
+class ComputePool final : boost::noncopyable {
+    struct worker_t {
+        std::mutex mtx;
+        std::deque<detail::ComputeTask> tasks;
+    };
+
+public:
+    /// 默认的计算池, 线程数为hardware_concurrency()
+    static ComputePool& instance() {
+        static ComputePool cp;
+        return cp;
+    }
+
+    /// @param num 工作线程数
+    explicit ComputePool(int num = std::thread::hardware_concurrency()) {
+        num = std::max(num, 1);
+        workers_.reserve(num);
+        for (int i = 0; i < num; i++) {
+            workers_.emplace_back(std::make_unique<worker_t>());
+        }
+        threads_.reserve(num);
+        for (int i = 0; i < num; i++) {
+            threads_.emplace_back([this, i] { run_thread(static_cast<std::size_t>(i)); });
+        }
+    }
+
+    /// 等已提交的任务都执行完再返回
+    ~ComputePool() {
+        do {
+            std::unique_lock _lck{idle_mtx_};
+            stopped_ = true;
+        } while (0);
+        idle_cv_.notify_all();
+        for (auto& th : threads_) {
+            th.join();
+        }
+    }
+
+    /// 提交任务, 可在任意线程调用
+    template <typename Fn>
+    void post(Fn&& f) {
+        auto i = current_.pool == this ? current_.index
+                                       : next_.fetch_add(1, std::memory_order_relaxed) % size();
+        // 先计数再入队, 取走任务时的减一不会早于这里的加一
+        pending_.fetch_add(1, std::memory_order_seq_cst);
+        do {
+            std::unique_lock _lck{workers_[i]->mtx};
+            workers_[i]->tasks.emplace_back(std::forward<Fn>(f));
+        } while (0);
+        if (sleeping_.load(std::memory_order_seq_cst) > 0) {
+            // 加锁保证唤醒不会发生在休眠的线程检查条件和进入等待之间
+            do {
+                std::unique_lock _lck{idle_mtx_};
+            } while (0);
+            idle_cv_.notify_one();
+        }
+    }
+
+    /// 工作线程数
+    inline std::size_t size() const noexcept { return workers_.size(); }
+
+    /// 当前线程在本池中的下标, 不是本池的线程时返回-1
+    inline int current_index() const noexcept {
+        return current_.pool == this ? static_cast<int>(current_.index) : -1;
+    }
+
+private:
+    static inline void set_threadname(std::size_t index) {
+        char buf[32] = {0};
+        snprintf(buf, 32, "cpu#%zu", index + 1);
+        cc::set_threadname((const char*)buf);
+    }
+
+    void run_thread(std::size_t i) {
+        set_threadname(i);
+        current_ = {this, i};
+        std::size_t seed = i * 0x9E3779B97F4A7C15ULL + 1;
+        for (;;) {
+            detail::ComputeTask task;
+            if (pop_local(i, task) || steal(i, seed, task)) {
+                pending_.fetch_sub(1, std::memory_order_relaxed);
+                try {
+                    task();
+                } catch (std::exception& e) {
+                    fprintf(stderr, "Error in ComputePool: %s\n", e.what());
+                }
+                continue;
+            }
+
+            std::unique_lock _lck{idle_mtx_};
+            sleeping_.fetch_add(1, std::memory_order_seq_cst);
+            idle_cv_.wait(_lck, [this] {
+                return stopped_ || pending_.load(std::memory_order_seq_cst) > 0;
+            });
+            sleeping_.fetch_sub(1, std::memory_order_relaxed);
+            if (stopped_ && pending_.load(std::memory_order_relaxed) == 0) {
+                break;
+            }
+        }
+        current_ = {};
+    }
+
+    bool pop_local(std::size_t i, detail::ComputeTask& task) {
+        auto& w = *workers_[i];
+        std::unique_lock _lck{w.mtx};
+        if (w.tasks.empty()) {
+            return false;
+        }
+        task = std::move(w.tasks.back());
+        w.tasks.pop_back();
+        return true;
+    }
+
+    /// 从随机的一个线程开始依次尝试, 偷走队首的任务
+    bool steal(std::size_t i, std::size_t& seed, detail::ComputeTask& task) {
+        auto n = size();
+        if (n == 1) {
+            return false;
+        }
+        seed       = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        auto start = (seed >> 33) % n;
+        for (std::size_t k = 0; k < n; k++) {
+            auto v = (start + k) % n;
+            if (v == i) {
+                continue;
+            }
+            auto& w = *workers_[v];
+            std::unique_lock _lck{w.mtx};
+            if (!w.tasks.empty()) {
+                task = std::move(w.tasks.front());
+                w.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    static inline thread_local detail::pool_thread_t current_;
+
+    std::vector<std::unique_ptr<worker_t>> workers_;
+    std::vector<std::thread> threads_;
+    std::atomic<std::size_t> next_{0};
+    std::atomic<std::int64_t> pending_{0};  // 已提交未取走的任务数
+    std::atomic<int> sleeping_{0};
+
+    std::mutex idle_mtx_;
+    std::condition_variable idle_cv_;
+    bool stopped_ = false;
+};
+
+/// 在pool上执行f(args...), 完成后回到调用协程原来的executor. f抛出的异常在调用方重新抛出
+///
+/// 与schedule(ioc, f)相比, 任务进入工作窃取队列而不是另一个io_context, 池内线程之间
+/// 自动均衡; f和args按值保存在协程帧里
+template <typename Fn, typename... Args>
+net::awaitable<std::invoke_result_t<Fn&, Args&...>>  //
+offload(ComputePool& pool, Fn f, Args... args) {
+    using R = std::invoke_result_t<Fn&, Args&...>;
+    std::exception_ptr e;
+    std::conditional_t<std::is_void_v<R>, bool, std::optional<R>> r{};
+
+    auto run = [&] {
+        try {
+            if constexpr (std::is_void_v<R>) {
+                std::invoke(f, args...);
+            } else {
+                r.emplace(std::invoke(f, args...));
+            }
+        } catch (...) {
+            e = std::current_exception();
+        }
+    };
+    co_await net::async_initiate<decltype(net::use_awaitable), void()>(
+        [&pool, &run](auto handler) {
+            auto work = net::make_work_guard(handler);
+            pool.post([&run, handler = std::move(handler), work = std::move(work)]() mutable {
+                run();
+                auto ex = work.get_executor();
+                net::post(ex, std::move(handler));
+            });
+        },
+        net::use_awaitable);
+
+    if (GSL_UNLIKELY(e)) {
+        std::rethrow_exception(e);
+    }
+    if constexpr (!std::is_void_v<R>) {
+        co_return std::move(*r);
+    }
+}
+
+/// 在默认的ComputePool::instance()上执行f(args...)
+template <typename Fn, typename... Args>
+    requires std::is_invocable_v<Fn&, Args&...>
+net::awaitable<std::invoke_result_t<Fn&, Args&...>>  //
+offload(Fn f, Args... args) {
+    return offload(ComputePool::instance(), std::move(f), std::move(args)...);
+}
+
+}  // namespace cc
@@ -1,14 +1,13 @@
 #pragma once
 
-#include <functional>
-#include <memory>
-#include <vector>
+#include <cstddef>
+#include <limits>
 #include <boost/asio.hpp>
 #include <boost/asio/experimental/awaitable_operators.hpp>
 #include <boost/core/noncopyable.hpp>
 #include <cc/asio/helper.h>
+#include <cc/asio/waiter.h>
 #include <cc/util.h>
-#include <time.h>
 
 namespace cc {
 
@@ -19,76 +18,59 @@ template <
 >  // clang-format on
 class CondVar final : public boost::noncopyable {
     MutexPolicy mtx_;
-    std::vector<std::function<void()>> handles_;
+    detail::WakeQueue waiters_;
 
 public:
-    CondVar() { handles_.reserve(4); }
+    /// @param policy   notify_one/notify_n的唤醒顺序
+    explicit CondVar(wake_e policy = wake_e::FIFO) : waiters_(policy) {}
     ~CondVar() = default;
 
-    net::task<void> wait() {
-        using time_point                         = net::steady_timer::clock_type::time_point;
-        auto ctx                                 = co_await net::this_coro::executor;
-        std::shared_ptr<net::steady_timer> timer = std::make_shared<net::steady_timer>(ctx);
-        timer->expires_at(time_point::max());
-        std::weak_ptr<net::steady_timer> weak_timer(timer);
-        wait_impl([weak_timer] {
-            if (auto timer = weak_timer.lock()) {
-                timer->cancel();
-            }
-        });
-        co_await timer->async_wait(net::as_tuple(net::use_awaitable));
+    /// 等待节点放在协程帧里, 不分配内存; 支持取消(用于wait_until)
+    ///
+    /// @param priority 仅PRIORITY策略下有效, 0最高, 范围[0, 8)
+    net::task<void> wait(std::size_t priority = 0) {
+        auto enqueue = [this, priority](detail::WaitNode& n) {
+            WriterLock<MutexPolicy> _lck{mtx_};
+            waiters_.push(n, priority);
+            return true;
+        };
+        detail::WaitNode node;
+        co_await detail::park<&CondVar::unlink>(node, this, enqueue);
     }
 
-    net::task<bool> wait_until(int timeout) {
+    /// @return 是否超时
+    net::task<bool> wait_until(int timeout, std::size_t priority = 0) {
         using namespace net::experimental::awaitable_operators;
-        auto ctx = co_await net::this_coro::executor;
-        auto v   = co_await (cc::async_sleep(timeout) || wait());
+        auto v = co_await (cc::async_sleep(timeout) || wait(priority));
         co_return v.index() == 0;
     }
 
-    void notify_all() noexcept {
-        std::vector<std::function<void()>> handles;
-        {
-            WriterLock<MutexPolicy> _lck{mtx_};
-            handles = std::move(handles_);
-        }
-        for (const auto& fn : handles) {
-            try {
-                fn();
-            } catch (...) {
-                // ignore
-            }
-        }
-    }
+    inline void notify_all() noexcept { notify_n(std::numeric_limits<std::size_t>::max()); }
+
+    inline void notify_one() noexcept { notify_n(1); }
 
-    void notify_one() noexcept {
-        std::function<void()> f = nullptr;
+    /// 按唤醒策略唤醒至多n个等待者
+    ///
+    /// @return 实际唤醒的个数
+    std::size_t notify_n(std::size_t n) noexcept {
+        detail::WaitNode* head = nullptr;
         do {
             WriterLock<MutexPolicy> _lck{mtx_};
-            if (handles_.size() > 0) {
-                int offset = random(handles_.size());
-                auto it    = handles_.begin();
-                std::advance(it, offset);
-                f = std::move(*it);
-                handles_.erase(it);
-            }
+            head = waiters_.take(n);
         } while (0);
-        try {
-            if (f) f();
-        } catch (...) {
-            // ignore
+        std::size_t woken = 0;
+        for (auto* w = head; w; w = w->next) {
+            woken++;
         }
+        detail::WaitQueue::resume_all(head);
+        return woken;
     }
 
 private:
-    template <typename Callback>
-    void wait_impl(Callback&& cb) {
+    bool unlink(detail::WaitNode& n) {
         WriterLock<MutexPolicy> _lck{mtx_};
-        handles_.emplace_back(std::forward<Callback>(cb));
+        return waiters_.erase(n);
     }
-
-    /// @return [0, m)
-    static inline int random(int m) { return time(NULL) / m; }
 };
 
 }  // namespace cc
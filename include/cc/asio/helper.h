@@ -1,6 +1,8 @@
 #pragma once
 
+#include <cstddef>
 #include <exception>
+#include <stdexcept>
 #include <boost/asio.hpp>
 #include <cc/type_traits.h>
 #include <gsl/gsl>
@@ -68,6 +70,56 @@ timeout(int ms) {
     co_return co_await async_sleep(ms);
 }
 
+#ifdef SO_REUSEPORT
+
+/// SO_REUSEPORT套接字选项, 用法同net::socket_base::reuse_address:
+/// acceptor.set_option(cc::reuse_port(true))
+class reuse_port {
+public:
+    reuse_port() = default;
+    explicit reuse_port(bool v) : value_(v ? 1 : 0) {}
+
+    inline bool value() const noexcept { return value_ != 0; }
+    explicit operator bool() const noexcept { return value(); }
+
+    template <typename Protocol>
+    int level(const Protocol&) const noexcept {
+        return SOL_SOCKET;
+    }
+
+    template <typename Protocol>
+    int name(const Protocol&) const noexcept {
+        return SO_REUSEPORT;
+    }
+
+    template <typename Protocol>
+    int* data(const Protocol&) noexcept {
+        return &value_;
+    }
+
+    template <typename Protocol>
+    const int* data(const Protocol&) const noexcept {
+        return &value_;
+    }
+
+    template <typename Protocol>
+    std::size_t size(const Protocol&) const noexcept {
+        return sizeof(value_);
+    }
+
+    template <typename Protocol>
+    void resize(const Protocol&, std::size_t s) {
+        if (s != sizeof(value_)) {
+            throw std::length_error("reuse_port socket option resize");
+        }
+    }
+
+private:
+    int value_ = 0;
+};
+
+#endif
+
 /// 在ioc上调度程序f(args...)
 /// 从当前executor上，切换到ioc执行f，然后再且回到当前executor
 ///
@@ -0,0 +1,341 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/asio.hpp>
+#include <boost/core/noncopyable.hpp>
+#include <boost/stacktrace.hpp>
+#include <cc/latency_histogram.h>
+#include <cc/stopwatch.h>
+#include <gsl/gsl>
+
+#ifdef __linux__
+#    include <pthread.h>
+#    include <signal.h>
+#endif
+
+namespace cc {
+
+/// AsioPool::enable_monitor的参数
+struct monitor_option_t {
+    int lag_interval_ms  = 100;  // 事件循环延迟探针的周期, 小于等于0时不探测
+    int slow_handler_ms  = 0;    // 处理器执行超过此时长时记录, 小于等于0时关闭
+    std::size_t slow_log = 32;   // 保留最近的慢处理器记录数
+    int signal           = 0;    // 抓取调用栈用的信号, 0表示SIGRTMIN+3. 仅Linux抓取调用栈
+};
+
+/// 一次慢处理器记录
+struct slow_handler_t {
+    std::size_t thread;                          // 线程下标, net#N的N-1
+    std::int64_t duration_ns;                    // 执行时长
+    std::chrono::system_clock::time_point when;  // 结束时刻
+    std::string stacktrace;                      // 执行中抓到的调用栈, 没抓到时为空
+};
+
+/// AsioPool::loop_stats的结果, 时长单位ns
+struct loop_stats_t {
+    struct shard_t {
+        LatencyHistogram::snapshot_t lag;  // 延迟探针: 定时器实际触发与预期的差
+    };
+
+    struct thread_t {
+        std::size_t shard;
+        std::uint64_t handlers;             // 执行过的处理器数
+        std::int64_t busy_ns;               // 当前处理器已执行的时长, 空闲时为0
+        LatencyHistogram::snapshot_t exec;  // 处理器执行时间
+    };
+
+    std::vector<shard_t> shards;
+    std::vector<thread_t> threads;
+    std::vector<slow_handler_t> slow;  // 从旧到新
+};
+
+namespace detail {
+
+/// run()中一个线程的监测状态
+struct loop_thread_t : boost::noncopyable {
+    enum dump_e : int { kIdle, kRequested, kReady };
+
+    std::size_t shard = 0;
+    std::atomic<std::int64_t> started{0};  // 当前处理器开始的TscClock时刻, 0表示空闲
+    std::atomic<std::uint64_t> handlers{0};
+    LatencyHistogram exec;
+
+#ifdef __linux__
+    std::atomic<bool> attached{false};
+    pthread_t tid{};
+#endif
+
+    // 看门狗发信号, 线程在信号处理函数里把调用栈写进dump
+    std::atomic<int> dump_state{kIdle};
+    std::atomic<std::int64_t> dump_for{0};  // 只抓started为此值的处理器
+    alignas(void*) std::array<unsigned char, 4096> dump{};
+
+    // 看门狗抓到调用栈时处理器还没结束, 先放在这里等finish()取走. 由slow_mtx_保护
+    std::int64_t captured_for = 0;  // 抓到的调用栈属于started为此值的处理器
+    std::string captured;
+};
+
+/// AsioPool的事件循环监测: 每个分片的延迟探针直方图, 每个线程的处理器执行时间直方图,
+/// 以及可选的慢处理器看门狗
+///
+/// 开启后线程用poll_one逐个执行处理器并计时. 空闲时用run_one等待, 唤醒后执行的第一个
+/// 处理器的时长含等待, 只计数不计时; 繁忙时(正是需要关注的时候)每个处理器都计时.
+/// 看门狗发现某个线程的处理器执行超过阈值时向它发信号, 由该线程在信号处理函数里
+/// 用boost::stacktrace::safe_dump_to保存调用栈. 记录和调用栈都以处理器的开始时刻为键,
+/// 处理器先结束时看门狗把调用栈补进已有的记录, 否则留给finish()取走
+///
+/// 每个处理器多两次读时钟和逐个poll_one的开销, 约几十ns, 对空处理器的post链明显,
+/// 对实际的I/O处理器可以忽略
+class LoopMonitor : boost::noncopyable {
+public:
+    LoopMonitor(const monitor_option_t& opt, std::size_t shards, std::size_t threads)
+      : opt_(opt)
+      , slow_ns_(static_cast<std::int64_t>(opt.slow_handler_ms) * 1000000) {
+        lag_.reserve(shards);
+        for (std::size_t i = 0; i < shards; i++) {
+            lag_.emplace_back(std::make_unique<LatencyHistogram>());
+        }
+        threads_.reserve(threads);
+        for (std::size_t i = 0; i < threads; i++) {
+            threads_.emplace_back(std::make_unique<loop_thread_t>());
+            threads_.back()->shard = shards == 1 ? 0 : i;  // 共用模式下都在分片0
+        }
+    }
+
+    ~LoopMonitor() { stop(); }
+
+    inline const monitor_option_t& option() const noexcept { return opt_; }
+
+    /// 启动慢处理器看门狗, 未设置slow_handler_ms时什么也不做
+    void start() {
+        if (slow_ns_ <= 0 || watchdog_.joinable()) {
+            return;
+        }
+#ifdef __linux__
+        signal_ = opt_.signal > 0 ? opt_.signal : SIGRTMIN + 3;
+        install_signal(signal_);
+#endif
+        watchdog_ = std::thread([this] { watch(); });
+    }
+
+    void stop() {
+        do {
+            std::unique_lock _lck{watch_mtx_};
+            stopped_ = true;
+        } while (0);
+        watch_cv_.notify_all();
+        if (watchdog_.joinable()) {
+            watchdog_.join();
+        }
+    }
+
+    /// 第i个线程运行它的io_context, 直到它停止
+    void run(boost::asio::io_context& ctx, std::size_t i) {
+        auto& t = *threads_[i];
+        attach(t);
+        for (;;) {
+            t.started.store(TscClock::now(), std::memory_order_relaxed);
+            if (ctx.poll_one()) {
+                finish(i, t);
+                continue;
+            }
+            t.started.store(0, std::memory_order_relaxed);
+            if (ctx.stopped() || ctx.run_one() == 0) {
+                break;
+            }
+            t.handlers.fetch_add(1, std::memory_order_relaxed);
+        }
+        detach(t);
+    }
+
+    inline void record_lag(std::size_t shard, std::int64_t ns) { lag_[shard]->record(ns); }
+
+    loop_stats_t stats() const {
+        loop_stats_t r;
+        r.shards.reserve(lag_.size());
+        for (auto& h : lag_) {
+            r.shards.push_back({h->snapshot()});
+        }
+        auto now = TscClock::now();
+        r.threads.reserve(threads_.size());
+        for (auto& t : threads_) {
+            auto started = t->started.load(std::memory_order_relaxed);
+            r.threads.push_back({t->shard, t->handlers.load(std::memory_order_relaxed),
+                                 started ? TscClock::to_ns(now - started) : 0,
+                                 t->exec.snapshot()});
+        }
+        std::unique_lock _lck{slow_mtx_};
+        r.slow.reserve(slow_.size());
+        for (auto& s : slow_) {
+            r.slow.push_back(s.record);
+        }
+        return r;
+    }
+
+private:
+    static inline thread_local loop_thread_t* current_ = nullptr;
+
+    void attach(loop_thread_t& t) {
+        current_ = &t;
+#ifdef __linux__
+        t.tid = pthread_self();
+        t.attached.store(true, std::memory_order_release);
+#endif
+    }
+
+    void detach(loop_thread_t& t) {
+#ifdef __linux__
+        t.attached.store(false, std::memory_order_release);
+#endif
+        t.started.store(0, std::memory_order_relaxed);
+        current_ = nullptr;
+    }
+
+    void finish(std::size_t i, loop_thread_t& t) {
+        auto start = t.started.exchange(0, std::memory_order_relaxed);
+        auto ns    = TscClock::to_ns(TscClock::now() - start);
+        t.exec.record(ns);
+        t.handlers.fetch_add(1, std::memory_order_relaxed);
+        if (GSL_UNLIKELY(slow_ns_ > 0 && ns >= slow_ns_)) {
+            std::string stack;
+            std::unique_lock _lck{slow_mtx_};
+            if (t.captured_for == start) {
+                stack          = std::move(t.captured);
+                t.captured_for = 0;
+            }
+            slow_.push_back(
+                {start, {i, ns, std::chrono::system_clock::now(), std::move(stack)}});
+            while (slow_.size() > opt_.slow_log) {
+                slow_.pop_front();
+            }
+        }
+    }
+
+    /// 每隔阈值的1/4检查一次, 每个超时的处理器只抓一次调用栈
+    void watch() {
+        auto period = std::chrono::microseconds(std::max<std::int64_t>(slow_ns_ / 4000, 1000));
+        std::vector<std::int64_t> dumped(threads_.size(), 0);
+        std::unique_lock _lck{watch_mtx_};
+        while (!watch_cv_.wait_for(_lck, period, [this] { return stopped_; })) {
+            auto now = TscClock::now();
+            for (std::size_t i = 0; i < threads_.size(); i++) {
+                auto& t      = *threads_[i];
+                auto started = t.started.load(std::memory_order_relaxed);
+                if (started && started != dumped[i]
+                    && TscClock::to_ns(now - started) >= slow_ns_) {
+                    dumped[i] = started;
+                    capture(i, t, started);
+                }
+            }
+        }
+    }
+
+    void capture(std::size_t i, loop_thread_t& t, std::int64_t started) {
+#ifdef __linux__
+        if (!t.attached.load(std::memory_order_acquire)) {
+            return;
+        }
+        t.dump_for.store(started, std::memory_order_relaxed);
+        t.dump_state.store(loop_thread_t::kRequested, std::memory_order_release);
+        if (pthread_kill(t.tid, signal_) != 0) {
+            t.dump_state.store(loop_thread_t::kIdle, std::memory_order_relaxed);
+            return;
+        }
+        // 信号处理函数只做safe_dump_to, 很快; 等不到(如线程在屏蔽信号)或处理器已结束就放弃
+        for (int k = 0; k < 100; k++) {
+            auto state = t.dump_state.load(std::memory_order_acquire);
+            if (state == loop_thread_t::kReady) {
+                auto st = boost::stacktrace::stacktrace::from_dump(t.dump.data(), t.dump.size());
+                publish(i, t, started, boost::stacktrace::to_string(st));
+                break;
+            }
+            if (state == loop_thread_t::kIdle) {
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+        t.dump_state.store(loop_thread_t::kIdle, std::memory_order_release);
+#else
+        (void)i;
+        (void)t;
+        (void)started;
+#endif
+    }
+
+    /// 处理器已经结束时补进它的记录, 否则留给finish()
+    void publish(std::size_t i, loop_thread_t& t, std::int64_t started, std::string stack) {
+        std::unique_lock _lck{slow_mtx_};
+        for (auto it = slow_.rbegin(); it != slow_.rend(); ++it) {
+            if (it->started == started && it->record.thread == i) {
+                it->record.stacktrace = std::move(stack);
+                return;
+            }
+        }
+        t.captured_for = started;
+        t.captured     = std::move(stack);
+    }
+
+#ifdef __linux__
+    static void on_signal(int) {
+        auto* t = current_;
+        if (!t || t->dump_state.load(std::memory_order_acquire) != loop_thread_t::kRequested) {
+            return;
+        }
+        // 信号到达前处理器已经结束, 不要把之后的调用栈算到它头上
+        if (t->started.load(std::memory_order_relaxed)
+            != t->dump_for.load(std::memory_order_relaxed)) {
+            t->dump_state.store(loop_thread_t::kIdle, std::memory_order_release);
+            return;
+        }
+        boost::stacktrace::safe_dump_to(t->dump.data(), t->dump.size());
+        t->dump_state.store(loop_thread_t::kReady, std::memory_order_release);
+    }
+
+    static void install_signal(int sig) {
+        static std::once_flag flag;
+        std::call_once(flag, [sig] {
+            struct sigaction sa {};
+            sa.sa_handler = &LoopMonitor::on_signal;
+            sa.sa_flags   = SA_RESTART;
+            sigemptyset(&sa.sa_mask);
+            sigaction(sig, &sa, nullptr);
+        });
+    }
+
+    int signal_ = 0;
+#endif
+
+private:
+    const monitor_option_t opt_;
+    const std::int64_t slow_ns_;
+    std::vector<std::unique_ptr<LatencyHistogram>> lag_;
+    std::vector<std::unique_ptr<loop_thread_t>> threads_;
+
+    struct slow_entry_t {
+        std::int64_t started;  // 处理器的开始时刻, 看门狗据此补上调用栈
+        slow_handler_t record;
+    };
+
+    mutable std::mutex slow_mtx_;
+    std::deque<slow_entry_t> slow_;  // 还保护各线程的captured
+
+    std::mutex watch_mtx_;
+    std::condition_variable watch_cv_;
+    bool stopped_ = false;
+    std::thread watchdog_;
+};
+
+}  // namespace detail
+}  // namespace cc
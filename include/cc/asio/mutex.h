@@ -0,0 +1,301 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <boost/asio.hpp>
+#include <boost/core/noncopyable.hpp>
+#include <boost/system/system_error.hpp>
+#include <cc/asio/helper.h>
+#include <cc/asio/waiter.h>
+#include <cc/util.h>
+
+namespace cc {
+
+namespace detail {
+
+/// 持有一把协程锁, 析构时解锁. 只能移动, 默认构造的为空
+template <typename Mutex, bool Shared = false>
+class [[nodiscard]] AsyncLockGuard {
+    Mutex* mtx_ = nullptr;
+
+public:
+    AsyncLockGuard() = default;
+    explicit AsyncLockGuard(Mutex* mtx) : mtx_(mtx) {}
+    AsyncLockGuard(const AsyncLockGuard&)            = delete;
+    AsyncLockGuard& operator=(const AsyncLockGuard&) = delete;
+
+    AsyncLockGuard(AsyncLockGuard&& o) noexcept : mtx_(std::exchange(o.mtx_, nullptr)) {}
+
+    AsyncLockGuard& operator=(AsyncLockGuard&& o) noexcept {
+        if (this != &o) {
+            unlock();
+            mtx_ = std::exchange(o.mtx_, nullptr);
+        }
+        return *this;
+    }
+
+    ~AsyncLockGuard() { unlock(); }
+
+    inline explicit operator bool() const noexcept { return mtx_ != nullptr; }
+
+    /// 提前解锁
+    void unlock() {
+        if (auto* m = std::exchange(mtx_, nullptr)) {
+            if constexpr (Shared) {
+                m->unlock_shared();
+            } else {
+                m->unlock();
+            }
+        }
+    }
+
+    /// 放弃所有权, 之后由调用方解锁
+    void detach() noexcept { mtx_ = nullptr; }
+};
+
+}  // namespace detail
+
+/// 协程互斥锁: 拿不到锁时挂起协程而不是阻塞线程, 可以跨co_await持有.
+/// 等待者按FIFO获得锁, 解锁时直接把所有权交给队首, 不会被新来的插队
+///
+/// 也满足Lockable的try_lock/unlock, 可配合std::unique_lock(m, std::try_to_lock)或
+/// co_await async_lock()之后的std::unique_lock(m, std::adopt_lock)使用.
+/// 没有同步的lock(), 避免在协程里误用而阻塞线程
+template <typename MutexPolicy = NonMutex, template <class> class WriterLock = LockGuard>
+class AsyncMutex final : public boost::noncopyable {
+public:
+    using Guard = detail::AsyncLockGuard<AsyncMutex>;
+
+    /// @throw boost::system::system_error(operation_aborted) 等待被取消, 未拿到锁
+    net::awaitable<void> async_lock() {
+        if (try_lock()) {
+            co_return;
+        }
+
+        auto enqueue = [this](detail::WaitNode& w) {
+            WriterLock<MutexPolicy> _lck{mtx_};
+            if (!locked_) {
+                locked_ = true;
+                return false;
+            }
+            waiters_.push_back(w);
+            return true;
+        };
+        detail::WaitNode node;
+        co_await detail::park<&AsyncMutex::unlink>(node, this, enqueue);
+        if (GSL_UNLIKELY(node.cancelled)) {
+            throw boost::system::system_error(net::error::operation_aborted);
+        }
+    }
+
+    /// co_await m.guard() 加锁, 离开作用域时解锁
+    net::awaitable<Guard> guard() {
+        if (!try_lock()) {
+            co_await async_lock();
+        }
+        co_return Guard(this);
+    }
+
+    bool try_lock() {
+        WriterLock<MutexPolicy> _lck{mtx_};
+        if (locked_) {
+            return false;
+        }
+        locked_ = true;
+        return true;
+    }
+
+    /// 有等待者时锁直接转交给队首, 在锁外恢复它
+    void unlock() {
+        detail::WaitNode* next = nullptr;
+        do {
+            WriterLock<MutexPolicy> _lck{mtx_};
+            next = waiters_.pop_front();
+            if (!next) {
+                locked_ = false;
+            }
+        } while (0);
+        if (next) {
+            next->resume();
+        }
+    }
+
+private:
+    bool unlink(detail::WaitNode& w) {
+        WriterLock<MutexPolicy> _lck{mtx_};
+        return waiters_.erase(w);
+    }
+
+private:
+    MutexPolicy mtx_;
+    bool locked_ = false;
+    detail::WaitQueue waiters_;
+};
+
+/// 协程读写锁, 写优先: 有写者排队时新来的读者也要排队, 写者不会被源源不断的读者饿死.
+/// 写者解锁时排队的读者整批放行(一次加锁, 锁外逐个恢复), 之后才轮到下一个写者,
+/// 读多写多时两边都不会饿死
+///
+/// 同AsyncMutex, 满足SharedLockable的try_lock/unlock/try_lock_shared/unlock_shared,
+/// 但没有同步的lock()/lock_shared()
+template <typename MutexPolicy = NonMutex, template <class> class WriterLock = LockGuard>
+class AsyncSharedMutex final : public boost::noncopyable {
+public:
+    using Guard       = detail::AsyncLockGuard<AsyncSharedMutex>;
+    using SharedGuard = detail::AsyncLockGuard<AsyncSharedMutex, true>;
+
+    /// 加写锁
+    /// @throw boost::system::system_error(operation_aborted) 等待被取消, 未拿到锁
+    net::awaitable<void> async_lock() {
+        if (try_lock()) {
+            co_return;
+        }
+
+        auto enqueue = [this](detail::WaitNode& w) {
+            WriterLock<MutexPolicy> _lck{mtx_};
+            if (!writer_ && readers_ == 0) {
+                writer_ = true;
+                return false;
+            }
+            writers_.push_back(w);
+            return true;
+        };
+        detail::WaitNode node;
+        co_await detail::park<&AsyncSharedMutex::unlink_writer>(node, this, enqueue);
+        if (GSL_UNLIKELY(node.cancelled)) {
+            throw boost::system::system_error(net::error::operation_aborted);
+        }
+    }
+
+    /// 加读锁
+    /// @throw boost::system::system_error(operation_aborted) 等待被取消, 未拿到锁
+    net::awaitable<void> async_lock_shared() {
+        if (try_lock_shared()) {
+            co_return;
+        }
+
+        auto enqueue = [this](detail::WaitNode& w) {
+            WriterLock<MutexPolicy> _lck{mtx_};
+            if (!writer_ && writers_.empty()) {
+                readers_++;
+                return false;
+            }
+            readers_waiting_.push_back(w);
+            return true;
+        };
+        detail::WaitNode node;
+        co_await detail::park<&AsyncSharedMutex::unlink_reader>(node, this, enqueue);
+        if (GSL_UNLIKELY(node.cancelled)) {
+            throw boost::system::system_error(net::error::operation_aborted);
+        }
+    }
+
+    net::awaitable<Guard> guard() {
+        if (!try_lock()) {
+            co_await async_lock();
+        }
+        co_return Guard(this);
+    }
+
+    net::awaitable<SharedGuard> shared_guard() {
+        if (!try_lock_shared()) {
+            co_await async_lock_shared();
+        }
+        co_return SharedGuard(this);
+    }
+
+    bool try_lock() {
+        WriterLock<MutexPolicy> _lck{mtx_};
+        if (writer_ || readers_ > 0) {
+            return false;
+        }
+        writer_ = true;
+        return true;
+    }
+
+    /// 有写者排队时返回false
+    bool try_lock_shared() {
+        WriterLock<MutexPolicy> _lck{mtx_};
+        if (writer_ || !writers_.empty()) {
+            return false;
+        }
+        readers_++;
+        return true;
+    }
+
+    /// 解写锁: 有读者排队时整批放行, 否则交给下一个写者
+    void unlock() {
+        detail::WaitNode* woken = nullptr;
+        do {
+            WriterLock<MutexPolicy> _lck{mtx_};
+            writer_ = false;
+            woken   = grant_readers();
+            if (!woken) {
+                woken = grant_writer();
+            }
+        } while (0);
+        detail::WaitQueue::resume_all(woken);
+    }
+
+    /// 解读锁: 最后一个读者离开时交给排队的写者
+    void unlock_shared() {
+        detail::WaitNode* woken = nullptr;
+        do {
+            WriterLock<MutexPolicy> _lck{mtx_};
+            if (--readers_ == 0) {
+                // 排队的写者都已被取消时, 放行被它们挡住的读者
+                woken = grant_writer();
+                if (!woken) {
+                    woken = grant_readers();
+                }
+            }
+        } while (0);
+        detail::WaitQueue::resume_all(woken);
+    }
+
+private:
+    detail::WaitNode* grant_writer() noexcept {
+        auto* w = writers_.pop_front();
+        if (w) {
+            writer_ = true;
+        }
+        return w;
+    }
+
+    detail::WaitNode* grant_readers() noexcept {
+        auto* head = readers_waiting_.take_all();
+        for (auto* w = head; w; w = w->next) {
+            readers_++;
+        }
+        return head;
+    }
+
+    bool unlink_reader(detail::WaitNode& w) {
+        WriterLock<MutexPolicy> _lck{mtx_};
+        return readers_waiting_.erase(w);
+    }
+
+    /// 最后一个排队的写者放弃时, 被它挡住的读者可以进来了
+    bool unlink_writer(detail::WaitNode& w) {
+        detail::WaitNode* woken = nullptr;
+        bool erased             = false;
+        do {
+            WriterLock<MutexPolicy> _lck{mtx_};
+            erased = writers_.erase(w);
+            if (!writer_ && writers_.empty()) {
+                woken = grant_readers();
+            }
+        } while (0);
+        detail::WaitQueue::resume_all(woken);
+        return erased;
+    }
+
+private:
+    MutexPolicy mtx_;
+    bool writer_         = false;
+    std::size_t readers_ = 0;  // 持有读锁的数量
+    detail::WaitQueue writers_;
+    detail::WaitQueue readers_waiting_;
+};
+
+}  // namespace cc
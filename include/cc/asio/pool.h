@@ -1,10 +1,13 @@
 #pragma once
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <thread>
@@ -12,6 +15,10 @@
 #include <vector>
 #include <boost/asio.hpp>
 #include <boost/core/noncopyable.hpp>
+#include <cc/affinity.h>
+#include <cc/asio/loop_monitor.h>
+#include <cc/asio/timer_wheel.h>
+#include <cc/metrics.h>
 #include <cc/util.h>
 #include <stddef.h>
 #include <stdio.h>
@@ -52,14 +59,122 @@ private:
     std::chrono::milliseconds interval_;
     Callback callback_;
 };
+
+inline metrics::Counter& asio_handlers_total() {
+    static auto& c = metrics::Registry::instance().counter("cc_asio_handlers_total",
+                                                           "Handlers submitted to AsioPool");
+    return c;
+}
+
+/// 当前线程属于哪个AsioPool的哪个分片
+struct pool_thread_t {
+    const void* pool  = nullptr;
+    std::size_t index = 0;
+};
+
+}  // namespace detail
+
+/// 分片模式下新任务分配到哪个io_context
+enum class placement_e : std::uint8_t {
+    ROUND_ROBIN,   // 轮流
+    LEAST_LOADED,  // 随机取两个分片, 选事件循环延迟较小的
+};
+
+/// 分片模式的构造参数, 见AsioPool(sharded_t, ...)
+struct sharded_t {};
+inline constexpr sharded_t sharded{};
+
+/// 线程绑核方式
+enum class affinity_e : std::uint8_t {
+    NONE,       // 不绑定, 由系统调度
+    CPU,        // 每个线程绑一个CPU, 按NUMA节点依次排满, 相邻的线程共享缓存
+    NUMA_NODE,  // 线程轮流分到各NUMA节点, 绑定该节点的全部CPU, 节点内由系统调度
+};
+
+/// AsioPool::set_affinity的参数
+struct affinity_t {
+    affinity_e mode = affinity_e::NONE;
+    cpu_list_t cpus;      // 可分配给池的CPU, 为空时取allowed_cpus()
+    cpu_list_t reserved;  // 不分配给池的CPU, 如留给st扫描线程(cc::pin_thread)
+};
+
+namespace detail {
+
+/// @return 第i个线程绑定的CPU, 为空时不绑定
+inline std::vector<cpu_list_t> plan_affinity(const affinity_t& a, std::size_t num) {
+    if (a.mode == affinity_e::NONE || num == 0) {
+        return {};
+    }
+    auto pool = a.cpus.empty() ? allowed_cpus() : a.cpus;
+    std::erase_if(pool, [&a](int c) {
+        return std::find(a.reserved.begin(), a.reserved.end(), c) != a.reserved.end();
+    });
+    if (pool.empty()) {
+        return {};
+    }
+
+    // 按节点分组, 不属于任何节点的CPU归到最后一组
+    std::vector<cpu_list_t> groups;
+    auto rest = pool;
+    for (int node = 0, n = numa_nodes(); node < n; node++) {
+        cpu_list_t g;
+        for (int c : numa_node_cpus(node)) {
+            auto it = std::find(rest.begin(), rest.end(), c);
+            if (it != rest.end()) {
+                g.push_back(c);
+                rest.erase(it);
+            }
+        }
+        if (!g.empty()) {
+            groups.push_back(std::move(g));
+        }
+    }
+    if (!rest.empty()) {
+        groups.push_back(std::move(rest));
+    }
+
+    std::vector<cpu_list_t> plan(num);
+    if (a.mode == affinity_e::CPU) {
+        cpu_list_t ordered;
+        for (auto& g : groups) {
+            ordered.insert(ordered.end(), g.begin(), g.end());
+        }
+        for (std::size_t i = 0; i < num; i++) {
+            plan[i] = {ordered[i % ordered.size()]};
+        }
+    } else {
+        for (std::size_t i = 0; i < num; i++) {
+            plan[i] = groups[i % groups.size()];
+        }
+    }
+    return plan;
+}
+
 }  // namespace detail
 
+/// 默认所有线程共用一个io_context. 分片模式下每个线程一个io_context, 完成事件不再
+/// 经过同一个调度队列和锁; 从池内线程发起的set_timeout/co_spawn/enqueue留在本线程的分片,
+/// 从池外发起的按placement分配
 class AsioPool final : boost::noncopyable {
     using executor_t   = boost::asio::io_context::executor_type;
     using work_guard_t = boost::asio::executor_work_guard<executor_t>;
 
+    struct shard_t {
+        boost::asio::io_context ctx;
+        std::unique_ptr<work_guard_t> work_guard;
+        std::atomic<std::int64_t> lag_ns{0};  // LEAST_LOADED用, 最近一次测得的循环延迟
+
+        explicit shard_t(int concurrency_hint) : ctx(concurrency_hint) {}
+    };
+
 public:
     using timer_t = std::weak_ptr<boost::asio::steady_timer>;
+    using wheel_t = ConcurrentTimerWheel;
+
+    struct wheel_timer_t {
+        wheel_t* wheel = nullptr;
+        wheel_t::handle_t handle;
+    };
 
 public:
     static AsioPool& instance() {
@@ -67,15 +182,52 @@ public:
         return ap;
     }
 
-    explicit AsioPool() : stopped_(false), work_guard_(nullptr) {}
+    explicit AsioPool() : stopped_(false), sharded_(false), placement_(placement_e::ROUND_ROBIN) {
+        shards_.emplace_back(std::make_unique<shard_t>(BOOST_ASIO_CONCURRENCY_HINT_DEFAULT));
+    }
+
+    /// 分片模式: 每个分片一个io_context, run()为每个分片起一个线程. 分片模式下
+    /// 各线程一直运行到shutdown(), 任务做完不会自动返回
+    ///
+    /// @param num       分片(线程)数
+    /// @param placement 池外发起的任务如何选择分片
+    AsioPool(sharded_t, int num = std::thread::hardware_concurrency(),
+             placement_e placement = placement_e::ROUND_ROBIN)
+      : stopped_(false)
+      , sharded_(true)
+      , placement_(placement) {
+        num = std::max(num, 1);
+        shards_.reserve(num);
+        for (int i = 0; i < num; i++) {
+            shards_.emplace_back(std::make_unique<shard_t>(1));
+        }
+    }
 
     ~AsioPool() { shutdown(); }
 
-    inline boost::asio::io_context& get_io_context() { return ctx_; }
+    /// 池内线程返回本线程的io_context, 池外按placement选一个
+    inline boost::asio::io_context& get_io_context() { return shards_[local_index()]->ctx; }
+
+    /// 不论调用方在哪个线程, 都按placement选一个, 如接受连接后把会话分到各分片
+    inline boost::asio::io_context& next_io_context() { return shards_[pick_index()]->ctx; }
+
+    /// @param i 分片下标, 共用模式下只有0
+    inline boost::asio::io_context& get_io_context(std::size_t i) { return shards_.at(i)->ctx; }
+
+    /// 分片数, 共用模式下为1
+    inline std::size_t size() const noexcept { return shards_.size(); }
+
+    inline bool is_sharded() const noexcept { return sharded_; }
+
+    /// 当前线程所在的分片, 不是本池的线程时返回-1
+    inline int current_index() const noexcept {
+        return current_.pool == this ? static_cast<int>(current_.index) : -1;
+    }
 
     template <typename CompletionToken>
     inline auto enqueue(CompletionToken&& token) {
-        return boost::asio::dispatch(ctx_, std::forward<CompletionToken>(token));
+        detail::asio_handlers_total().inc();
+        return boost::asio::dispatch(get_io_context(), std::forward<CompletionToken>(token));
     }
 
     template <typename Fn>
@@ -89,7 +241,7 @@ public:
 
     template <typename Fn>
     auto set_timeout(int ms, Fn&& f) {
-        auto timer = std::make_shared<boost::asio::steady_timer>(ctx_);
+        auto timer = std::make_shared<boost::asio::steady_timer>(get_io_context());
         timer->expires_after(std::chrono::milliseconds(ms));
         std::function handle = [fn = std::forward<Fn>(f), timer](boost::system::error_code ec) {
             if (!ec) {
@@ -108,42 +260,151 @@ public:
 
     inline void clear_interval(timer_t timer) const { clear_timeout(timer); }
 
+    /// 时间轮版本: 大量定时器(会话超时等)时使用, 无逐个定时器的堆分配, 启动/取消为O(1)
+    /// 回调为void(), set_interval的回调不再携带定时器
+    template <typename Fn>
+    wheel_timer_t set_timeout(int ms, Fn&& f, use_wheel_t) {
+        auto& w = timer_wheel();
+        return wheel_timer_t{&w, w.set_timeout(ms, std::forward<Fn>(f))};
+    }
+
+    template <typename Fn>
+    wheel_timer_t set_interval(int ms, Fn&& f, use_wheel_t) {
+        auto& w = timer_wheel();
+        return wheel_timer_t{&w, w.set_interval(ms, std::forward<Fn>(f))};
+    }
+
+    inline void clear_timeout(wheel_timer_t timer) const {
+        if (timer.wheel) {
+            timer.wheel->cancel(timer.handle);
+        }
+    }
+
+    inline void clear_interval(wheel_timer_t timer) const { clear_timeout(timer); }
+
+    /// 时间轮, 每个io_context一个, 由其上的一个asio定时器驱动. 分片模式下池内线程用
+    /// 自己分片上的, 其余线程按线程id分散; 共用模式下只有一个
+    wheel_t& timer_wheel() {
+        std::call_once(wheels_flag_, [this] {
+            wheels_.reserve(shards_.size());
+            for (auto& s : shards_) {
+                wheels_.emplace_back(std::make_unique<wheel_t>(s->ctx));
+            }
+        });
+        if (sharded_ && current_.pool == this) {
+            return *wheels_[current_.index];
+        }
+        static thread_local const std::size_t hint =
+            std::hash<std::thread::id>{}(std::this_thread::get_id());
+        return *wheels_[hint % wheels_.size()];
+    }
+
+    /// 设置run()创建的线程如何绑核, 在run()之前调用. 线程先绑核再进入事件循环,
+    /// asio的每线程缓存和分片模式下各分片的处理器内存因此分配在线程所在的NUMA节点上
+    AsioPool& set_affinity(affinity_t a) {
+        affinity_ = std::move(a);
+        return *this;
+    }
+
+    inline const affinity_t& affinity() const noexcept { return affinity_; }
+
+    /// 开启事件循环监测, 在run()之前调用: 每个分片的延迟探针, 每个线程的处理器执行时间,
+    /// 以及可选的慢处理器记录(含调用栈), 用loop_stats()读取. 开启延迟探针后共用模式的run()
+    /// 也要shutdown()才会返回
+    AsioPool& enable_monitor(const monitor_option_t& opt = {}) {
+        monitor_opt_ = opt;
+        return *this;
+    }
+
+    /// 最近一次run()的监测结果, 未开启监测时为空
+    loop_stats_t loop_stats() {
+        std::shared_ptr<detail::LoopMonitor> m;
+        do {
+            std::unique_lock _lck{mtx_};
+            m = monitor_;
+        } while (0);
+        return m ? m->stats() : loop_stats_t{};
+    }
+
+    /// 不会自行返回时(with_guard或分片模式)每个分片周期性测量事件循环延迟,
+    /// 导出为cc_asio_loop_lag_seconds{shard}
+    ///
+    /// @param num        共用模式下的线程数, 分片模式下忽略(每个分片一个线程)
+    /// @param with_guard 共用模式下没有任务时也不返回; 分片模式下总是如此
     void run(int num = std::thread::hardware_concurrency(), bool with_guard = false) {
         if (stopped_.load(std::memory_order_relaxed)) {
             return;
         }
 
-        if (with_guard) {
+        std::shared_ptr<detail::LoopMonitor> monitor;
+        if (sharded_) {
+            num = static_cast<int>(shards_.size());
+            // 任务可能随时被投递到空闲的分片, 分片的线程不能因为一时没有任务就退出
+            std::unique_lock _lck{mtx_};
+            for (auto& s : shards_) {
+                s->work_guard = std::make_unique<work_guard_t>(s->ctx.get_executor());
+            }
+        } else if (with_guard) {
+            std::unique_lock _lck{mtx_};
+            shards_[0]->work_guard =
+                std::make_unique<work_guard_t>(shards_[0]->ctx.get_executor());
+        }
+        if (monitor_opt_) {
+            monitor = std::make_shared<detail::LoopMonitor>(*monitor_opt_, shards_.size(), num);
             std::unique_lock _lck{mtx_};
-            work_guard_ = std::make_unique<work_guard_t>(ctx_.get_executor());
+            monitor_ = monitor;
+        }
+
+        // run()本来就要shutdown()才返回时总是开延迟探针, 导出cc_asio_loop_lag_seconds.
+        // LEAST_LOADED和监测要求的探针周期更短, 共用一个探针
+        int probe_ms = 0;
+        if (sharded_ || with_guard) {
+            probe_ms = placement_ == placement_e::LEAST_LOADED && sharded_ ? kLagProbeMs
+                                                                            : kMetricsProbeMs;
+        }
+        if (monitor && monitor_opt_->lag_interval_ms > 0) {
+            probe_ms = probe_ms > 0 ? std::min(probe_ms, monitor_opt_->lag_interval_ms)
+                                    : monitor_opt_->lag_interval_ms;
+        }
+        if (probe_ms > 0) {
+            for (std::size_t i = 0; i < shards_.size(); i++) {
+                start_lag_probe(i, probe_ms, monitor);
+            }
+        }
+        if (monitor) {
+            monitor->start();
         }
 
+        auto plan = detail::plan_affinity(affinity_, num);
         std::vector<std::thread> threads_;
         threads_.reserve(num - 1);
         for (size_t i = 0; i < num - 1; i++) {
-            threads_.emplace_back([&, i] {
-                set_threadname(i + 2);
-                ctx_.run();
-            });
+            threads_.emplace_back([&, i] { run_thread(i + 1, plan, monitor.get()); });
         }
 
-        // run on current thread
-        set_threadname(1);
-        ctx_.run();
+        // run on current thread, 返回前恢复调用线程原来的绑核
+        auto saved = plan.empty() ? cpu_list_t{} : allowed_cpus();
+        run_thread(0, plan, monitor.get());
+        pin_thread(saved);
 
         for (auto& th : threads_) {
             if (th.joinable()) {
                 th.join();
             }
         }
+        if (monitor) {
+            monitor->stop();
+        }
     }
 
     void shutdown() {
         if (!stopped_.exchange(true, std::memory_order_acquire)) {
-            ctx_.stop();
+            for (auto& s : shards_) {
+                s->ctx.stop();
+            }
             std::unique_lock _lck{mtx_};
-            if (work_guard_) {
-                work_guard_.reset();
+            for (auto& s : shards_) {
+                s->work_guard.reset();
             }
         }
     }
@@ -151,13 +412,16 @@ public:
 #ifdef CC_ENABLE_COROUTINE
     template <typename Any, typename CompletionToken>
     auto co_spawn(Any&& a, CompletionToken&& token) {
-        return boost::asio::co_spawn(ctx_, std::forward<Any>(a),
+        detail::asio_handlers_total().inc();
+        return boost::asio::co_spawn(get_io_context(), std::forward<Any>(a),
                                      std::forward<CompletionToken>(token));
     }
 
     template <typename Any>
     auto co_spawn(Any&& a) {
-        return boost::asio::co_spawn(ctx_, std::forward<Any>(a), [](std::exception_ptr e) {
+        detail::asio_handlers_total().inc();
+        auto& ctx = get_io_context();
+        return boost::asio::co_spawn(ctx, std::forward<Any>(a), [](std::exception_ptr e) {
             if (!e) return;
             try {
                 std::rethrow_exception(e);
@@ -175,13 +439,90 @@ private:
         cc::set_threadname((const char*)buf);
     }
 
+    /// 第i个线程: 共用模式下都跑分片0, 分片模式下跑分片i
+    void run_thread(std::size_t i, const std::vector<cpu_list_t>& plan,
+                    detail::LoopMonitor* monitor) {
+        set_threadname(static_cast<int>(i + 1));
+        if (i < plan.size()) {
+            pin_thread(plan[i]);
+        }
+        auto index = sharded_ ? i : 0;
+        current_   = {this, index};
+        if (monitor) {
+            monitor->run(shards_[index]->ctx, i);
+        } else {
+            shards_[index]->ctx.run();
+        }
+        current_ = {};
+    }
+
+    std::size_t local_index() noexcept {
+        if (current_.pool == this) {
+            return current_.index;
+        }
+        return pick_index();
+    }
+
+    std::size_t pick_index() noexcept {
+        auto n = shards_.size();
+        if (n == 1) {
+            return 0;
+        }
+        auto a = next_.fetch_add(1, std::memory_order_relaxed) % n;
+        if (placement_ == placement_e::ROUND_ROBIN) {
+            return a;
+        }
+        // 两个随机选择: 轮到的a和随机的另一个b中取循环延迟较小的, 不用扫描所有分片
+        static thread_local std::size_t seed =
+            std::hash<std::thread::id>{}(std::this_thread::get_id());
+        seed   = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        auto b = (a + 1 + (seed >> 33) % (n - 1)) % n;
+        return shards_[b]->lag_ns.load(std::memory_order_relaxed)
+                       < shards_[a]->lag_ns.load(std::memory_order_relaxed)
+                   ? b
+                   : a;
+    }
+
+    void start_lag_probe(std::size_t i, int interval_ms,
+                         std::shared_ptr<detail::LoopMonitor> monitor) {
+        auto* s = shards_[i].get();
+        auto* g = &metrics::Registry::instance().gauge(
+            "cc_asio_loop_lag_seconds", "Delay of the last AsioPool lag probe",
+            {{"shard", std::to_string(i)}});
+        auto t = std::make_shared<detail::IntervalTimer>(
+            s->ctx, std::chrono::milliseconds(interval_ms),
+            [s, g, i, monitor](std::shared_ptr<boost::asio::steady_timer> t) {
+                auto lag = boost::asio::steady_timer::clock_type::now() - t->expiry();
+                auto ns  = std::chrono::duration_cast<std::chrono::nanoseconds>(lag).count();
+                s->lag_ns.store(ns, std::memory_order_relaxed);
+                g->set(ns / 1e9);
+                if (monitor) {
+                    monitor->record_lag(i, ns);
+                }
+            });
+        t->start();
+    }
+
 private:
-    boost::asio::io_context ctx_;
+    static constexpr int kLagProbeMs     = 10;
+    static constexpr int kMetricsProbeMs = 1000;
+
+    static inline thread_local detail::pool_thread_t current_;
+
+    std::vector<std::unique_ptr<shard_t>> shards_;
     std::atomic<bool> stopped_;
+    const bool sharded_;
+    const placement_e placement_;
+    std::atomic<std::size_t> next_{0};
+    affinity_t affinity_;
+    std::optional<monitor_option_t> monitor_opt_;
+    std::shared_ptr<detail::LoopMonitor> monitor_;  // 由mtx_保护
 
     // prevent the run() method from return.
     std::mutex mtx_;
-    std::unique_ptr<work_guard_t> work_guard_;
+
+    std::once_flag wheels_flag_;
+    std::vector<std::unique_ptr<wheel_t>> wheels_;
 };
 
 }  // namespace cc
@@ -0,0 +1,262 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <unordered_map>
+#include <boost/asio.hpp>
+#include <boost/core/noncopyable.hpp>
+#include <cc/asio/helper.h>
+#include <cc/stopwatch.h>
+#include <cc/util.h>
+
+namespace cc {
+
+namespace detail {
+
+inline net::awaitable<void> sleep_ns(std::int64_t ns) {
+    net::steady_timer timer(co_await net::this_coro::executor);
+    timer.expires_after(std::chrono::nanoseconds(ns));
+    co_await timer.async_wait(net::use_awaitable);
+}
+
+}  // namespace detail
+
+/// 无锁令牌桶, 按GCRA实现: 只记一个"理论到达时间"(TAT), 取令牌是对它的一次CAS,
+/// 不需要定时补充令牌
+///
+/// 令牌不够时acquire预约之后的令牌并挂起到预约时刻, 按调用顺序整形而不是丢弃;
+/// try_acquire不预约, 不够时立即返回false. burst为1时相当于漏桶: 输出严格按rate匀速
+class TokenBucket : boost::noncopyable {
+public:
+    using clock_t = cc::SteadyClock;
+
+    /// 返回值: 无法在限定时间内取得令牌
+    static constexpr std::int64_t kRejected = -1;
+
+    /// @param rate  每秒产生的令牌数, 必须大于0
+    /// @param burst 桶容量, 空闲之后最多可以一次取走的令牌数, 不能小于1
+    /// @throw std::invalid_argument 参数不合法
+    TokenBucket(double rate, double burst)
+      : interval_ns_(interval(rate, burst))
+      , burst_ns_(std::max(static_cast<std::int64_t>(burst * 1e9 / rate), interval_ns_)) {}
+
+    /// @return 立即取得令牌时返回true, 否则不消耗令牌
+    bool try_acquire(std::size_t tokens = 1) noexcept { return reserve(tokens, 0) == 0; }
+
+    /// 预约令牌
+    ///
+    /// @param max_wait_ns 能接受的最长等待, 小于0表示不限
+    /// @return 需要等待的纳秒数(0表示立即可用); 超过max_wait_ns时返回kRejected且不预约
+    std::int64_t reserve(std::size_t tokens = 1, std::int64_t max_wait_ns = -1) noexcept {
+        auto cost = static_cast<std::int64_t>(tokens) * interval_ns_;
+        auto now  = clock_t::now();
+        auto tat  = tat_.load(std::memory_order_relaxed);
+        for (;;) {
+            auto next = std::max(tat, now) + cost;
+            auto wait = std::max<std::int64_t>(next - burst_ns_ - now, 0);
+            if (max_wait_ns >= 0 && wait > max_wait_ns) {
+                return kRejected;
+            }
+            if (tat_.compare_exchange_weak(tat, next, std::memory_order_relaxed)) {
+                return wait;
+            }
+        }
+    }
+
+    /// 退还预约了但没有用上的令牌(如等待被取消), 不会超过桶容量
+    void refund(std::size_t tokens = 1) noexcept {
+        auto cost = static_cast<std::int64_t>(tokens) * interval_ns_;
+        auto now  = clock_t::now();
+        auto tat  = tat_.load(std::memory_order_relaxed);
+        // TAT不晚于now即桶已满
+        while (tat > now) {
+            if (tat_.compare_exchange_weak(tat, std::max(tat - cost, now),
+                                           std::memory_order_relaxed)) {
+                break;
+            }
+        }
+    }
+
+    /// 令牌不够时挂起到预约时刻, 不丢弃. 等待被取消时退还预约的令牌
+    net::awaitable<void> acquire(std::size_t tokens = 1) {
+        co_await acquire_for(-1, tokens);
+    }
+
+    /// @param ms 能接受的最长等待(毫秒), 小于0表示不限
+    /// @return 需要等待超过ms毫秒时不预约, 立即返回false
+    net::awaitable<bool> acquire_for(int ms, std::size_t tokens = 1) {
+        auto wait = reserve(tokens, ms < 0 ? -1 : static_cast<std::int64_t>(ms) * 1000000);
+        if (wait == kRejected) {
+            co_return false;
+        }
+        if (wait > 0) {
+            try {
+                co_await detail::sleep_ns(wait);
+            } catch (...) {
+                refund(tokens);
+                throw;
+            }
+        }
+        co_return true;
+    }
+
+    /// 桶是否已满(空闲), 用于回收不再活跃的按键限速器
+    bool idle() const noexcept {
+        return tat_.load(std::memory_order_relaxed) <= clock_t::now();
+    }
+
+    inline double rate() const noexcept { return 1e9 / interval_ns_; }
+
+private:
+    static std::int64_t interval(double rate, double burst) {
+        if (!(rate > 0) || !(burst >= 1)) {
+            throw std::invalid_argument("TokenBucket: rate must be > 0 and burst >= 1");
+        }
+        // rate超过1e9时间隔按1ns算
+        return std::max<std::int64_t>(static_cast<std::int64_t>(1e9 / rate), 1);
+    }
+
+    const std::int64_t interval_ns_;  // 每个令牌的间隔
+    const std::int64_t burst_ns_;     // 桶容量折算成的时长
+    std::atomic<std::int64_t> tat_{0};
+};
+
+/// 按键限速, 如每个客户端IP一个令牌桶, 可以再挂一个全局的上级限速器(分层限速).
+/// 键按hash分到kShards个分片, 每个分片各自加锁, 令牌桶本身无锁
+///
+/// 每个键的令牌桶在第一次用到时创建, sweep()回收已空闲(桶已满)且没有在用的
+template <typename Key, typename MutexPolicy = NonMutex,
+          template <class> class WriterLock = LockGuard, typename Hash = std::hash<Key>>
+class KeyedRateLimiter : boost::noncopyable {
+public:
+    static constexpr std::size_t kShards = 16;
+
+    /// @param rate   每个键每秒的令牌数
+    /// @param burst  每个键的桶容量
+    /// @param parent 所有键共享的上级限速器, 可以为空
+    KeyedRateLimiter(double rate, double burst, std::shared_ptr<TokenBucket> parent = nullptr)
+      : rate_(rate)
+      , burst_(burst)
+      , parent_(std::move(parent)) {}
+
+    /// 同时满足本键和上级限速器时才返回true, 否则都不消耗令牌
+    bool try_acquire(const Key& key, std::size_t tokens = 1) {
+        auto b = bucket(key);
+        if (!b->try_acquire(tokens)) {
+            return false;
+        }
+        if (parent_ && !parent_->try_acquire(tokens)) {
+            b->refund(tokens);
+            return false;
+        }
+        return true;
+    }
+
+    /// 分别在本键和上级限速器预约, 等待两者中较晚的那个
+    ///
+    /// @param max_wait_ns 能接受的最长等待, 小于0表示不限
+    /// @return 需要等待的纳秒数; 任一方超过max_wait_ns时返回TokenBucket::kRejected,
+    ///         两边都不预约
+    std::int64_t reserve(const Key& key, std::size_t tokens = 1, std::int64_t max_wait_ns = -1) {
+        return reserve(*bucket(key), tokens, max_wait_ns);
+    }
+
+    net::awaitable<void> acquire(const Key& key, std::size_t tokens = 1) {
+        co_await acquire_for(key, -1, tokens);
+    }
+
+    /// @param ms 能接受的最长等待(毫秒), 小于0表示不限
+    /// @return 需要等待超过ms毫秒时不预约, 立即返回false
+    net::awaitable<bool> acquire_for(const Key& key, int ms, std::size_t tokens = 1) {
+        auto b    = bucket(key);
+        auto wait = reserve(*b, tokens, ms < 0 ? -1 : static_cast<std::int64_t>(ms) * 1000000);
+        if (wait == TokenBucket::kRejected) {
+            co_return false;
+        }
+        if (wait > 0) {
+            try {
+                co_await detail::sleep_ns(wait);
+            } catch (...) {
+                b->refund(tokens);
+                if (parent_) {
+                    parent_->refund(tokens);
+                }
+                throw;
+            }
+        }
+        co_return true;
+    }
+
+    /// 回收空闲的键
+    /// @return 回收的数量
+    std::size_t sweep() {
+        std::size_t n = 0;
+        for (auto& s : shards_) {
+            WriterLock<MutexPolicy> _lck{s.mtx};
+            for (auto it = s.buckets.begin(); it != s.buckets.end();) {
+                if (it->second.use_count() == 1 && it->second->idle()) {
+                    it = s.buckets.erase(it);
+                    n++;
+                } else {
+                    ++it;
+                }
+            }
+        }
+        return n;
+    }
+
+    std::size_t size() {
+        std::size_t n = 0;
+        for (auto& s : shards_) {
+            WriterLock<MutexPolicy> _lck{s.mtx};
+            n += s.buckets.size();
+        }
+        return n;
+    }
+
+    inline const std::shared_ptr<TokenBucket>& parent() const noexcept { return parent_; }
+
+private:
+    std::int64_t reserve(TokenBucket& b, std::size_t tokens, std::int64_t max_wait_ns) {
+        auto wait = b.reserve(tokens, max_wait_ns);
+        if (wait == TokenBucket::kRejected || !parent_) {
+            return wait;
+        }
+        auto pwait = parent_->reserve(tokens, max_wait_ns);
+        if (pwait == TokenBucket::kRejected) {
+            b.refund(tokens);
+            return pwait;
+        }
+        return std::max(wait, pwait);
+    }
+
+    std::shared_ptr<TokenBucket> bucket(const Key& key) {
+        auto h  = Hash{}(key);
+        auto& s = shards_[h % kShards];
+        WriterLock<MutexPolicy> _lck{s.mtx};
+        auto& b = s.buckets[key];
+        if (!b) {
+            b = std::make_shared<TokenBucket>(rate_, burst_);
+        }
+        return b;
+    }
+
+    struct shard_t {
+        MutexPolicy mtx;
+        std::unordered_map<Key, std::shared_ptr<TokenBucket>, Hash> buckets;
+    };
+
+    const double rate_;
+    const double burst_;
+    std::shared_ptr<TokenBucket> parent_;
+    std::array<shard_t, kShards> shards_;
+};
+
+}  // namespace cc
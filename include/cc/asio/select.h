@@ -0,0 +1,277 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <boost/asio.hpp>
+#include <boost/core/noncopyable.hpp>
+#include <boost/system/system_error.hpp>
+#include <cc/asio/helper.h>
+#include <cc/asio/waiter.h>
+
+namespace cc {
+namespace chan {
+
+namespace detail {
+
+class SelectState;
+
+/// 挂在数据源上的侵入式钩子, 由数据源的锁保护
+struct SelectHook {
+    SelectHook* prev = nullptr;
+    SelectHook* next = nullptr;
+    bool linked      = false;
+
+    SelectState* state = nullptr;
+    std::size_t index  = 0;
+
+    // 注销用, 由数据源的select_watch设置
+    void* source                             = nullptr;
+    void (*unwatch)(void*, SelectHook& self) = nullptr;
+
+    inline void fire() noexcept;
+};
+
+class SelectHooks {
+    SelectHook* head_ = nullptr;
+
+public:
+    void push(SelectHook& h) noexcept {
+        h.prev   = nullptr;
+        h.next   = head_;
+        h.linked = true;
+        if (head_) {
+            head_->prev = &h;
+        }
+        head_ = &h;
+    }
+
+    void erase(SelectHook& h) noexcept {
+        if (!h.linked) {
+            return;
+        }
+        (h.prev ? h.prev->next : head_) = h.next;
+        if (h.next) {
+            h.next->prev = h.prev;
+        }
+        h.prev = h.next = nullptr;
+        h.linked        = false;
+    }
+
+    /// 数据源变为可读(或关闭)时在锁内调用
+    void fire_all() noexcept {
+        for (auto* h = head_; h; h = h->next) {
+            h->fire();
+        }
+    }
+};
+
+/// 设置钩子的注销回调
+template <typename Source>
+inline void bind_hook(SelectHook& h, Source* source) noexcept {
+    h.source  = source;
+    h.unwatch = [](void* s, SelectHook& self) { static_cast<Source*>(s)->select_unwatch(self); };
+}
+
+/// Select的状态. 定时器回调可能晚于Select析构执行, 也可能在别的线程上执行, 所以由
+/// shared_ptr单独持有, 回调里只访问原子变量
+///
+/// 第一个触发的数据源通过CAS记下下标; 登记完所有钩子后才arm, arm之后由触发方或arm方
+/// 中的一个(completed_)恢复协程, 避免登记到一半时协程就在别的线程上恢复.
+/// 取消回调与数据源抢同一个CAS, 赢了才由它恢复协程
+class SelectState : boost::noncopyable {
+public:
+    static constexpr std::size_t kNone      = static_cast<std::size_t>(-1);
+    static constexpr std::size_t kCancelled = kNone - 1;
+
+    std::atomic<std::size_t> fired{kNone};
+    std::atomic<bool> timer_expired{false};
+    cc::detail::InplaceHandler<> handler;
+
+    void fire(std::size_t index) noexcept {
+        std::size_t expected = kNone;
+        if (fired.compare_exchange_strong(expected, index)) {
+            try_complete();
+        }
+    }
+
+    /// @return false表示已有数据源触发, 取消方什么也不做
+    bool cancel() noexcept {
+        std::size_t expected = kNone;
+        return fired.compare_exchange_strong(expected, kCancelled);
+    }
+
+    /// cancel()成功并注销钩子后调用
+    void complete_cancelled() noexcept { try_complete(); }
+
+    void arm() noexcept {
+        armed_.store(true);
+        if (fired.load() != kNone) {
+            try_complete();
+        }
+    }
+
+    /// 每次等待前调用
+    void reset() noexcept {
+        fired.store(kNone);
+        armed_.store(false);
+        completed_.store(false);
+    }
+
+private:
+    void try_complete() noexcept {
+        if (armed_.load() && !completed_.exchange(true)) {
+            handler.post();
+        }
+    }
+
+    std::atomic<bool> armed_{false};
+    std::atomic<bool> completed_{false};
+};
+
+inline void SelectHook::fire() noexcept { state->fire(index); }
+
+}  // namespace detail
+
+/// 同时等待N个接收者和一个可选的超时. 应在循环外创建并复用, 稳态下没有堆分配
+///
+/// 只等待"可读", 不取走消息: 返回后由调用方对触发的接收者try_recv, 其余接收者的消息原样
+/// 留在通道里, 超时或协程被取消都不会丢消息. 等待被取消(如awaitable_operators的||)时
+/// 注销所有钩子, 抛出operation_aborted. mpmc的元素可能被其他消费者先取走, 此时
+/// try_recv为空, 重新等待即可. 已关闭的接收者每次都立即触发, 由调用方据此退出循环.
+///
+/// 支持bounded, mpmc, broadcast, watch的Receiver (实现了select_watch/select_unwatch)
+/// 超时用的定时器在两次等待之间保持挂起, Select析构时才取消
+template <std::size_t N>
+class Select : boost::noncopyable {
+    std::shared_ptr<detail::SelectState> state_ = std::make_shared<detail::SelectState>();
+    using clock_t = net::steady_timer::clock_type;
+
+    std::array<detail::SelectHook, N> hooks_;
+    std::array<void (*)(void*, detail::SelectHook&), N> watch_;
+    std::array<void*, N> receivers_;
+    std::size_t start_ = 0;
+    std::optional<net::steady_timer> timer_;
+    std::optional<clock_t::time_point> timer_expiry_;  // 定时器挂起中时的到期时间
+
+public:
+    /// wait_for超时时的返回值
+    static constexpr std::size_t timeout = N;
+
+    ~Select() { unwatch_all(); }
+
+    /// @return 触发的接收者下标(按参数顺序)
+    template <typename... Rs>
+    inline net::awaitable<std::size_t> wait(Rs&... rs) {
+        return wait_for(-1, rs...);
+    }
+
+    /// @param ms   超时(毫秒), 小于0表示不超时
+    /// @return     触发的接收者下标(按参数顺序), 超时返回timeout
+    /// @throw boost::system::system_error operation_aborted, 等待被取消
+    template <typename... Rs>
+    net::awaitable<std::size_t> wait_for(int ms, Rs&... rs) {
+        static_assert(sizeof...(Rs) == N, "Select: expect N receivers");
+        std::size_t i = 0;
+        (bind(i++, rs), ...);
+
+        auto deadline = clock_t::now() + std::chrono::milliseconds(ms);
+        for (;;) {
+            state_->reset();
+            if (state_->timer_expired.exchange(false)) {
+                timer_expiry_.reset();
+            }
+            // 定时器在等待之间保持挂起, 只在没有挂起或到期时间晚于本次deadline时重设,
+            // 稳态下每轮既不cancel也不重新async_wait; 提前到期时重新等待即可
+            if (ms >= 0 && (!timer_expiry_ || *timer_expiry_ > deadline)) {
+                if (!timer_) {
+                    timer_.emplace(co_await net::this_coro::executor);
+                }
+                timer_->expires_at(deadline);
+                timer_expiry_ = deadline;
+                timer_->async_wait([state = state_](const boost::system::error_code& ec) {
+                    if (!ec) {
+                        state->timer_expired.store(true);
+                        state->fire(timeout);
+                    }
+                });
+            }
+
+            // 每次从不同的接收者开始登记, 多个同时可读时轮流胜出
+            start_    = start_ + 1 == N ? 0 : start_ + 1;
+            auto init = [this](auto handler) {
+                auto slot = net::get_associated_cancellation_slot(handler);
+                state_->handler.emplace(std::move(handler));
+                if (slot.is_connected()) {
+                    slot.template emplace<canceller_t>(this);
+                }
+                for (std::size_t k = 0; k < N; k++) {
+                    auto j = start_ + k < N ? start_ + k : start_ + k - N;
+                    watch_[j](receivers_[j], hooks_[j]);
+                }
+                state_->arm();
+            };
+            co_await net::async_initiate<decltype(net::use_awaitable), void()>(
+                init, net::use_awaitable);
+            unwatch_all();
+
+            auto fired = state_->fired.load();
+            if (fired == detail::SelectState::kCancelled) {
+                throw boost::system::system_error(net::error::operation_aborted);
+            }
+            if (fired != timeout) {
+                co_return fired;
+            }
+            state_->timer_expired.store(false);
+            timer_expiry_.reset();
+            if (ms >= 0 && clock_t::now() >= deadline) {
+                co_return fired;
+            }
+        }
+    }
+
+private:
+    /// 放在取消槽里, 可能在等待结束后才被调用: 输掉CAS时只访问自己持有的state
+    struct canceller_t {
+        Select* self;
+        std::shared_ptr<detail::SelectState> state;
+
+        explicit canceller_t(Select* s) : self(s), state(s->state_) {}
+
+        void operator()(net::cancellation_type_t) {
+            if (!state->cancel()) {
+                return;
+            }
+            // 赢了之后协程一直挂起, Select有效. 先注销再恢复, 不与恢复后的协程并发
+            self->unwatch_all();
+            state->complete_cancelled();
+        }
+    };
+
+    template <typename R>
+    void bind(std::size_t i, R& r) noexcept {
+        hooks_[i].state = state_.get();
+        hooks_[i].index = i;
+        receivers_[i]   = &r;
+        watch_[i]       = [](void* p, detail::SelectHook& h) {
+            static_cast<R*>(p)->select_watch(h);
+        };
+    }
+
+    void unwatch_all() noexcept {
+        for (auto& h : hooks_) {
+            if (h.source) {
+                h.unwatch(h.source, h);
+                h.source = nullptr;
+            }
+        }
+    }
+};
+
+}  // namespace chan
+}  // namespace cc
@@ -1,66 +1,184 @@
 #pragma once
 
 #include <cstddef>
-#include <functional>
-#include <list>
+#include <utility>
 #include <boost/asio.hpp>
+#include <boost/asio/experimental/awaitable_operators.hpp>
 #include <boost/core/noncopyable.hpp>
+#include <boost/system/system_error.hpp>
 #include <cc/asio/helper.h>
+#include <cc/asio/waiter.h>
 #include <cc/util.h>
 
 namespace cc {
 
+/// 计数信号量, 等待者严格按FIFO取得许可: 队首请求的数量不够时, 后面请求少的也要等,
+/// 大请求不会被饿死
 template <typename MutexPolicy = NonMutex, template <class> class WriterLock = LockGuard>
 class Semaphore final : public boost::noncopyable {
 public:
-    Semaphore(std::size_t init_permits) : permits_(init_permits) {}
+    /// 持有n个许可, 析构时归还. 只能移动, 默认构造的为空
+    class Permit {
+        Semaphore* sem_    = nullptr;
+        std::size_t count_ = 0;
 
-    net::awaitable<void> acquire() {
-        do {
-            WriterLock<MutexPolicy> _lck{mtx_};
-            if (permits_ > 0) {
-                permits_--;
-                co_return;
+    public:
+        Permit() = default;
+        Permit(Semaphore* sem, std::size_t count) : sem_(sem), count_(count) {}
+        Permit(const Permit&)            = delete;
+        Permit& operator=(const Permit&) = delete;
+
+        Permit(Permit&& o) noexcept
+          : sem_(std::exchange(o.sem_, nullptr))
+          , count_(std::exchange(o.count_, 0)) {}
+
+        Permit& operator=(Permit&& o) noexcept {
+            if (this != &o) {
+                release();
+                sem_   = std::exchange(o.sem_, nullptr);
+                count_ = std::exchange(o.count_, 0);
             }
-        } while (0);
+            return *this;
+        }
+
+        ~Permit() { release(); }
+
+        inline explicit operator bool() const noexcept { return sem_ != nullptr; }
+        inline std::size_t count() const noexcept { return count_; }
 
-        using time_point = net::steady_timer::clock_type::time_point;
-        std::shared_ptr<net::steady_timer> timer =
-            std::make_shared<net::steady_timer>(co_await net::this_coro::executor);
-        timer->expires_at(time_point::max());
-        std::weak_ptr<net::steady_timer> weak_timer(timer);
-        add_handle([weak_timer] {
-            if (auto timer = weak_timer.lock()) {
-                timer->cancel();
+        /// 提前归还
+        void release() {
+            if (sem_) {
+                std::exchange(sem_, nullptr)->release(std::exchange(count_, 0));
             }
-        });
-        co_await timer->async_wait(net::as_tuple(net::use_awaitable));
+        }
+
+        /// 放弃所有权, 之后由调用方release
+        void detach() noexcept {
+            sem_   = nullptr;
+            count_ = 0;
+        }
+    };
+
+    Semaphore(std::size_t init_permits) : permits_(init_permits) {}
+
+    /// 等待节点放在协程帧里, 不分配内存
+    ///
+    /// @throw boost::system::system_error(operation_aborted) 等待被取消, 未取得许可
+    net::awaitable<void> acquire(std::size_t n = 1) {
+        if (try_acquire(n)) {
+            co_return;
+        }
+
+        auto enqueue = [this, n](detail::WaitNode& w) {
+            WriterLock<MutexPolicy> _lck{mtx_};
+            if (waiters_.empty() && permits_ >= n) {
+                permits_ -= n;
+                return false;
+            }
+            w.count = n;
+            waiters_.push_back(w);
+            return true;
+        };
+        detail::WaitNode node;
+        co_await detail::park<&Semaphore::unlink>(node, this, enqueue);
+        if (GSL_UNLIKELY(node.cancelled)) {
+            throw boost::system::system_error(net::error::operation_aborted);
+        }
     }
 
-    inline void release() {
+    /// 不挂起, 有人排队时也返回false(不插队)
+    bool try_acquire(std::size_t n = 1) {
         WriterLock<MutexPolicy> _lck{mtx_};
-        permits_++;
-
-        // 存在等待的
-        if (permits_ > 0 && handles_.size() > 0) {
-            permits_--;
-            auto f = handles_.front();
-            handles_.pop_front();
-            f();
+        if (waiters_.empty() && permits_ >= n) {
+            permits_ -= n;
+            return true;
         }
+        return false;
     }
 
-private:
-    template <typename Callback>
-    void add_handle(Callback&& cb) {
+    /// @return 超时未取得许可时返回false; 返回true时由调用方release(n)
+    net::awaitable<bool> acquire_for(int ms, std::size_t n = 1) {
+        auto p  = co_await guard_for(ms, n);
+        bool ok = static_cast<bool>(p);
+        p.detach();
+        co_return ok;
+    }
+
+    /// co_await sem.guard(n) 取得许可, 离开作用域时归还
+    net::awaitable<Permit> guard(std::size_t n = 1) {
+        co_await acquire(n);
+        co_return Permit(this, n);
+    }
+
+    /// @return 超时时返回空的Permit
+    net::awaitable<Permit> guard_for(int ms, std::size_t n = 1) {
+        if (try_acquire(n)) {
+            co_return Permit(this, n);
+        }
+        // 超时与取得许可同时发生时, 输掉的一方的Permit被销毁, 许可随之归还, 不会泄漏
+        using namespace net::experimental::awaitable_operators;
+        auto v = co_await (cc::async_sleep(ms) || guard(n));
+        if (v.index() == 0) {
+            co_return Permit();
+        }
+        Permit p = std::move(std::get<1>(v));
+        co_return p;
+    }
+
+    /// 归还n个许可, 在锁外恢复因此满足的等待者
+    void release(std::size_t n = 1) {
+        detail::WaitNode* woken = nullptr;
+        do {
+            WriterLock<MutexPolicy> _lck{mtx_};
+            permits_ += n;
+            woken = grant();
+        } while (0);
+        detail::WaitQueue::resume_all(woken);
+    }
+
+    std::size_t available() {
         WriterLock<MutexPolicy> _lck{mtx_};
-        handles_.emplace_back(std::forward<Callback>(cb));
+        return permits_;
+    }
+
+private:
+    /// 在锁内按FIFO把许可分给队首的等待者, 返回以next串起的链表
+    detail::WaitNode* grant() noexcept {
+        detail::WaitNode* head = nullptr;
+        detail::WaitNode* tail = nullptr;
+        while (auto* w = waiters_.front()) {
+            if (permits_ < w->count) {
+                break;
+            }
+            waiters_.erase(*w);
+            if (!w->claim()) {
+                continue;  // 已被取消, 由取消方恢复
+            }
+            permits_ -= w->count;
+            (tail ? tail->next : head) = w;
+            tail                       = w;
+        }
+        return head;
+    }
+
+    /// 取消等待. 被摘下的若是队首, 后面的等待者可能因此得到满足
+    bool unlink(detail::WaitNode& w) {
+        detail::WaitNode* woken = nullptr;
+        bool erased             = false;
+        do {
+            WriterLock<MutexPolicy> _lck{mtx_};
+            erased = waiters_.erase(w);
+            woken  = grant();
+        } while (0);
+        detail::WaitQueue::resume_all(woken);
+        return erased;
     }
 
 private:
     MutexPolicy mtx_;
     std::size_t permits_;
-    std::list<std::function<void()>> handles_;
+    detail::WaitQueue waiters_;
 };
 
 }  // namespace cc
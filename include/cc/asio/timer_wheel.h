@@ -0,0 +1,455 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <boost/asio.hpp>
+#include <boost/core/noncopyable.hpp>
+#include <cc/util.h>
+#include <gsl/gsl>
+
+namespace cc {
+
+/// 选择时间轮实现的定时器, 例如 AsioPool::set_timeout(ms, fn, cc::use_wheel)
+struct use_wheel_t {};
+inline constexpr use_wheel_t use_wheel{};
+
+namespace detail {
+
+/// 定长内联存储的void()可调用对象, 超出容量时才退化为堆分配
+template <std::size_t N = 48>
+class inline_function : boost::noncopyable {
+    alignas(std::max_align_t) unsigned char buf_[N];
+    void (*invoke_)(void*)  = nullptr;
+    void (*destroy_)(void*) = nullptr;
+
+public:
+    inline_function() = default;
+    ~inline_function() { reset(); }
+
+    template <typename Fn>
+    void emplace(Fn&& fn) {
+        using F = std::decay_t<Fn>;
+        reset();
+        if constexpr (sizeof(F) <= N && alignof(F) <= alignof(std::max_align_t)) {
+            ::new (static_cast<void*>(buf_)) F(std::forward<Fn>(fn));
+            invoke_  = [](void* p) { (*static_cast<F*>(p))(); };
+            destroy_ = [](void* p) { static_cast<F*>(p)->~F(); };
+        } else {
+            ::new (static_cast<void*>(buf_)) F*(new F(std::forward<Fn>(fn)));
+            invoke_  = [](void* p) { (**static_cast<F**>(p))(); };
+            destroy_ = [](void* p) { delete *static_cast<F**>(p); };
+        }
+    }
+
+    inline void operator()() { invoke_(buf_); }
+
+    inline void reset() noexcept {
+        if (destroy_) {
+            destroy_(buf_);
+            destroy_ = nullptr;
+            invoke_  = nullptr;
+        }
+    }
+};
+
+}  // namespace detail
+
+/// 分层时间轮(5层: 256 + 4 * 64 槽, 覆盖 2^32 个tick)
+///
+/// 定时器节点来自内部的slab, 按块扩容并复用, 启动/取消均为O(1)且没有逐个定时器的堆分配
+/// (回调捕获超过48字节时除外). 两种驱动方式:
+///   - TimerWheel(ioc): 由一个asio steady_timer驱动, 只在最近的到期点或需要级联时唤醒
+///   - TimerWheel():    由使用者周期性调用poll(), 例如在扫描周期中
+///
+/// 回调在锁外执行, 回调内可以再次启动/取消定时器.
+// clang-format off
+template <
+    typename MutexPolicy = NonMutex,
+    template <class> class WriterLock = LockGuard
+>  // clang-format on
+class TimerWheel final : boost::noncopyable {
+    using clock = std::chrono::steady_clock;
+
+    enum : std::uint32_t {
+        kRootBits    = 8,
+        kLevelBits   = 6,
+        kLevels      = 4,
+        kRootSize    = 1 << kRootBits,
+        kLevelSize   = 1 << kLevelBits,
+        kBuckets     = kRootSize + kLevels * kLevelSize,
+        kChunkBits   = 12,
+        kChunkSize   = 1 << kChunkBits,
+        kMaxInterval = 0xffffffff,
+    };
+
+    enum state_e : std::uint8_t { FREE = 0, ARMED, FIRING, CANCELLED };
+
+    struct link_t {
+        link_t* prev;
+        link_t* next;
+
+        inline void init() noexcept { prev = next = this; }
+        inline bool empty() const noexcept { return next == this; }
+
+        inline void push_back(link_t* n) noexcept {
+            n->prev    = prev;
+            n->next    = this;
+            prev->next = n;
+            prev       = n;
+        }
+
+        inline void unlink() noexcept {
+            prev->next = next;
+            next->prev = prev;
+        }
+
+        /// 将整个链表移到 to 的尾部
+        inline void splice_to(link_t& to) noexcept {
+            if (empty()) return;
+            next->prev    = to.prev;
+            to.prev->next = next;
+            prev->next    = &to;
+            to.prev       = prev;
+            init();
+        }
+    };
+
+    struct node_t : link_t {
+        std::uint64_t expires;
+        std::uint32_t interval;  // tick, 0表示一次性
+        std::uint32_t gen;
+        std::uint32_t index;
+        std::uint16_t bucket;
+        state_e state;
+        detail::inline_function<> fn;
+    };
+
+public:
+    struct handle_t {
+        std::uint32_t index = 0;
+        std::uint32_t gen   = 0;
+
+        explicit operator bool() const noexcept { return gen != 0; }
+    };
+
+public:
+    /// 手动驱动, 需周期性调用poll()
+    explicit TimerWheel(std::chrono::milliseconds resolution = std::chrono::milliseconds(1))
+      : resolution_(resolution)
+      , epoch_(clock::now()) {
+        for (auto& b : buckets_) b.init();
+    }
+
+    /// 由ioc上的一个steady_timer驱动
+    explicit TimerWheel(boost::asio::io_context& ioc,
+                        std::chrono::milliseconds resolution = std::chrono::milliseconds(1))
+      : TimerWheel(resolution) {
+        timer_.emplace(ioc);
+    }
+
+    ~TimerWheel() {
+        WriterLock<MutexPolicy> _lck{mtx_};
+        if (timer_) {
+            timer_->cancel();
+        }
+        for (auto& chunk : chunks_) {
+            for (std::uint32_t i = 0; i < kChunkSize; i++) {
+                chunk[i].fn.reset();
+            }
+        }
+    }
+
+    /// @param ms   超时时间, 单位毫秒
+    /// @param f    void()
+    template <typename Fn>
+    handle_t set_timeout(int ms, Fn&& f) {
+        return arm(ms, 0, std::forward<Fn>(f));
+    }
+
+    template <typename Fn>
+    handle_t set_interval(int ms, Fn&& f) {
+        return arm(ms, std::max<std::uint32_t>(1, to_ticks(ms)), std::forward<Fn>(f));
+    }
+
+    /// @return 定时器仍处于等待中并被取消时返回true
+    bool cancel(handle_t h) noexcept {
+        WriterLock<MutexPolicy> _lck{mtx_};
+        node_t* n = lookup(h);
+        if (!n) return false;
+        if (n->state == ARMED) {
+            unlink(n);
+            release(n);
+            return true;
+        }
+        if (n->state == FIRING) {
+            // 正在执行回调, 执行完毕后回收
+            n->state = CANCELLED;
+        }
+        return false;
+    }
+
+    /// 等待中的定时器个数
+    std::size_t size() const noexcept { return pending_; }
+
+    /// 执行所有已到期的定时器
+    ///
+    /// @return 执行的回调个数
+    std::size_t poll() { return run_until(tick_of(clock::now())); }
+
+private:
+    template <typename Fn>
+    handle_t arm(int ms, std::uint32_t interval, Fn&& f) {
+        WriterLock<MutexPolicy> _lck{mtx_};
+        auto tick = tick_of(clock::now());
+        if (pending_ == 0) {
+            // 空闲期间没有推进now_, 直接跳到当前tick, 免得下次run_until逐个走过
+            now_ = std::max(now_, tick);
+        }
+        node_t* n   = acquire();
+        n->interval = interval;
+        n->fn.emplace(std::forward<Fn>(f));
+        // 当前tick已走过一部分, 从下一个tick的起点算起, 保证不早于ms触发
+        n->expires = std::max(tick + 1, now_) + to_ticks(ms);
+        insert(n);
+        schedule();
+        return handle_t{n->index, n->gen};
+    }
+
+    inline std::uint32_t to_ticks(int ms) const noexcept {
+        if (ms <= 0) return 0;
+        auto t = (std::chrono::milliseconds(ms) + resolution_ - std::chrono::milliseconds(1))
+                 / resolution_;
+        return static_cast<std::uint32_t>(std::min<std::int64_t>(t, kMaxInterval));
+    }
+
+    inline std::uint64_t tick_of(clock::time_point tp) const noexcept {
+        return static_cast<std::uint64_t>((tp - epoch_) / resolution_);
+    }
+
+    // ------------------------------------------------------------- nodes
+    node_t* acquire() {
+        if (!free_) {
+            auto chunk = std::make_unique<node_t[]>(kChunkSize);
+            auto base  = gsl::narrow_cast<std::uint32_t>(chunks_.size() << kChunkBits);
+            for (std::uint32_t i = kChunkSize; i-- > 0;) {
+                chunk[i].index = base + i;
+                chunk[i].gen   = 0;
+                chunk[i].state = FREE;
+                chunk[i].next  = free_;
+                free_          = &chunk[i];
+            }
+            chunks_.emplace_back(std::move(chunk));
+        }
+        auto* n = static_cast<node_t*>(free_);
+        free_   = n->next;
+        if (++n->gen == 0) n->gen = 1;
+        n->state = ARMED;
+        return n;
+    }
+
+    void release(node_t* n) noexcept {
+        n->fn.reset();
+        n->state = FREE;
+        n->next  = free_;
+        free_    = n;
+    }
+
+    node_t* lookup(handle_t h) const noexcept {
+        if (!h || (h.index >> kChunkBits) >= chunks_.size()) return nullptr;
+        node_t* n = &chunks_[h.index >> kChunkBits][h.index & (kChunkSize - 1)];
+        return (n->gen == h.gen && n->state != FREE) ? n : nullptr;
+    }
+
+    // ------------------------------------------------------------- wheel
+    void insert(node_t* n) noexcept {
+        std::uint64_t expires = n->expires;
+        std::uint64_t idx     = expires - now_;
+        std::uint32_t bucket;
+        if (expires < now_) {
+            bucket = now_ & (kRootSize - 1);
+        } else if (idx < (1ull << kRootBits)) {
+            bucket = expires & (kRootSize - 1);
+        } else {
+            if (idx > kMaxInterval) {
+                expires = now_ + kMaxInterval;
+            }
+            std::uint32_t level = 1;
+            while (level < kLevels && idx >= (1ull << (kRootBits + level * kLevelBits))) {
+                level++;
+            }
+            auto shift = kRootBits + (level - 1) * kLevelBits;
+            auto slot  = (expires >> shift) & (kLevelSize - 1);
+            bucket     = kRootSize + (level - 1) * kLevelSize + slot;
+        }
+
+        n->bucket = static_cast<std::uint16_t>(bucket);
+        buckets_[bucket].push_back(n);
+        if (bucket < kRootSize) {
+            root_bitmap_[bucket >> 6] |= (1ull << (bucket & 63));
+        }
+        pending_++;
+    }
+
+    void unlink(node_t* n) noexcept {
+        n->unlink();
+        auto bucket = n->bucket;
+        if (bucket < kRootSize && buckets_[bucket].empty()) {
+            root_bitmap_[bucket >> 6] &= ~(1ull << (bucket & 63));
+        }
+        pending_--;
+    }
+
+    /// 将上层某个槽的定时器重新分配到下层
+    /// @return 槽下标, 为0时需要继续级联更上一层
+    std::uint32_t cascade(std::uint32_t level) noexcept {
+        auto shift = kRootBits + (level - 1) * kLevelBits;
+        auto index = static_cast<std::uint32_t>((now_ >> shift) & (kLevelSize - 1));
+        link_t list;
+        list.init();
+        buckets_[kRootSize + (level - 1) * kLevelSize + index].splice_to(list);
+        while (!list.empty()) {
+            auto* n = static_cast<node_t*>(list.next);
+            n->unlink();
+            pending_--;
+            insert(n);
+        }
+        return index;
+    }
+
+    std::size_t run_until(std::uint64_t target) {
+        link_t fired;
+        fired.init();
+
+        do {
+            WriterLock<MutexPolicy> _lck{mtx_};
+            while (now_ <= target) {
+                if (pending_ == 0) {
+                    // 轮上没有定时器, 剩下的tick都是空的
+                    now_ = target + 1;
+                    break;
+                }
+                auto index = static_cast<std::uint32_t>(now_ & (kRootSize - 1));
+                if (index == 0) {
+                    std::uint32_t level = 1;
+                    while (level <= kLevels && cascade(level) == 0) {
+                        level++;
+                    }
+                }
+                auto& bucket = buckets_[index];
+                for (auto* l = bucket.next; l != &bucket; l = l->next) {
+                    static_cast<node_t*>(l)->state = FIRING;
+                    pending_--;
+                }
+                bucket.splice_to(fired);
+                root_bitmap_[index >> 6] &= ~(1ull << (index & 63));
+                now_++;
+            }
+        } while (0);
+
+        // 在锁外执行回调
+        std::size_t count = 0;
+        std::exception_ptr e;
+        for (auto* l = fired.next; l != &fired; l = l->next) {
+            try {
+                static_cast<node_t*>(l)->fn();
+            } catch (...) {
+                if (!e) e = std::current_exception();
+            }
+            count++;
+        }
+
+        do {
+            WriterLock<MutexPolicy> _lck{mtx_};
+            while (!fired.empty()) {
+                auto* n = static_cast<node_t*>(fired.next);
+                n->unlink();
+                if (n->state == FIRING && n->interval) {
+                    n->state   = ARMED;
+                    n->expires = std::max(n->expires + n->interval, now_);
+                    insert(n);
+                } else {
+                    release(n);
+                }
+            }
+            schedule();
+        } while (0);
+
+        if (GSL_UNLIKELY(e)) {
+            std::rethrow_exception(e);
+        }
+        return count;
+    }
+
+    /// 下一次需要处理的tick: 根层最近的非空槽, 或者根层回绕(需要级联)的时刻
+    std::uint64_t next_wakeup() const noexcept {
+        auto index = static_cast<std::uint32_t>(now_ & (kRootSize - 1));
+        if (index == 0) {
+            return now_;
+        }
+        for (std::uint32_t w = index >> 6; w < kRootSize / 64; w++) {
+            std::uint64_t bits = root_bitmap_[w];
+            if (w == (index >> 6)) {
+                bits &= ~0ull << (index & 63);
+            }
+            if (bits) {
+                return (now_ & ~std::uint64_t(kRootSize - 1)) + w * 64 + __builtin_ctzll(bits);
+            }
+        }
+        return (now_ | (kRootSize - 1)) + 1;
+    }
+
+    /// 调整asio定时器, 需持有锁
+    void schedule() {
+        if (!timer_ || pending_ == 0) {
+            return;
+        }
+        auto wake = next_wakeup();
+        if (waiting_ && wake >= wake_tick_) {
+            return;
+        }
+        waiting_   = true;
+        wake_tick_ = wake;
+        timer_->expires_at(epoch_ + resolution_ * wake);
+        timer_->async_wait([this](const boost::system::error_code& ec) {
+            if (ec) return;
+            do {
+                WriterLock<MutexPolicy> _lck{mtx_};
+                waiting_ = false;
+            } while (0);
+            poll();
+        });
+    }
+
+private:
+    const std::chrono::milliseconds resolution_;
+    const clock::time_point epoch_;
+
+    MutexPolicy mtx_;
+    std::uint64_t now_   = 0;  // 下一个待处理的tick
+    std::size_t pending_ = 0;
+    std::array<link_t, kBuckets> buckets_;
+    std::array<std::uint64_t, kRootSize / 64> root_bitmap_ = {};
+
+    std::vector<std::unique_ptr<node_t[]>> chunks_;
+    link_t* free_ = nullptr;
+
+    std::optional<boost::asio::steady_timer> timer_;
+    bool waiting_           = false;
+    std::uint64_t wake_tick_ = 0;
+};
+
+using ConcurrentTimerWheel = TimerWheel<std::mutex>;
+
+}  // namespace cc
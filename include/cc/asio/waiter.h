@@ -0,0 +1,312 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <boost/asio.hpp>
+#include <boost/core/noncopyable.hpp>
+#include <cc/asio/helper.h>
+
+namespace cc {
+
+/// 等待者的唤醒顺序
+enum class wake_e : std::uint8_t {
+    FIFO,      // 等待最久的先唤醒
+    LIFO,      // 最近开始等待的先唤醒, 它的协程帧和数据更可能还在缓存里
+    PRIORITY,  // 按等待时给的优先级唤醒(0最高), 同级FIFO
+};
+
+namespace detail {
+
+/// 放在定长缓冲里的完成处理器, 不做堆分配
+template <std::size_t Size = 128>
+class InplaceHandler : boost::noncopyable {
+    alignas(std::max_align_t) unsigned char buf_[Size];
+    void (*post_)(void*)    = nullptr;
+    void (*destroy_)(void*) = nullptr;
+
+public:
+    InplaceHandler() = default;
+    ~InplaceHandler() { reset(); }
+
+    template <typename Handler>
+    void emplace(Handler&& handler) {
+        using H = std::decay_t<Handler>;
+        static_assert(sizeof(H) <= Size && alignof(H) <= alignof(std::max_align_t),
+                      "InplaceHandler: handler too large");
+        reset();
+        new (buf_) H(std::forward<Handler>(handler));
+        post_ = [](void* p) {
+            auto* h = static_cast<H*>(p);
+            H tmp(std::move(*h));
+            h->~H();
+            net::post(std::move(tmp));
+        };
+        destroy_ = [](void* p) { static_cast<H*>(p)->~H(); };
+    }
+
+    inline explicit operator bool() const noexcept { return post_ != nullptr; }
+
+    /// 把处理器post回它自己的executor, 之后为空
+    void post() {
+        auto f   = std::exchange(post_, nullptr);
+        destroy_ = nullptr;
+        f(buf_);
+    }
+
+    void reset() noexcept {
+        if (destroy_) {
+            destroy_(buf_);
+            post_    = nullptr;
+            destroy_ = nullptr;
+        }
+    }
+};
+
+/// 等待节点, 放在等待者的协程帧里, 由队列所有者的锁保护
+///
+/// 唤醒方与取消方可能在不同线程上同时处理同一个节点, 由一个原子状态决定谁恢复等待者:
+/// 唤醒方在所有者的锁内出队时claim(), 取消方在取消回调里抢先置为kCancelled.
+/// 状态放在取消回调对象里(属于cancellation_signal, 不随协程帧销毁), 输掉的一方只访问
+/// 自己的内存, 不会碰到已销毁的节点
+struct WaitNode : boost::noncopyable {
+    enum state_e : std::uint8_t { kWaiting, kNotified, kCancelled };
+
+    WaitNode* prev = nullptr;
+    WaitNode* next = nullptr;
+    bool linked        = false;
+    bool cancelled     = false;
+    std::uint8_t level = 0;  // WakeQueue里的优先级
+    std::size_t count  = 0;  // 请求的数量
+    InplaceHandler<> handler;
+
+    // 取消用: 在所有者的锁内摘下节点
+    void* owner                      = nullptr;
+    bool (*unlink)(void*, WaitNode&) = nullptr;
+    std::atomic<std::uint8_t>* state = nullptr;  // 不可取消时为空
+
+    /// 唤醒方在锁内出队时调用
+    /// @return false表示已被取消, 由取消方恢复, 唤醒方应跳过它
+    inline bool claim() noexcept {
+        if (!state) {
+            return true;
+        }
+        std::uint8_t expected = kWaiting;
+        return state->compare_exchange_strong(expected, kNotified, std::memory_order_acq_rel);
+    }
+
+    /// claim()成功并出队后调用, 恢复等待者; 之后节点随时可能被销毁, 不能再访问
+    inline void resume() { handler.post(); }
+};
+
+/// 侵入式双向链表, 入队/出队/删除都是O(1), 不分配内存. 由所有者的锁保护
+class WaitQueue {
+    WaitNode* head_   = nullptr;
+    WaitNode* tail_   = nullptr;
+    std::size_t size_ = 0;
+
+public:
+    inline bool empty() const noexcept { return size_ == 0; }
+    inline std::size_t size() const noexcept { return size_; }
+    inline WaitNode* front() const noexcept { return head_; }
+
+    void push_back(WaitNode& n) noexcept {
+        n.prev   = tail_;
+        n.next   = nullptr;
+        n.linked = true;
+        (tail_ ? tail_->next : head_) = &n;
+        tail_                         = &n;
+        size_++;
+    }
+
+    /// 出队并claim, 跳过已被取消的节点
+    /// @return 队首节点, 队列为空时返回nullptr
+    WaitNode* pop_front() noexcept {
+        while (auto* n = head_) {
+            erase(*n);
+            if (n->claim()) {
+                return n;
+            }
+        }
+        return nullptr;
+    }
+
+    /// 出队并claim, 跳过已被取消的节点
+    /// @return 队尾节点, 队列为空时返回nullptr
+    WaitNode* pop_back() noexcept {
+        while (auto* n = tail_) {
+            erase(*n);
+            if (n->claim()) {
+                return n;
+            }
+        }
+        return nullptr;
+    }
+
+    /// @return 节点是否在队列里
+    bool erase(WaitNode& n) noexcept {
+        if (!n.linked) {
+            return false;
+        }
+        (n.prev ? n.prev->next : head_) = n.next;
+        (n.next ? n.next->prev : tail_) = n.prev;
+        n.prev = n.next = nullptr;
+        n.linked        = false;
+        size_--;
+        return true;
+    }
+
+    /// 摘下全部节点并claim, 返回以next串起的链表(不含已被取消的), 在锁外逐个resume
+    WaitNode* take_all() noexcept {
+        WaitNode* head = nullptr;
+        WaitNode* tail = nullptr;
+        for (auto* n = head_; n;) {
+            auto* next = n->next;
+            n->prev = n->next = nullptr;
+            n->linked         = false;
+            if (n->claim()) {
+                (tail ? tail->next : head) = n;
+                tail                       = n;
+            }
+            n = next;
+        }
+        head_ = tail_ = nullptr;
+        size_         = 0;
+        return head;
+    }
+
+    /// 恢复take_all返回的链表
+    static void resume_all(WaitNode* head) {
+        while (head) {
+            auto* next = head->next;
+            head->resume();
+            head = next;
+        }
+    }
+};
+
+/// 按wake_e选择唤醒顺序的等待队列, 入队/出队/删除都是O(1). 由所有者的锁保护
+///
+/// 每个优先级一个链表, 用位图找最高的非空级别; FIFO/LIFO只用第0级
+class WakeQueue {
+public:
+    static constexpr std::size_t kLevels = 8;
+
+    explicit WakeQueue(wake_e policy) : policy_(policy) {}
+
+    inline bool empty() const noexcept { return nonempty_ == 0; }
+    inline wake_e policy() const noexcept { return policy_; }
+
+    /// @param priority 仅PRIORITY下有效, 超过kLevels-1的按最低级处理
+    void push(WaitNode& n, std::size_t priority = 0) noexcept {
+        auto level = policy_ == wake_e::PRIORITY ? std::min(priority, kLevels - 1) : 0;
+        n.level    = static_cast<std::uint8_t>(level);
+        levels_[level].push_back(n);
+        nonempty_ |= 1u << level;
+    }
+
+    /// 出队并claim, 某一级的节点都已被取消时继续找下一级
+    /// @return 下一个该唤醒的节点, 队列为空时返回nullptr
+    WaitNode* pop() noexcept {
+        while (nonempty_) {
+            auto level = std::countr_zero(nonempty_);
+            auto& q    = levels_[level];
+            auto* n    = policy_ == wake_e::LIFO ? q.pop_back() : q.pop_front();
+            if (q.empty()) {
+                nonempty_ &= ~(1u << level);
+            }
+            if (n) {
+                return n;
+            }
+        }
+        return nullptr;
+    }
+
+    /// @return 节点是否在队列里
+    bool erase(WaitNode& n) noexcept {
+        auto& q = levels_[n.level];
+        if (!q.erase(n)) {
+            return false;
+        }
+        if (q.empty()) {
+            nonempty_ &= ~(1u << n.level);
+        }
+        return true;
+    }
+
+    /// 按唤醒顺序摘下至多n个节点, 返回以next串起的链表, 在锁外用WaitQueue::resume_all恢复
+    WaitNode* take(std::size_t n) noexcept {
+        WaitNode* head = nullptr;
+        WaitNode* tail = nullptr;
+        for (; n; n--) {
+            auto* w = pop();
+            if (!w) {
+                break;
+            }
+            (tail ? tail->next : head) = w;
+            tail                       = w;
+        }
+        return head;
+    }
+
+private:
+    const wake_e policy_;
+    std::uint32_t nonempty_ = 0;
+    std::array<WaitQueue, kLevels> levels_;
+};
+
+/// 挂起当前协程直到节点被resume或等待被取消(如awaitable_operators的||), 被取消时
+/// node.cancelled为true. 不是协程, 不额外分配协程帧
+///
+/// @tparam Unlink  bool (Owner::*)(WaitNode&), 取消时在所有者的锁内摘下节点
+/// @param enqueue  bool(WaitNode&), 在发起函数里调用: 加锁检查条件, 需要等待时入队并返回true
+template <auto Unlink, typename Owner, typename Enqueue>
+net::awaitable<void> park(WaitNode& node, Owner* owner, Enqueue enqueue) {
+    node.owner     = owner;
+    node.unlink    = [](void* o, WaitNode& n) { return (static_cast<Owner*>(o)->*Unlink)(n); };
+    node.cancelled = false;
+    node.state     = nullptr;
+
+    struct canceller_t {
+        WaitNode* node;
+        std::atomic<std::uint8_t> state{WaitNode::kWaiting};
+
+        explicit canceller_t(WaitNode* n) : node(n) {}
+
+        void operator()(net::cancellation_type_t) {
+            std::uint8_t expected = WaitNode::kWaiting;
+            if (!state.compare_exchange_strong(expected, WaitNode::kCancelled,
+                                               std::memory_order_acq_rel)) {
+                return;  // 已被唤醒, 节点可能已销毁
+            }
+            // 赢了之后只有这里会恢复等待者, 节点一直有效. 唤醒方可能已把它出队并跳过
+            node->unlink(node->owner, *node);
+            node->cancelled = true;
+            node->handler.post();
+        }
+    };
+
+    return net::async_initiate<decltype(net::use_awaitable), void()>(
+        [&node, enqueue](auto handler) mutable {
+            auto slot = net::get_associated_cancellation_slot(handler);
+            node.handler.emplace(std::move(handler));
+            if (slot.is_connected()) {
+                node.state = &slot.template emplace<canceller_t>(&node).state;
+            }
+            if (!enqueue(node)) {
+                // 没有入队, 之后的取消回调什么也不做. asio不允许取消与发起函数并发, 总是成功
+                node.claim();
+                node.resume();
+            }
+        },
+        net::use_awaitable);
+}
+
+}  // namespace detail
+}  // namespace cc
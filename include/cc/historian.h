@@ -0,0 +1,471 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+#include <boost/core/noncopyable.hpp>
+#include <cc/sqlite3pp.h>
+#include <cc/util.h>
+#include <gsl/gsl>
+
+namespace cc {
+
+struct HistorianOptions {
+    std::size_t ring_capacity = 4096;      // 每个tag的内存缓冲样本数, 向上取2的幂
+    int flush_interval_ms     = 1000;      // 后台落盘周期
+    std::int64_t partition_ms = 86400000;  // 原始数据按时间分表, 默认每天一张
+};
+
+/// 过程数据历史库
+///
+/// 采样线程调用append写入每个tag自己的无锁环形缓冲(单生产者), 后台线程周期性地
+/// 在一个事务里用预编译语句批量落盘, 同时维护1s/1min/1h的min/max/avg汇总.
+///
+/// 表结构(均为WITHOUT ROWID):
+///   hist_tags(id, name)
+///   hist_raw_<partition>(tag, ts, value)         按partition_ms分表, 过期数据整表删除
+///   hist_rollup(level, tag, ts, min, max, sum, count)
+///
+/// 查询在调用线程上使用各自的连接, 因此数据库不能是":memory:".
+/// 汇总按增量合并(ON CONFLICT累加), 重启后继续写同一个时间桶也是正确的;
+/// 早于当前时间桶的乱序样本只写原始数据, 不计入汇总.
+class Historian final : boost::noncopyable {
+public:
+    using tag_t = std::uint32_t;
+
+    enum Rollup : int { SECOND = 0, MINUTE = 1, HOUR = 2 };
+
+    struct sample_t {
+        std::int64_t ts;  // 毫秒
+        double value;
+    };
+
+    struct rollup_t {
+        std::int64_t ts;
+        double min;
+        double max;
+        double avg;
+        std::int64_t count;
+    };
+
+private:
+    static constexpr std::int64_t kRollupWidth[3] = {1000, 60000, 3600000};
+
+    enum : std::uint32_t { kChunkBits = 10, kChunkSize = 1 << kChunkBits, kMaxChunks = 4096 };
+
+    // 自上次落盘以来的增量
+    struct bucket_t {
+        std::int64_t ts    = -1;
+        double min         = 0;
+        double max         = 0;
+        double sum         = 0;
+        std::int64_t count = 0;
+    };
+
+    struct alignas(64) tag_state_t {
+        std::unique_ptr<sample_t[]> buf;
+        std::size_t mask = 0;
+        std::atomic<std::uint64_t> head{0};  // 后台线程
+        std::atomic<std::uint64_t> tail{0};  // 采样线程
+        std::uint64_t head_cache = 0;        // 采样线程
+
+        std::string name;
+        std::array<bucket_t, 3> buckets;  // 后台线程
+    };
+
+public:
+    explicit Historian(const std::string& dbpath, HistorianOptions opts = HistorianOptions())
+      : opts_(opts)
+      , capacity_(ceil_pow2(std::max<std::size_t>(opts.ring_capacity, 2)))
+      , db_(dbpath) {
+        if (GSL_UNLIKELY(dbpath == ":memory:")) {
+            throw std::runtime_error("Historian: memory database is not supported");
+        }
+
+        db_.execute(
+            "CREATE TABLE IF NOT EXISTS hist_tags("
+            "id INTEGER PRIMARY KEY, name TEXT NOT NULL UNIQUE);");
+        db_.execute(
+            "CREATE TABLE IF NOT EXISTS hist_rollup("
+            "level INTEGER NOT NULL, tag INTEGER NOT NULL, ts INTEGER NOT NULL, "
+            "min REAL, max REAL, sum REAL, count INTEGER, "
+            "PRIMARY KEY(level, tag, ts)) WITHOUT ROWID;");
+
+        using row_t = std::tuple<std::int64_t, std::string>;
+        auto rows   = db_.execute<row_t>("SELECT id, name FROM hist_tags ORDER BY id;");
+        for (auto& [id, name] : rows) {
+            while (ntags_.load(std::memory_order_relaxed) <= id) {
+                add_tag(std::string());
+            }
+            state(static_cast<tag_t>(id)).name = name;
+            names_[name]                       = static_cast<tag_t>(id);
+        }
+        registered_ = ntags_.load(std::memory_order_relaxed);
+
+        thread_ = std::thread([this] { loop(); });
+    }
+
+    /// 停止后台线程, 落盘剩余数据
+    ~Historian() {
+        do {
+            std::lock_guard _lck{mtx_};
+            stopped_ = true;
+        } while (0);
+        cv_.notify_all();
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+    /// 注册(或查找)tag, 返回的id在库中保持不变
+    tag_t tag(std::string_view name) {
+        std::lock_guard _lck{reg_mtx_};
+        auto it = names_.find(std::string(name));
+        if (it != names_.end()) {
+            return it->second;
+        }
+        auto id = add_tag(std::string(name));
+        names_.emplace(std::string(name), id);
+        return id;
+    }
+
+    /// 写入一个样本, 同一个tag只允许一个线程写入. id不是tag()返回的值时抛出std::out_of_range
+    ///
+    /// @return 缓冲区已满(后台落盘跟不上)时丢弃并返回false
+    inline bool append(tag_t id, double value) { return append(id, now_ms(), value); }
+
+    bool append(tag_t id, std::int64_t ts, double value) {
+        auto& s = state(id);
+        auto t  = s.tail.load(std::memory_order_relaxed);
+        if (GSL_UNLIKELY(t - s.head_cache >= capacity_)) {
+            s.head_cache = s.head.load(std::memory_order_acquire);
+            if (t - s.head_cache >= capacity_) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+        }
+        s.buf[t & s.mask] = sample_t{ts, value};
+        s.tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// 立即落盘并等待完成
+    void flush() {
+        std::unique_lock _lck{mtx_};
+        auto target = ++flush_req_;
+        cv_.notify_all();
+        done_cv_.wait(_lck, [&] { return flush_done_ >= target || stopped_; });
+    }
+
+    /// 原始数据 [from, to)
+    std::vector<sample_t> query(tag_t id, std::int64_t from, std::int64_t to) {
+        std::vector<sample_t> ret;
+        using row_t = std::tuple<std::int64_t, double>;
+        for (auto p : partitions(from, to)) {
+            auto sql  = "SELECT ts, value FROM " + table(p)
+                       + " WHERE tag = ? AND ts >= ? AND ts < ? ORDER BY ts;";
+            auto rows = db_.execute<row_t>(sql, id, from, to);
+            for (auto& [ts, v] : rows) {
+                ret.push_back(sample_t{ts, v});
+            }
+        }
+        return ret;
+    }
+
+    /// 汇总数据 [from, to), 当前时间桶包含已落盘的部分
+    std::vector<rollup_t> rollup(tag_t id, Rollup level, std::int64_t from, std::int64_t to) {
+        using row_t = std::tuple<std::int64_t, double, double, double, std::int64_t>;
+        auto rows   = db_.execute<row_t>(
+            "SELECT ts, min, max, sum, count FROM hist_rollup "
+            "WHERE level = ? AND tag = ? AND ts >= ? AND ts < ? ORDER BY ts;",
+            static_cast<int>(level), id, from - from % kRollupWidth[level], to);
+
+        std::vector<rollup_t> ret;
+        ret.reserve(rows.size());
+        for (auto& [ts, mn, mx, sum, count] : rows) {
+            ret.push_back(rollup_t{ts, mn, mx, count ? sum / count : 0, count});
+        }
+        return ret;
+    }
+
+    /// 删除完全早于ts的原始数据分表, 汇总数据保留
+    ///
+    /// @return 删除的分表个数
+    int drop_before(std::int64_t ts) {
+        int n = 0;
+        for (auto p : partitions(0, ts)) {
+            if ((p + 1) * opts_.partition_ms <= ts) {
+                db_.execute("DROP TABLE IF EXISTS " + table(p) + ";");
+                n++;
+            }
+        }
+        return n;
+    }
+
+    /// 缓冲区满而丢弃的样本数
+    inline std::uint64_t dropped() const noexcept {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+    /// 已落盘的样本数
+    inline std::uint64_t written() const noexcept {
+        return written_.load(std::memory_order_relaxed);
+    }
+
+    static inline std::int64_t now_ms() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+                   std::chrono::system_clock::now().time_since_epoch())
+            .count();
+    }
+
+private:
+    static std::size_t ceil_pow2(std::size_t n) {
+        std::size_t r = 1;
+        while (r < n) r <<= 1;
+        return r;
+    }
+
+    inline tag_state_t& state(tag_t id) {
+        if (GSL_UNLIKELY(id >= ntags_.load(std::memory_order_acquire))) {
+            throw std::out_of_range("Historian: unknown tag " + std::to_string(id));
+        }
+        return chunks_[id >> kChunkBits][id & (kChunkSize - 1)];
+    }
+
+    // 需持有reg_mtx_(或在构造函数中)
+    tag_t add_tag(std::string name) {
+        auto id = ntags_.load(std::memory_order_relaxed);
+        if (GSL_UNLIKELY((id >> kChunkBits) >= kMaxChunks)) {
+            throw std::runtime_error("Historian: too many tags");
+        }
+        auto& chunk = chunks_[id >> kChunkBits];
+        if (!chunk) {
+            chunk = std::make_unique<tag_state_t[]>(kChunkSize);
+        }
+        auto& s = chunk[id & (kChunkSize - 1)];
+        s.buf   = std::make_unique<sample_t[]>(capacity_);
+        s.mask  = capacity_ - 1;
+        s.name  = std::move(name);
+        ntags_.store(id + 1, std::memory_order_release);
+        return id;
+    }
+
+    inline std::int64_t partition_of(std::int64_t ts) const noexcept {
+        auto p = ts / opts_.partition_ms;
+        return (ts < 0 && ts % opts_.partition_ms) ? p - 1 : p;
+    }
+
+    static inline std::string table(std::int64_t partition) {
+        return "hist_raw_" + std::to_string(partition);
+    }
+
+    /// 与 [from, to) 相交且已存在的分表
+    std::vector<std::int64_t> partitions(std::int64_t from, std::int64_t to) {
+        using row_t = std::tuple<std::string>;
+        auto rows   = db_.execute<row_t>(
+            "SELECT name FROM sqlite_master WHERE type = 'table' AND name LIKE 'hist\\_raw\\_%' "
+            "ESCAPE '\\';");
+        auto p0 = partition_of(from);
+        auto p1 = partition_of(to - 1);
+
+        std::vector<std::int64_t> ret;
+        for (auto& [name] : rows) {
+            auto p = std::stoll(name.substr(9));
+            if (p >= p0 && p <= p1) {
+                ret.push_back(p);
+            }
+        }
+        std::sort(ret.begin(), ret.end());
+        return ret;
+    }
+
+    void loop() {
+        cc::set_threadname("historian");
+        for (;;) {
+            std::uint64_t req;
+            bool stop;
+            do {
+                std::unique_lock _lck{mtx_};
+                cv_.wait_for(_lck, std::chrono::milliseconds(opts_.flush_interval_ms),
+                             [this] { return stopped_ || flush_req_ > flush_done_; });
+                req  = flush_req_;
+                stop = stopped_;
+            } while (0);
+
+            try {
+                flush_once();
+            } catch (std::exception& e) {
+                fprintf(stderr, "Error in Historian: %s\n", e.what());
+            }
+
+            do {
+                std::lock_guard _lck{mtx_};
+                flush_done_ = req;
+            } while (0);
+            done_cv_.notify_all();
+
+            if (stop) {
+                break;
+            }
+        }
+        // 预编译语句属于本线程的连接
+        inserts_.clear();
+        upsert_.reset();
+    }
+
+    /// 后台线程: 取出所有缓冲样本, 在一个事务中落盘
+    ///
+    /// 事务失败时内存中的状态不变, 样本留在缓冲里下次重新落盘
+    void flush_once() {
+        auto ntags = ntags_.load(std::memory_order_acquire);
+        if (!upsert_) {
+            upsert_ = std::make_unique<Sqlite3pp::Statement>(db_.prepare(
+                "INSERT INTO hist_rollup(level, tag, ts, min, max, sum, count) "
+                "VALUES(?, ?, ?, ?, ?, ?, ?) ON CONFLICT(level, tag, ts) DO UPDATE SET "
+                "min = MIN(min, excluded.min), max = MAX(max, excluded.max), "
+                "sum = sum + excluded.sum, count = count + excluded.count;"));
+        }
+
+        // 提交成功后才写回
+        struct flushed_t {
+            tag_t id;
+            std::uint64_t tail;
+            std::array<bucket_t, 3> buckets;
+        };
+        std::vector<flushed_t> flushed;
+        auto registered     = registered_;
+        std::uint64_t count = 0;
+        db_.transaction([&] {
+            if (registered < ntags) {
+                std::lock_guard _lck{reg_mtx_};
+                auto stmt = db_.prepare("INSERT OR IGNORE INTO hist_tags(id, name) VALUES(?, ?);");
+                for (; registered < ntags; registered++) {
+                    stmt.execute(registered, state(registered).name);
+                }
+            }
+
+            for (tag_t id = 0; id < ntags; id++) {
+                auto& s = state(id);
+                auto h  = s.head.load(std::memory_order_relaxed);
+                auto t  = s.tail.load(std::memory_order_acquire);
+                if (h == t) {
+                    continue;  // 上次落盘后各时间桶的增量都已清零
+                }
+                auto& f = flushed.emplace_back(flushed_t{id, t, s.buckets});
+                for (auto i = h; i < t; i++) {
+                    auto& e = s.buf[i & s.mask];
+                    insert_stmt(partition_of(e.ts)).execute(id, e.ts, e.value);
+                    accumulate(id, f.buckets, e);
+                }
+                count += t - h;
+
+                for (int level = 0; level < 3; level++) {
+                    commit_bucket(id, level, f.buckets[level]);
+                }
+            }
+        });
+        registered_ = registered;
+        for (auto& f : flushed) {
+            auto& s   = state(f.id);
+            s.buckets = f.buckets;
+            s.head.store(f.tail, std::memory_order_release);
+        }
+        written_.fetch_add(count, std::memory_order_relaxed);
+
+        // 旧分表不会再有新数据, 释放其预编译语句
+        if (inserts_.size() > 2) {
+            auto newest = inserts_.rbegin()->first;
+            for (auto it = inserts_.begin(); it != inserts_.end() && it->first < newest - 1;) {
+                it = inserts_.erase(it);
+            }
+        }
+    }
+
+    Sqlite3pp::Statement& insert_stmt(std::int64_t partition) {
+        auto it = inserts_.find(partition);
+        if (GSL_LIKELY(it != inserts_.end())) {
+            return it->second;
+        }
+        db_.execute("CREATE TABLE IF NOT EXISTS " + table(partition)
+                    + "(tag INTEGER NOT NULL, ts INTEGER NOT NULL, value REAL, "
+                      "PRIMARY KEY(tag, ts)) WITHOUT ROWID;");
+        auto stmt = db_.prepare("INSERT OR REPLACE INTO " + table(partition)
+                                + "(tag, ts, value) VALUES(?, ?, ?);");
+        return inserts_.emplace(partition, std::move(stmt)).first->second;
+    }
+
+    void accumulate(tag_t id, std::array<bucket_t, 3>& buckets, const sample_t& e) {
+        for (int level = 0; level < 3; level++) {
+            auto& b  = buckets[level];
+            auto w   = kRollupWidth[level];
+            auto bts = e.ts - ((e.ts % w) + w) % w;
+            if (bts < b.ts) {
+                continue;  // 乱序样本
+            }
+            if (bts != b.ts) {
+                commit_bucket(id, level, b);
+                b.ts = bts;
+            }
+            if (b.count == 0) {
+                b.min = b.max = e.value;
+                b.sum         = 0;
+            }
+            b.min = std::min(b.min, e.value);
+            b.max = std::max(b.max, e.value);
+            b.sum += e.value;
+            b.count++;
+        }
+    }
+
+    void commit_bucket(tag_t id, int level, bucket_t& b) {
+        if (b.count == 0) {
+            return;
+        }
+        upsert_->execute(level, id, b.ts, b.min, b.max, b.sum, b.count);
+        b.count = 0;
+        b.sum   = 0;
+    }
+
+private:
+    const HistorianOptions opts_;
+    const std::size_t capacity_;
+    Sqlite3pp db_;
+
+    std::mutex reg_mtx_;
+    std::unordered_map<std::string, tag_t> names_;
+    std::unique_ptr<tag_state_t[]> chunks_[kMaxChunks];
+    std::atomic<tag_t> ntags_{0};
+    tag_t registered_ = 0;  // 已写入hist_tags的个数
+
+    std::atomic<std::uint64_t> dropped_{0};
+    std::atomic<std::uint64_t> written_{0};
+
+    // 后台线程
+    std::map<std::int64_t, Sqlite3pp::Statement> inserts_;
+    std::unique_ptr<Sqlite3pp::Statement> upsert_;
+
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    std::condition_variable done_cv_;
+    std::uint64_t flush_req_  = 0;
+    std::uint64_t flush_done_ = 0;
+    bool stopped_             = false;
+    std::thread thread_;
+};
+
+}  // namespace cc
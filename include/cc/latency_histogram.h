@@ -0,0 +1,227 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include <boost/core/noncopyable.hpp>
+#include <gsl/gsl>
+#include <cc/stopwatch.h>
+
+namespace cc {
+
+/// 对数-线性分桶: 每个2的幂区间再线性切分为2^Precision个子桶,
+/// 相对误差不超过 2^-Precision (Precision=5时约3%), 覆盖[0, 2^63)ns.
+template <int Precision>
+struct LatencyBuckets {
+    static_assert(Precision >= 1 && Precision <= 16, "LatencyBuckets: bad precision");
+
+    static constexpr std::uint64_t kSub   = std::uint64_t(1) << Precision;
+    static constexpr std::size_t kBuckets = (64 - Precision + 1) * kSub;
+
+    static inline std::size_t index(std::uint64_t v) noexcept {
+        if (v < kSub) {
+            return static_cast<std::size_t>(v);
+        }
+        int shift = 63 - std::countl_zero(v) - Precision;
+        return static_cast<std::size_t>(kSub + shift * kSub + ((v >> shift) - kSub));
+    }
+
+    /// 桶内的最小值
+    static inline std::uint64_t lowest(std::size_t i) noexcept {
+        if (i < kSub) {
+            return i;
+        }
+        int shift = static_cast<int>(i / kSub) - 1;
+        return (kSub + i % kSub) << shift;
+    }
+
+    /// 桶内的最大值
+    static inline std::uint64_t highest(std::size_t i) noexcept {
+        if (i < kSub) {
+            return i;
+        }
+        int shift = static_cast<int>(i / kSub) - 1;
+        return lowest(i) + ((std::uint64_t(1) << shift) - 1);
+    }
+};
+
+/// 直方图的合并结果, 单位ns
+template <int Precision>
+struct LatencySnapshot {
+    using buckets_t = LatencyBuckets<Precision>;
+
+    std::uint64_t count = 0;
+    std::uint64_t sum   = 0;
+    std::uint64_t min   = std::numeric_limits<std::uint64_t>::max();
+    std::uint64_t max   = 0;
+    std::vector<std::uint64_t> buckets = std::vector<std::uint64_t>(buckets_t::kBuckets);
+
+    /// @param p    百分位, [0, 100]
+    /// @return     不小于p%样本的值(桶上界, 不超过max); 无样本时返回0
+    std::uint64_t percentile(double p) const noexcept {
+        if (count == 0) {
+            return 0;
+        }
+        p                  = std::clamp(p, 0.0, 100.0);
+        auto rank          = static_cast<std::uint64_t>(std::ceil(p / 100.0 * count));
+        rank               = std::max<std::uint64_t>(rank, 1);
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < buckets.size(); i++) {
+            seen += buckets[i];
+            if (seen >= rank) {
+                return std::clamp(buckets_t::highest(i), min, max);
+            }
+        }
+        return max;
+    }
+
+    inline double mean() const noexcept { return count ? double(sum) / count : 0.0; }
+
+    void merge(const LatencySnapshot& o) noexcept {
+        count += o.count;
+        sum += o.sum;
+        min = std::min(min, o.min);
+        max = std::max(max, o.max);
+        for (std::size_t i = 0; i < buckets.size(); i++) {
+            buckets[i] += o.buckets[i];
+        }
+    }
+};
+
+/// 延迟直方图, 多线程无等待记录
+///
+/// 每个线程按到达顺序分配一个分片(最多Shards个, 第一次记录时才分配内存), 分片内只做
+/// relaxed原子加, 读取时合并所有分片. 内存上限为 Shards * kBuckets * 8 字节.
+template <int Precision = 5, std::size_t Shards = 16>
+class BasicLatencyHistogram : boost::noncopyable {
+    using buckets_t = LatencyBuckets<Precision>;
+
+    struct alignas(64) shard_t {
+        std::atomic<std::uint64_t> sum{0};
+        std::atomic<std::uint64_t> min{std::numeric_limits<std::uint64_t>::max()};
+        std::atomic<std::uint64_t> max{0};
+        std::array<std::atomic<std::uint64_t>, buckets_t::kBuckets> buckets{};
+    };
+
+    std::array<std::atomic<shard_t*>, Shards> shards_{};
+
+public:
+    using snapshot_t = LatencySnapshot<Precision>;
+
+    /// 析构时记录作用域耗时
+    template <typename Clock>
+    class Scope : boost::noncopyable {
+        BasicLatencyHistogram& hist_;
+        BasicStopWatch<Clock> sw_;
+
+    public:
+        explicit Scope(BasicLatencyHistogram& hist) : hist_(hist) {}
+        ~Scope() { hist_.record(sw_.elapsed_ns()); }
+    };
+
+    BasicLatencyHistogram() = default;
+
+    ~BasicLatencyHistogram() {
+        for (auto& s : shards_) {
+            delete s.load(std::memory_order_relaxed);
+        }
+    }
+
+    /// 记录一个样本, 负数按0计
+    ///
+    /// @param ns   耗时, 单位ns
+    inline void record(std::int64_t ns) {
+        auto v  = static_cast<std::uint64_t>(std::max<std::int64_t>(ns, 0));
+        auto& s = shard();
+        s.sum.fetch_add(v, std::memory_order_relaxed);
+        s.buckets[buckets_t::index(v)].fetch_add(1, std::memory_order_relaxed);
+
+        // 分片基本只被一个线程写, 极少进入循环
+        auto m = s.max.load(std::memory_order_relaxed);
+        while (v > m && !s.max.compare_exchange_weak(m, v, std::memory_order_relaxed)) {
+        }
+        m = s.min.load(std::memory_order_relaxed);
+        while (v < m && !s.min.compare_exchange_weak(m, v, std::memory_order_relaxed)) {
+        }
+    }
+
+    template <typename Rep, typename Period>
+    inline void record(std::chrono::duration<Rep, Period> d) {
+        record(std::chrono::duration_cast<std::chrono::nanoseconds>(d).count());
+    }
+
+    /// 作用域计时: auto _t = hist.scope();
+    template <typename Clock = SteadyClock>
+    inline Scope<Clock> scope() {
+        return Scope<Clock>(*this);
+    }
+
+    /// 合并所有分片. 与record并发时结果是近似一致的
+    snapshot_t snapshot() const {
+        snapshot_t r;
+        for (auto& p : shards_) {
+            auto* s = p.load(std::memory_order_acquire);
+            if (!s) {
+                continue;
+            }
+            r.sum += s->sum.load(std::memory_order_relaxed);
+            r.min = std::min(r.min, s->min.load(std::memory_order_relaxed));
+            r.max = std::max(r.max, s->max.load(std::memory_order_relaxed));
+            for (std::size_t i = 0; i < r.buckets.size(); i++) {
+                auto n = s->buckets[i].load(std::memory_order_relaxed);
+                r.buckets[i] += n;
+                r.count += n;
+            }
+        }
+        return r;
+    }
+
+    inline std::uint64_t percentile(double p) const { return snapshot().percentile(p); }
+
+    /// 清零. 与record并发时可能丢失少量样本
+    void reset() noexcept {
+        for (auto& p : shards_) {
+            auto* s = p.load(std::memory_order_acquire);
+            if (!s) {
+                continue;
+            }
+            s->sum.store(0, std::memory_order_relaxed);
+            s->min.store(std::numeric_limits<std::uint64_t>::max(), std::memory_order_relaxed);
+            s->max.store(0, std::memory_order_relaxed);
+            for (auto& b : s->buckets) {
+                b.store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+
+private:
+    static inline std::size_t thread_slot() noexcept {
+        static std::atomic<std::size_t> next{0};
+        static thread_local std::size_t slot = next.fetch_add(1, std::memory_order_relaxed);
+        return slot % Shards;
+    }
+
+    inline shard_t& shard() {
+        auto& p = shards_[thread_slot()];
+        auto* s = p.load(std::memory_order_acquire);
+        if (GSL_UNLIKELY(!s)) {
+            auto* n = new shard_t;
+            if (p.compare_exchange_strong(s, n, std::memory_order_acq_rel)) {
+                s = n;
+            } else {
+                delete n;
+            }
+        }
+        return *s;
+    }
+};
+
+using LatencyHistogram = BasicLatencyHistogram<>;
+
+}  // namespace cc
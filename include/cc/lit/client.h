@@ -10,7 +10,9 @@
 #include <boost/beast.hpp>
 #include <boost/core/noncopyable.hpp>
 #include <boost/url.hpp>
+#include <cc/asio/rate_limiter.h>
 #include <cc/lit/multipart_parser.h>
+#include <cc/metrics.h>
 #include <fmt/core.h>
 #include <gsl/gsl>
 
@@ -74,10 +76,12 @@ public:
         if (!queue.empty()) {
             auto conn = queue.front();
             queue.pop_front();
+            hits_.inc();
             co_return conn;
         }
 
         lock.unlock();
+        misses_.inc();
         auto resolver =
             net::use_awaitable.as_default_on(tcp::resolver(co_await net::this_coro::executor));
         tcp_stream stream =
@@ -105,6 +109,10 @@ public:
 
 private:
     const int max_per_host_ = 128;
+    metrics::Counter& hits_ = metrics::Registry::instance().counter(
+        "cc_fetch_pool_total", "fetch connection pool lookups", {{"result", "hit"}});
+    metrics::Counter& misses_ = metrics::Registry::instance().counter(
+        "cc_fetch_pool_total", "fetch connection pool lookups", {{"result", "miss"}});
     std::mutex mtx_;
     std::unordered_map<std::string, std::deque<std::shared_ptr<Connection>>> connections_;
 };
@@ -114,12 +122,13 @@ struct fetch_option_t {
     using method_type  = boost::beast::http::verb;
     using headers_type = boost::beast::http::fields;
 
-    method_type method   = method_type::get;
-    headers_type headers = {};
-    std::string body     = "";
-    int timeout          = 30;  // seconds
-    bool keepalive       = false;
-    int max_retry        = 5;
+    method_type method                   = method_type::get;
+    headers_type headers                 = {};
+    std::string body                     = "";
+    int timeout                          = 30;  // seconds
+    bool keepalive                       = false;
+    int max_retry                        = 5;
+    std::shared_ptr<TokenBucket> limiter = nullptr;  // 发送前先取令牌, 可在多个fetch间共享
 };
 
 template <typename Body = beast::http::string_body>
@@ -151,6 +160,10 @@ fetch(std::string_view url, const fetch_option_t options = {}) {
         requri += u.query();
     }
 
+    if (options.limiter) {
+        co_await options.limiter->acquire();
+    }
+
     for (int retry = options.max_retry; retry > 0; retry--) {
         std::shared_ptr<detail::Connection> conn;
         try {
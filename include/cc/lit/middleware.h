@@ -1,4 +1,7 @@
 #pragma once
 
 #include <cc/lit/middleware/common.h>
+#include <cc/lit/middleware/loop_stats.h>
+#include <cc/lit/middleware/metrics.h>
+#include <cc/lit/middleware/rate_limit.h>
 #include <cc/lit/middleware/serve_static.h>
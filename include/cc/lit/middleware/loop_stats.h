@@ -0,0 +1,104 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cc/asio/pool.h>
+#include <cc/json.h>
+#include <cc/lit/object.h>
+
+namespace cc {
+namespace lit {
+
+namespace detail {
+
+struct latency_json_t {
+    std::uint64_t count;
+    std::uint64_t p50;
+    std::uint64_t p99;
+    std::uint64_t p999;
+    std::uint64_t max;
+};
+
+struct shard_json_t {
+    std::size_t index;
+    latency_json_t lag_ns;
+};
+
+struct thread_json_t {
+    std::string name;
+    std::size_t shard;
+    std::uint64_t handlers;
+    std::int64_t busy_ns;
+    latency_json_t exec_ns;
+};
+
+struct slow_json_t {
+    std::string thread;
+    std::int64_t duration_ns;
+    std::int64_t time_ms;
+    std::string stacktrace;
+};
+
+struct loop_stats_json_t {
+    std::vector<shard_json_t> shards;
+    std::vector<thread_json_t> threads;
+    std::vector<slow_json_t> slow;
+};
+
+template <typename Snapshot>
+latency_json_t latency_json(const Snapshot& s) {
+    return {s.count, s.percentile(50), s.percentile(99), s.percentile(99.9), s.max};
+}
+
+/// AsioPool::loop_stats()的JSON形式, 时长单位ns
+inline std::string loop_stats_json(const loop_stats_t& st) {
+    loop_stats_json_t out;
+    out.shards.reserve(st.shards.size());
+    for (std::size_t i = 0; i < st.shards.size(); i++) {
+        out.shards.push_back({i, latency_json(st.shards[i].lag)});
+    }
+    out.threads.reserve(st.threads.size());
+    for (std::size_t i = 0; i < st.threads.size(); i++) {
+        auto& t = st.threads[i];
+        out.threads.push_back({"net#" + std::to_string(i + 1), t.shard, t.handlers, t.busy_ns,
+                               latency_json(t.exec)});
+    }
+    out.slow.reserve(st.slow.size());
+    for (auto& s : st.slow) {
+        auto when = std::chrono::duration_cast<std::chrono::milliseconds>(
+                        s.when.time_since_epoch())
+                        .count();
+        out.slow.push_back({"net#" + std::to_string(s.thread + 1), s.duration_ns,
+                            static_cast<std::int64_t>(when), s.stacktrace});
+    }
+    return cc::json::dump(out);
+}
+
+}  // namespace detail
+
+/// 以JSON暴露AsioPool的事件循环监测结果(AsioPool::enable_monitor): 各分片的循环延迟,
+/// 各线程的处理器执行时间分布, 最近的慢处理器及其调用栈
+class LoopStatsExporter {
+    std::string path_;
+    AsioPool* pool_;
+
+public:
+    explicit LoopStatsExporter(AsioPool& pool, std::string_view path = "/debug/loop")
+      : path_(path)
+      , pool_(&pool) {}
+
+    net::awaitable<void>  //
+    operator()(const auto& req, auto& resp, const auto& go) {
+        if (req->method() != http::verb::get || req.path != path_) {
+            co_return co_await go();
+        }
+        resp.set_content(detail::loop_stats_json(pool_->loop_stats()), "application/json");
+    }
+};
+
+}  // namespace lit
+}  // namespace cc
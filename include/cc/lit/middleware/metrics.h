@@ -0,0 +1,38 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <boost/asio/thread_pool.hpp>
+#include <cc/asio/helper.h>
+#include <cc/lit/object.h>
+#include <cc/metrics.h>
+
+namespace cc {
+namespace lit {
+
+/// 以Prometheus文本格式暴露cc::metrics, 聚合在独立线程上完成, 不占用io线程
+class MetricsExporter {
+    std::string path_;
+    std::shared_ptr<net::thread_pool> pool_;
+
+public:
+    explicit MetricsExporter(std::string_view path = "/metrics")
+      : path_(path)
+      , pool_(std::make_shared<net::thread_pool>(1)) {}
+
+    net::awaitable<void>  //
+    operator()(const auto& req, auto& resp, const auto& go) {
+        if (req->method() != http::verb::get || req.path != path_) {
+            co_return co_await go();
+        }
+
+        auto body = co_await cc::schedule(*pool_, [] {
+            return metrics::Registry::instance().scrape();
+        });
+        resp.set_content(body, "text/plain; version=0.0.4");
+    }
+};
+
+}  // namespace lit
+}  // namespace cc
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <cc/asio/rate_limiter.h>
+#include <cc/lit/object.h>
+
+namespace cc {
+namespace lit {
+
+namespace detail {
+
+struct address_hash {
+    std::size_t operator()(const net::ip::address& a) const noexcept {
+        if (a.is_v4()) {
+            return std::hash<std::uint32_t>{}(a.to_v4().to_uint());
+        }
+        auto bytes = a.to_v6().to_bytes();
+        return std::hash<std::string_view>{}(
+            std::string_view(reinterpret_cast<const char*>(bytes.data()), bytes.size()));
+    }
+};
+
+}  // namespace detail
+
+/// 按客户端IP限速, 可以再挂一个所有IP共享的全局限速器. 超出速率的请求先延迟处理,
+/// 需要等待超过max_delay_ms时直接返回429 Too Many Requests
+class RateLimit {
+    using limiter_t = KeyedRateLimiter<net::ip::address, std::mutex, LockGuard, detail::address_hash>;
+
+    // 每处理kSweepEvery个请求回收一次空闲IP的令牌桶
+    static constexpr std::size_t kSweepEvery = 4096;
+
+    struct state_t {
+        limiter_t limiter;
+        std::atomic<std::size_t> requests{0};
+
+        state_t(double rate, double burst, std::shared_ptr<TokenBucket> global)
+          : limiter(rate, burst, std::move(global)) {}
+    };
+
+    std::shared_ptr<state_t> state_;
+    int max_delay_ms_;
+
+public:
+    /// @param rate         每个IP每秒的请求数
+    /// @param burst        每个IP的突发请求数
+    /// @param max_delay_ms 能接受的最长延迟(毫秒), 0表示超出速率时立即返回429
+    /// @param global       所有IP共享的限速器, 可以为空
+    RateLimit(double rate, double burst, int max_delay_ms = 0,
+              std::shared_ptr<TokenBucket> global = nullptr)
+      : state_(std::make_shared<state_t>(rate, burst, std::move(global)))
+      , max_delay_ms_(max_delay_ms) {}
+
+    net::awaitable<void>  //
+    operator()(const auto& req, auto& resp, const auto& go) {
+        if (state_->requests.fetch_add(1, std::memory_order_relaxed) % kSweepEvery == 0) {
+            state_->limiter.sweep();
+        }
+        if (!co_await state_->limiter.acquire_for(req.remote, max_delay_ms_)) {
+            resp->result(http::status::too_many_requests);
+            resp->set(http::field::retry_after, "1");
+            resp->body() = "Too many requests\n";
+            co_return;
+        }
+        co_await go();
+    }
+};
+
+}  // namespace lit
+}  // namespace cc
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <functional>
 #include <iomanip>
 #include <optional>
@@ -71,6 +72,8 @@ struct http_request_t {
     std::string_view path;
     std::optional<kv_t> queries;         // ?a=b&c=d
     mutable std::optional<kv_t> params;  // compile route path(/:user/:name)
+    std::uint64_t trace_id = 0;          // 所属的trace异步轨道, 用作CC_TRACE_CO_SCOPE的父id
+    net::ip::address remote;             // 客户端地址
 
     inline raw_type* operator->() { return &raw; }
     inline const raw_type* operator->() const { return &raw; }
@@ -9,6 +9,8 @@
 #include <boost/beast.hpp>
 #include <boost/noncopyable.hpp>
 #include <cc/lit/object.h>
+#include <cc/metrics.h>
+#include <cc/trace.h>
 #include <gsl/gsl>
 
 namespace cc {
@@ -42,7 +44,12 @@ public:
             Functor(http::verb method, std::string_view path, const route_handler& handler)
               : method_(method)
               , parse_path_(compile_route(path))
-              , handler_(handler) {}
+              , handler_(handler)
+              , latency_(&metrics::Registry::instance().histogram(
+                    "cc_lit_route_seconds", "lit route handler latency",
+                    {{"method", method == (http::verb)-1 ? std::string("ANY")
+                                                         : std::string(http::to_string(method))},
+                     {"route", std::string(path)}})) {}
 
             net::awaitable<void>
             operator()(const request_type& req, response_type& resp, const next_handler& go) {
@@ -58,6 +65,7 @@ public:
                 }
 
                 req.params = std::move(params);
+                auto _t    = latency_->scope();
                 co_await handler_(req, resp, go);
             }
 
@@ -65,6 +73,7 @@ public:
             http::verb method_;
             std::function<std::tuple<bool, kv_t>(std::string_view)> parse_path_;
             route_handler handler_;
+            metrics::Histogram* latency_;
         };
 
         return use(Functor(method, path, h));
@@ -72,6 +81,7 @@ public:
 
     net::awaitable<void>  //
     process(const request_type& req, response_type& resp, const next_handler& go) {
+        CC_TRACE_CO_SCOPE("Router::process", req.trace_id);
         try {
             co_await process_one(0, req, resp, go);
         } catch (std::exception& e) {
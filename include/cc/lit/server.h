@@ -1,20 +1,51 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <memory>
 #include <regex>
 #include <string>
 #include <vector>
 #include <boost/noncopyable.hpp>
+#include <cc/asio/helper.h>
+#include <cc/asio/pool.h>
 #include <cc/lit/middleware.h>
 #include <cc/lit/object.h>
 #include <cc/lit/router.h>
+#include <cc/metrics.h>
+#include <cc/trace.h>
 #include <cc/type_traits.h>
 #include <stdint.h>
 
 namespace cc {
 namespace lit {
 
+namespace detail {
+
+inline metrics::Counter& requests_total(unsigned code) {
+    static std::array<std::atomic<metrics::Counter*>, 600> cache{};
+    if (code >= cache.size()) {
+        code = 0;
+    }
+    auto* c = cache[code].load(std::memory_order_acquire);
+    if (GSL_UNLIKELY(!c)) {
+        c = &metrics::Registry::instance().counter(
+            "cc_lit_requests_total", "HTTP requests handled by lit::App",
+            {{"code", std::to_string(code)}});
+        cache[code].store(c, std::memory_order_release);
+    }
+    return *c;
+}
+
+inline metrics::Gauge& active_connections() {
+    static auto& g = metrics::Registry::instance().gauge("cc_lit_connections",
+                                                         "Open lit::App connections");
+    return g;
+}
+
+}  // namespace detail
+
 class App final : boost::noncopyable {
 public:
     using ReqBody       = http_request_body_t;
@@ -28,13 +59,17 @@ public:
     struct option_t {
         int body_limit;
         int timeout;
-        int backlog;
+        int backlog;  // 监听队列长度, <= 0时取max_listen_connections
     };
 
 private:
+    using acceptor_t = net::use_awaitable_t<>::as_default_on_t<tcp::acceptor>;
+
     net::io_context& ioc_;
+    AsioPool* pool_ = nullptr;
     const std::string ip_;
     const uint16_t port_;
+    uint16_t bound_port_ = 0;
     const option_t option_;
     router_t router_;
     std::vector<ws_handler0> ws_router_;
@@ -42,7 +77,7 @@ private:
 
 public:
     App(net::io_context& ctx, std::string_view ip, uint16_t port,
-        const option_t& option = {-1, 30, 128})
+        const option_t& option = {-1, 30, -1})
       : ioc_(ctx)
       , ip_(ip)
       , port_(port)
@@ -52,6 +87,14 @@ public:
         router_.use(middleware::auto_headers<ReqBody, RespBody>);
     }
 
+    /// 在pool的每个io_context上各开一个SO_REUSEPORT监听, 由内核在各线程间分配连接,
+    /// 会话留在接受它的线程上. 配合AsioPool(cc::sharded, n)使用; 共用模式的pool只有一个监听
+    App(AsioPool& pool, std::string_view ip, uint16_t port,
+        const option_t& option = {-1, 30, -1})
+      : App(pool.get_io_context(0), ip, port, option) {
+        pool_ = &pool;
+    }
+
     ~App() = default;
 
     App& on_error(const on_error_handler& h) {
@@ -60,22 +103,56 @@ public:
     }
 
     void start() {
-        auto address = net::ip::make_address(ip_);
-        net::co_spawn(ioc_, do_listen(tcp::endpoint{address, port_}), [this](auto e) {
-            try {
-                handle_exception(e);
-            } catch (std::exception& e0) {
-                if (!(on_error_ && on_error_(e0.what()))) {
-                    throw;
-                }
+        std::size_t n = pool_ ? pool_->size() : 1;
+#ifndef SO_REUSEPORT
+        n = 1;
+#endif
+        try {
+            tcp::endpoint endpoint{net::ip::make_address(ip_), port_};
+            for (std::size_t i = 0; i < n; i++) {
+                auto& ctx     = pool_ ? pool_->get_io_context(i) : ioc_;
+                auto acceptor = open_acceptor(ctx, endpoint, n > 1);
+                // 端口为0时由第一个监听选定, 其余监听绑定到同一个端口
+                endpoint.port(acceptor.local_endpoint().port());
+                net::co_spawn(ctx, do_listen(std::move(acceptor)), [this](auto e) {
+                    try {
+                        handle_exception(e);
+                    } catch (std::exception& e0) {
+                        if (!(on_error_ && on_error_(e0.what()))) {
+                            throw;
+                        }
+                    }
+                });
+            }
+            bound_port_ = endpoint.port();
+        } catch (std::exception& e) {
+            if (!(on_error_ && on_error_(e.what()))) {
+                throw;
             }
-        });
+        }
     }
 
+    /// 实际监听的端口, 构造时端口为0时由系统分配. start()之后有效
+    inline uint16_t port() const noexcept { return bound_port_; }
+
     App& serve_static(std::string_view mountpoint, std::string_view dir) {
         return use(StaticFileProvider(mountpoint, dir));
     }
 
+    /// Prometheus抓取入口, 见cc/metrics.h
+    App& serve_metrics(std::string_view path = "/metrics") { return use(MetricsExporter(path)); }
+
+    /// 事件循环监测的调试入口, 见AsioPool::enable_monitor
+    App& serve_loop_stats(AsioPool& pool, std::string_view path = "/debug/loop") {
+        return use(LoopStatsExporter(pool, path));
+    }
+
+    /// 按客户端IP限速, 见RateLimit
+    App& rate_limit(double rate, double burst, int max_delay_ms = 0,
+                    std::shared_ptr<TokenBucket> global = nullptr) {
+        return use(RateLimit(rate, burst, max_delay_ms, std::move(global)));
+    }
+
     App& websocket(std::string_view path, ws_handler<ReqBody>&& handler) {
         class Functor {
         public:
@@ -177,24 +254,30 @@ private:
         }
     }
 
-    // Accepts incoming connections and launches the sessions
-    net::awaitable<void> do_listen(tcp::endpoint endpoint) {
-        // Open the acceptor
-        auto acceptor =
-            net::use_awaitable.as_default_on(tcp::acceptor(co_await net::this_coro::executor));
+    acceptor_t open_acceptor(net::io_context& ctx, const tcp::endpoint& endpoint,
+                             bool reuse_port) {
+        acceptor_t acceptor(ctx);
         acceptor.open(endpoint.protocol());
 
-        // Disallow address reuse
+        // Allow address reuse
         acceptor.set_option(net::socket_base::reuse_address(true));
+#ifdef SO_REUSEPORT
+        if (reuse_port) {
+            acceptor.set_option(cc::reuse_port(true));
+        }
+#endif
 
         // Bind to the server address
         acceptor.bind(endpoint);
 
         // Start listening for connections
-        // const auto backlog = net::socket_base::max_listen_connections;
-        const auto backlog = option_.backlog;
-        acceptor.listen(net::socket_base::max_listen_connections);
+        acceptor.listen(option_.backlog > 0 ? option_.backlog
+                                            : net::socket_base::max_listen_connections);
+        return acceptor;
+    }
 
+    // Accepts incoming connections and launches the sessions
+    net::awaitable<void> do_listen(acceptor_t acceptor) {
         for (;;) {
             auto stream = std::make_shared<tcp_stream>(co_await acceptor.async_accept());
             net::co_spawn(acceptor.get_executor(), do_session(stream), [this](auto e) {
@@ -213,6 +296,11 @@ private:
     net::awaitable<void> do_session(std::shared_ptr<tcp_stream> stream) {
         // This buffer is required to persist across reads
         beast::flat_buffer buffer;
+        cc::trace::AsyncSpan session_span("App::do_session");
+        detail::active_connections().inc();
+        auto _ = gsl::finally([] { detail::active_connections().dec(); });
+        beast::error_code remote_ec;
+        auto remote = stream->socket().remote_endpoint(remote_ec).address();
 
         try {
             for (;;) {
@@ -229,6 +317,10 @@ private:
                 }
                 co_await http::async_read(*stream, buffer, request_parser);
                 req.raw = request_parser.release();
+                req.remote = remote;
+
+                cc::trace::AsyncSpan request_span("App::request", session_span.id());
+                req.trace_id = request_span.id();
 
                 if (GSL_LIKELY(req.compile_target())) {
                     if (GSL_UNLIKELY(beast::websocket::is_upgrade(req.raw))) {
@@ -248,6 +340,7 @@ private:
                     resp->prepare_payload();
                 }
 
+                detail::requests_total(resp->result_int()).inc();
                 http::message_generator msg(std::move(resp.raw));
                 // Determine if we should close the connection
                 bool keep_alive = msg.keep_alive();
@@ -0,0 +1,236 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <boost/core/noncopyable.hpp>
+#include <cc/latency_histogram.h>
+#include <fmt/format.h>
+
+namespace cc {
+namespace metrics {
+
+using labels_t = std::vector<std::pair<std::string, std::string>>;
+
+namespace detail {
+
+inline constexpr std::size_t kCells = 16;
+
+/// 线程按到达顺序分到一个单元, 前kCells个线程互不共享缓存行
+inline std::size_t cell_index() noexcept {
+    static std::atomic<std::size_t> next{0};
+    static thread_local std::size_t slot = next.fetch_add(1, std::memory_order_relaxed);
+    return slot % kCells;
+}
+
+template <typename T>
+struct alignas(64) cell_t {
+    std::atomic<T> v{0};
+};
+
+inline void escape_to(std::string& out, std::string_view s) {
+    for (char c : s) {
+        switch (c) {
+            case '\\': out += "\\\\"; break;
+            case '"': out += "\\\""; break;
+            case '\n': out += "\\n"; break;
+            default: out += c;
+        }
+    }
+}
+
+/// {k="v",...}, 无标签时为空串
+inline std::string format_labels(const labels_t& labels) {
+    std::string out;
+    for (auto& [k, v] : labels) {
+        out += out.empty() ? '{' : ',';
+        out += k;
+        out += "=\"";
+        escape_to(out, v);
+        out += '"';
+    }
+    if (!out.empty()) {
+        out += '}';
+    }
+    return out;
+}
+
+}  // namespace detail
+
+/// 单调递增计数器
+class Counter : boost::noncopyable {
+    std::array<detail::cell_t<std::uint64_t>, detail::kCells> cells_;
+
+public:
+    inline void inc(std::uint64_t n = 1) noexcept {
+        cells_[detail::cell_index()].v.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    std::uint64_t value() const noexcept {
+        std::uint64_t sum = 0;
+        for (auto& c : cells_) {
+            sum += c.v.load(std::memory_order_relaxed);
+        }
+        return sum;
+    }
+};
+
+/// 可增减的瞬时值. add在各线程的单元上累加, set与并发的add之间不保证原子
+class Gauge : boost::noncopyable {
+    std::array<detail::cell_t<double>, detail::kCells> cells_;
+
+public:
+    inline void add(double v) noexcept {
+        cells_[detail::cell_index()].v.fetch_add(v, std::memory_order_relaxed);
+    }
+
+    inline void inc() noexcept { add(1); }
+    inline void dec() noexcept { add(-1); }
+
+    void set(double v) noexcept {
+        for (auto& c : cells_) {
+            c.v.store(0, std::memory_order_relaxed);
+        }
+        cells_[0].v.store(v, std::memory_order_relaxed);
+    }
+
+    double value() const noexcept {
+        double sum = 0;
+        for (auto& c : cells_) {
+            sum += c.v.load(std::memory_order_relaxed);
+        }
+        return sum;
+    }
+};
+
+/// 延迟直方图, 记录单位ns, 导出时按秒和固定的le边界聚合
+/// Prometheus的桶本身就很粗, 这里用4位精度(约6%)换取每个分片8KB的内存
+class Histogram : public BasicLatencyHistogram<4> {
+public:
+    inline void observe(std::int64_t ns) { record(ns); }
+};
+
+// clang-format off
+inline const std::vector<double> kDefaultBounds = {
+    0.0001, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10
+};  // clang-format on
+
+/// 进程内的指标注册表, 获取到的指标引用在进程生命周期内有效, 调用方应缓存引用
+class Registry : boost::noncopyable {
+    enum type_t { COUNTER, GAUGE, HISTOGRAM };
+
+    struct family_t {
+        std::string help;
+        type_t type;
+        std::map<std::string, std::shared_ptr<void>> series;  // labels -> metric
+    };
+
+    mutable std::shared_mutex mtx_;
+    std::map<std::string, family_t, std::less<>> families_;
+
+public:
+    static Registry& instance() {
+        static Registry ins;
+        return ins;
+    }
+
+    Counter& counter(std::string_view name, std::string_view help, const labels_t& labels = {}) {
+        return get<Counter>(name, help, labels, COUNTER);
+    }
+
+    Gauge& gauge(std::string_view name, std::string_view help, const labels_t& labels = {}) {
+        return get<Gauge>(name, help, labels, GAUGE);
+    }
+
+    Histogram& histogram(std::string_view name, std::string_view help,
+                         const labels_t& labels = {}) {
+        return get<Histogram>(name, help, labels, HISTOGRAM);
+    }
+
+    /// Prometheus text format 0.0.4
+    std::string scrape() const {
+        std::string out;
+        std::shared_lock _lck{mtx_};
+        for (auto& [name, f] : families_) {
+            static const char* types[] = {"counter", "gauge", "histogram"};
+            out += fmt::format("# HELP {} {}\n# TYPE {} {}\n", name, f.help, name, types[f.type]);
+            for (auto& [labels, p] : f.series) {
+                if (f.type == COUNTER) {
+                    auto* c = static_cast<Counter*>(p.get());
+                    out += fmt::format("{}{} {}\n", name, labels, c->value());
+                } else if (f.type == GAUGE) {
+                    auto* g = static_cast<Gauge*>(p.get());
+                    out += fmt::format("{}{} {}\n", name, labels, g->value());
+                } else {
+                    scrape_histogram(out, name, labels, *static_cast<Histogram*>(p.get()));
+                }
+            }
+        }
+        return out;
+    }
+
+private:
+    template <typename T>
+    T& get(std::string_view name, std::string_view help, const labels_t& labels, type_t type) {
+        auto key = detail::format_labels(labels);
+        do {
+            std::shared_lock _lck{mtx_};
+            auto it = families_.find(name);
+            if (it != families_.end() && it->second.type == type) {
+                auto s = it->second.series.find(key);
+                if (s != it->second.series.end()) {
+                    return *static_cast<T*>(s->second.get());
+                }
+            }
+        } while (0);
+
+        std::unique_lock _lck{mtx_};
+        auto it = families_.find(name);
+        if (it == families_.end()) {
+            it = families_.emplace(std::string(name), family_t{std::string(help), type, {}}).first;
+        } else if (GSL_UNLIKELY(it->second.type != type)) {
+            throw std::runtime_error("metrics: type mismatch. name=" + std::string(name));
+        }
+        auto& p = it->second.series[key];
+        if (!p) {
+            p = std::make_shared<T>();
+        }
+        return *static_cast<T*>(p.get());
+    }
+
+    static void scrape_histogram(std::string& out, const std::string& name,
+                                 const std::string& labels, const Histogram& h) {
+        auto snap       = h.snapshot();
+        using buckets_t = decltype(snap)::buckets_t;
+
+        // 在已有标签后追加le
+        auto prefix = labels.empty() ? std::string("{") : labels.substr(0, labels.size() - 1);
+        if (!labels.empty()) {
+            prefix += ',';
+        }
+        std::uint64_t cum = 0;
+        std::size_t i     = 0;
+        for (double bound : kDefaultBounds) {
+            auto bound_ns = static_cast<std::uint64_t>(bound * 1e9);
+            for (; i < snap.buckets.size() && buckets_t::highest(i) <= bound_ns; i++) {
+                cum += snap.buckets[i];
+            }
+            out += fmt::format("{}_bucket{}le=\"{}\"}} {}\n", name, prefix, bound, cum);
+        }
+        out += fmt::format("{}_bucket{}le=\"+Inf\"}} {}\n", name, prefix, snap.count);
+        out += fmt::format("{}_sum{} {}\n", name, labels, snap.sum / 1e9);
+        out += fmt::format("{}_count{} {}\n", name, labels, snap.count);
+    }
+};
+
+}  // namespace metrics
+}  // namespace cc
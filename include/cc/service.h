@@ -8,6 +8,7 @@
 #include <unordered_map>
 #include <boost/asio.hpp>
 #include <boost/callable_traits.hpp>
+#include <cc/trace.h>
 #include <cc/type_traits.h>
 #include <cc/util.h>
 
@@ -129,6 +130,7 @@ public:
     template <typename R, typename... Args>
     std::enable_if_t<cc::is_awaitable_v<R>, R>  // clang-format on
     call(std::string_view svc, Args... args) const {
+        CC_TRACE_CO_SCOPE("Service::call");
         using Inner = typename R::value_type;
         auto lck    = std::make_unique<ReaderLock<MutexPolicy>>(mtx_);
         std::string svc0(svc);
@@ -160,6 +162,7 @@ public:
     template <typename R, typename... Args>
     std::enable_if_t<!cc::is_awaitable_v<R>, R>  // clang-format on
     call(std::string_view svc, Args... args) const {
+        CC_TRACE_SCOPE("Service::call");
         ReaderLock<MutexPolicy> _lck{mtx_};
         std::string svc0(svc);
         auto iter = functors_.find(svc0);
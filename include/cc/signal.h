@@ -8,9 +8,11 @@
 #include <string>
 #include <typeinfo>
 #include <unordered_map>
+#include <unordered_set>
 #include <boost/callable_traits.hpp>
 #include <boost/core/demangle.hpp>
 #include <boost/core/noncopyable.hpp>
+#include <cc/metrics.h>
 #include <cc/stopwatch.h>
 #include <cc/type_traits.h>
 #include <cc/util.h>
@@ -66,6 +68,29 @@ public:
     }
 };
 
+inline constexpr std::size_t kMaxTopicSeries = 256;
+
+/// cc_signal_pub_total按topic分序列, 序列不随退订删除(可能被其他Signal共用).
+/// 进程内最多kMaxTopicSeries个话题有自己的序列, 之后新出现的话题都计入topic="other"
+inline metrics::Counter& signal_pub_counter(const std::string& topic) {
+    static std::mutex mtx;
+    static std::unordered_set<std::string> topics;
+
+    std::string label = topic;
+    do {
+        std::lock_guard<std::mutex> _lck{mtx};
+        if (!topics.contains(topic)) {
+            if (topics.size() < kMaxTopicSeries) {
+                topics.insert(topic);
+            } else {
+                label = "other";
+            }
+        }
+    } while (0);
+    return metrics::Registry::instance().counter(
+        "cc_signal_pub_total", "Signal::pub calls per subscribed topic", {{"topic", label}});
+}
+
 }  // namespace detail
 
 // clang-format off
@@ -123,6 +148,36 @@ public:
         return sub(topic, duration, 1, std::forward<Fn>(f));
     }
 
+#ifdef CC_ENABLE_COROUTINE
+
+    /// 按令牌桶整形某个话题: 超出速率的事件不丢弃, 延迟到取得令牌时回调.
+    /// 参数总是拷贝一份, 回调总是在ex上执行(ex可以是strand), 不在pub的线程上
+    ///
+    /// @param topic    话题
+    /// @param limiter  令牌桶, 可以在多个话题间共享
+    /// @param ex       回调所在的executor
+    /// @param f        回调
+    /// @return handler_t  句柄id
+    template <typename Fn, typename = std::enable_if_t<!std::is_member_function_pointer_v<Fn>>>
+    handler_t sub(std::string_view topic, std::shared_ptr<TokenBucket> limiter,
+                  net::any_io_executor ex, Fn&& f) {
+        auto f0         = make_sig_handle(std::forward<Fn>(f));
+        decltype(f0) nf = [limiter, ex, f0 = std::move(f0)](const auto&... args) {
+            if (limiter->try_acquire()) {
+                net::post(ex, [f0, args...] { f0(args...); });
+                return;
+            }
+            auto delayed = [limiter, f0, args...]() -> net::awaitable<void> {
+                co_await limiter->acquire();
+                f0(args...);
+            };
+            net::co_spawn(ex, std::move(delayed), net::detached);
+        };
+        return sub(topic, std::move(nf));
+    }
+
+#endif
+
     template <typename MemFn, typename Cls>
     std::enable_if_t<std::is_member_function_pointer_v<MemFn>, handler_t>
     sub(std::string_view topic, const MemFn& fn, Cls obj) {
@@ -154,6 +209,9 @@ public:
         }
 
         ReaderLock<MutexPolicy> _lck{mtx_};
+        if (auto c = pub_counters_.find(topic0); c != pub_counters_.end()) {
+            c->second->inc();
+        }
         auto range = registry_.equal_range(topic0);
         for (auto it = range.first; it != range.second; ++it) {
             const auto* f = std::any_cast<std::function<Signature>>(&(handlers_.at(it->second)));
@@ -170,6 +228,7 @@ public:
         }
         registry_.erase(topic0);
         topic_types_.erase(topic0);
+        pub_counters_.erase(topic0);
     }
 
     void unsub(handler_t id) {
@@ -190,6 +249,7 @@ public:
 
         if (!registry_.contains(topic)) {
             topic_types_.erase(topic);
+            pub_counters_.erase(topic);
         }
     }
 
@@ -219,6 +279,7 @@ private:
             }
         } else {
             topic_types_.emplace(topic0, (std::string&&)typname);
+            pub_counters_.emplace(topic0, &detail::signal_pub_counter(topic0));
         }
         handler_t h = next_id_++;
         registry_.emplace(std::string(topic), h);
@@ -253,6 +314,7 @@ private:
     std::unordered_multimap<std::string, handler_t> registry_;
     std::unordered_map<handler_t, std::any> handlers_;
     std::unordered_map<std::string, std::string> topic_types_;
+    std::unordered_map<std::string, metrics::Counter*> pub_counters_;  // 只统计有订阅者的话题
 };
 
 using ConcurrentSignal = Signal<std::recursive_mutex>;
@@ -1,9 +1,14 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <stdexcept>
 #include <type_traits>
+#include <utility>
+#include <gsl/gsl>
 
 namespace cc {
 
@@ -20,16 +25,27 @@ class SingletonProvider {
     static inline std::unique_ptr<T> ins_ = nullptr;
     static inline std::once_flag flag_;
 
+    // 初始化完成后instance()只做一次acquire读, 不再进入call_once
+    static inline std::atomic<T*> ptr_{nullptr};
+
 public:
     using value_type = T;
 
     template <typename... Args>
     static std::enable_if_t<std::is_constructible_v<T, Args...>>  //
     init(Args&&... args) {
-        std::call_once(flag_, [&] { ins_ = std::make_unique<T>(std::forward<Args>(args)...); });
+        std::call_once(flag_, [&] {
+            ins_ = std::make_unique<T>(std::forward<Args>(args)...);
+            ptr_.store(ins_.get(), std::memory_order_release);
+        });
     }
 
     static T& instance() {
+        auto* p = ptr_.load(std::memory_order_acquire);
+        if (GSL_LIKELY(p)) {
+            return *p;
+        }
+
         if constexpr (std::is_constructible_v<T>) {
             init();
         } else {
@@ -41,4 +57,106 @@ public:
     }
 };
 
+/// 分片的单例: 每个线程按到达顺序分到一个分片, 分片内的实例在第一次访问时构造
+///
+/// 前Shards个线程各自独占一个实例, 之后的线程与前面的线程共享, 因此线程数可能超过Shards时
+/// T自身应是线程安全的(例如StFactory<std::mutex>), 此时只是把一把锁拆成了Shards把.
+/// 按线程而不按CPU分片: 线程被抢占或迁移后sched_getcpu()会变, 同一实例会被交错使用.
+template <typename T, std::size_t Shards = 64,
+          typename = std::enable_if_t<detail::is_noncopyable_v<T>>>
+class ShardedProvider {
+    struct storage_t {
+        std::array<std::atomic<T*>, Shards> shards{};
+        std::mutex mtx;
+        std::function<std::unique_ptr<T>()> factory;
+    };
+
+    /// 有意泄漏: 其他静态对象的析构函数或未退出的线程仍可能访问实例
+    static storage_t& storage() {
+        static storage_t& s = *new storage_t;
+        return s;
+    }
+
+public:
+    using value_type = T;
+
+    /// 设置各分片实例的构造参数(拷贝保存), 应在第一次instance()之前调用, 只有第一次调用生效
+    template <typename... Args>
+    static std::enable_if_t<std::is_constructible_v<T, const std::decay_t<Args>&...>>  //
+    init(Args&&... args) {
+        auto& st = storage();
+        std::lock_guard<std::mutex> _lck{st.mtx};
+        if (!st.factory) {
+            st.factory = [... args = std::forward<Args>(args)] {
+                return std::make_unique<T>(args...);
+            };
+        }
+    }
+
+    /// 当前线程的实例
+    static T& instance() {
+        auto& p = storage().shards[thread_slot()];
+        auto* s = p.load(std::memory_order_acquire);
+        if (GSL_LIKELY(s)) {
+            return *s;
+        }
+        return create(p);
+    }
+
+    /// 遍历所有已构造的实例, 与其他线程对实例的访问不互斥
+    ///
+    /// @param fn   void(T&)
+    template <typename Fn>
+    static void visit(Fn&& fn) {
+        for (auto& p : storage().shards) {
+            if (auto* s = p.load(std::memory_order_acquire)) {
+                fn(*s);
+            }
+        }
+    }
+
+    /// 聚合所有已构造的实例
+    ///
+    /// @param init 初值
+    /// @param fn   R(R acc, T&)
+    template <typename R, typename Fn>
+    static R merge(R init, Fn&& fn) {
+        visit([&](T& t) { init = fn(std::move(init), t); });
+        return init;
+    }
+
+    /// 已构造的实例数
+    static std::size_t size() noexcept {
+        std::size_t n = 0;
+        visit([&](T&) { n++; });
+        return n;
+    }
+
+private:
+    static inline std::size_t thread_slot() noexcept {
+        static std::atomic<std::size_t> next{0};
+        static thread_local std::size_t slot = next.fetch_add(1, std::memory_order_relaxed);
+        return slot % Shards;
+    }
+
+    static T& create(std::atomic<T*>& p) {
+        auto& st = storage();
+        std::lock_guard<std::mutex> _lck{st.mtx};
+        if (auto* s = p.load(std::memory_order_relaxed)) {
+            return *s;
+        }
+
+        std::unique_ptr<T> ins;
+        if (st.factory) {
+            ins = st.factory();
+        } else if constexpr (std::is_constructible_v<T>) {
+            ins = std::make_unique<T>();
+        } else {
+            throw std::runtime_error("Expect init first.");
+        }
+        p.store(ins.get(), std::memory_order_release);
+        return *ins.release();
+    }
+};
+
 }  // namespace cc
@@ -1,13 +1,21 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <filesystem>
+#include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <string>
 #include <string_view>
 #include <tuple>
+#include <type_traits>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 #include <boost/noncopyable.hpp>
+#include <cc/metrics.h>
+#include <cc/trace.h>
 #include <cc/type_traits.h>
 #include <field_reflection.hpp>  // cpp_yyjson
 #include <gsl/gsl>
@@ -20,6 +28,18 @@ inline void mk_parent_dir(const std::string& path) {
     std::filesystem::path fp(path);
     std::filesystem::create_directories(fp.parent_path());
 }
+
+inline metrics::Counter& sqlite_queries_total() {
+    static auto& c = metrics::Registry::instance().counter("cc_sqlite_queries_total",
+                                                           "Statements run by Sqlite3pp::execute");
+    return c;
+}
+
+inline metrics::Histogram& sqlite_prepare_seconds() {
+    static auto& h = metrics::Registry::instance().histogram("cc_sqlite_prepare_seconds",
+                                                             "Time spent in sqlite3_prepare_v3");
+    return h;
+}
 }  // namespace detail
 
 class Sqlite3pp : boost::noncopyable {
@@ -39,12 +59,27 @@ class Sqlite3pp : boost::noncopyable {
         static constexpr bool value = std::is_class_v<T> && !std::is_union_v<T>;
     };
 
+    using conn_t = std::unique_ptr<sqlite3, Sqlite3Deleter>;
+
     const std::string dbpath_;
     const int timeout_;
-    static inline thread_local std::unique_ptr<sqlite3, Sqlite3Deleter> conn_ = nullptr;
+
+    // 每个线程对每个数据库各有一个连接. 连接由实例持有, 析构时全部关闭;
+    // 线程本地只按id缓存指针, close()后换新id, 各线程的旧缓存不再命中
+    std::atomic<std::uint64_t> id_;
+    std::mutex mtx_;
+    std::vector<conn_t> conns_;
+
+    static inline std::atomic<std::uint64_t> next_id_{1};
+    static inline thread_local std::unordered_map<std::uint64_t, sqlite3*> cache_;
 
 public:
-    Sqlite3pp(std::string dbpath, int timeout = -1) : dbpath_(dbpath), timeout_(timeout) {
+    class Statement;
+
+    Sqlite3pp(std::string dbpath, int timeout = -1)
+      : dbpath_(dbpath)
+      , timeout_(timeout)
+      , id_(next_id_.fetch_add(1, std::memory_order_relaxed)) {
         sqlite3_config(SQLITE_CONFIG_SINGLETHREAD);
         sqlite3_initialize();
         auto c = get_conn();
@@ -54,7 +89,8 @@ public:
         execute("PRAGMA case_sensitive_like=ON;");
     }
 
-    ~Sqlite3pp() {}
+    /// 关闭所有线程上的连接, 此时不能有其他线程在使用
+    ~Sqlite3pp() { cache_.erase(id_.load(std::memory_order_relaxed)); }
 
     void flush() {
         using row_t = std::tuple<std::string>;
@@ -66,24 +102,92 @@ public:
 
     template <typename R = void, typename... Args>
     std::enable_if_t<std::is_void_v<R>, void> execute(std::string_view stmt, Args&&... args) {
+        CC_TRACE_SCOPE("Sqlite3pp::execute");
+        detail::sqlite_queries_total().inc();
         auto conn = get_conn();
         auto vm   = build_stmt(stmt, std::forward<Args>(args)...);
-        int rc;
+        auto _    = gsl::finally([vm] { sqlite3_finalize(vm); });
+        step_all(conn, vm);
+    }
+
+    template <typename R = void, typename... Args>
+    std::enable_if_t<!std::is_void_v<R>, std::vector<R>>
+    execute(std::string_view stmt, Args&&... args) {
+        CC_TRACE_SCOPE("Sqlite3pp::execute");
+        detail::sqlite_queries_total().inc();
+        auto conn = get_conn();
+        auto vm   = build_stmt(stmt, std::forward<Args>(args)...);
+        auto _    = gsl::finally([vm] { sqlite3_finalize(vm); });
+        return fetch_rows<R>(conn, vm);
+    }
+
+    /// 预编译语句, 可反复绑定执行, 只能在创建它的线程上使用
+    Statement prepare(std::string_view stmt);
+
+    /// 在事务中执行fn, fn抛出异常时回滚
+    template <typename Fn>
+    decltype(auto) transaction(Fn&& fn) {
+        execute("BEGIN IMMEDIATE;");
+        try {
+            if constexpr (std::is_void_v<std::invoke_result_t<Fn>>) {
+                std::forward<Fn>(fn)();
+                execute("COMMIT;");
+            } else {
+                decltype(auto) r = std::forward<Fn>(fn)();
+                execute("COMMIT;");
+                return r;
+            }
+        } catch (...) {
+            execute("ROLLBACK;");
+            throw;
+        }
+    }
+
+    int64_t last_insert_rowid() { return sqlite3_last_insert_rowid(get_conn()); }
+
+    int affected_rows() { return sqlite3_changes(get_conn()); }
+
+    /// 关闭所有线程上的连接, 此时不能有其他线程在使用. 之后再执行语句时重新打开
+    void close() {
+        auto id  = id_.load(std::memory_order_relaxed);
+        auto it  = cache_.find(id);
+        auto own = it != cache_.end() ? it->second : nullptr;
+
+        // 先关闭其他线程的连接, 本线程的连接才能切换journal_mode把WAL合并回数据库
+        std::vector<conn_t> others;
+        do {
+            std::lock_guard<std::mutex> _lck{mtx_};
+            for (auto& c : conns_) {
+                if (c.get() != own) {
+                    others.emplace_back(std::move(c));
+                }
+            }
+            std::erase(conns_, nullptr);
+        } while (0);
+        others.clear();
 
+        if (own) {
+            flush();
+            std::lock_guard<std::mutex> _lck{mtx_};
+            conns_.clear();
+        }
+        cache_.erase(id);
+        id_.store(next_id_.fetch_add(1, std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+
+private:
+    static void step_all(sqlite3* conn, sqlite3_stmt* vm) {
+        int rc;
         while ((rc = sqlite3_step(vm)) == SQLITE_ROW) {
         }
 
         if (GSL_UNLIKELY(rc != SQLITE_DONE)) {
             throw std::runtime_error(std::string("Execute error:") + sqlite3_errmsg(conn));
         }
-        sqlite3_finalize(vm);
     }
 
-    template <typename R = void, typename... Args>
-    std::enable_if_t<!std::is_void_v<R>, std::vector<R>>
-    execute(std::string_view stmt, Args&&... args) {
-        auto conn = get_conn();
-        auto vm   = build_stmt(stmt, std::forward<Args>(args)...);
+    template <typename R>
+    static std::vector<R> fetch_rows(sqlite3* conn, sqlite3_stmt* vm) {
         int rc;
 
         std::vector<R> ret;
@@ -124,31 +228,18 @@ public:
         if (GSL_UNLIKELY(rc != SQLITE_DONE)) {
             throw std::runtime_error(std::string("Execute error:") + sqlite3_errmsg(conn));
         }
-
-        sqlite3_finalize(vm);
         return ret;
     }
 
-    int64_t last_insert_rowid() { return sqlite3_last_insert_rowid(get_conn()); }
-
-    int affected_rows() { return sqlite3_changes(get_conn()); }
-
-    void close() {
-        if (conn_) {
-            flush();
-            sqlite3_close_v2(conn_.get());
-            conn_.reset();
-        }
-    }
-
-private:
     sqlite3* get_conn() {
-        if (!conn_) {
-            auto c = open(dbpath_, timeout_);
-            conn_.reset(c);
+        auto& c = cache_[id_.load(std::memory_order_relaxed)];
+        if (!c) {
+            conn_t conn(open(dbpath_, timeout_));
+            std::lock_guard<std::mutex> _lck{mtx_};
+            c = conns_.emplace_back(std::move(conn)).get();
         }
 
-        return conn_.get();
+        return c;
     }
 
     static sqlite3* open(std::string dbpath, int timeout = -1) {
@@ -191,6 +282,8 @@ private:
             rc = sqlite3_bind_double(vm, param_no, (double)std::forward<T0>(t));
         } else if constexpr (std::is_same_v<T, const char*>) {
             rc = sqlite3_bind_text(vm, param_no, t, -1, SQLITE_TRANSIENT);
+        } else if constexpr (std::is_same_v<T, std::vector<char>>) {
+            rc = sqlite3_bind_blob64(vm, param_no, t.data(), t.size(), SQLITE_TRANSIENT);
         } else if constexpr (is_text<T>::value) {
             rc = sqlite3_bind_text(vm, param_no, t.data(), t.size(), SQLITE_TRANSIENT);
         } else if constexpr (cc::is_optional_v<T>) {
@@ -246,7 +339,10 @@ private:
         int rc;
         const char* tail;
 
-        rc = sqlite3_prepare_v3(c, stmt.data(), -1, 0, &vm, &tail);
+        do {
+            auto _t = detail::sqlite_prepare_seconds().scope();
+            rc      = sqlite3_prepare_v3(c, stmt.data(), -1, 0, &vm, &tail);
+        } while (0);
         if (GSL_UNLIKELY(rc != SQLITE_OK)) {
             throw std::runtime_error(std::string("sqlite3_prepare_v3:") + sqlite3_errmsg(c));
         }
@@ -259,4 +355,64 @@ private:
     }
 };
 
+class Sqlite3pp::Statement : boost::noncopyable {
+    sqlite3* conn_;
+    sqlite3_stmt* vm_;
+
+public:
+    Statement(sqlite3* conn, sqlite3_stmt* vm) : conn_(conn), vm_(vm) {}
+
+    Statement(Statement&& rhs) noexcept
+      : conn_(rhs.conn_)
+      , vm_(std::exchange(rhs.vm_, nullptr)) {}
+
+    Statement& operator=(Statement&& rhs) noexcept {
+        if (this != &rhs) {
+            if (vm_) sqlite3_finalize(vm_);
+            conn_ = rhs.conn_;
+            vm_   = std::exchange(rhs.vm_, nullptr);
+        }
+        return *this;
+    }
+
+    ~Statement() {
+        if (vm_) sqlite3_finalize(vm_);
+    }
+
+    template <typename R = void, typename... Args>
+    std::enable_if_t<std::is_void_v<R>, void> execute(Args&&... args) {
+        bind(std::forward<Args>(args)...);
+        auto _ = gsl::finally([this] { sqlite3_reset(vm_); });
+        step_all(conn_, vm_);
+    }
+
+    template <typename R = void, typename... Args>
+    std::enable_if_t<!std::is_void_v<R>, std::vector<R>> execute(Args&&... args) {
+        bind(std::forward<Args>(args)...);
+        auto _ = gsl::finally([this] { sqlite3_reset(vm_); });
+        return fetch_rows<R>(conn_, vm_);
+    }
+
+private:
+    template <typename... Args>
+    void bind(Args&&... args) {
+        if constexpr (sizeof...(args) > 0) {
+            int idx = 1;
+            ((bindone(vm_, idx++, std::forward<Args>(args))), ...);
+        }
+    }
+};
+
+inline Sqlite3pp::Statement Sqlite3pp::prepare(std::string_view stmt) {
+    auto c = get_conn();
+    sqlite3_stmt* vm;
+    auto _t = detail::sqlite_prepare_seconds().scope();
+    int rc  = sqlite3_prepare_v3(c, stmt.data(), gsl::narrow_cast<int>(stmt.size()),
+                                 SQLITE_PREPARE_PERSISTENT, &vm, nullptr);
+    if (GSL_UNLIKELY(rc != SQLITE_OK)) {
+        throw std::runtime_error(std::string("sqlite3_prepare_v3:") + sqlite3_errmsg(c));
+    }
+    return Statement(c, vm);
+}
+
 }  // namespace cc
@@ -1,12 +1,17 @@
 #pragma once
 
-#include <any>
+#include <cstdint>
 #include <memory>
 #include <mutex>
+#include <string>
+#include <string_view>
 #include <tuple>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 #include <boost/core/noncopyable.hpp>
 #include <cc/singleton_provider.h>
+#include <cc/st/retain.h>
 #include <cc/stopwatch.h>
 #include <cc/util.h>
 
@@ -14,6 +19,9 @@ namespace cc {
 namespace st {
 
 struct R_TRIG : boost::noncopyable {
+    /// 保持数据中的类型名, 不依赖编译器的typeid名字
+    static constexpr const char* type_name = "R_TRIG";
+
     mutable int M = 0;
 
     int operator()(int CLK) const {
@@ -21,9 +29,16 @@ struct R_TRIG : boost::noncopyable {
         M      = CLK;
         return Q;
     }
+
+    template <typename Ar>
+    void retain(Ar& ar) const {
+        ar(M);
+    }
 };
 
 struct F_TRIG : boost::noncopyable {
+    static constexpr const char* type_name = "F_TRIG";
+
     mutable int M = 1;
 
     int operator()(int CLK) const {
@@ -31,9 +46,16 @@ struct F_TRIG : boost::noncopyable {
         M      = CLK;
         return Q;
     }
+
+    template <typename Ar>
+    void retain(Ar& ar) const {
+        ar(M);
+    }
 };
 
 struct TON : boost::noncopyable {
+    static constexpr const char* type_name = "TON";
+
     mutable int Q       = 0;
     mutable int ET      = 0;
     mutable int STATE   = 0;
@@ -52,7 +74,7 @@ struct TON : boost::noncopyable {
                 Q     = 0;
                 ET    = 0;
             } else if (STATE == 1) {
-                int elapsed = stopwatch.elapsed() * 1000;
+                int elapsed = stopwatch.elapsed_ms();
                 if (elapsed > PT) {
                     STATE = 2;
                     Q     = 1;
@@ -66,9 +88,16 @@ struct TON : boost::noncopyable {
         PREV_IN = IN;
         return std::make_tuple(Q, ET);
     }
+
+    template <typename Ar>
+    void retain(Ar& ar) const {
+        ar(Q, ET, STATE, PREV_IN, stopwatch);
+    }
 };
 
 struct TOF : boost::noncopyable {
+    static constexpr const char* type_name = "TOF";
+
     mutable int Q       = 0;
     mutable int ET      = 0;
     mutable int STATE   = 0;  // (* internal state: 0-reset, 1-counting, 2-set *)
@@ -85,7 +114,7 @@ struct TOF : boost::noncopyable {
                 STATE = 0;
                 ET    = 0;
             } else if (STATE == 1) {
-                int elapsed = stopwatch.elapsed() * 1000;
+                int elapsed = stopwatch.elapsed_ms();
                 if (elapsed > PT) {
                     STATE = 2;
                     ET    = PT;
@@ -99,6 +128,93 @@ struct TOF : boost::noncopyable {
         PREV_IN = IN;
         return std::make_tuple(Q, ET);
     }
+
+    template <typename Ar>
+    void retain(Ar& ar) const {
+        ar(Q, ET, STATE, PREV_IN, stopwatch);
+    }
+};
+
+struct CTU : boost::noncopyable {
+    static constexpr const char* type_name = "CTU";
+
+    mutable int Q       = 0;
+    mutable int CV      = 0;
+    mutable int PREV_CU = 0;
+
+    std::tuple<int, int> operator()(int CU, int R, int PV) const {
+        if (R) {
+            CV = 0;
+        } else if (CU && !PREV_CU && CV < 0x7fffffff) {
+            CV++;
+        }
+        Q       = CV >= PV;
+        PREV_CU = CU;
+        return std::make_tuple(Q, CV);
+    }
+
+    template <typename Ar>
+    void retain(Ar& ar) const {
+        ar(Q, CV, PREV_CU);
+    }
+};
+
+struct CTD : boost::noncopyable {
+    static constexpr const char* type_name = "CTD";
+
+    mutable int Q       = 0;
+    mutable int CV      = 0;
+    mutable int PREV_CD = 0;
+
+    std::tuple<int, int> operator()(int CD, int LD, int PV) const {
+        if (LD) {
+            CV = PV;
+        } else if (CD && !PREV_CD && CV > -0x7fffffff) {
+            CV--;
+        }
+        Q       = CV <= 0;
+        PREV_CD = CD;
+        return std::make_tuple(Q, CV);
+    }
+
+    template <typename Ar>
+    void retain(Ar& ar) const {
+        ar(Q, CV, PREV_CD);
+    }
+};
+
+/// 置位优先
+struct SR : boost::noncopyable {
+    static constexpr const char* type_name = "SR";
+
+    mutable int Q1 = 0;
+
+    int operator()(int S1, int R) const {
+        Q1 = S1 || (!R && Q1);
+        return Q1;
+    }
+
+    template <typename Ar>
+    void retain(Ar& ar) const {
+        ar(Q1);
+    }
+};
+
+/// 复位优先
+struct RS : boost::noncopyable {
+    static constexpr const char* type_name = "RS";
+
+    mutable int Q1 = 0;
+
+    int operator()(int S, int R1) const {
+        Q1 = !R1 && (S || Q1);
+        return Q1;
+    }
+
+    template <typename Ar>
+    void retain(Ar& ar) const {
+        ar(Q1);
+    }
 };
 
 }  // namespace st
@@ -108,6 +224,31 @@ class StFactory final : boost::noncopyable {
 #define ST_FACTORY_METHOD(funcname, type) \
     inline decltype(auto) funcname(std::string_view name) { return get<type>(name); }
 
+    struct entry_t {
+        std::shared_ptr<void> obj;
+        const char* type;
+        std::string name;
+        std::uint16_t size;
+        void (*save)(const void*, st::detail::RetainWriter&);
+        void (*load)(void*, st::detail::RetainReader&);
+    };
+
+    struct retain_key_t {
+        std::string_view type;
+        std::string_view name;
+
+        bool operator==(const retain_key_t& rhs) const {
+            return type == rhs.type && name == rhs.name;
+        }
+    };
+
+    struct retain_key_hash {
+        std::size_t operator()(const retain_key_t& k) const noexcept {
+            std::hash<std::string_view> h;
+            return h(k.name) * 31 + h(k.type);
+        }
+    };
+
 public:
     StFactory() = default;
 
@@ -115,32 +256,111 @@ public:
     ST_FACTORY_METHOD(f_trig, cc::st::F_TRIG)
     ST_FACTORY_METHOD(ton, cc::st::TON)
     ST_FACTORY_METHOD(tof, cc::st::TOF)
+    ST_FACTORY_METHOD(ctu, cc::st::CTU)
+    ST_FACTORY_METHOD(ctd, cc::st::CTD)
+    ST_FACTORY_METHOD(sr, cc::st::SR)
+    ST_FACTORY_METHOD(rs, cc::st::RS)
+
+    /// 将所有块的状态写入out(复用out的容量), 应在扫描线程的两次扫描之间调用
+    void snapshot(std::vector<char>& out) {
+        std::lock_guard<MutexPolicy> _lck{mtx_};
+        if (dir_.count() != entries_.size()) {
+            dir_.clear();
+            for (auto& e : entries_) {
+                dir_.add(e.type, e.name, e.size);
+            }
+        }
+
+        st::detail::RetainWriter w(dir_.begin(out));
+        for (auto& e : entries_) {
+            e.save(e.obj.get(), w);
+        }
+    }
+
+    /// 从快照恢复, 已创建的块立即恢复, 其余的在第一次创建时恢复
+    ///
+    /// @return 快照格式是否合法
+    bool restore(std::vector<char> data) {
+        std::lock_guard<MutexPolicy> _lck{mtx_};
+        pending_.clear();
+        retained_ = std::move(data);
+
+        std::string k;
+        return st::detail::retain_parse(
+            retained_.data(), retained_.size(),
+            [&](std::string_view type, std::string_view name, const char* p, std::uint16_t size) {
+                k.assign(type).append(":").append(name);
+                auto it = index_.find(k);
+                if (it == index_.end()) {
+                    pending_.emplace(retain_key_t{type, name}, std::make_pair(p, size));
+                } else if (entries_[it->second].size == size) {
+                    auto& e = entries_[it->second];
+                    st::detail::RetainReader r(p, size);
+                    e.load(e.obj.get(), r);
+                }
+            });
+    }
+
+    inline std::size_t size() const { return entries_.size(); }
 
 private:
     template <typename T>
     const T& get(std::string_view name) {
         std::lock_guard<MutexPolicy> _lck{mtx_};
         std::string k = tname<T>(std::string(name));
-        if (m_.find(k) == m_.end()) {
-            auto p = std::make_shared<T>();
-            m_.emplace((std::string&&)k, p);
-            return *p;
+        auto it       = index_.find(k);
+        if (it != index_.end()) {
+            return *static_cast<const T*>(entries_[it->second].obj.get());
+        }
+
+        auto p    = std::make_shared<T>();
+        auto size = st::detail::retain_size(*p);
+        if (!pending_.empty()) {
+            auto r = pending_.find(retain_key_t{T::type_name, name});
+            if (r != pending_.end()) {
+                if (r->second.second == size) {
+                    st::detail::RetainReader reader(r->second.first, size);
+                    p->retain(reader);
+                }
+                pending_.erase(r);
+            }
         }
-        auto p = std::any_cast<std::shared_ptr<T>>(m_.at(k));
+
+        index_.emplace(std::move(k), entries_.size());
+        entries_.emplace_back(entry_t{
+            p,
+            T::type_name,
+            std::string(name),
+            size,
+            [](const void* o, st::detail::RetainWriter& w) {
+                static_cast<const T*>(o)->retain(w);
+            },
+            [](void* o, st::detail::RetainReader& r) { static_cast<const T*>(o)->retain(r); },
+        });
         return *p;
     }
 
     template <typename T>
     static inline std::string tname(std::string name) {
-        return std::string(typeid(T).name()) + ":" + name;
+        return std::string(T::type_name) + ":" + name;
     }
 
 private:
     MutexPolicy mtx_;
-    std::unordered_map<std::string, std::any> m_;
+    std::unordered_map<std::string, std::size_t> index_;
+    std::vector<entry_t> entries_;
+    st::detail::RetainDirectory dir_;
+
+    // 尚未创建的块的保持数据, 指向retained_
+    std::vector<char> retained_;
+    std::unordered_map<retain_key_t, std::pair<const char*, std::uint16_t>, retain_key_hash>
+        pending_;
 };
 
 using StFactoryProvider           = SingletonProvider<StFactory<>>;
 using ConcurrentStFactoryProvider = SingletonProvider<StFactory<std::mutex>>;
 
+/// 多个扫描线程时每个线程一个工厂, 前64个线程互不竞争同一把锁
+using ShardedStFactoryProvider = ShardedProvider<StFactory<std::mutex>>;
+
 }  // namespace cc
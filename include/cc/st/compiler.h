@@ -0,0 +1,960 @@
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cc/st/vm.h>
+#include <gsl/gsl>
+
+namespace cc {
+namespace st {
+
+namespace detail {
+
+struct token_t {
+    enum kind_e { END, IDENT, INT, REAL, TIME, OP };
+
+    kind_e kind = END;
+    std::string text;  // IDENT(大写) / OP
+    std::int64_t i = 0;
+    double f       = 0;
+    int line       = 1;
+    int col        = 1;
+};
+
+/// IEC 61131-3 ST 词法分析, 标识符和关键字不区分大小写
+class Lexer {
+    std::string_view src_;
+    std::size_t pos_ = 0;
+    int line_        = 1;
+    int col_         = 1;
+
+public:
+    explicit Lexer(std::string_view src) : src_(src) {}
+
+    token_t next() {
+        skip_space();
+        token_t t;
+        t.line = line_;
+        t.col  = col_;
+        if (pos_ >= src_.size()) {
+            return t;
+        }
+
+        char c = src_[pos_];
+        if (std::isalpha((unsigned char)c) || c == '_') {
+            std::size_t start = pos_;
+            while (std::isalnum((unsigned char)peek()) || peek() == '_') {
+                advance();
+            }
+            t.kind = token_t::IDENT;
+            t.text = upper(src_.substr(start, pos_ - start));
+            if (peek() == '#' && (t.text == "T" || t.text == "TIME")) {
+                advance();
+                t.kind = token_t::TIME;
+                t.i    = lex_time(t);
+            }
+            return t;
+        }
+
+        if (std::isdigit((unsigned char)c)) {
+            lex_number(t);
+            return t;
+        }
+
+        static constexpr std::string_view ops2[] = {":=", "<>", "<=", ">=", "=>"};
+        for (auto o : ops2) {
+            if (src_.substr(pos_, 2) == o) {
+                advance(2);
+                t.kind = token_t::OP;
+                t.text = o;
+                return t;
+            }
+        }
+        if (std::string_view("+-*/()=<>,;:.&").find(c) != std::string_view::npos) {
+            advance();
+            t.kind = token_t::OP;
+            t.text = std::string(1, c);
+            return t;
+        }
+        error(t, std::string("unexpected character '") + c + "'");
+        return t;
+    }
+
+    [[noreturn]] static void error(const token_t& t, const std::string& msg) {
+        throw std::runtime_error("st: line " + std::to_string(t.line) + ":"
+                                 + std::to_string(t.col) + ": " + msg);
+    }
+
+private:
+    static std::string upper(std::string_view s) {
+        std::string r(s);
+        std::transform(r.begin(), r.end(), r.begin(),
+                       [](unsigned char c) { return std::toupper(c); });
+        return r;
+    }
+
+    inline char peek(std::size_t off = 0) const noexcept {
+        return pos_ + off < src_.size() ? src_[pos_ + off] : '\0';
+    }
+
+    inline void advance(std::size_t n = 1) {
+        for (; n > 0 && pos_ < src_.size(); n--) {
+            if (src_[pos_++] == '\n') {
+                line_++;
+                col_ = 1;
+            } else {
+                col_++;
+            }
+        }
+    }
+
+    void skip_space() {
+        while (pos_ < src_.size()) {
+            char c = src_[pos_];
+            if (std::isspace((unsigned char)c)) {
+                advance();
+            } else if (src_.substr(pos_, 2) == "//") {
+                while (pos_ < src_.size() && peek() != '\n') advance();
+            } else if (src_.substr(pos_, 2) == "(*") {
+                token_t t{token_t::END, "", 0, 0, line_, col_};
+                auto end = src_.find("*)", pos_ + 2);
+                if (end == std::string_view::npos) {
+                    error(t, "unterminated comment");
+                }
+                advance(end + 2 - pos_);
+            } else {
+                break;
+            }
+        }
+    }
+
+    std::string digits(int base) {
+        std::string r;
+        while (pos_ < src_.size()) {
+            auto c = (unsigned char)src_[pos_];
+            if (c == '_') {
+                advance();
+                continue;
+            }
+            bool ok = base == 16 ? std::isxdigit(c) : std::isdigit(c);
+            if (!ok) break;
+            r.push_back(c);
+            advance();
+        }
+        return r;
+    }
+
+    void lex_number(token_t& t) {
+        std::string s = digits(10);
+        if (peek() == '#') {
+            int base = std::atoi(s.c_str());
+            if (base != 2 && base != 8 && base != 16) {
+                error(t, "unsupported integer base " + s);
+            }
+            advance();
+            t.kind = token_t::INT;
+            t.i    = std::strtoll(digits(base).c_str(), nullptr, base);
+            return;
+        }
+
+        bool real = false;
+        if (peek() == '.' && std::isdigit((unsigned char)peek(1))) {
+            real = true;
+            advance();
+            s += "." + digits(10);
+        }
+        if (peek() == 'e' || peek() == 'E') {
+            real = true;
+            s.push_back('e');
+            advance();
+            if (peek() == '+' || peek() == '-') {
+                s.push_back(peek());
+                advance();
+            }
+            s += digits(10);
+        }
+
+        if (real) {
+            t.kind = token_t::REAL;
+            t.f    = std::strtod(s.c_str(), nullptr);
+        } else {
+            t.kind = token_t::INT;
+            t.i    = std::strtoll(s.c_str(), nullptr, 10);
+        }
+    }
+
+    /// T#1h2m3s500ms, T#1.5s, 返回毫秒
+    std::int64_t lex_time(const token_t& t) {
+        double ms = 0;
+        bool any  = false;
+        while (std::isdigit((unsigned char)peek()) || peek() == '_') {
+            std::string num = digits(10);
+            if (peek() == '.') {
+                advance();
+                num += "." + digits(10);
+            }
+            double v = std::strtod(num.c_str(), nullptr);
+
+            std::size_t start = pos_;
+            while (std::isalpha((unsigned char)peek())) advance();
+            auto unit = upper(src_.substr(start, pos_ - start));
+            if (unit == "D") {
+                ms += v * 86400000;
+            } else if (unit == "H") {
+                ms += v * 3600000;
+            } else if (unit == "M") {
+                ms += v * 60000;
+            } else if (unit == "S") {
+                ms += v * 1000;
+            } else if (unit == "MS") {
+                ms += v;
+            } else {
+                error(t, "invalid time unit '" + unit + "'");
+            }
+            any = true;
+        }
+        if (!any) {
+            error(t, "invalid time literal");
+        }
+        return static_cast<std::int64_t>(ms);
+    }
+};
+
+/// 递归下降, 边解析边生成字节码
+class Compiler {
+    struct symbol_t {
+        vtype type;
+        std::uint32_t slot;
+        bool writable;
+    };
+
+    Lexer lex_;
+    token_t tok_;
+    std::shared_ptr<Program> prog_;
+    std::unordered_map<std::string, symbol_t> symbols_;
+    std::unordered_map<std::string, std::uint32_t> fbs_;  // 实例名 -> fbs下标
+    std::vector<std::vector<std::size_t>> exits_;         // 每层循环待回填的EXIT
+    std::int64_t depth_ = 0;
+
+public:
+    explicit Compiler(std::string_view src) : lex_(src), prog_(std::make_shared<Program>()) {
+        tok_ = lex_.next();
+    }
+
+    std::shared_ptr<Program> compile() {
+        if (accept_kw("PROGRAM")) {
+            prog_->name = expect_ident();
+        }
+        while (is_kw("VAR") || is_kw("VAR_INPUT") || is_kw("VAR_OUTPUT") || is_kw("VAR_GLOBAL")) {
+            next();
+            var_block();
+        }
+        statements();
+        if (accept_kw("END_PROGRAM")) {
+            accept_op(";");
+        }
+        if (tok_.kind != token_t::END) {
+            Lexer::error(tok_, "unexpected '" + describe(tok_) + "'");
+        }
+        emit(op::HALT);
+        return std::move(prog_);
+    }
+
+private:
+    // ---------------------------------------- tokens
+    static std::string describe(const token_t& t) {
+        switch (t.kind) {
+        case token_t::END: return "end of input";
+        case token_t::INT: return std::to_string(t.i);
+        case token_t::REAL: return std::to_string(t.f);
+        case token_t::TIME: return "T#" + std::to_string(t.i) + "ms";
+        default: return t.text;
+        }
+    }
+
+    inline void next() { tok_ = lex_.next(); }
+    inline bool is_kw(std::string_view kw) const {
+        return tok_.kind == token_t::IDENT && tok_.text == kw;
+    }
+    inline bool is_op(std::string_view o) const {
+        return tok_.kind == token_t::OP && tok_.text == o;
+    }
+
+    bool accept_kw(std::string_view kw) {
+        if (!is_kw(kw)) return false;
+        next();
+        return true;
+    }
+
+    bool accept_op(std::string_view o) {
+        if (!is_op(o)) return false;
+        next();
+        return true;
+    }
+
+    void expect_kw(std::string_view kw) {
+        if (!accept_kw(kw)) Lexer::error(tok_, "expected '" + std::string(kw) + "'");
+    }
+
+    void expect_op(std::string_view o) {
+        if (!accept_op(o)) Lexer::error(tok_, "expected '" + std::string(o) + "'");
+    }
+
+    std::string expect_ident() {
+        if (tok_.kind != token_t::IDENT) Lexer::error(tok_, "expected identifier");
+        auto s = std::move(tok_.text);
+        next();
+        return s;
+    }
+
+    // ---------------------------------------- emit
+    inline std::size_t here() const noexcept { return prog_->code.size(); }
+
+    /// 操作数(跳转目标, 槽位, 常量下标)超出24位时程序过大, 报编译错误
+    std::int32_t operand(std::int64_t v) const {
+        if (v < kArgMin || v > kArgMax) Lexer::error(tok_, "program too large");
+        return static_cast<std::int32_t>(v);
+    }
+
+    void emit(std::uint8_t code, std::int64_t arg = 0, int stack = 0) {
+        prog_->code.push_back(encode(code, operand(arg)));
+        depth_ += stack;
+        prog_->max_stack = std::max<std::uint32_t>(prog_->max_stack, depth_);
+    }
+
+    void patch(std::size_t at, std::size_t target) {
+        auto code       = static_cast<std::uint8_t>(prog_->code[at] & 0xff);
+        prog_->code[at] = encode(code, operand(static_cast<std::int64_t>(target)));
+    }
+
+    void push_int(std::int64_t v) {
+        if (v >= kArgMin && v <= kArgMax) {
+            emit(op::PUSHI, v, 1);
+        } else {
+            cell_t c;
+            c.i = v;
+            push_const(c);
+        }
+    }
+
+    void push_real(double v) {
+        cell_t c;
+        c.f = v;
+        push_const(c);
+    }
+
+    void push_const(cell_t c) {
+        prog_->consts.push_back(c);
+        emit(op::PUSHK, static_cast<std::int64_t>(prog_->consts.size() - 1), 1);
+    }
+
+    std::uint32_t alloc_slot() { return prog_->nslots++; }
+
+    // ---------------------------------------- types
+    static inline bool is_int(vtype t) { return t == vtype::INT || t == vtype::TIME; }
+    static inline bool is_num(vtype t) { return t != vtype::BOOL; }
+
+    static vtype parse_type(const std::string& s) {
+        if (s == "BOOL") return vtype::BOOL;
+        if (s == "SINT" || s == "INT" || s == "DINT" || s == "LINT" || s == "USINT" || s == "UINT"
+            || s == "UDINT" || s == "ULINT" || s == "BYTE" || s == "WORD" || s == "DWORD"
+            || s == "LWORD") {
+            return vtype::INT;
+        }
+        if (s == "REAL" || s == "LREAL") return vtype::REAL;
+        if (s == "TIME") return vtype::TIME;
+        throw std::invalid_argument(s);
+    }
+
+    /// 将栈顶值(from)转为to类型, 失败时报错
+    void coerce(vtype from, vtype to, const token_t& at) {
+        if (from == to || (is_int(from) && is_int(to))) return;
+        if (is_int(from) && to == vtype::REAL) {
+            emit(op::I2F);
+            return;
+        }
+        Lexer::error(at, "type mismatch");
+    }
+
+    /// 二元数值运算的类型提升, 栈上为 a b
+    vtype promote(vtype a, vtype b, const token_t& at) {
+        if (!is_num(a) || !is_num(b)) {
+            Lexer::error(at, "numeric operands expected");
+        }
+        if (a == vtype::REAL || b == vtype::REAL) {
+            if (a != vtype::REAL) emit(op::I2F1);
+            if (b != vtype::REAL) emit(op::I2F);
+            return vtype::REAL;
+        }
+        return (a == vtype::TIME || b == vtype::TIME) ? vtype::TIME : vtype::INT;
+    }
+
+    // ---------------------------------------- declarations
+    void var_block() {
+        while (!accept_kw("END_VAR")) {
+            std::vector<std::pair<std::string, token_t>> names;
+            do {
+                auto at = tok_;
+                names.emplace_back(expect_ident(), at);
+            } while (accept_op(","));
+            expect_op(":");
+            auto type_tok  = tok_;
+            auto type_name = expect_ident();
+
+            for (const auto& [name, at] : names) {
+                if (symbols_.count(name) || fbs_.count(name)) {
+                    Lexer::error(at, "duplicate variable '" + name + "'");
+                }
+            }
+
+            if (const auto* desc = find_block(type_name)) {
+                for (const auto& [name, at] : names) {
+                    auto base = prog_->nslots;
+                    prog_->nslots += desc->size();
+                    fbs_.emplace(name, gsl::narrow_cast<std::uint32_t>(prog_->fbs.size()));
+                    prog_->fbs.push_back(Program::fb_t{name, type_name, base});
+                }
+                expect_op(";");
+                continue;
+            }
+
+            vtype type;
+            try {
+                type = parse_type(type_name);
+            } catch (std::invalid_argument&) {
+                Lexer::error(type_tok, "unknown type '" + type_name + "'");
+            }
+
+            cell_t init{0};
+            if (accept_op(":=")) {
+                init = const_expr(type);
+            }
+            expect_op(";");
+
+            for (const auto& [name, at] : names) {
+                auto slot = alloc_slot();
+                symbols_.emplace(name, symbol_t{type, slot, true});
+                prog_->vars.push_back(Program::var_t{name, type, slot, init});
+            }
+        }
+    }
+
+    cell_t const_expr(vtype type) {
+        bool neg = accept_op("-");
+        cell_t c{0};
+        auto at = tok_;
+        if (tok_.kind == token_t::INT || tok_.kind == token_t::TIME) {
+            if (type == vtype::REAL) {
+                c.f = neg ? -double(tok_.i) : double(tok_.i);
+            } else {
+                c.i = neg ? -tok_.i : tok_.i;
+            }
+        } else if (tok_.kind == token_t::REAL && type == vtype::REAL) {
+            c.f = neg ? -tok_.f : tok_.f;
+        } else if (type == vtype::BOOL && (is_kw("TRUE") || is_kw("FALSE")) && !neg) {
+            c.i = is_kw("TRUE");
+        } else {
+            Lexer::error(at, "invalid initial value");
+        }
+        next();
+        return c;
+    }
+
+    // ---------------------------------------- statements
+    bool at_block_end() const {
+        return tok_.kind == token_t::END || is_kw("END_IF") || is_kw("ELSE") || is_kw("ELSIF")
+               || is_kw("END_WHILE") || is_kw("END_FOR") || is_kw("UNTIL")
+               || is_kw("END_PROGRAM");
+    }
+
+    void statements() {
+        while (!at_block_end()) {
+            statement();
+        }
+    }
+
+    void statement() {
+        auto at = tok_;
+        if (accept_op(";")) {
+            return;
+        } else if (accept_kw("IF")) {
+            if_stmt();
+        } else if (accept_kw("WHILE")) {
+            while_stmt();
+        } else if (accept_kw("FOR")) {
+            for_stmt();
+        } else if (accept_kw("REPEAT")) {
+            repeat_stmt();
+        } else if (accept_kw("EXIT")) {
+            if (exits_.empty()) Lexer::error(at, "EXIT outside of loop");
+            exits_.back().push_back(here());
+            emit(op::JMP);
+            expect_op(";");
+        } else if (accept_kw("RETURN")) {
+            emit(op::HALT);
+            expect_op(";");
+        } else if (tok_.kind == token_t::IDENT) {
+            auto name = expect_ident();
+            if (is_op("(")) {
+                fb_call(name, at);
+            } else {
+                auto sym = lvalue(name, at);
+                expect_op(":=");
+                auto etok = tok_;
+                coerce(expr(), sym.type, etok);
+                emit(op::STORE, sym.slot, -1);
+            }
+            expect_op(";");
+        } else {
+            Lexer::error(at, "unexpected '" + describe(at) + "'");
+        }
+    }
+
+    symbol_t lvalue(const std::string& name, const token_t& at) {
+        symbol_t sym = member_or_var(name, at);
+        if (!sym.writable) Lexer::error(at, "'" + name + "' is read-only");
+        return sym;
+    }
+
+    symbol_t member_or_var(const std::string& name, const token_t& at) {
+        if (accept_op(".")) {
+            auto it = fbs_.find(name);
+            if (it == fbs_.end()) Lexer::error(at, "'" + name + "' is not a function block");
+            auto member = expect_ident();
+            return fb_member(it->second, member, at);
+        }
+        auto it = symbols_.find(name);
+        if (it == symbols_.end()) Lexer::error(at, "undefined variable '" + name + "'");
+        return it->second;
+    }
+
+    symbol_t fb_member(std::uint32_t index, const std::string& member, const token_t& at) {
+        const auto& fb   = prog_->fbs[index];
+        const auto* desc = find_block(fb.type);
+        std::uint32_t i  = 0;
+        for (const auto& p : desc->inputs) {
+            if (p.name == member) return symbol_t{p.type, fb.slot + i, true};
+            i++;
+        }
+        for (const auto& p : desc->outputs) {
+            if (p.name == member) return symbol_t{p.type, fb.slot + i, false};
+            i++;
+        }
+        Lexer::error(at, fb.type + " has no member '" + member + "'");
+    }
+
+    /// inst(IN := a, PT := T#1s);  未赋值的输入保持上次的值
+    void fb_call(const std::string& name, const token_t& at) {
+        auto it = fbs_.find(name);
+        if (it == fbs_.end()) Lexer::error(at, "'" + name + "' is not a function block");
+        expect_op("(");
+        if (!is_op(")")) {
+            do {
+                auto ptok   = tok_;
+                auto member = expect_ident();
+                auto sym    = fb_member(it->second, member, ptok);
+                if (!sym.writable) Lexer::error(ptok, "'" + member + "' is not an input");
+                expect_op(":=");
+                auto etok = tok_;
+                coerce(expr(), sym.type, etok);
+                emit(op::STORE, sym.slot, -1);
+            } while (accept_op(","));
+        }
+        expect_op(")");
+        emit(op::CALLFB, it->second);
+    }
+
+    void condition() {
+        auto at = tok_;
+        auto t  = expr();
+        if (t != vtype::BOOL) Lexer::error(at, "BOOL condition expected");
+    }
+
+    void if_stmt() {
+        std::vector<std::size_t> ends;
+        condition();
+        expect_kw("THEN");
+        auto jz = here();
+        emit(op::JZ, 0, -1);
+        statements();
+        for (;;) {
+            if (accept_kw("ELSIF")) {
+                ends.push_back(here());
+                emit(op::JMP);
+                patch(jz, here());
+                condition();
+                expect_kw("THEN");
+                jz = here();
+                emit(op::JZ, 0, -1);
+                statements();
+            } else if (accept_kw("ELSE")) {
+                ends.push_back(here());
+                emit(op::JMP);
+                patch(jz, here());
+                jz = SIZE_MAX;
+                statements();
+                break;
+            } else {
+                break;
+            }
+        }
+        expect_kw("END_IF");
+        accept_op(";");
+        if (jz != SIZE_MAX) patch(jz, here());
+        for (auto e : ends) patch(e, here());
+    }
+
+    void end_loop(std::size_t target) {
+        for (auto e : exits_.back()) patch(e, target);
+        exits_.pop_back();
+    }
+
+    void while_stmt() {
+        auto top = here();
+        condition();
+        expect_kw("DO");
+        auto jz = here();
+        emit(op::JZ, 0, -1);
+        exits_.emplace_back();
+        statements();
+        expect_kw("END_WHILE");
+        accept_op(";");
+        emit(op::LOOP, static_cast<std::int64_t>(top));
+        patch(jz, here());
+        end_loop(here());
+    }
+
+    void repeat_stmt() {
+        auto top = here();
+        exits_.emplace_back();
+        statements();
+        expect_kw("UNTIL");
+        condition();
+        expect_kw("END_REPEAT");
+        accept_op(";");
+        auto jnz = here();
+        emit(op::JNZ, 0, -1);
+        emit(op::LOOP, static_cast<std::int64_t>(top));
+        patch(jnz, here());
+        end_loop(here());
+    }
+
+    /// FOR i := a TO b [BY k] DO ... END_FOR, k为整数常量, 终值只求一次
+    void for_stmt() {
+        auto at   = tok_;
+        auto name = expect_ident();
+        auto sym  = lvalue(name, at);
+        if (!is_int(sym.type)) Lexer::error(at, "FOR variable must be an integer");
+        expect_op(":=");
+        auto etok = tok_;
+        coerce(expr(), sym.type, etok);
+        emit(op::STORE, sym.slot, -1);
+
+        expect_kw("TO");
+        etok = tok_;
+        coerce(expr(), sym.type, etok);
+        auto end = alloc_slot();
+        emit(op::STORE, end, -1);
+
+        std::int64_t step = 1;
+        if (accept_kw("BY")) {
+            bool neg = accept_op("-");
+            if (tok_.kind != token_t::INT) {
+                Lexer::error(tok_, "integer constant expected after BY");
+            }
+            step = neg ? -tok_.i : tok_.i;
+            if (step == 0) Lexer::error(tok_, "FOR step must not be zero");
+            next();
+        }
+        expect_kw("DO");
+
+        auto top = here();
+        emit(op::LOAD, sym.slot, 1);
+        emit(op::LOAD, end, 1);
+        emit(step > 0 ? op::LEI : op::GEI, 0, -1);
+        auto jz = here();
+        emit(op::JZ, 0, -1);
+
+        exits_.emplace_back();
+        statements();
+        expect_kw("END_FOR");
+        accept_op(";");
+
+        emit(op::LOAD, sym.slot, 1);
+        push_int(step);
+        emit(op::ADDI, 0, -1);
+        emit(op::STORE, sym.slot, -1);
+        emit(op::LOOP, static_cast<std::int64_t>(top));
+        patch(jz, here());
+        end_loop(here());
+    }
+
+    // ---------------------------------------- expressions
+    vtype expr() {
+        auto t = xor_expr();
+        while (is_kw("OR")) {
+            auto at = tok_;
+            next();
+            t = logic(t, xor_expr(), op::OR, at);
+        }
+        return t;
+    }
+
+    vtype xor_expr() {
+        auto t = and_expr();
+        while (is_kw("XOR")) {
+            auto at = tok_;
+            next();
+            t = logic(t, and_expr(), op::XOR, at);
+        }
+        return t;
+    }
+
+    vtype and_expr() {
+        auto t = eq_expr();
+        while (is_kw("AND") || is_op("&")) {
+            auto at = tok_;
+            next();
+            t = logic(t, eq_expr(), op::AND, at);
+        }
+        return t;
+    }
+
+    vtype logic(vtype a, vtype b, std::uint8_t code, const token_t& at) {
+        bool ok = (a == vtype::BOOL && b == vtype::BOOL) || (is_int(a) && is_int(b));
+        if (!ok) Lexer::error(at, "operands of '" + at.text + "' must both be BOOL or integer");
+        emit(code, 0, -1);
+        return a == vtype::BOOL ? vtype::BOOL : vtype::INT;
+    }
+
+    vtype eq_expr() {
+        auto t = rel_expr();
+        while (is_op("=") || is_op("<>")) {
+            auto at = tok_;
+            bool eq = is_op("=");
+            next();
+            auto b = rel_expr();
+            if (t == vtype::BOOL && b == vtype::BOOL) {
+                emit(eq ? op::EQI : op::NEI, 0, -1);
+            } else {
+                bool real = promote(t, b, at) == vtype::REAL;
+                emit(eq ? (real ? op::EQF : op::EQI) : (real ? op::NEF : op::NEI), 0, -1);
+            }
+            t = vtype::BOOL;
+        }
+        return t;
+    }
+
+    vtype rel_expr() {
+        auto t = add_expr();
+        while (is_op("<") || is_op(">") || is_op("<=") || is_op(">=")) {
+            auto at = tok_;
+            next();
+            bool real = promote(t, add_expr(), at) == vtype::REAL;
+            std::uint8_t code;
+            if (at.text == "<") {
+                code = real ? op::LTF : op::LTI;
+            } else if (at.text == ">") {
+                code = real ? op::GTF : op::GTI;
+            } else if (at.text == "<=") {
+                code = real ? op::LEF : op::LEI;
+            } else {
+                code = real ? op::GEF : op::GEI;
+            }
+            emit(code, 0, -1);
+            t = vtype::BOOL;
+        }
+        return t;
+    }
+
+    vtype add_expr() {
+        auto t = mul_expr();
+        while (is_op("+") || is_op("-")) {
+            auto at = tok_;
+            next();
+            t = promote(t, mul_expr(), at);
+            if (at.text == "+") {
+                emit(t == vtype::REAL ? op::ADDF : op::ADDI, 0, -1);
+            } else {
+                emit(t == vtype::REAL ? op::SUBF : op::SUBI, 0, -1);
+            }
+        }
+        return t;
+    }
+
+    vtype mul_expr() {
+        auto t = unary();
+        while (is_op("*") || is_op("/") || is_kw("MOD")) {
+            auto at = tok_;
+            next();
+            t = promote(t, unary(), at);
+            if (at.text == "*") {
+                emit(t == vtype::REAL ? op::MULF : op::MULI, 0, -1);
+            } else if (at.text == "/") {
+                emit(t == vtype::REAL ? op::DIVF : op::DIVI, 0, -1);
+            } else {
+                if (t == vtype::REAL) Lexer::error(at, "MOD requires integer operands");
+                emit(op::MODI, 0, -1);
+            }
+        }
+        return t;
+    }
+
+    vtype unary() {
+        auto at = tok_;
+        if (accept_op("-")) {
+            // 字面量直接取负, 避免 -8388608 之类溢出立即数范围
+            if (tok_.kind == token_t::INT) {
+                push_int(-tok_.i);
+                next();
+                return vtype::INT;
+            }
+            auto t = unary();
+            if (!is_num(t)) Lexer::error(at, "numeric operand expected");
+            emit(t == vtype::REAL ? op::NEGF : op::NEGI);
+            return t;
+        }
+        if (accept_kw("NOT")) {
+            auto t = unary();
+            if (t == vtype::REAL) Lexer::error(at, "NOT requires BOOL or integer operand");
+            emit(t == vtype::BOOL ? op::NOTB : op::NOTI);
+            return t;
+        }
+        return primary();
+    }
+
+    vtype primary() {
+        auto at = tok_;
+        switch (tok_.kind) {
+        case token_t::INT: push_int(tok_.i); next(); return vtype::INT;
+        case token_t::TIME: push_int(tok_.i); next(); return vtype::TIME;
+        case token_t::REAL: push_real(tok_.f); next(); return vtype::REAL;
+        case token_t::OP:
+            if (accept_op("(")) {
+                auto t = expr();
+                expect_op(")");
+                return t;
+            }
+            break;
+        case token_t::IDENT: {
+            auto name = expect_ident();
+            if (name == "TRUE" || name == "FALSE") {
+                emit(op::PUSHI, name == "TRUE", 1);
+                return vtype::BOOL;
+            }
+            if (is_op("(")) {
+                return function(name, at);
+            }
+            auto sym = member_or_var(name, at);
+            emit(op::LOAD, sym.slot, 1);
+            return sym.type;
+        }
+        default: break;
+        }
+        Lexer::error(at, "unexpected '" + describe(at) + "'");
+    }
+
+    std::vector<vtype> args() {
+        std::vector<vtype> r;
+        expect_op("(");
+        if (!is_op(")")) {
+            do {
+                r.push_back(expr());
+            } while (accept_op(","));
+        }
+        expect_op(")");
+        return r;
+    }
+
+    vtype function(const std::string& name, const token_t& at) {
+        auto arity = [&](const std::vector<vtype>& a, std::size_t n) {
+            if (a.size() != n) {
+                Lexer::error(at, name + " expects " + std::to_string(n) + " argument(s)");
+            }
+        };
+
+        if (name == "ABS") {
+            auto a = args();
+            arity(a, 1);
+            if (!is_num(a[0])) Lexer::error(at, "numeric argument expected");
+            emit(a[0] == vtype::REAL ? op::ABSF : op::ABSI);
+            return a[0];
+        }
+        if (name == "SQRT") {
+            auto a = args();
+            arity(a, 1);
+            coerce(a[0], vtype::REAL, at);
+            emit(op::SQRTF);
+            return vtype::REAL;
+        }
+        if (name == "MIN" || name == "MAX") {
+            // 逐个参数求值并两两归约, 以便在中间插入类型提升
+            expect_op("(");
+            auto t = expr();
+            std::size_t n = 1;
+            while (accept_op(",")) {
+                t = promote(t, expr(), at);
+                if (name == "MIN") {
+                    emit(t == vtype::REAL ? op::MINF : op::MINI, 0, -1);
+                } else {
+                    emit(t == vtype::REAL ? op::MAXF : op::MAXI, 0, -1);
+                }
+                n++;
+            }
+            expect_op(")");
+            if (n < 2) Lexer::error(at, name + " expects at least 2 arguments");
+            return t;
+        }
+        if (name == "LIMIT") {
+            // LIMIT(MN, IN, MX) = MIN(MAX(IN, MN), MX)
+            expect_op("(");
+            auto t = expr();
+            expect_op(",");
+            t = promote(t, expr(), at);
+            emit(t == vtype::REAL ? op::MAXF : op::MAXI, 0, -1);
+            expect_op(",");
+            t = promote(t, expr(), at);
+            emit(t == vtype::REAL ? op::MINF : op::MINI, 0, -1);
+            expect_op(")");
+            return t;
+        }
+        if (name == "INT_TO_REAL" || name == "TIME_TO_REAL" || name == "TO_REAL") {
+            auto a = args();
+            arity(a, 1);
+            coerce(a[0], vtype::REAL, at);
+            return vtype::REAL;
+        }
+        if (name == "REAL_TO_INT" || name == "REAL_TO_TIME" || name == "TO_INT"
+            || name == "TIME_TO_INT" || name == "INT_TO_TIME" || name == "BOOL_TO_INT") {
+            auto a = args();
+            arity(a, 1);
+            if (a[0] == vtype::REAL) emit(op::F2I);
+            return name.ends_with("TIME") ? vtype::TIME : vtype::INT;
+        }
+        Lexer::error(at, "unknown function '" + name + "'");
+    }
+};
+
+}  // namespace detail
+
+/// 编译ST源码, 语法错误时抛出 std::runtime_error("st: line L:C: ...")
+///
+/// 支持的子集:
+///   - PROGRAM/VAR/VAR_INPUT/VAR_OUTPUT ... END_VAR, 类型 BOOL/INT族/REAL/LREAL/TIME
+///   - 功能块实例: R_TRIG/F_TRIG/TON/TOF/CTU/CTD/SR/RS, 调用 t(IN := x, PT := T#1s), 读 t.Q/t.ET
+///   - 语句: :=, IF/ELSIF/ELSE, WHILE, FOR..BY, REPEAT..UNTIL, EXIT, RETURN
+///   - 运算: OR/XOR/AND/&, = <> < <= > >=, + - * / MOD, - NOT
+///   - 函数: ABS/SQRT/MIN/MAX/LIMIT 及 INT_TO_REAL/REAL_TO_INT 等转换
+inline std::shared_ptr<const Program> compile(std::string_view src) {
+    return detail::Compiler(src).compile();
+}
+
+}  // namespace st
+}  // namespace cc
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <boost/core/noncopyable.hpp>
+#include <cc/asio/pool.h>
+#include <cc/asio/timer_wheel.h>
+#include <cc/stopwatch.h>
+
+namespace cc {
+namespace st {
+
+/// 事件驱动的TON/TOF: 到期由时间轮回调置位, 扫描时只读一个原子量, 不再每周期读时钟.
+/// ET按需计算(调用ET()时才读时钟).
+///
+/// 默认使用AsioPool::instance()的时间轮, 也可以传入扫描线程手动poll()的时间轮.
+/// 到期标志由回调共享持有, 块析构后仍在执行的回调不会访问悬空内存.
+template <typename Wheel = ConcurrentTimerWheel>
+struct EV_TON : boost::noncopyable {
+    mutable int STATE   = 0;  // (* 0-reset, 1-counting, 2-set *)
+    mutable int PREV_IN = 0;
+    mutable int PRESET  = 0;
+    mutable StopWatch stopwatch;
+
+    EV_TON() : EV_TON(AsioPool::instance().timer_wheel()) {}
+
+    explicit EV_TON(Wheel& wheel)
+      : wheel_(wheel)
+      , fired_(std::make_shared<std::atomic<unsigned>>(0)) {}
+
+    ~EV_TON() { wheel_.cancel(timer_); }
+
+    /// @return Q
+    int operator()(int IN, int PT) const {
+        if (!IN) {
+            if (STATE) {
+                wheel_.cancel(timer_);
+                STATE = 0;
+            }
+        } else if (STATE == 0 && !PREV_IN) {
+            PRESET = PT;
+            gen_++;
+            stopwatch.reset();
+            if (PT <= 0) {
+                STATE = 2;
+            } else {
+                STATE  = 1;
+                timer_ = wheel_.set_timeout(PT, [fired = fired_, gen = gen_] {
+                    fired->store(gen, std::memory_order_release);
+                });
+            }
+        } else if (STATE == 1 && fired_->load(std::memory_order_acquire) == gen_) {
+            STATE = 2;
+        }
+
+        PREV_IN = IN;
+        return STATE == 2;
+    }
+
+    int ET() const {
+        if (STATE == 2) return PRESET;
+        if (STATE == 0) return 0;
+        return std::min<int>(PRESET, stopwatch.elapsed_ms());
+    }
+
+private:
+    Wheel& wheel_;
+    std::shared_ptr<std::atomic<unsigned>> fired_;  // 最近一次到期的启动序号
+    mutable unsigned gen_ = 0;
+    mutable typename Wheel::handle_t timer_;
+};
+
+template <typename Wheel = ConcurrentTimerWheel>
+struct EV_TOF : boost::noncopyable {
+    mutable int STATE   = 0;  // (* 0-reset, 1-counting, 2-set *)
+    mutable int PREV_IN = 0;
+    mutable int PRESET  = 0;
+    mutable StopWatch stopwatch;
+
+    EV_TOF() : EV_TOF(AsioPool::instance().timer_wheel()) {}
+
+    explicit EV_TOF(Wheel& wheel)
+      : wheel_(wheel)
+      , fired_(std::make_shared<std::atomic<unsigned>>(0)) {}
+
+    ~EV_TOF() { wheel_.cancel(timer_); }
+
+    /// @return Q
+    int operator()(int IN, int PT) const {
+        if (IN) {
+            if (STATE) {
+                wheel_.cancel(timer_);
+                STATE = 0;
+            }
+        } else if (STATE == 0 && PREV_IN) {
+            PRESET = PT;
+            gen_++;
+            stopwatch.reset();
+            if (PT <= 0) {
+                STATE = 2;
+            } else {
+                STATE  = 1;
+                timer_ = wheel_.set_timeout(PT, [fired = fired_, gen = gen_] {
+                    fired->store(gen, std::memory_order_release);
+                });
+            }
+        } else if (STATE == 1 && fired_->load(std::memory_order_acquire) == gen_) {
+            STATE = 2;
+        }
+
+        PREV_IN = IN;
+        return IN || STATE == 1;
+    }
+
+    int ET() const {
+        if (STATE == 2) return PRESET;
+        if (STATE == 0) return 0;
+        return std::min<int>(PRESET, stopwatch.elapsed_ms());
+    }
+
+private:
+    Wheel& wheel_;
+    std::shared_ptr<std::atomic<unsigned>> fired_;  // 最近一次到期的启动序号
+    mutable unsigned gen_ = 0;
+    mutable typename Wheel::handle_t timer_;
+};
+
+}  // namespace st
+}  // namespace cc
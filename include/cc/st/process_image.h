@@ -0,0 +1,407 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <typeinfo>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <boost/core/noncopyable.hpp>
+#include <cc/st/retain.h>
+#include <cc/util.h>
+#include <gsl/gsl>
+
+namespace cc {
+namespace st {
+
+namespace detail {
+
+// 每个tag占用一个8字节的槽位
+using slot_t = std::uint64_t;
+
+template <typename T>
+inline constexpr bool is_tag_type_v =
+    std::is_trivially_copyable_v<T> && (std::is_arithmetic_v<T> || std::is_enum_v<T>)
+    && sizeof(T) <= sizeof(slot_t);
+
+/// 保持数据中的tag类型名(IEC 61131-3), 不依赖编译器的typeid名字. 枚举按底层类型
+template <typename T>
+inline constexpr const char* tag_type_name() noexcept {
+    if constexpr (std::is_enum_v<T>) {
+        return tag_type_name<std::underlying_type_t<T>>();
+    } else if constexpr (std::is_same_v<T, bool>) {
+        return "BOOL";
+    } else if constexpr (std::is_floating_point_v<T>) {
+        return sizeof(T) == 4 ? "REAL" : "LREAL";
+    } else if constexpr (std::is_signed_v<T>) {
+        constexpr const char* names[] = {"SINT", "INT", "DINT", "LINT"};
+        return names[sizeof(T) == 1 ? 0 : sizeof(T) == 2 ? 1 : sizeof(T) == 4 ? 2 : 3];
+    } else {
+        constexpr const char* names[] = {"USINT", "UINT", "UDINT", "ULINT"};
+        return names[sizeof(T) == 1 ? 0 : sizeof(T) == 2 ? 1 : sizeof(T) == 4 ? 2 : 3];
+    }
+}
+
+/// 无锁三缓冲: 单生产者/单消费者
+/// 生产者写back并与middle交换(publish), 消费者将front与middle交换(fetch)
+/// 双方都不会阻塞对方, 消费者总能拿到最新一次publish的完整镜像
+class TripleBuffer : boost::noncopyable {
+    enum : std::uint8_t { kIndexMask = 0x03, kDirty = 0x04 };
+
+    std::unique_ptr<slot_t[]> data_;
+    std::size_t size_ = 0;
+    std::atomic<std::uint8_t> middle_{1};
+    std::uint8_t back_  = 0;
+    std::uint8_t front_ = 2;
+
+public:
+    TripleBuffer() = default;
+
+    void resize(std::size_t n) {
+        data_ = std::make_unique<slot_t[]>(n * 3);
+        size_ = n;
+    }
+
+    inline std::size_t size() const noexcept { return size_; }
+
+    inline slot_t* back() noexcept { return data_.get() + back_ * size_; }
+    inline const slot_t* front() const noexcept { return data_.get() + front_ * size_; }
+
+    inline void publish() noexcept {
+        back_ = middle_.exchange(back_ | kDirty, std::memory_order_acq_rel) & kIndexMask;
+    }
+
+    /// @return 是否取到了新的镜像
+    inline bool fetch() noexcept {
+        if (!(middle_.load(std::memory_order_relaxed) & kDirty)) {
+            return false;
+        }
+        front_ = middle_.exchange(front_, std::memory_order_acq_rel) & kIndexMask;
+        return true;
+    }
+};
+
+/// 单侧的过程映像: 写端在staging上累积修改, commit时整体发布
+class ImageSide : boost::noncopyable {
+public:
+    inline std::size_t size() const noexcept { return size_; }
+
+    /// 声明阶段只计数, 开始运行时一次性分配
+    inline std::uint32_t add_slot() noexcept { return gsl::narrow_cast<std::uint32_t>(size_++); }
+
+    void allocate() {
+        staging_ = std::make_unique<slot_t[]>(size_);
+        buf_.resize(size_);
+    }
+
+    inline slot_t* staging() noexcept { return staging_.get(); }
+    inline const slot_t* snapshot() const noexcept { return buf_.front(); }
+
+    inline void commit() noexcept {
+        std::memcpy(buf_.back(), staging_.get(), size_ * sizeof(slot_t));
+        buf_.publish();
+    }
+
+    inline bool fetch() noexcept { return buf_.fetch(); }
+
+private:
+    std::size_t size_ = 0;
+    TripleBuffer buf_;
+    std::unique_ptr<slot_t[]> staging_;
+};
+
+template <typename T>
+inline T load_slot(const slot_t* base, std::uint32_t index) noexcept {
+    T v;
+    std::memcpy(&v, base + index, sizeof(T));
+    return v;
+}
+
+template <typename T>
+inline void store_slot(slot_t* base, std::uint32_t index, T v) noexcept {
+    std::memcpy(base + index, &v, sizeof(T));
+}
+
+}  // namespace detail
+
+template <typename T>
+struct InputTag {
+    std::uint32_t index;
+};
+
+template <typename T>
+struct OutputTag {
+    std::uint32_t index;
+};
+
+/// 扫描周期的过程映像(process image)
+///
+/// tag只声明一次, 每个扫描周期开始时拿到一份不可变的输入快照, 结束时整体发布输出.
+/// 输入/输出各用一个无锁三缓冲交换, IO线程更新下一份输入映像时不会阻塞扫描线程.
+///
+/// 约定:
+///   - 所有tag需在第一次scan/读写之前声明
+///   - 扫描(begin_scan)只允许在一个线程上进行
+///   - 多个IO线程同时写输入/读输出时, 使用ConcurrentProcessImage
+// clang-format off
+template <
+    typename MutexPolicy = NonMutex,
+    template <class> class WriterLock = LockGuard
+>  // clang-format on
+class ProcessImage final : boost::noncopyable {
+    using slot_t = detail::slot_t;
+
+    struct tag_info_t {
+        std::uint32_t index;
+        const std::type_info* type;
+        const char* type_name;  // 保持数据中的类型名
+    };
+
+public:
+    class Scan;
+
+    class InputWriter {
+        slot_t* base_;
+
+    public:
+        explicit InputWriter(slot_t* base) : base_(base) {}
+
+        template <typename T>
+        inline void set(InputTag<T> tag, T v) noexcept {
+            detail::store_slot<T>(base_, tag.index, v);
+        }
+    };
+
+    class OutputReader {
+        const slot_t* base_;
+
+    public:
+        explicit OutputReader(const slot_t* base) : base_(base) {}
+
+        template <typename T>
+        inline T get(OutputTag<T> tag) const noexcept {
+            return detail::load_slot<T>(base_, tag.index);
+        }
+    };
+
+public:
+    ProcessImage() = default;
+
+    template <typename T>
+    InputTag<T> declare_input(std::string_view name) {
+        return InputTag<T>{declare<T>(inputs_, input_tags_, name)};
+    }
+
+    template <typename T>
+    OutputTag<T> declare_output(std::string_view name) {
+        return OutputTag<T>{declare<T>(outputs_, output_tags_, name)};
+    }
+
+    template <typename T>
+    InputTag<T> input(std::string_view name) const {
+        return InputTag<T>{lookup<T>(input_tags_, name)};
+    }
+
+    template <typename T>
+    OutputTag<T> output(std::string_view name) const {
+        return OutputTag<T>{lookup<T>(output_tags_, name)};
+    }
+
+    /// 开始一个扫描周期, 取最新发布的输入映像作为本周期的快照
+    /// Scan析构(或调用commit)时发布输出映像
+    Scan begin_scan() {
+        seal();
+        inputs_.fetch();
+        scans_++;
+        return Scan(*this);
+    }
+
+    /// IO端: 批量写入输入, 只发布一次
+    ///
+    /// @param fn   void(InputWriter&)
+    template <typename Fn>
+    void write_inputs(Fn&& fn) {
+        seal();
+        WriterLock<MutexPolicy> _lck{in_mtx_};
+        InputWriter w(inputs_.staging());
+        std::forward<Fn>(fn)(w);
+        inputs_.commit();
+    }
+
+    template <typename T>
+    void set_input(InputTag<T> tag, T v) {
+        write_inputs([&](InputWriter& w) { w.set(tag, v); });
+    }
+
+    /// IO端: 读取最近一次扫描发布的输出
+    ///
+    /// @param fn   R(const OutputReader&)
+    template <typename Fn>
+    decltype(auto) read_outputs(Fn&& fn) {
+        seal();
+        WriterLock<MutexPolicy> _lck{out_mtx_};
+        outputs_.fetch();
+        return std::forward<Fn>(fn)(OutputReader(outputs_.snapshot()));
+    }
+
+    template <typename T>
+    T get_output(OutputTag<T> tag) {
+        return read_outputs([&](const OutputReader& r) { return r.get(tag); });
+    }
+
+    /// 已完成的扫描次数
+    inline std::uint64_t scans() const noexcept { return scans_; }
+
+    /// 保持型输出: 将输出映像写入out(复用out的容量), 在扫描线程的两次扫描之间调用
+    void snapshot(std::vector<char>& out) {
+        seal();
+        if (GSL_UNLIKELY(dir_.count() != outputs_.size())) {
+            std::vector<std::pair<const std::string*, const tag_info_t*>> tags(outputs_.size());
+            for (auto& [name, info] : output_tags_) {
+                tags[info.index] = {&name, &info};
+            }
+            for (auto& [name, info] : tags) {
+                dir_.add(info->type_name, *name, sizeof(slot_t));
+            }
+        }
+
+        std::memcpy(dir_.begin(out), outputs_.staging(), outputs_.size() * sizeof(slot_t));
+    }
+
+    /// 按tag名与类型恢复输出映像并发布, 应在第一次扫描之前调用
+    ///
+    /// @return 快照格式是否合法
+    bool restore(const std::vector<char>& data) {
+        seal();
+        bool ok = detail::retain_parse(
+            data.data(), data.size(),
+            [this](std::string_view type, std::string_view name, const char* p,
+                   std::uint16_t size) {
+                auto it = output_tags_.find(std::string(name));
+                if (it != output_tags_.end() && type == it->second.type_name
+                    && size == sizeof(slot_t)) {
+                    std::memcpy(outputs_.staging() + it->second.index, p, sizeof(slot_t));
+                }
+            });
+        outputs_.commit();
+        return ok;
+    }
+
+private:
+    template <typename T>
+    std::uint32_t declare(detail::ImageSide& side,
+                          std::unordered_map<std::string, tag_info_t>& tags,
+                          std::string_view name) {
+        static_assert(detail::is_tag_type_v<T>, "ProcessImage: unsupported tag type");
+        if (GSL_UNLIKELY(sealed_.load(std::memory_order_relaxed))) {
+            throw std::runtime_error("ProcessImage: declare after start. tag="
+                                     + std::string(name));
+        }
+
+        std::string k(name);
+        auto it = tags.find(k);
+        if (it != tags.end()) {
+            if (*it->second.type != typeid(T)) {
+                throw std::runtime_error("ProcessImage: tag type dismatch. tag=" + k);
+            }
+            return it->second.index;
+        }
+
+        auto index = side.add_slot();
+        tags.emplace(std::move(k), tag_info_t{index, &typeid(T), detail::tag_type_name<T>()});
+        return index;
+    }
+
+    template <typename T>
+    static std::uint32_t lookup(const std::unordered_map<std::string, tag_info_t>& tags,
+                                std::string_view name) {
+        auto it = tags.find(std::string(name));
+        if (it == tags.end()) {
+            throw std::runtime_error("ProcessImage: tag not found. tag=" + std::string(name));
+        }
+        if (*it->second.type != typeid(T)) {
+            throw std::runtime_error("ProcessImage: tag type dismatch. tag=" + std::string(name));
+        }
+        return it->second.index;
+    }
+
+    inline void seal() {
+        if (GSL_UNLIKELY(!sealed_.load(std::memory_order_acquire))) {
+            std::call_once(seal_flag_, [this] {
+                inputs_.allocate();
+                outputs_.allocate();
+                sealed_.store(true, std::memory_order_release);
+            });
+        }
+    }
+
+private:
+    detail::ImageSide inputs_;
+    detail::ImageSide outputs_;
+    std::unordered_map<std::string, tag_info_t> input_tags_;
+    std::unordered_map<std::string, tag_info_t> output_tags_;
+    std::atomic<bool> sealed_{false};
+    std::once_flag seal_flag_;
+    std::uint64_t scans_ = 0;
+    detail::RetainDirectory dir_;
+
+    MutexPolicy in_mtx_;
+    MutexPolicy out_mtx_;
+};
+
+template <typename MutexPolicy, template <class> class WriterLock>
+class ProcessImage<MutexPolicy, WriterLock>::Scan : boost::noncopyable {
+    ProcessImage* image_;
+    const slot_t* in_;
+    slot_t* out_;
+
+public:
+    explicit Scan(ProcessImage& image)
+      : image_(&image)
+      , in_(image.inputs_.snapshot())
+      , out_(image.outputs_.staging()) {}
+
+    Scan(Scan&& rhs) noexcept
+      : image_(std::exchange(rhs.image_, nullptr))
+      , in_(rhs.in_)
+      , out_(rhs.out_) {}
+
+    ~Scan() { commit(); }
+
+    template <typename T>
+    inline T get(InputTag<T> tag) const noexcept {
+        return detail::load_slot<T>(in_, tag.index);
+    }
+
+    /// 本周期内已写入(或上周期保留)的输出值
+    template <typename T>
+    inline T get(OutputTag<T> tag) const noexcept {
+        return detail::load_slot<T>(out_, tag.index);
+    }
+
+    template <typename T>
+    inline void set(OutputTag<T> tag, T v) noexcept {
+        detail::store_slot<T>(out_, tag.index, v);
+    }
+
+    /// 发布输出映像, 只生效一次
+    void commit() noexcept {
+        if (image_) {
+            image_->outputs_.commit();
+            image_ = nullptr;
+        }
+    }
+};
+
+using ConcurrentProcessImage = ProcessImage<std::mutex>;
+
+}  // namespace st
+}  // namespace cc
@@ -0,0 +1,240 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include <cc/stopwatch.h>
+
+namespace cc {
+namespace st {
+
+namespace detail {
+
+/// 保持型变量快照格式:
+///   "CCRT" | u32 ntypes | ntypes * (u16 len, type, u16 size)
+///          | u32 count  | count * (u16 type, u16 len, name)
+///          | payload
+/// payload按目录顺序紧密排列, 同类型条目长度相同. 目录只在条目集合变化时重建.
+inline constexpr char kRetainMagic[4] = {'C', 'C', 'R', 'T'};
+
+inline void retain_put(std::vector<char>& out, const void* p, std::size_t n) {
+    auto* c = static_cast<const char*>(p);
+    out.insert(out.end(), c, c + n);
+}
+
+class RetainDirectory {
+    struct type_t {
+        std::string name;
+        std::uint16_t size;
+    };
+
+    std::vector<type_t> types_;
+    std::unordered_map<std::string, std::uint16_t> type_index_;
+    std::vector<char> names_;
+    std::uint32_t count_ = 0;
+    std::size_t payload_ = 0;
+    mutable bool dirty_  = true;
+    mutable std::vector<char> buf_;
+
+public:
+    void clear() {
+        type_index_.clear();
+        types_.clear();
+        names_.clear();
+        count_   = 0;
+        payload_ = 0;
+        dirty_   = true;
+    }
+
+    void add(std::string_view type, std::string_view name, std::uint16_t size) {
+        auto it = type_index_.find(std::string(type));
+        if (it == type_index_.end()) {
+            auto index = static_cast<std::uint16_t>(types_.size());
+            types_.push_back(type_t{std::string(type), size});
+            it = type_index_.emplace(std::string(type), index).first;
+        }
+
+        auto len = static_cast<std::uint16_t>(name.size());
+        retain_put(names_, &it->second, sizeof(it->second));
+        retain_put(names_, &len, sizeof(len));
+        retain_put(names_, name.data(), name.size());
+        count_++;
+        payload_ += types_[it->second].size;
+        dirty_ = true;
+    }
+
+    inline std::uint32_t count() const noexcept { return count_; }
+
+    /// 以目录开始一份新的快照, 预留payload空间
+    ///
+    /// @return payload的起始位置
+    char* begin(std::vector<char>& out) const {
+        if (dirty_) {
+            buf_.clear();
+            auto ntypes = static_cast<std::uint32_t>(types_.size());
+            retain_put(buf_, kRetainMagic, sizeof(kRetainMagic));
+            retain_put(buf_, &ntypes, sizeof(ntypes));
+            for (auto& t : types_) {
+                auto len = static_cast<std::uint16_t>(t.name.size());
+                retain_put(buf_, &len, sizeof(len));
+                retain_put(buf_, t.name.data(), t.name.size());
+                retain_put(buf_, &t.size, sizeof(t.size));
+            }
+            retain_put(buf_, &count_, sizeof(count_));
+            buf_.insert(buf_.end(), names_.begin(), names_.end());
+            dirty_ = false;
+        }
+
+        out.resize(buf_.size() + payload_);
+        std::memcpy(out.data(), buf_.data(), buf_.size());
+        return out.data() + buf_.size();
+    }
+};
+
+/// 遍历快照中的条目
+///
+/// @param fn   void(std::string_view type, std::string_view name, const char* data,
+///                  std::uint16_t size)
+/// @return 格式是否合法
+template <typename Fn>
+bool retain_parse(const char* data, std::size_t n, Fn&& fn) {
+    const char* p   = data;
+    const char* end = data + n;
+    auto take       = [&](void* dst, std::size_t len) {
+        if (static_cast<std::size_t>(end - p) < len) return false;
+        std::memcpy(dst, p, len);
+        p += len;
+        return true;
+    };
+    auto take_str = [&](std::string_view& s) {
+        std::uint16_t len;
+        if (!take(&len, sizeof(len)) || static_cast<std::size_t>(end - p) < len) return false;
+        s = std::string_view(p, len);
+        p += len;
+        return true;
+    };
+
+    char magic[4];
+    std::uint32_t ntypes;
+    if (!take(magic, sizeof(magic)) || std::memcmp(magic, kRetainMagic, sizeof(magic)) != 0
+        || !take(&ntypes, sizeof(ntypes))) {
+        return false;
+    }
+
+    struct type_t {
+        std::string_view name;
+        std::uint16_t size;
+    };
+    std::vector<type_t> types(ntypes);
+    for (auto& t : types) {
+        if (!take_str(t.name) || !take(&t.size, sizeof(t.size))) return false;
+    }
+
+    std::uint32_t count;
+    if (!take(&count, sizeof(count))) {
+        return false;
+    }
+
+    // 先校验目录与payload长度, 再回调
+    const char* names = p;
+    std::size_t total = 0;
+    for (std::uint32_t i = 0; i < count; i++) {
+        std::uint16_t type;
+        std::string_view name;
+        if (!take(&type, sizeof(type)) || type >= ntypes || !take_str(name)) return false;
+        total += types[type].size;
+    }
+    if (static_cast<std::size_t>(end - p) < total) {
+        return false;
+    }
+
+    const char* payload = p;
+    p                   = names;
+    for (std::uint32_t i = 0; i < count; i++) {
+        std::uint16_t type;
+        std::string_view name;
+        take(&type, sizeof(type));
+        take_str(name);
+        fn(types[type].name, name, payload, types[type].size);
+        payload += types[type].size;
+    }
+    return true;
+}
+
+/// 块状态序列化: 块实现 template <class Ar> void retain(Ar& ar) const { ar(a, b, ...); }
+/// 写入预先分配好的缓冲区, p为nullptr时只计算长度
+class RetainWriter {
+    char* p_;
+    std::size_t size_ = 0;
+
+public:
+    explicit RetainWriter(char* p) : p_(p) {}
+
+    template <typename... Ts>
+    inline void operator()(const Ts&... vs) {
+        (put(vs), ...);
+    }
+
+    inline std::size_t size() const noexcept { return size_; }
+
+private:
+    template <typename Clock>
+    inline void put(const BasicStopWatch<Clock>& sw) {
+        put(sw.elapsed());
+    }
+
+    template <typename T>
+    inline void put(const T& v) {
+        static_assert(std::is_trivially_copyable_v<T>, "retain: unsupported type");
+        if (p_) {
+            std::memcpy(p_ + size_, &v, sizeof(T));
+        }
+        size_ += sizeof(T);
+    }
+};
+
+class RetainReader {
+    const char* p_;
+    const char* end_;
+
+public:
+    RetainReader(const char* data, std::size_t n) : p_(data), end_(data + n) {}
+
+    template <typename... Ts>
+    inline void operator()(Ts&... vs) {
+        (get(vs), ...);
+    }
+
+private:
+    template <typename Clock>
+    inline void get(BasicStopWatch<Clock>& sw) {
+        double elapsed = 0;
+        get(elapsed);
+        sw.reset(elapsed);
+    }
+
+    template <typename T>
+    inline void get(T& v) {
+        if (static_cast<std::size_t>(end_ - p_) < sizeof(T)) return;
+        std::memcpy(&v, p_, sizeof(T));
+        p_ += sizeof(T);
+    }
+};
+
+/// 块状态的序列化长度(同类型的块长度固定)
+template <typename T>
+std::uint16_t retain_size(const T& obj) {
+    RetainWriter w(nullptr);
+    obj.retain(w);
+    return static_cast<std::uint16_t>(w.size());
+}
+
+}  // namespace detail
+
+}  // namespace st
+}  // namespace cc
@@ -0,0 +1,330 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include <boost/core/noncopyable.hpp>
+#include <cc/util.h>
+#include <gsl/gsl>
+
+#ifdef __linux__
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
+#ifdef CC_WITH_SQLITE3
+#    include <cc/sqlite3pp.h>
+#endif
+
+namespace cc {
+namespace st {
+
+#ifdef __linux__
+/// 基于mmap的双槽快照文件
+///
+/// 每次写入较旧的槽, 数据落盘后才更新槽头(序号/长度/校验), 写入中途掉电时另一个槽仍完整.
+/// 槽容量不足时在文件尾部分配新的区域, 文件只增不减.
+class MmapRetainStore final : boost::noncopyable {
+    struct slot_t {
+        std::uint64_t seq;
+        std::uint64_t offset;
+        std::uint64_t capacity;
+        std::uint64_t length;
+        std::uint64_t checksum;
+    };
+
+    struct header_t {
+        char magic[8];
+        slot_t slots[2];
+    };
+
+    static constexpr char kMagic[8] = {'C', 'C', 'R', 'E', 'T', 'A', 'I', 'N'};
+    static constexpr std::size_t kPage = 4096;
+
+public:
+    explicit MmapRetainStore(const std::string& path) {
+        fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (GSL_UNLIKELY(fd_ < 0)) {
+            throw std::runtime_error("MmapRetainStore: open failed. path=" + path);
+        }
+
+        struct stat st;
+        ::fstat(fd_, &st);
+        if (static_cast<std::size_t>(st.st_size) < kPage) {
+            resize(kPage);
+            std::memset(base_, 0, sizeof(header_t));
+            std::memcpy(header()->magic, kMagic, sizeof(kMagic));
+            ::msync(base_, kPage, MS_SYNC);
+        } else {
+            resize(st.st_size);
+            if (std::memcmp(header()->magic, kMagic, sizeof(kMagic)) != 0) {
+                throw std::runtime_error("MmapRetainStore: bad file. path=" + path);
+            }
+        }
+    }
+
+    ~MmapRetainStore() {
+        if (base_) ::munmap(base_, size_);
+        if (fd_ >= 0) ::close(fd_);
+    }
+
+    void save(const std::vector<char>& data) {
+        auto* h    = header();
+        int which  = h->slots[0].seq <= h->slots[1].seq ? 0 : 1;
+        slot_t s   = h->slots[which];
+        auto newer = std::max(h->slots[0].seq, h->slots[1].seq) + 1;
+
+        if (s.capacity < data.size()) {
+            s.offset   = size_;
+            s.capacity = (data.size() * 2 + kPage - 1) / kPage * kPage;
+            resize(size_ + s.capacity);
+            h = header();
+        }
+
+        std::memcpy(base_ + s.offset, data.data(), data.size());
+        sync(s.offset, data.size());
+
+        s.length   = data.size();
+        s.checksum = checksum(data.data(), data.size());
+        s.seq      = newer;
+
+        h->slots[which] = s;
+        sync(0, sizeof(header_t));
+    }
+
+    /// @return 是否存在完整的快照
+    bool load(std::vector<char>& out) {
+        auto* h  = header();
+        int best = -1;
+        for (int i = 0; i < 2; i++) {
+            auto& s = h->slots[i];
+            if (s.seq == 0 || s.offset + s.length > size_
+                || checksum(base_ + s.offset, s.length) != s.checksum) {
+                continue;
+            }
+            if (best < 0 || s.seq > h->slots[best].seq) {
+                best = i;
+            }
+        }
+        if (best < 0) {
+            return false;
+        }
+
+        auto& s = h->slots[best];
+        out.assign(base_ + s.offset, base_ + s.offset + s.length);
+        return true;
+    }
+
+private:
+    inline header_t* header() noexcept { return reinterpret_cast<header_t*>(base_); }
+
+    void resize(std::size_t size) {
+        if (GSL_UNLIKELY(::ftruncate(fd_, size) != 0)) {
+            throw std::runtime_error("MmapRetainStore: ftruncate failed");
+        }
+        if (base_) {
+            ::munmap(base_, size_);
+        }
+        void* p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (GSL_UNLIKELY(p == MAP_FAILED)) {
+            base_ = nullptr;
+            throw std::runtime_error("MmapRetainStore: mmap failed");
+        }
+        base_ = static_cast<char*>(p);
+        size_ = size;
+    }
+
+    void sync(std::size_t offset, std::size_t len) {
+        auto begin = offset / kPage * kPage;
+        ::msync(base_ + begin, offset + len - begin, MS_SYNC);
+    }
+
+    // FNV-1a
+    static std::uint64_t checksum(const char* p, std::size_t n) noexcept {
+        std::uint64_t h = 14695981039346656037ull;
+        for (std::size_t i = 0; i < n; i++) {
+            h = (h ^ static_cast<unsigned char>(p[i])) * 1099511628211ull;
+        }
+        return h;
+    }
+
+private:
+    int fd_           = -1;
+    char* base_       = nullptr;
+    std::size_t size_ = 0;
+};
+#endif
+
+#ifdef CC_WITH_SQLITE3
+/// 以name为主键保存在sqlite的st_retain表中
+///
+/// 写入在后台线程上进行(Sqlite3pp的连接是线程独立的), 因此不能使用":memory:"
+class SqliteRetainStore final : boost::noncopyable {
+public:
+    SqliteRetainStore(Sqlite3pp& db, std::string name) : db_(db), name_(std::move(name)) {
+        db_.execute(
+            "CREATE TABLE IF NOT EXISTS st_retain("
+            "name TEXT PRIMARY KEY, ts INTEGER NOT NULL, data BLOB NOT NULL) WITHOUT ROWID;");
+    }
+
+    void save(const std::vector<char>& data) {
+        auto ts = std::chrono::duration_cast<std::chrono::milliseconds>(
+                      std::chrono::system_clock::now().time_since_epoch())
+                      .count();
+        db_.execute("INSERT OR REPLACE INTO st_retain(name, ts, data) VALUES(?, ?, ?);", name_,
+                    ts, data);
+    }
+
+    bool load(std::vector<char>& out) {
+        using row_t = std::tuple<std::vector<char>>;
+        auto rows = db_.execute<row_t>("SELECT data FROM st_retain WHERE name = ?;", name_);
+        if (rows.empty()) {
+            return false;
+        }
+        out = std::move(std::get<0>(rows[0]));
+        return true;
+    }
+
+private:
+    Sqlite3pp& db_;
+    const std::string name_;
+};
+#endif
+
+/// 保持型变量的异步保存
+///
+/// 扫描线程每every次扫描对源对象(StFactory/ProcessImage, 提供snapshot(std::vector<char>&))
+/// 做一次快照, 与后台线程交换缓冲区后立即返回; 后台线程只写最新的一份, 来不及写的旧快照直接丢弃.
+/// 稳定运行时缓冲区被反复复用, 没有内存分配.
+///
+/// Store需提供 void save(const std::vector<char>&) 与 bool load(std::vector<char>&)
+template <typename Store>
+class Retainer final : boost::noncopyable {
+public:
+    /// @param every    每多少次扫描保存一次
+    /// @param args     Store的构造参数
+    template <typename... Args>
+    explicit Retainer(int every, Args&&... args)
+      : store_(std::forward<Args>(args)...)
+      , every_(std::max(1, every)) {
+        thread_ = std::thread([this] { loop(); });
+    }
+
+    /// 析构时写入尚未保存的快照
+    ~Retainer() {
+        do {
+            std::lock_guard _lck{mtx_};
+            stopped_ = true;
+        } while (0);
+        cv_.notify_one();
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+    /// 扫描线程每个周期调用一次
+    ///
+    /// @return 本周期是否做了快照
+    template <typename Source>
+    bool on_scan(Source& source) {
+        if (++scans_ < every_) {
+            return false;
+        }
+        scans_ = 0;
+        save(source);
+        return true;
+    }
+
+    /// 立即做一次快照(异步写入)
+    template <typename Source>
+    void save(Source& source) {
+        source.snapshot(front_);
+        do {
+            std::lock_guard _lck{mtx_};
+            if (has_pending_) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+            }
+            std::swap(front_, pending_);
+            has_pending_ = true;
+        } while (0);
+        cv_.notify_one();
+    }
+
+    /// 启动时从Store恢复, sink提供restore(std::vector<char>)
+    template <typename Sink>
+    bool restore(Sink& sink) {
+        std::vector<char> data;
+        if (!store_.load(data)) {
+            return false;
+        }
+        return sink.restore(std::move(data));
+    }
+
+    /// 已写入的快照个数
+    inline std::uint64_t written() const noexcept {
+        return written_.load(std::memory_order_relaxed);
+    }
+
+    /// 因后台写入较慢而被丢弃的快照个数
+    inline std::uint64_t dropped() const noexcept {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+private:
+    void loop() {
+        cc::set_threadname("st#retain");
+        for (;;) {
+            do {
+                std::unique_lock _lck{mtx_};
+                cv_.wait(_lck, [this] { return has_pending_ || stopped_; });
+                if (!has_pending_) {
+                    return;
+                }
+                std::swap(pending_, back_);
+                has_pending_ = false;
+            } while (0);
+
+            try {
+                store_.save(back_);
+                written_.fetch_add(1, std::memory_order_relaxed);
+            } catch (std::exception& e) {
+                fprintf(stderr, "Error in Retainer: %s\n", e.what());
+            }
+        }
+    }
+
+private:
+    Store store_;
+    const int every_;
+    int scans_ = 0;
+
+    // front_: 扫描线程; pending_: 交接; back_: 后台线程
+    std::vector<char> front_;
+    std::vector<char> pending_;
+    std::vector<char> back_;
+
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    bool has_pending_ = false;
+    bool stopped_     = false;
+    std::atomic<std::uint64_t> written_{0};
+    std::atomic<std::uint64_t> dropped_{0};
+    std::thread thread_;
+};
+
+}  // namespace st
+}  // namespace cc
@@ -0,0 +1,472 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <boost/core/noncopyable.hpp>
+#include <cc/st.h>
+#include <gsl/gsl>
+
+namespace cc {
+namespace st {
+
+/// 变量类型, INT/TIME统一按int64存储, TIME单位为毫秒
+enum class vtype : std::uint8_t { BOOL, INT, REAL, TIME };
+
+union cell_t {
+    std::int64_t i;
+    double f;
+};
+
+/// 字节码: 每条指令32位, 低8位为操作码, 高24位为操作数(有符号立即数/槽位/跳转地址)
+namespace op {
+enum : std::uint8_t {
+    HALT = 0,
+    PUSHI,  // 立即数
+    PUSHK,  // 常量池
+    LOAD,
+    STORE,
+    ADDI,
+    SUBI,
+    MULI,
+    DIVI,
+    MODI,
+    NEGI,
+    ADDF,
+    SUBF,
+    MULF,
+    DIVF,
+    NEGF,
+    I2F,   // 栈顶 int -> real
+    I2F1,  // 次栈顶 int -> real
+    F2I,
+    EQI,
+    NEI,
+    LTI,
+    LEI,
+    GTI,
+    GEI,
+    EQF,
+    NEF,
+    LTF,
+    LEF,
+    GTF,
+    GEF,
+    AND,
+    OR,
+    XOR,
+    NOTB,
+    NOTI,
+    ABSI,
+    ABSF,
+    MINI,
+    MINF,
+    MAXI,
+    MAXF,
+    SQRTF,
+    JMP,
+    JZ,
+    JNZ,
+    LOOP,  // 向后跳转, 计入看门狗
+    CALLFB,
+};
+}  // namespace op
+
+/// 指令操作数为24位有符号数
+inline constexpr std::int32_t kArgMin = -(1 << 23);
+inline constexpr std::int32_t kArgMax = (1 << 23) - 1;
+
+/// @param arg 须在[kArgMin, kArgMax]内, 由编译器检查
+inline constexpr std::uint32_t encode(std::uint8_t code, std::int32_t arg = 0) noexcept {
+    return (static_cast<std::uint32_t>(arg) << 8) | code;
+}
+
+/// 编译产物, 不可变, 可在多个Vm之间共享
+struct Program {
+    struct var_t {
+        std::string name;
+        vtype type;
+        std::uint32_t slot;
+        cell_t init;
+    };
+
+    struct fb_t {
+        std::string name;
+        std::string type;
+        std::uint32_t slot;  // io槽位起始: 先输入后输出
+    };
+
+    std::string name;
+    std::vector<std::uint32_t> code;
+    std::vector<cell_t> consts;
+    std::vector<var_t> vars;
+    std::vector<fb_t> fbs;
+    std::uint32_t nslots    = 0;
+    std::uint32_t max_stack = 0;
+
+    const var_t* find_var(std::string_view name) const {
+        for (const auto& v : vars) {
+            if (v.name == name) return &v;
+        }
+        return nullptr;
+    }
+
+    const fb_t* find_fb(std::string_view name) const {
+        for (const auto& fb : fbs) {
+            if (fb.name == name) return &fb;
+        }
+        return nullptr;
+    }
+};
+
+namespace detail {
+
+struct block_t {
+    virtual ~block_t() = default;
+    virtual void call(cell_t* io) = 0;
+};
+
+template <typename T, typename Fn>
+struct native_block_t final : block_t {
+    T obj;
+    void call(cell_t* io) override { Fn{}(obj, io); }
+};
+
+struct block_desc_t {
+    struct param_t {
+        std::string name;
+        vtype type;
+    };
+
+    std::vector<param_t> inputs;
+    std::vector<param_t> outputs;
+    std::unique_ptr<block_t> (*make)();
+
+    inline std::uint32_t size() const noexcept {
+        return gsl::narrow_cast<std::uint32_t>(inputs.size() + outputs.size());
+    }
+};
+
+// clang-format off
+struct call_trig {
+    template <typename T>
+    void operator()(const T& b, cell_t* io) const { io[1].i = b(int(io[0].i)); }
+};
+
+struct call_timer {
+    template <typename T>
+    void operator()(const T& b, cell_t* io) const {
+        auto [q, et] = b(int(io[0].i), int(io[1].i));
+        io[2].i      = q;
+        io[3].i      = et;
+    }
+};
+
+struct call_counter {
+    template <typename T>
+    void operator()(const T& b, cell_t* io) const {
+        auto [q, cv] = b(int(io[0].i), int(io[1].i), int(io[2].i));
+        io[3].i      = q;
+        io[4].i      = cv;
+    }
+};
+
+struct call_latch {
+    template <typename T>
+    void operator()(const T& b, cell_t* io) const { io[2].i = b(int(io[0].i), int(io[1].i)); }
+};
+// clang-format on
+
+template <typename T, typename Fn>
+std::unique_ptr<block_t> make_block() {
+    return std::make_unique<native_block_t<T, Fn>>();
+}
+
+/// st.h中的标准功能块, 以原生方式调用
+inline const std::unordered_map<std::string, block_desc_t>& block_table() {
+    static const std::unordered_map<std::string, block_desc_t> table = {
+        {"R_TRIG", {{{"CLK", vtype::BOOL}}, {{"Q", vtype::BOOL}}, make_block<R_TRIG, call_trig>}},
+        {"F_TRIG", {{{"CLK", vtype::BOOL}}, {{"Q", vtype::BOOL}}, make_block<F_TRIG, call_trig>}},
+        {"TON",
+         {{{"IN", vtype::BOOL}, {"PT", vtype::TIME}},
+          {{"Q", vtype::BOOL}, {"ET", vtype::TIME}},
+          make_block<TON, call_timer>}},
+        {"TOF",
+         {{{"IN", vtype::BOOL}, {"PT", vtype::TIME}},
+          {{"Q", vtype::BOOL}, {"ET", vtype::TIME}},
+          make_block<TOF, call_timer>}},
+        {"CTU",
+         {{{"CU", vtype::BOOL}, {"R", vtype::BOOL}, {"PV", vtype::INT}},
+          {{"Q", vtype::BOOL}, {"CV", vtype::INT}},
+          make_block<CTU, call_counter>}},
+        {"CTD",
+         {{{"CD", vtype::BOOL}, {"LD", vtype::BOOL}, {"PV", vtype::INT}},
+          {{"Q", vtype::BOOL}, {"CV", vtype::INT}},
+          make_block<CTD, call_counter>}},
+        {"SR",
+         {{{"S1", vtype::BOOL}, {"R", vtype::BOOL}}, {{"Q1", vtype::BOOL}},
+          make_block<SR, call_latch>}},
+        {"RS",
+         {{{"S", vtype::BOOL}, {"R1", vtype::BOOL}}, {{"Q1", vtype::BOOL}},
+          make_block<RS, call_latch>}},
+    };
+    return table;
+}
+
+inline const block_desc_t* find_block(std::string_view type) {
+    const auto& table = block_table();
+    auto it           = table.find(std::string(type));
+    return it == table.end() ? nullptr : &it->second;
+}
+
+}  // namespace detail
+
+/// Structured Text 字节码虚拟机
+///
+/// 每个扫描周期调用一次scan(). load()可在任意线程调用, 新程序在下一个扫描周期开始时生效,
+/// 同名同类型的变量和功能块实例(含计时状态)会迁移到新程序.
+/// 对抖动敏感时, 扫描线程可用cc::pin_thread绑到AsioPool的affinity_t::reserved里的核上.
+class Vm final : boost::noncopyable {
+public:
+    explicit Vm(std::shared_ptr<const Program> prog, std::size_t max_loops = 1000000)
+      : max_loops_(max_loops) {
+        install(std::move(prog));
+    }
+
+    /// 热替换程序, 在下一个扫描周期开始前生效
+    void load(std::shared_ptr<const Program> prog) {
+        std::lock_guard<std::mutex> _lck{mtx_};
+        pending_ = std::move(prog);
+        has_pending_.store(true, std::memory_order_release);
+    }
+
+    void scan() {
+        if (GSL_UNLIKELY(has_pending_.load(std::memory_order_acquire))) {
+            std::shared_ptr<const Program> prog;
+            do {
+                std::lock_guard<std::mutex> _lck{mtx_};
+                prog = std::move(pending_);
+                has_pending_.store(false, std::memory_order_relaxed);
+            } while (0);
+            install(std::move(prog));
+        }
+        exec();
+    }
+
+    inline const Program& program() const noexcept { return *prog_; }
+
+    /// @return 变量槽位, 不存在时抛异常
+    std::uint32_t slot(std::string_view name0) const {
+        std::string upper(name0);
+        std::transform(upper.begin(), upper.end(), upper.begin(),
+                       [](unsigned char c) { return std::toupper(c); });
+        std::string_view name = upper;
+        auto dot = name.find('.');
+        if (dot != std::string_view::npos) {
+            const auto* fb = prog_->find_fb(name.substr(0, dot));
+            if (fb) {
+                const auto* desc = detail::find_block(fb->type);
+                auto member      = name.substr(dot + 1);
+                std::uint32_t i  = 0;
+                for (const auto& p : desc->inputs) {
+                    if (p.name == member) return fb->slot + i;
+                    i++;
+                }
+                for (const auto& p : desc->outputs) {
+                    if (p.name == member) return fb->slot + i;
+                    i++;
+                }
+            }
+        } else if (const auto* v = prog_->find_var(name)) {
+            return v->slot;
+        }
+        throw std::runtime_error("st: variable not found: " + std::string(name0));
+    }
+
+    template <typename T>
+    T get(std::string_view name) const {
+        return get<T>(slot(name));
+    }
+
+    template <typename T>
+    void set(std::string_view name, T v) {
+        set<T>(slot(name), v);
+    }
+
+    template <typename T>
+    inline T get(std::uint32_t slot) const noexcept {
+        if constexpr (std::is_floating_point_v<T>) {
+            return static_cast<T>(slots_[slot].f);
+        } else {
+            return static_cast<T>(slots_[slot].i);
+        }
+    }
+
+    template <typename T>
+    inline void set(std::uint32_t slot, T v) noexcept {
+        if constexpr (std::is_floating_point_v<T>) {
+            slots_[slot].f = v;
+        } else {
+            slots_[slot].i = static_cast<std::int64_t>(v);
+        }
+    }
+
+private:
+    void install(std::shared_ptr<const Program> prog) {
+        std::vector<cell_t> slots(prog->nslots, cell_t{0});
+        std::vector<std::unique_ptr<detail::block_t>> blocks(prog->fbs.size());
+
+        for (const auto& v : prog->vars) {
+            const Program::var_t* old = prog_ ? prog_->find_var(v.name) : nullptr;
+            if (old && old->type == v.type) {
+                slots[v.slot] = slots_[old->slot];
+            } else {
+                slots[v.slot] = v.init;
+            }
+        }
+
+        for (std::size_t i = 0; i < prog->fbs.size(); i++) {
+            const auto& fb          = prog->fbs[i];
+            const auto* desc        = detail::find_block(fb.type);
+            const Program::fb_t* old = prog_ ? prog_->find_fb(fb.name) : nullptr;
+            if (old && old->type == fb.type) {
+                auto index = old - prog_->fbs.data();
+                blocks[i]  = std::move(blocks_[index]);
+                std::copy_n(slots_.data() + old->slot, desc->size(), slots.data() + fb.slot);
+            } else {
+                blocks[i] = desc->make();
+            }
+        }
+
+        prog_   = std::move(prog);
+        slots_  = std::move(slots);
+        blocks_ = std::move(blocks);
+        stack_.assign(prog_->max_stack + 1, cell_t{0});
+    }
+
+    void exec() {
+        const std::uint32_t* code = prog_->code.data();
+        const cell_t* k           = prog_->consts.data();
+        cell_t* s                 = slots_.data();
+        cell_t* sp                = stack_.data();  // stack_[0]不使用, sp指向栈顶
+        std::size_t loops         = 0;
+        std::uint32_t pc          = 0;
+
+#define ST_ARG   (static_cast<std::int32_t>(insn) >> 8)
+#define ST_BIN(field, expr)      \
+    do {                         \
+        auto b = sp->field;      \
+        auto a = (--sp)->field;  \
+        sp->field = (expr);      \
+    } while (0)
+#define ST_CMP(field, expr)      \
+    do {                         \
+        auto b = sp->field;      \
+        auto a = (--sp)->field;  \
+        sp->i  = (expr);         \
+    } while (0)
+
+        for (;;) {
+            std::uint32_t insn = code[pc++];
+            switch (insn & 0xff) {
+            case op::HALT: return;
+            case op::PUSHI: (++sp)->i = ST_ARG; break;
+            case op::PUSHK: *++sp = k[ST_ARG]; break;
+            case op::LOAD: *++sp = s[ST_ARG]; break;
+            case op::STORE: s[ST_ARG] = *sp--; break;
+            case op::ADDI: ST_BIN(i, a + b); break;
+            case op::SUBI: ST_BIN(i, a - b); break;
+            case op::MULI: ST_BIN(i, a * b); break;
+            case op::DIVI:
+                if (GSL_UNLIKELY(sp->i == 0)) throw std::runtime_error("st: division by zero");
+                ST_BIN(i, a / b);
+                break;
+            case op::MODI:
+                if (GSL_UNLIKELY(sp->i == 0)) throw std::runtime_error("st: division by zero");
+                ST_BIN(i, a % b);
+                break;
+            case op::NEGI: sp->i = -sp->i; break;
+            case op::ADDF: ST_BIN(f, a + b); break;
+            case op::SUBF: ST_BIN(f, a - b); break;
+            case op::MULF: ST_BIN(f, a * b); break;
+            case op::DIVF: ST_BIN(f, a / b); break;
+            case op::NEGF: sp->f = -sp->f; break;
+            case op::I2F: sp->f = static_cast<double>(sp->i); break;
+            case op::I2F1: sp[-1].f = static_cast<double>(sp[-1].i); break;
+            case op::F2I: sp->i = std::llround(sp->f); break;
+            case op::EQI: ST_CMP(i, a == b); break;
+            case op::NEI: ST_CMP(i, a != b); break;
+            case op::LTI: ST_CMP(i, a < b); break;
+            case op::LEI: ST_CMP(i, a <= b); break;
+            case op::GTI: ST_CMP(i, a > b); break;
+            case op::GEI: ST_CMP(i, a >= b); break;
+            case op::EQF: ST_CMP(f, a == b); break;
+            case op::NEF: ST_CMP(f, a != b); break;
+            case op::LTF: ST_CMP(f, a < b); break;
+            case op::LEF: ST_CMP(f, a <= b); break;
+            case op::GTF: ST_CMP(f, a > b); break;
+            case op::GEF: ST_CMP(f, a >= b); break;
+            case op::AND: ST_BIN(i, a & b); break;
+            case op::OR: ST_BIN(i, a | b); break;
+            case op::XOR: ST_BIN(i, a ^ b); break;
+            case op::NOTB: sp->i = !sp->i; break;
+            case op::NOTI: sp->i = ~sp->i; break;
+            case op::ABSI: sp->i = sp->i < 0 ? -sp->i : sp->i; break;
+            case op::ABSF: sp->f = std::fabs(sp->f); break;
+            case op::MINI: ST_BIN(i, a < b ? a : b); break;
+            case op::MINF: ST_BIN(f, a < b ? a : b); break;
+            case op::MAXI: ST_BIN(i, a > b ? a : b); break;
+            case op::MAXF: ST_BIN(f, a > b ? a : b); break;
+            case op::SQRTF: sp->f = std::sqrt(sp->f); break;
+            case op::JMP: pc = ST_ARG; break;
+            case op::JZ:
+                if (!(sp--)->i) pc = ST_ARG;
+                break;
+            case op::JNZ:
+                if ((sp--)->i) pc = ST_ARG;
+                break;
+            case op::LOOP:
+                if (GSL_UNLIKELY(++loops > max_loops_)) {
+                    throw std::runtime_error("st: watchdog, too many loop iterations");
+                }
+                pc = ST_ARG;
+                break;
+            case op::CALLFB: {
+                auto index = ST_ARG;
+                blocks_[index]->call(s + prog_->fbs[index].slot);
+                break;
+            }
+            default: throw std::runtime_error("st: illegal instruction");
+            }
+        }
+
+#undef ST_CMP
+#undef ST_BIN
+#undef ST_ARG
+    }
+
+private:
+    const std::size_t max_loops_;
+    std::shared_ptr<const Program> prog_;
+    std::vector<cell_t> slots_;
+    std::vector<cell_t> stack_;
+    std::vector<std::unique_ptr<detail::block_t>> blocks_;
+
+    std::mutex mtx_;
+    std::atomic<bool> has_pending_{false};
+    std::shared_ptr<const Program> pending_;
+};
+
+}  // namespace st
+}  // namespace cc
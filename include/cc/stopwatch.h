@@ -1,32 +1,142 @@
 #pragma once
 
 #include <chrono>
+#include <cstdint>
+#include <limits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#    include <cpuid.h>
+#    include <x86intrin.h>
+#    define CC_HAS_TSC 1
+#endif
 
 // Displays elapsed seconds since construction as double.
 namespace cc {
 
-class StopWatch {
-    using clock      = std::chrono::steady_clock;
-    using time_point = clock::time_point;
+/// 时钟策略:
+///   rep now();  double to_seconds(rep);  int64_t to_ns(rep);  rep from_seconds(double);
+struct SteadyClock {
+    using rep = std::int64_t;
+
+    static inline rep now() noexcept {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    static inline double to_seconds(rep t) noexcept { return t * 1e-9; }
+    static inline std::int64_t to_ns(rep t) noexcept { return t; }
+    static inline rep from_seconds(double s) noexcept { return static_cast<rep>(s * 1e9); }
+};
 
-    enum { MAX_TIME = 0x7fffffff };
-    time_point start_tp_;
+/// 基于invariant TSC的时钟, 第一次使用时(或调用calibrate)用steady_clock标定约10ms.
+/// 非x86或CPU未声明invariant TSC(如部分虚拟机)时退化为SteadyClock.
+class TscClock {
+    struct calibration_t {
+        bool tsc;
+        double seconds_per_tick;
+        double ns_per_tick;
+    };
 
 public:
-    static StopWatch now() { return StopWatch(); }
-    static StopWatch min() { return StopWatch(clock::now() - std::chrono::seconds(MAX_TIME)); }
-    static StopWatch max() { return StopWatch(clock::now() + std::chrono::seconds(MAX_TIME)); }
+    using rep = std::int64_t;
+
+    static inline rep now() noexcept {
+#ifdef CC_HAS_TSC
+        if (calibration().tsc) {
+            return static_cast<rep>(__rdtsc());
+        }
+#endif
+        return SteadyClock::now();
+    }
+
+    static inline double to_seconds(rep t) noexcept { return t * calibration().seconds_per_tick; }
 
-    StopWatch() : start_tp_{clock::now()} {}
+    static inline std::int64_t to_ns(rep t) noexcept {
+        return static_cast<std::int64_t>(t * calibration().ns_per_tick);
+    }
 
-    inline double elapsed() const {
-        return std::chrono::duration<double>(clock::now() - start_tp_).count();
+    static inline rep from_seconds(double s) noexcept {
+        return static_cast<rep>(s / calibration().seconds_per_tick);
     }
 
-    inline void reset() { start_tp_ = clock::now(); }
+    /// 是否真正使用了TSC
+    static inline bool is_tsc() noexcept { return calibration().tsc; }
+
+    /// 每秒的tick数
+    static inline double frequency() noexcept { return 1.0 / calibration().seconds_per_tick; }
+
+    /// 在启动阶段提前标定, 避免第一次计时时阻塞
+    static inline void calibrate() noexcept { (void)calibration(); }
 
 private:
-    explicit StopWatch(time_point tp) : start_tp_((time_point&&)tp) {}
+    static const calibration_t& calibration() noexcept {
+        static const calibration_t c = do_calibrate();
+        return c;
+    }
+
+    static calibration_t do_calibrate() noexcept {
+#ifdef CC_HAS_TSC
+        unsigned a, b, c, d;
+        if (__get_cpuid(0x80000000, &a, &b, &c, &d) && a >= 0x80000007) {
+            __get_cpuid(0x80000007, &a, &b, &c, &d);
+            if (d & (1u << 8)) {
+                using clock = std::chrono::steady_clock;
+                auto t0     = clock::now();
+                auto c0     = __rdtsc();
+                auto t1     = t0;
+                while (t1 - t0 < std::chrono::milliseconds(10)) {
+                    t1 = clock::now();
+                }
+                auto c1 = __rdtsc();
+
+                double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+                if (c1 > c0) {
+                    return calibration_t{true, ns * 1e-9 / (c1 - c0), ns / (c1 - c0)};
+                }
+            }
+        }
+#endif
+        return calibration_t{false, 1e-9, 1.0};
+    }
 };
 
+template <typename Clock = SteadyClock>
+class BasicStopWatch {
+    using rep = typename Clock::rep;
+
+    // min()/max()相对当前时刻的偏移, 直接以tick计, 不经换算, 任何时钟频率下都不会溢出
+    static constexpr rep kMaxTicks = std::numeric_limits<rep>::max() / 4;
+    rep start_;
+
+public:
+    using clock = Clock;
+
+    static BasicStopWatch now() { return BasicStopWatch(); }
+    static BasicStopWatch min() { return BasicStopWatch(Clock::now() - kMaxTicks); }
+    static BasicStopWatch max() { return BasicStopWatch(Clock::now() + kMaxTicks); }
+
+    BasicStopWatch() : start_{Clock::now()} {}
+
+    inline double elapsed() const { return Clock::to_seconds(Clock::now() - start_); }
+
+    /// 时钟的原始tick数, 不做换算
+    inline rep elapsed_ticks() const { return Clock::now() - start_; }
+
+    inline std::int64_t elapsed_ns() const { return Clock::to_ns(elapsed_ticks()); }
+
+    inline std::int64_t elapsed_ms() const { return elapsed_ns() / 1000000; }
+
+    inline void reset() { start_ = Clock::now(); }
+
+    /// 重置并设定已流逝的秒数, 用于恢复保持型计时
+    inline void reset(double elapsed) { start_ = Clock::now() - Clock::from_seconds(elapsed); }
+
+private:
+    explicit BasicStopWatch(rep start) : start_(start) {}
+};
+
+using StopWatch    = BasicStopWatch<>;
+using TscStopWatch = BasicStopWatch<TscClock>;
+
 }  // namespace cc
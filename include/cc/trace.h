@@ -0,0 +1,263 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <boost/core/noncopyable.hpp>
+#include <cc/stopwatch.h>
+#include <cc/util.h>
+
+#ifdef __linux__
+#    include <pthread.h>
+#endif
+
+/// 同步作用域, 生成Chrome trace的complete事件, 作用域内不应有co_await
+#define CC_TRACE_SCOPE(name) cc::trace::Span CC_CONCAT(__cc_span_, __LINE__)(name)
+
+/// 协程作用域, begin/end可以发生在不同线程上(跨co_await)
+/// CC_TRACE_CO_SCOPE("name") 新建异步轨道; CC_TRACE_CO_SCOPE("name", parent_id) 嵌套在父轨道上
+#define CC_TRACE_CO_SCOPE(...) cc::trace::AsyncSpan CC_CONCAT(__cc_span_, __LINE__)(__VA_ARGS__)
+
+namespace cc {
+namespace trace {
+
+/// name必须是静态字符串
+struct event_t {
+    const char* name;
+    std::int64_t ts;   // TscClock的tick
+    std::int64_t dur;  // 'X'事件的时长(tick)
+    std::uint64_t id;  // 'b'/'e'事件的异步id
+    char ph;           // 'X' | 'b' | 'e'
+};
+
+namespace detail {
+
+inline std::atomic<bool> enabled_{false};
+inline std::atomic<std::size_t> buffer_size_{4096};
+
+/// 单写者环形缓冲, 写满后覆盖最旧的事件. 读取方用每个槽位的序号判断是否读到撕裂的数据
+///
+/// 槽位的各字段都是relaxed原子量(seqlock), 读取方与写入方并发访问同一槽位不是数据竞争
+class ThreadBuffer : boost::noncopyable {
+    struct slot_t {
+        std::atomic<std::uint64_t> seq{0};
+        std::atomic<const char*> name{nullptr};
+        std::atomic<std::int64_t> ts{0};
+        std::atomic<std::int64_t> dur{0};
+        std::atomic<std::uint64_t> id{0};
+        std::atomic<char> ph{0};
+    };
+
+    std::unique_ptr<slot_t[]> slots_;
+    const std::uint64_t mask_;
+    std::atomic<std::uint64_t> head_{0};
+
+public:
+    const std::uint32_t tid;
+    std::string thread_name;
+
+    ThreadBuffer(std::size_t capacity, std::uint32_t tid0, std::string name)
+      : slots_(new slot_t[capacity])
+      , mask_(capacity - 1)
+      , tid(tid0)
+      , thread_name(std::move(name)) {}
+
+    inline void push(const event_t& ev) noexcept {
+        auto h  = head_.load(std::memory_order_relaxed);
+        auto& s = slots_[h & mask_];
+        s.seq.store(2 * h + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        s.name.store(ev.name, std::memory_order_relaxed);
+        s.ts.store(ev.ts, std::memory_order_relaxed);
+        s.dur.store(ev.dur, std::memory_order_relaxed);
+        s.id.store(ev.id, std::memory_order_relaxed);
+        s.ph.store(ev.ph, std::memory_order_relaxed);
+        s.seq.store(2 * h + 2, std::memory_order_release);
+        head_.store(h + 1, std::memory_order_release);
+    }
+
+    template <typename Fn>
+    void for_each(Fn&& fn) const {
+        auto h     = head_.load(std::memory_order_acquire);
+        auto begin = h > mask_ + 1 ? h - (mask_ + 1) : 0;
+        for (auto i = begin; i < h; i++) {
+            const auto& s = slots_[i & mask_];
+            auto seq      = s.seq.load(std::memory_order_acquire);
+            if (seq != 2 * i + 2) {
+                continue;
+            }
+            event_t ev{s.name.load(std::memory_order_relaxed),
+                       s.ts.load(std::memory_order_relaxed),
+                       s.dur.load(std::memory_order_relaxed),
+                       s.id.load(std::memory_order_relaxed),
+                       s.ph.load(std::memory_order_relaxed)};
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (s.seq.load(std::memory_order_relaxed) == seq) {
+                fn(ev);
+            }
+        }
+    }
+
+    /// 只作废槽位序号, 读取方会跳过这些槽位
+    void clear() noexcept {
+        for (std::uint64_t i = 0; i <= mask_; i++) {
+            slots_[i].seq.store(0, std::memory_order_relaxed);
+        }
+    }
+};
+
+/// 所有线程的缓冲. 线程退出后它的缓冲还保留一段时间以便导出, 只保留最近退出的
+/// kMaxRetired个, 更早的随之释放, 线程频繁创建退出时内存不会一直增长
+class Registry : boost::noncopyable {
+    std::mutex mtx_;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers_;
+    std::deque<const ThreadBuffer*> retired_;
+    std::uint32_t next_tid_ = 0;
+
+public:
+    static constexpr std::size_t kMaxRetired = 16;
+
+    static Registry& instance() {
+        static Registry ins;
+        return ins;
+    }
+
+    std::shared_ptr<ThreadBuffer> create() {
+        std::size_t n = 1;
+        while (n < buffer_size_.load(std::memory_order_relaxed)) {
+            n <<= 1;
+        }
+
+        std::string name;
+#ifdef __linux__
+        char buf[16] = {0};
+        if (pthread_getname_np(pthread_self(), buf, sizeof(buf)) == 0) {
+            name = buf;
+        }
+#endif
+        std::lock_guard<std::mutex> _lck{mtx_};
+        auto tid = ++next_tid_;
+        if (name.empty()) {
+            name = "thread#" + std::to_string(tid);
+        }
+        buffers_.emplace_back(std::make_shared<ThreadBuffer>(n, tid, std::move(name)));
+        return buffers_.back();
+    }
+
+    /// 线程退出时调用
+    void retire(const ThreadBuffer* buf) {
+        std::lock_guard<std::mutex> _lck{mtx_};
+        retired_.push_back(buf);
+        while (retired_.size() > kMaxRetired) {
+            auto* old = retired_.front();
+            retired_.pop_front();
+            // 正在导出的一方持有shared_ptr, 导出完才真正释放
+            std::erase_if(buffers_, [old](const auto& b) { return b.get() == old; });
+        }
+    }
+
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers() {
+        std::lock_guard<std::mutex> _lck{mtx_};
+        return buffers_;
+    }
+};
+
+struct thread_buffer_holder_t {
+    std::shared_ptr<ThreadBuffer> buf;
+
+    ~thread_buffer_holder_t() { Registry::instance().retire(buf.get()); }
+};
+
+inline ThreadBuffer& thread_buffer() {
+    static thread_local thread_buffer_holder_t holder{Registry::instance().create()};
+    return *holder.buf;
+}
+
+inline std::uint64_t next_async_id() noexcept {
+    static std::atomic<std::uint64_t> id{0};
+    return id.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+inline void record(const event_t& ev) { thread_buffer().push(ev); }
+
+}  // namespace detail
+
+/// 运行时开关, 关闭时每个作用域只有一次relaxed读
+inline bool enabled() noexcept { return detail::enabled_.load(std::memory_order_relaxed); }
+
+inline void enable(bool on = true) noexcept {
+    if (on) {
+        TscClock::calibrate();
+    }
+    detail::enabled_.store(on, std::memory_order_relaxed);
+}
+
+/// 每个线程的环形缓冲容量(向上取整到2的幂), 只影响之后第一次记录事件的线程
+inline void set_buffer_size(std::size_t events) noexcept {
+    detail::buffer_size_.store(events, std::memory_order_relaxed);
+}
+
+/// 遍历所有线程缓冲中的事件
+///
+/// @param fn   void(const detail::ThreadBuffer& thread, const event_t& ev)
+template <typename Fn>
+void collect(Fn&& fn) {
+    for (auto& b : detail::Registry::instance().buffers()) {
+        b->for_each([&](const event_t& ev) { fn(*b, ev); });
+    }
+}
+
+inline void clear() {
+    for (auto& b : detail::Registry::instance().buffers()) {
+        b->clear();
+    }
+}
+
+class Span : boost::noncopyable {
+    const char* name_;
+    std::int64_t start_;
+
+public:
+    explicit Span(const char* name) noexcept
+      : name_(enabled() ? name : nullptr)
+      , start_(name_ ? TscClock::now() : 0) {}
+
+    ~Span() {
+        if (name_) {
+            detail::record(event_t{name_, start_, TscClock::now() - start_, 0, 'X'});
+        }
+    }
+};
+
+/// 异步作用域的父子关系通过id显式传递, 不依赖thread_local: 同一线程上交错运行的协程
+/// 不会互相串到对方的轨道上
+class AsyncSpan : boost::noncopyable {
+    const char* name_;
+    std::uint64_t id_ = 0;
+
+public:
+    /// @param parent   父作用域的id(), 0表示新建轨道
+    explicit AsyncSpan(const char* name, std::uint64_t parent = 0)
+      : name_(enabled() ? name : nullptr) {
+        if (name_) {
+            id_ = parent ? parent : detail::next_async_id();
+            detail::record(event_t{name_, TscClock::now(), 0, id_, 'b'});
+        }
+    }
+
+    ~AsyncSpan() {
+        if (name_) {
+            detail::record(event_t{name_, TscClock::now(), 0, id_, 'e'});
+        }
+    }
+
+    /// 未启用时为0
+    inline std::uint64_t id() const noexcept { return id_; }
+};
+
+}  // namespace trace
+}  // namespace cc
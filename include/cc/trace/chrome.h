@@ -0,0 +1,90 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+#include <cc/json.h>
+#include <cc/trace.h>
+
+namespace cc {
+namespace trace {
+
+namespace detail {
+
+struct chrome_event_t {
+    std::string name;
+    std::string cat;
+    std::string ph;
+    double ts;   // us
+    double dur;  // us
+    int pid;
+    std::uint32_t tid;
+    std::uint64_t id;
+};
+
+struct chrome_meta_args_t {
+    std::string name;
+};
+
+struct chrome_meta_t {
+    std::string name;
+    std::string ph;
+    int pid;
+    std::uint32_t tid;
+    chrome_meta_args_t args;
+};
+
+}  // namespace detail
+
+/// 导出为Chrome trace JSON(chrome://tracing, ui.perfetto.dev均可加载)
+/// 时间戳以最早的事件为0点
+inline std::string dump_chrome() {
+    struct item_t {
+        const detail::ThreadBuffer* thread;
+        event_t ev;
+    };
+
+    std::vector<item_t> items;
+    std::vector<const detail::ThreadBuffer*> threads;
+    auto base = std::numeric_limits<std::int64_t>::max();
+    collect([&](const detail::ThreadBuffer& t, const event_t& ev) {
+        if (threads.empty() || threads.back() != &t) {
+            threads.push_back(&t);
+        }
+        items.push_back(item_t{&t, ev});
+        base = std::min(base, ev.ts);
+    });
+
+    std::string out = R"({"displayTimeUnit":"ns","traceEvents":[)";
+    bool first      = true;
+    auto append     = [&](const std::string& s) {
+        if (!first) {
+            out += ',';
+        }
+        out += s;
+        first = false;
+    };
+
+    for (auto* t : threads) {
+        detail::chrome_meta_t m{"thread_name", "M", 1, t->tid, {t->thread_name}};
+        append(cc::json::dump(m));
+    }
+
+    detail::chrome_event_t e{"", "cc", "", 0, 0, 1, 0, 0};
+    for (auto& item : items) {
+        e.name = item.ev.name;
+        e.ph   = std::string(1, item.ev.ph);
+        e.ts   = TscClock::to_ns(item.ev.ts - base) / 1000.0;
+        e.dur  = TscClock::to_ns(item.ev.dur) / 1000.0;
+        e.tid  = item.thread->tid;
+        e.id   = item.ev.id;
+        append(cc::json::dump(e));
+    }
+    out += "]}";
+    return out;
+}
+
+}  // namespace trace
+}  // namespace cc
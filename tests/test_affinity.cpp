@@ -0,0 +1,109 @@
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include <cc/affinity.h>
+#include <cc/asio/pool.h>
+#include <gtest/gtest.h>
+
+namespace {
+
+bool contains(const cc::cpu_list_t& cpus, int c) {
+    return std::find(cpus.begin(), cpus.end(), c) != cpus.end();
+}
+
+}  // namespace
+
+TEST(affinity, parse_cpulist) {
+    using cc::cpu_list_t;
+    EXPECT_EQ(cc::parse_cpulist("0-3,8,10-11"), (cpu_list_t{0, 1, 2, 3, 8, 10, 11}));
+    // sysfs读出的行可能带换行; 乱序和重复的结果升序去重
+    EXPECT_EQ(cc::parse_cpulist("0-1\n"), (cpu_list_t{0, 1}));
+    EXPECT_EQ(cc::parse_cpulist("5,3,1-3,3"), (cpu_list_t{1, 2, 3, 5}));
+    EXPECT_EQ(cc::parse_cpulist("7"), (cpu_list_t{7}));
+    EXPECT_TRUE(cc::parse_cpulist("").empty());
+    EXPECT_TRUE(cc::parse_cpulist(",\n").empty());
+}
+
+TEST(affinity, allowed_cpus) {
+    auto cpus = cc::allowed_cpus();
+    ASSERT_FALSE(cpus.empty());
+    EXPECT_TRUE(std::is_sorted(cpus.begin(), cpus.end()));
+
+    EXPECT_GE(cc::numa_nodes(), 1);
+    for (int node = 0; node < cc::numa_nodes(); node++) {
+        for (int c : cc::numa_node_cpus(node)) {
+            EXPECT_TRUE(contains(cpus, c));
+        }
+    }
+}
+
+TEST(affinity, pin_thread) {
+    EXPECT_FALSE(cc::pin_thread(cc::cpu_list_t{}));
+#ifdef __linux__
+    auto cpus = cc::allowed_cpus();
+    std::thread t([&] {
+        ASSERT_TRUE(cc::pin_thread(cpus.back()));
+        EXPECT_EQ(cc::allowed_cpus(), cc::cpu_list_t{cpus.back()});
+        EXPECT_EQ(cc::current_cpu(), cpus.back());
+        // 没有一个合法的CPU时失败, 原来的绑定不变
+        EXPECT_FALSE(cc::pin_thread(-1));
+        EXPECT_EQ(cc::allowed_cpus(), cc::cpu_list_t{cpus.back()});
+        EXPECT_TRUE(cc::pin_thread(cpus));
+        EXPECT_EQ(cc::allowed_cpus(), cpus);
+    });
+    t.join();
+#endif
+}
+
+TEST(affinity, plan) {
+    using cc::affinity_e;
+    auto cpus = cc::allowed_cpus();
+    EXPECT_TRUE(cc::detail::plan_affinity({}, 4).empty());
+    EXPECT_TRUE(cc::detail::plan_affinity({affinity_e::CPU, cpus, cpus}, 4).empty());
+
+    // 每个线程一个CPU, 线程比CPU多时循环使用
+    auto plan = cc::detail::plan_affinity({affinity_e::CPU, cpus, {}}, cpus.size() + 1);
+    ASSERT_EQ(plan.size(), cpus.size() + 1);
+    std::vector<int> used;
+    for (auto& p : plan) {
+        ASSERT_EQ(p.size(), 1u);
+        EXPECT_TRUE(contains(cpus, p[0]));
+        used.push_back(p[0]);
+    }
+    std::sort(used.begin(), used.end() - 1);
+    EXPECT_TRUE(std::equal(cpus.begin(), cpus.end(), used.begin()));
+    EXPECT_EQ(plan.back(), plan.front());
+
+    if (cpus.size() > 1) {
+        plan = cc::detail::plan_affinity({affinity_e::CPU, {}, {cpus[0]}}, 2);
+        for (auto& p : plan) {
+            EXPECT_NE(p[0], cpus[0]);
+        }
+    }
+
+    plan = cc::detail::plan_affinity({affinity_e::NUMA_NODE, cpus, {}}, 3);
+    ASSERT_EQ(plan.size(), 3u);
+    for (auto& p : plan) {
+        ASSERT_FALSE(p.empty());
+        for (int c : p) {
+            EXPECT_TRUE(contains(cpus, c));
+        }
+    }
+}
+
+#ifdef __linux__
+
+// run()的线程在进入事件循环前绑核, 返回后调用线程恢复原来的绑定
+TEST(affinity, pool_run) {
+    auto cpus = cc::allowed_cpus();
+    cc::AsioPool pool;
+    pool.set_affinity({cc::affinity_e::CPU, {cpus.back()}, {}});
+    EXPECT_EQ(pool.affinity().mode, cc::affinity_e::CPU);
+    cc::cpu_list_t inside;
+    pool.enqueue([&] { inside = cc::allowed_cpus(); });
+    pool.run(1);
+    EXPECT_EQ(inside, cc::cpu_list_t{cpus.back()});
+    EXPECT_EQ(cc::allowed_cpus(), cpus);
+}
+
+#endif
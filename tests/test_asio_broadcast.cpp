@@ -0,0 +1,149 @@
+#include <cstdint>
+#include <exception>
+#include <optional>
+#include <vector>
+#include <boost/asio.hpp>
+#include <boost/system/system_error.hpp>
+#include <cc/asio/broadcast.h>
+#include <gtest/gtest.h>
+
+TEST(asio_broadcast, fanout) {
+    net::io_context ioc;
+    int got[2] = {0, 0};
+    do {
+        auto [tx, rx] = cc::chan::broadcast::make<int>(4);
+        auto rx2      = tx.subscribe();
+        for (int c = 0; c < 2; c++) {
+            net::co_spawn(
+                ioc,
+                [rx = c ? rx2 : rx, &got, c]() mutable -> net::awaitable<void> {
+                    while (auto v = co_await rx.recv()) {
+                        EXPECT_EQ(*v, got[c]);
+                        got[c]++;
+                    }
+                },
+                net::detached);
+        }
+        net::co_spawn(
+            ioc,
+            [tx = tx]() mutable -> net::awaitable<void> {
+                for (int i = 0; i < 100; i++) {
+                    EXPECT_EQ(tx.send(i), 2u);
+                    co_await cc::async_sleep(0);
+                }
+            },
+            net::detached);
+    } while (0);
+    ioc.run();
+    EXPECT_EQ(got[0], 100);
+    EXPECT_EQ(got[1], 100);
+}
+
+// 落后超过容量的接收者先收到lagged_error, 再从最旧的消息继续读
+TEST(asio_broadcast, lagged) {
+    auto [tx, rx] = cc::chan::broadcast::make<int>(4);
+    EXPECT_EQ(tx.capacity(), 4u);
+    for (int i = 0; i < 10; i++) {
+        tx.send(i);
+    }
+    try {
+        rx.try_recv();
+        ADD_FAILURE() << "expected lagged_error";
+    } catch (const cc::chan::lagged_error& e) {
+        EXPECT_EQ(e.skipped(), 6u);
+    }
+    for (int i = 6; i < 10; i++) {
+        EXPECT_EQ(rx.try_recv(), i);
+    }
+    EXPECT_EQ(rx.try_recv(), std::nullopt);
+
+    // 订阅之后的消息才收得到, 拷贝出的接收者各自读取
+    auto late = tx.subscribe();
+    tx.send(10);
+    auto fork = late;
+    EXPECT_EQ(late.try_recv(), 10);
+    EXPECT_EQ(fork.try_recv(), 10);
+    EXPECT_EQ(rx.try_recv(), 10);
+}
+
+// 最后一个Sender析构后, 接收者先读完缓冲再看到关闭
+TEST(asio_broadcast, drain_after_close) {
+    net::io_context ioc;
+    std::vector<int> got;
+    bool closed   = false;
+    auto [tx, rx] = cc::chan::broadcast::make<int>(8);
+    do {
+        auto sender = std::move(tx);
+        for (int i = 0; i < 3; i++) {
+            sender.send(i);
+        }
+    } while (0);
+    net::co_spawn(
+        ioc,
+        [&, rx = rx]() mutable -> net::awaitable<void> {
+            while (auto v = co_await rx.recv()) {
+                got.push_back(*v);
+            }
+            closed = true;
+        },
+        net::detached);
+    ioc.run();
+    EXPECT_EQ(got, (std::vector<int>{0, 1, 2}));
+    EXPECT_TRUE(closed);
+}
+
+TEST(asio_broadcast, cancel_recv) {
+    net::io_context ioc;
+    auto [tx, rx] = cc::chan::broadcast::make<int>(4);
+    net::cancellation_signal sig;
+    std::exception_ptr err;
+    bool done    = false;
+    auto on_done = [&](std::exception_ptr e, std::optional<int>) {
+        err  = e;
+        done = true;
+    };
+    net::co_spawn(ioc, rx.recv(), net::bind_cancellation_slot(sig.slot(), on_done));
+    ioc.poll();
+    EXPECT_FALSE(done);
+    sig.emit(net::cancellation_type::terminal);
+    ioc.poll();
+    ASSERT_TRUE(done);
+    ASSERT_TRUE(err);
+    try {
+        std::rethrow_exception(err);
+    } catch (const boost::system::system_error& e) {
+        EXPECT_EQ(e.code(), net::error::operation_aborted);
+    }
+    // 接收位置不变
+    tx.send(1);
+    EXPECT_EQ(rx.try_recv(), 1);
+}
+
+// 中间的多次send只通知一次, 取到的是最新值
+TEST(asio_broadcast, watch) {
+    net::io_context ioc;
+    std::vector<int> seen;
+    do {
+        auto [tx, rx] = cc::chan::watch::make<int>(0);
+        EXPECT_EQ(rx.get(), 0);
+        net::co_spawn(
+            ioc,
+            [rx = rx, &seen]() mutable -> net::awaitable<void> {
+                while (co_await rx.changed()) {
+                    seen.push_back(rx.get());
+                }
+            },
+            net::detached);
+        net::co_spawn(
+            ioc,
+            [tx = tx]() mutable -> net::awaitable<void> {
+                tx.send(1);
+                tx.send(2);
+                co_await cc::async_sleep(1);
+                tx.send(3);
+            },
+            net::detached);
+    } while (0);
+    ioc.run();
+    EXPECT_EQ(seen, (std::vector<int>{2, 3}));
+}
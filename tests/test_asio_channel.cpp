@@ -0,0 +1,378 @@
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <optional>
+#include <thread>
+#include <vector>
+#include <boost/asio.hpp>
+#include <boost/system/system_error.hpp>
+#include <cc/asio/channel.h>
+#include <gtest/gtest.h>
+
+using cc::chan::overflow_e;
+
+TEST(asio_channel, bounded_block) {
+    net::io_context ioc;
+    std::vector<int> got;
+    do {
+        auto [tx, rx] = cc::chan::bounded::make<int>(4);
+        net::co_spawn(
+            ioc,
+            [tx = tx]() mutable -> net::awaitable<void> {
+                for (int i = 0; i < 100; i++) {
+                    EXPECT_TRUE(co_await tx.send(i));
+                    EXPECT_LE(tx.size(), 4u);
+                }
+            },
+            net::detached);
+        net::co_spawn(
+            ioc,
+            [rx = std::move(rx), &got]() mutable -> net::awaitable<void> {
+                while (auto v = co_await rx.recv()) {
+                    got.push_back(*v);
+                }
+            },
+            net::detached);
+    } while (0);
+    ioc.run();
+    ASSERT_EQ(got.size(), 100u);
+    for (int i = 0; i < 100; i++) {
+        EXPECT_EQ(got[i], i);
+    }
+}
+
+TEST(asio_channel, bounded_overflow) {
+    auto [tx, rx] = cc::chan::bounded::make<int, false>(3, overflow_e::DROP_OLDEST);
+    for (int i = 0; i < 5; i++) {
+        EXPECT_TRUE(tx.try_send(i));
+    }
+    EXPECT_EQ(tx.dropped(), 2u);
+    EXPECT_EQ(rx.try_recv(), 2);
+
+    auto [tx2, rx2] = cc::chan::bounded::make<int, false>(3, overflow_e::DROP_NEWEST);
+    for (int i = 0; i < 5; i++) {
+        EXPECT_EQ(tx2.try_send(i), i < 3);
+    }
+    EXPECT_EQ(tx2.dropped(), 2u);
+    EXPECT_EQ(rx2.try_recv(), 0);
+
+    auto [tx3, rx3] = cc::chan::bounded::make<int>(2);
+    EXPECT_TRUE(tx3.try_send(1));
+    EXPECT_TRUE(tx3.try_send(2));
+    EXPECT_FALSE(tx3.try_send(3));
+    EXPECT_EQ(tx3.dropped(), 0u);
+}
+
+// 最后一个Sender析构后, 接收方先取完缓冲里的元素才看到关闭
+TEST(asio_channel, bounded_drain_after_close) {
+    net::io_context ioc;
+    std::vector<int> got;
+    bool closed = false;
+    auto [tx, rx] = cc::chan::bounded::make<int>(8);
+    do {
+        auto sender = std::move(tx);
+        for (int i = 0; i < 5; i++) {
+            EXPECT_TRUE(sender.try_send(i));
+        }
+    } while (0);
+    net::co_spawn(
+        ioc,
+        [&, rx = std::move(rx)]() mutable -> net::awaitable<void> {
+            while (auto v = co_await rx.recv()) {
+                got.push_back(*v);
+            }
+            closed = true;
+        },
+        net::detached);
+    ioc.run();
+    EXPECT_EQ(got, (std::vector<int>{0, 1, 2, 3, 4}));
+    EXPECT_TRUE(closed);
+}
+
+// Receiver析构时, 挂起中的send返回false
+TEST(asio_channel, bounded_receiver_gone) {
+    net::io_context ioc;
+    auto [tx, rx] = cc::chan::bounded::make<int>(1);
+    std::optional<bool> sent;
+    net::co_spawn(
+        ioc,
+        [&, tx = tx]() mutable -> net::awaitable<void> {
+            EXPECT_TRUE(co_await tx.send(1));
+            sent = co_await tx.send(2);
+        },
+        net::detached);
+    ioc.poll();
+    EXPECT_FALSE(sent);
+    do {
+        auto receiver = std::move(rx);
+    } while (0);
+    ioc.run();
+    EXPECT_EQ(sent, false);
+    EXPECT_FALSE(tx.try_send(3));
+}
+
+TEST(asio_channel, bounded_recv_many) {
+    net::io_context pi;
+    net::io_context ci;
+    long sum      = 0;
+    std::size_t n = 0;
+    do {
+        auto [tx, rx] = cc::chan::bounded::make<int>(16);
+        for (int p = 0; p < 4; p++) {
+            net::co_spawn(
+                pi,
+                [tx = tx]() mutable -> net::awaitable<void> {
+                    for (int i = 1; i <= 10000; i++) {
+                        co_await tx.send(i);
+                    }
+                },
+                net::detached);
+        }
+        net::co_spawn(
+            ci,
+            [rx = std::move(rx), &sum, &n]() mutable -> net::awaitable<void> {
+                std::vector<int> out;
+                while (co_await rx.recv_many(out)) {
+                    EXPECT_LE(out.size(), 16u);
+                    for (int v : out) {
+                        sum += v;
+                        n++;
+                    }
+                    out.clear();
+                }
+            },
+            net::detached);
+    } while (0);
+    std::thread t([&] { ci.run(); });
+    pi.run();
+    t.join();
+    EXPECT_EQ(n, 40000u);
+    EXPECT_EQ(sum, 4L * 10000 * 10001 / 2);
+}
+
+// 跨越多个段, 保持发送顺序; 关闭后先取完积压的元素
+TEST(asio_channel, mpsc_drain_after_close) {
+    net::io_context ioc;
+    auto [tx, rx] = cc::chan::mpsc::make<int>();
+    for (int i = 0; i < 1000; i++) {
+        (*tx)(i);
+    }
+    tx.reset();
+
+    std::vector<int> got;
+    net::co_spawn(
+        ioc,
+        [&, rx = std::move(rx)]() mutable -> net::awaitable<void> {
+            for (;;) {
+                auto items = co_await (*rx)();
+                if (items.empty()) {
+                    break;
+                }
+                got.insert(got.end(), items.begin(), items.end());
+            }
+        },
+        net::detached);
+    ioc.run();
+    ASSERT_EQ(got.size(), 1000u);
+    for (int i = 0; i < 1000; i++) {
+        EXPECT_EQ(got[i], i);
+    }
+}
+
+// 多个生产者线程并发send, 消费者在另一个线程挂起等待; 每个生产者的元素保持顺序
+TEST(asio_channel, mpsc_threads) {
+    constexpr int kProducers = 4;
+    constexpr int kSends     = 50000;
+    net::io_context ioc;
+    std::vector<int> last(kProducers, -1);
+    std::size_t n = 0;
+    auto [tx, rx] = cc::chan::mpsc::make<int>();
+    net::co_spawn(
+        ioc,
+        [&, rx = std::move(rx)]() mutable -> net::awaitable<void> {
+            for (;;) {
+                auto items = co_await (*rx)();
+                if (items.empty()) {
+                    break;
+                }
+                for (int v : items) {
+                    EXPECT_GT(v % kSends, last[v / kSends]);
+                    last[v / kSends] = v % kSends;
+                    n++;
+                }
+            }
+        },
+        net::detached);
+    std::thread consumer([&] { ioc.run(); });
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < kProducers; p++) {
+        producers.emplace_back([p, tx = tx] {
+            for (int i = 0; i < kSends; i++) {
+                (*tx)(p * kSends + i);
+            }
+        });
+    }
+    for (auto& t : producers) {
+        t.join();
+    }
+    tx.reset();
+    consumer.join();
+    EXPECT_EQ(n, static_cast<std::size_t>(kProducers * kSends));
+    for (int v : last) {
+        EXPECT_EQ(v, kSends - 1);
+    }
+}
+
+// 多个消费者在等时按FIFO交付, 一个元素只唤醒一个消费者
+TEST(asio_channel, mpmc_handoff) {
+    net::io_context ioc;
+    auto [tx, rx] = cc::chan::mpmc::make<int>();
+    std::vector<std::pair<int, int>> got;
+    for (int c = 0; c < 3; c++) {
+        net::co_spawn(
+            ioc,
+            [&, c, rx = rx]() mutable -> net::awaitable<void> {
+                auto v = co_await rx.recv();
+                got.emplace_back(c, *v);
+            },
+            net::detached);
+    }
+    ioc.poll();
+    EXPECT_TRUE(tx.send(10));
+    ioc.poll();
+    EXPECT_EQ(got, (std::vector<std::pair<int, int>>{{0, 10}}));
+    EXPECT_TRUE(tx.send(11));
+    EXPECT_TRUE(tx.send(12));
+    EXPECT_TRUE(tx.send(13));
+    ioc.poll();
+    EXPECT_EQ(got, (std::vector<std::pair<int, int>>{{0, 10}, {1, 11}, {2, 12}}));
+    EXPECT_EQ(tx.size(), 1u);
+    EXPECT_EQ(rx.try_recv(), std::vector<int>{13});
+}
+
+// 被取消的recv不会拿走之后send的元素
+TEST(asio_channel, mpmc_cancel_recv) {
+    net::io_context ioc;
+    auto [tx, rx] = cc::chan::mpmc::make<int>();
+    net::cancellation_signal sig;
+    std::exception_ptr err;
+    bool done    = false;
+    auto on_done = [&](std::exception_ptr e, std::optional<int>) {
+        err  = e;
+        done = true;
+    };
+    net::co_spawn(ioc, rx.recv(), net::bind_cancellation_slot(sig.slot(), on_done));
+    ioc.poll();
+    sig.emit(net::cancellation_type::terminal);
+    ioc.poll();
+    ASSERT_TRUE(done);
+    ASSERT_TRUE(err);
+    try {
+        std::rethrow_exception(err);
+    } catch (const boost::system::system_error& e) {
+        EXPECT_EQ(e.code(), net::error::operation_aborted);
+    }
+
+    EXPECT_TRUE(tx.send(1));
+    EXPECT_EQ(tx.size(), 1u);
+    EXPECT_EQ(rx.try_recv(), std::vector<int>{1});
+}
+
+// 元素已交给等待者, 但它的executor没能恢复它就销毁了, 元素放回通道
+TEST(asio_channel, mpmc_requeue) {
+    auto [tx, rx] = cc::chan::mpmc::make<int>();
+    do {
+        net::io_context ioc;
+        net::co_spawn(
+            ioc,
+            [rx = rx]() mutable -> net::awaitable<void> { co_await rx.recv(); },
+            net::detached);
+        ioc.poll();
+        EXPECT_TRUE(tx.send(1));
+        EXPECT_EQ(tx.size(), 0u);
+    } while (0);
+    EXPECT_EQ(rx.try_recv(), std::vector<int>{1});
+}
+
+// 放回通道的元素交给其他还在等的recv
+TEST(asio_channel, mpmc_requeue_handoff) {
+    auto [tx, rx] = cc::chan::mpmc::make<int>();
+    net::io_context ioc;
+    std::optional<int> got;
+    do {
+        net::io_context dead;
+        net::co_spawn(
+            dead,
+            [rx = rx]() mutable -> net::awaitable<void> { co_await rx.recv(); },
+            net::detached);
+        dead.poll();
+        net::co_spawn(
+            ioc,
+            [&, rx = rx]() mutable -> net::awaitable<void> { got = co_await rx.recv(); },
+            net::detached);
+        ioc.poll();
+        // 先交给dead上的等待者
+        EXPECT_TRUE(tx.send(1));
+        ioc.poll();
+        EXPECT_FALSE(got);
+    } while (0);
+    ioc.poll();
+    EXPECT_EQ(got, 1);
+    EXPECT_EQ(tx.size(), 0u);
+}
+
+// 最后一个Receiver析构后通道关闭
+TEST(asio_channel, mpmc_receivers_gone) {
+    auto [tx, rx] = cc::chan::mpmc::make<int>();
+    do {
+        auto r1 = std::move(rx);
+        auto r2 = r1;
+        EXPECT_TRUE(tx.send(1));
+    } while (0);
+    EXPECT_FALSE(tx.send(2));
+}
+
+TEST(asio_channel, mpmc_threads) {
+    constexpr int kProducers = 2;
+    constexpr int kSends     = 20000;
+    net::io_context ioc;
+    std::atomic<long> sum{0};
+    std::atomic<int> n{0};
+    do {
+        auto [tx, rx] = cc::chan::mpmc::make<int>();
+        for (int c = 0; c < 3; c++) {
+            net::co_spawn(
+                ioc,
+                [&, rx = rx]() mutable -> net::awaitable<void> {
+                    for (;;) {
+                        auto items = co_await rx.recv(8);
+                        if (items.empty()) {
+                            break;
+                        }
+                        for (int v : items) {
+                            sum += v;
+                            n++;
+                        }
+                    }
+                },
+                net::detached);
+        }
+        std::vector<std::thread> producers;
+        for (int p = 0; p < kProducers; p++) {
+            producers.emplace_back([tx = tx]() mutable {
+                for (int i = 1; i <= kSends; i++) {
+                    EXPECT_TRUE(tx.send(i));
+                }
+            });
+        }
+        for (auto& t : producers) {
+            t.join();
+        }
+    } while (0);
+    std::thread t([&] { ioc.run(); });
+    ioc.run();
+    t.join();
+    EXPECT_EQ(n.load(), kProducers * kSends);
+    EXPECT_EQ(sum.load(), kProducers * (long)kSends * (kSends + 1) / 2);
+}
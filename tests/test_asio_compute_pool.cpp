@@ -0,0 +1,120 @@
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/asio.hpp>
+#include <cc/asio/compute_pool.h>
+#include <gtest/gtest.h>
+
+// 析构时等已提交的任务都执行完; 任务里抛出的异常不影响其他任务
+TEST(asio_compute_pool, post) {
+    std::atomic<int> n{0};
+    std::atomic<bool> bad{false};
+    do {
+        cc::ComputePool pool(4);
+        EXPECT_EQ(pool.size(), 4u);
+        EXPECT_EQ(pool.current_index(), -1);
+        for (int i = 0; i < 1000; i++) {
+            pool.post([&pool, &n, &bad, i] {
+                auto idx = pool.current_index();
+                if (idx < 0 || idx >= static_cast<int>(pool.size())) {
+                    bad = true;
+                }
+                if (i % 100 == 0) {
+                    throw std::runtime_error("expected");
+                }
+                n++;
+            });
+        }
+    } while (0);
+    EXPECT_EQ(n.load(), 990);
+    EXPECT_FALSE(bad);
+}
+
+// 任务里再提交子任务(分治), 空闲线程窃取, 都在析构前完成
+TEST(asio_compute_pool, fork_join) {
+    std::atomic<long> sum{0};
+    std::function<void(int, int)> split;
+    do {
+        cc::ComputePool pool(3);
+        split = [&](int lo, int hi) {
+            if (hi - lo <= 16) {
+                for (int i = lo; i < hi; i++) {
+                    sum += i;
+                }
+                return;
+            }
+            int mid = lo + (hi - lo) / 2;
+            pool.post([&split, lo, mid] { split(lo, mid); });
+            pool.post([&split, mid, hi] { split(mid, hi); });
+        };
+        pool.post([&split] { split(0, 100000); });
+    } while (0);
+    EXPECT_EQ(sum.load(), 100000L * 99999 / 2);
+}
+
+// 在计算池上执行, 完成后回到调用协程的线程; 结果和异常都交还给调用方
+TEST(asio_compute_pool, offload) {
+    net::io_context ioc;
+    cc::ComputePool pool(2);
+    std::thread::id ioc_tid;
+    std::vector<std::string> log;
+    net::co_spawn(
+        ioc,
+        [&]() -> net::awaitable<void> {
+            ioc_tid  = std::this_thread::get_id();
+            auto add = [&pool](int a, int b) {
+                EXPECT_GE(pool.current_index(), 0);
+                return a + b;
+            };
+            auto r = co_await cc::offload(pool, add, 1, 2);
+            EXPECT_EQ(r, 3);
+            EXPECT_EQ(std::this_thread::get_id(), ioc_tid);
+            log.push_back("value");
+
+            // 只能移动的参数按值保存在协程帧里
+            auto p = std::make_unique<int>(7);
+            auto n = co_await cc::offload(pool, [](std::unique_ptr<int>& v) { return *v; },
+                                          std::move(p));
+            EXPECT_EQ(n, 7);
+
+            bool ran = false;
+            co_await cc::offload(pool, [&ran] { ran = true; });
+            EXPECT_TRUE(ran);
+            log.push_back("void");
+
+            try {
+                co_await cc::offload(pool, [] { throw std::runtime_error("boom"); });
+                ADD_FAILURE() << "expected exception";
+            } catch (const std::runtime_error& e) {
+                EXPECT_EQ(std::string(e.what()), "boom");
+                EXPECT_EQ(std::this_thread::get_id(), ioc_tid);
+                log.push_back("error");
+            }
+        },
+        net::detached);
+    ioc.run();
+    EXPECT_EQ(log, (std::vector<std::string>{"value", "void", "error"}));
+}
+
+// 多个协程并发offload, 各自拿到自己的结果
+TEST(asio_compute_pool, offload_many) {
+    net::io_context ioc;
+    cc::ComputePool pool(4);
+    std::atomic<long> sum{0};
+    for (int i = 1; i <= 200; i++) {
+        net::co_spawn(
+            ioc,
+            [&pool, &sum, i]() -> net::awaitable<void> {
+                sum += co_await cc::offload(pool, [](int v) { return v * 2; }, i);
+            },
+            net::detached);
+    }
+    std::thread t([&] { ioc.run(); });
+    ioc.run();
+    t.join();
+    EXPECT_EQ(sum.load(), 200L * 201);
+}
@@ -0,0 +1,158 @@
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <boost/asio.hpp>
+#include <cc/asio/condvar.h>
+#include <gtest/gtest.h>
+
+TEST(asio_condvar, cancel_wait) {
+    net::io_context ioc;
+    cc::CondVar<> cv;
+    net::cancellation_signal sig;
+    bool done = false;
+    auto on_done = [&](std::exception_ptr) { done = true; };
+    net::co_spawn(ioc, cv.wait(), net::bind_cancellation_slot(sig.slot(), on_done));
+    ioc.poll();
+    EXPECT_FALSE(done);
+
+    sig.emit(net::cancellation_type::terminal);
+    ioc.poll();
+    EXPECT_TRUE(done);
+    // 被取消的节点已摘下
+    EXPECT_EQ(cv.notify_n(1), 0u);
+}
+
+TEST(asio_condvar, wait_until) {
+    net::io_context ioc;
+    cc::CondVar<> cv;
+    int timeouts = 0;
+    int notified = 0;
+    net::co_spawn(
+        ioc,
+        [&]() -> net::awaitable<void> {
+            (co_await cv.wait_until(10) ? timeouts : notified)++;
+            (co_await cv.wait_until(2000) ? timeouts : notified)++;
+        },
+        net::detached);
+    while (timeouts == 0) {
+        ioc.run_one();
+    }
+    ioc.poll();
+    EXPECT_EQ(cv.notify_n(1), 1u);
+    ioc.run();
+    EXPECT_EQ(timeouts, 1);
+    EXPECT_EQ(notified, 1);
+    EXPECT_EQ(cv.notify_n(1), 0u);
+}
+
+// 取消在io_context线程上发出, 同时另一个线程在notify, 每个等待者都恰好恢复一次
+TEST(asio_condvar, cancel_notify_race) {
+    constexpr int N = 2000;
+    net::io_context ioc;
+    cc::CondVar<std::mutex> cv;
+    std::vector<net::cancellation_signal> sigs(N);
+    std::atomic<int> done{0};
+    auto on_done = [&](std::exception_ptr) { done.fetch_add(1, std::memory_order_relaxed); };
+    for (auto& sig : sigs) {
+        net::co_spawn(ioc, cv.wait(), net::bind_cancellation_slot(sig.slot(), on_done));
+    }
+    ioc.poll();
+    for (int i = 0; i < N; i += 2) {
+        net::post(ioc, [&sigs, i] { sigs[i].emit(net::cancellation_type::terminal); });
+    }
+
+    std::size_t woken = 0;
+    std::thread t([&] { ioc.run(); });
+    while (done.load() < N) {
+        if (cv.notify_n(1)) {
+            woken++;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    t.join();
+    EXPECT_EQ(done.load(), N);
+    EXPECT_GE(woken, static_cast<std::size_t>(N / 2));
+    EXPECT_LE(woken, static_cast<std::size_t>(N));
+}
+
+namespace {
+
+/// 按给定的优先级依次开始等待, 被唤醒时记下自己的下标
+void spawn_waiters(net::io_context& ioc, cc::CondVar<>& cv, const std::vector<std::size_t>& prio,
+                   std::vector<int>& order) {
+    for (std::size_t i = 0; i < prio.size(); i++) {
+        net::co_spawn(
+            ioc,
+            [&cv, &order, i, p = prio[i]]() -> net::awaitable<void> {
+                co_await cv.wait(p);
+                order.push_back(static_cast<int>(i));
+            },
+            net::detached);
+        ioc.poll();
+    }
+}
+
+}  // namespace
+
+TEST(asio_condvar, fifo) {
+    net::io_context ioc;
+    cc::CondVar<> cv;
+    std::vector<int> order;
+    spawn_waiters(ioc, cv, {0, 0, 0, 0, 0}, order);
+    EXPECT_EQ(cv.notify_n(1), 1u);
+    ioc.poll();
+    EXPECT_EQ(cv.notify_n(2), 2u);
+    ioc.poll();
+    cv.notify_all();
+    ioc.poll();
+    EXPECT_EQ(order, (std::vector<int>{0, 1, 2, 3, 4}));
+    EXPECT_EQ(cv.notify_n(3), 0u);
+}
+
+TEST(asio_condvar, lifo) {
+    net::io_context ioc;
+    cc::CondVar<> cv(cc::wake_e::LIFO);
+    std::vector<int> order;
+    spawn_waiters(ioc, cv, {0, 0, 0, 0}, order);
+    cv.notify_one();
+    ioc.poll();
+    EXPECT_EQ(cv.notify_n(10), 3u);
+    ioc.poll();
+    EXPECT_EQ(order, (std::vector<int>{3, 2, 1, 0}));
+}
+
+// 0最高, 同级FIFO, 超出范围的按最低级
+TEST(asio_condvar, priority) {
+    net::io_context ioc;
+    cc::CondVar<> cv(cc::wake_e::PRIORITY);
+    std::vector<int> order;
+    spawn_waiters(ioc, cv, {3, 1, 100, 1, 0, 7}, order);
+    EXPECT_EQ(cv.notify_n(3), 3u);
+    ioc.poll();
+    EXPECT_EQ(order, (std::vector<int>{4, 1, 3}));
+    cv.notify_all();
+    ioc.poll();
+    EXPECT_EQ(order, (std::vector<int>{4, 1, 3, 0, 2, 5}));
+}
+
+// 最高一级的等待者都被取消后, notify唤醒下一级的
+TEST(asio_condvar, priority_cancelled) {
+    net::io_context ioc;
+    cc::CondVar<> cv(cc::wake_e::PRIORITY);
+    net::cancellation_signal sig;
+    bool cancelled = false;
+    auto on_done   = [&](std::exception_ptr) { cancelled = true; };
+    net::co_spawn(ioc, cv.wait(0), net::bind_cancellation_slot(sig.slot(), on_done));
+    ioc.poll();
+    std::vector<int> order;
+    spawn_waiters(ioc, cv, {2}, order);
+
+    sig.emit(net::cancellation_type::terminal);
+    EXPECT_EQ(cv.notify_n(1), 1u);
+    ioc.poll();
+    EXPECT_TRUE(cancelled);
+    EXPECT_EQ(order, std::vector<int>{0});
+}
@@ -0,0 +1,109 @@
+#include <chrono>
+#include <thread>
+#include <boost/asio.hpp>
+#include <cc/asio/pool.h>
+#include <gtest/gtest.h>
+
+#ifdef __linux__
+#    include <time.h>
+#endif
+
+namespace {
+
+void spin_for(std::chrono::milliseconds d) {
+    auto end = std::chrono::steady_clock::now() + d;
+    while (std::chrono::steady_clock::now() < end) {
+    }
+}
+
+}  // namespace
+
+TEST(asio_loop_monitor, handlers) {
+    cc::AsioPool pool;
+    EXPECT_TRUE(pool.loop_stats().threads.empty());
+    pool.enable_monitor({.lag_interval_ms = 0});
+    for (int i = 0; i < 1000; i++) {
+        pool.enqueue([] {});
+    }
+    pool.run(1);
+
+    auto st = pool.loop_stats();
+    ASSERT_EQ(st.shards.size(), 1u);
+    ASSERT_EQ(st.threads.size(), 1u);
+    EXPECT_EQ(st.threads[0].shard, 0u);
+    EXPECT_EQ(st.threads[0].handlers, 1000u);
+    EXPECT_EQ(st.threads[0].busy_ns, 0);
+    // 空闲后唤醒执行的第一个处理器只计数不计时
+    EXPECT_GE(st.threads[0].exec.count, 999u);
+    EXPECT_EQ(st.shards[0].lag.count, 0u);
+    EXPECT_TRUE(st.slow.empty());
+}
+
+// 每个分片各有一个延迟探针
+TEST(asio_loop_monitor, lag) {
+    cc::AsioPool pool(cc::sharded, 2);
+    pool.enable_monitor({.lag_interval_ms = 5});
+    std::thread t([&] { pool.run(); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    pool.shutdown();
+    t.join();
+
+    auto st = pool.loop_stats();
+    ASSERT_EQ(st.shards.size(), 2u);
+    ASSERT_EQ(st.threads.size(), 2u);
+    for (std::size_t i = 0; i < 2; i++) {
+        EXPECT_GT(st.shards[i].lag.count, 0u);
+        EXPECT_EQ(st.threads[i].shard, i);
+    }
+}
+
+// 超过阈值的处理器都有记录, 按结束顺序保留最近的slow_log条
+TEST(asio_loop_monitor, slow_handler) {
+    constexpr int kSlow = 20;
+    cc::AsioPool pool;
+    pool.enable_monitor({.lag_interval_ms = 0, .slow_handler_ms = 4, .slow_log = 8});
+    pool.enqueue([] { spin_for(std::chrono::milliseconds(1)); });
+    for (int i = 0; i < kSlow; i++) {
+        pool.enqueue([i] { spin_for(std::chrono::milliseconds(6 + i % 4)); });
+    }
+    pool.run(1);
+
+    auto st = pool.loop_stats();
+    ASSERT_EQ(st.slow.size(), 8u);
+    for (auto& s : st.slow) {
+        EXPECT_EQ(s.thread, 0u);
+        EXPECT_GE(s.duration_ns, 4000000);
+#ifdef __linux__
+        EXPECT_FALSE(s.stacktrace.empty());
+#endif
+    }
+    for (std::size_t i = 1; i < st.slow.size(); i++) {
+        EXPECT_LE(st.slow[i - 1].when, st.slow[i].when);
+    }
+}
+
+#ifdef __linux__
+
+// 处理器在看门狗抓完调用栈后立即结束, 早于看门狗取走dump: 调用栈仍补进记录
+TEST(asio_loop_monitor, slow_handler_race) {
+    cc::AsioPool pool;
+    pool.enable_monitor({.lag_interval_ms = 0, .slow_handler_ms = 4});
+    for (int i = 0; i < 5; i++) {
+        pool.enqueue([] {
+            // 抓调用栈的信号打断nanosleep, 信号处理函数返回后马上结束
+            timespec ts{1, 0};
+            for (int k = 0; k < 3 && ::nanosleep(&ts, nullptr) == 0; k++) {
+            }
+        });
+    }
+    pool.run(1);
+
+    auto st = pool.loop_stats();
+    ASSERT_EQ(st.slow.size(), 5u);
+    for (auto& s : st.slow) {
+        EXPECT_LT(s.duration_ns, 1000000000);
+        EXPECT_FALSE(s.stacktrace.empty());
+    }
+}
+
+#endif
@@ -0,0 +1,185 @@
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/asio.hpp>
+#include <boost/system/system_error.hpp>
+#include <cc/asio/mutex.h>
+#include <gtest/gtest.h>
+
+namespace {
+
+bool is_aborted(std::exception_ptr e) {
+    try {
+        std::rethrow_exception(e);
+    } catch (const boost::system::system_error& err) {
+        return err.code() == net::error::operation_aborted;
+    } catch (...) {
+    }
+    return false;
+}
+
+}  // namespace
+
+// 等待者按FIFO拿到锁, 解锁时直接转交, 新来的try_lock不能插队
+TEST(asio_mutex, fifo_handoff) {
+    net::io_context ioc;
+    cc::AsyncMutex<> m;
+    std::vector<int> order;
+    auto worker = [&](int id) -> net::awaitable<void> {
+        auto g = co_await m.guard();
+        order.push_back(id);
+        EXPECT_FALSE(m.try_lock());
+        co_await net::post(ioc, net::use_awaitable);
+    };
+    for (int i = 0; i < 4; i++) {
+        net::co_spawn(ioc, worker(i), net::detached);
+    }
+    ioc.run();
+    EXPECT_EQ(order, (std::vector<int>{0, 1, 2, 3}));
+
+    do {
+        std::unique_lock _lck(m, std::try_to_lock);
+        EXPECT_TRUE(_lck.owns_lock());
+        EXPECT_FALSE(m.try_lock());
+    } while (0);
+    EXPECT_TRUE(m.try_lock());
+    m.unlock();
+}
+
+TEST(asio_mutex, cancel_lock) {
+    net::io_context ioc;
+    cc::AsyncMutex<> m;
+    ASSERT_TRUE(m.try_lock());
+    net::cancellation_signal sig;
+    std::exception_ptr err;
+    bool done    = false;
+    auto on_done = [&](std::exception_ptr e) {
+        err  = e;
+        done = true;
+    };
+    net::co_spawn(ioc, m.async_lock(), net::bind_cancellation_slot(sig.slot(), on_done));
+    ioc.poll();
+    EXPECT_FALSE(done);
+    sig.emit(net::cancellation_type::terminal);
+    ioc.poll();
+    ASSERT_TRUE(done);
+    EXPECT_TRUE(err && is_aborted(err));
+
+    // 锁没有交给被取消的等待者
+    m.unlock();
+    EXPECT_TRUE(m.try_lock());
+    m.unlock();
+}
+
+// 写优先: 有写者排队时新来的读者也排队; 写者解锁时排队的读者整批放行
+TEST(asio_mutex, shared_writer_preference) {
+    net::io_context ioc;
+    cc::AsyncSharedMutex<> m;
+    std::vector<std::string> log;
+    auto reader = [&](std::string id) -> net::awaitable<void> {
+        auto g = co_await m.shared_guard();
+        log.push_back(id);
+        co_await net::post(ioc, net::use_awaitable);
+    };
+    auto writer = [&](std::string id) -> net::awaitable<void> {
+        auto g = co_await m.guard();
+        log.push_back(id);
+        co_await net::post(ioc, net::use_awaitable);
+    };
+    net::co_spawn(ioc, reader("r1"), net::detached);
+    net::co_spawn(ioc, reader("r2"), net::detached);
+    net::co_spawn(ioc, writer("w1"), net::detached);
+    net::co_spawn(ioc, reader("r3"), net::detached);
+    net::co_spawn(ioc, writer("w2"), net::detached);
+    net::co_spawn(ioc, reader("r4"), net::detached);
+    ioc.run();
+    EXPECT_EQ(log, (std::vector<std::string>{"r1", "r2", "w1", "r3", "r4", "w2"}));
+
+    EXPECT_TRUE(m.try_lock());
+    EXPECT_FALSE(m.try_lock_shared());
+    m.unlock();
+    EXPECT_TRUE(m.try_lock_shared());
+    EXPECT_FALSE(m.try_lock());
+    m.unlock_shared();
+}
+
+// 唯一排队的写者被取消后, 被它挡住的读者进来
+TEST(asio_mutex, shared_cancel_writer) {
+    net::io_context ioc;
+    cc::AsyncSharedMutex<> m;
+    ASSERT_TRUE(m.try_lock_shared());
+    net::cancellation_signal sig;
+    std::exception_ptr err;
+    bool cancelled = false;
+    auto on_done   = [&](std::exception_ptr e) {
+        err       = e;
+        cancelled = true;
+    };
+    net::co_spawn(ioc, m.async_lock(), net::bind_cancellation_slot(sig.slot(), on_done));
+    ioc.poll();
+    EXPECT_FALSE(m.try_lock_shared());
+
+    bool reader = false;
+    net::co_spawn(
+        ioc,
+        [&]() -> net::awaitable<void> {
+            co_await m.async_lock_shared();
+            reader = true;
+        },
+        net::detached);
+    ioc.poll();
+    EXPECT_FALSE(reader);
+
+    sig.emit(net::cancellation_type::terminal);
+    ioc.poll();
+    ASSERT_TRUE(cancelled);
+    EXPECT_TRUE(err && is_aborted(err));
+    EXPECT_TRUE(reader);
+    m.unlock_shared();
+    m.unlock_shared();
+    EXPECT_TRUE(m.try_lock());
+    m.unlock();
+}
+
+// 两个线程上的读者和写者, 写者独占, 读者之间可以并发
+TEST(asio_mutex, shared_threads) {
+    net::io_context ioc;
+    cc::AsyncSharedMutex<std::mutex> m;
+    std::atomic<int> inside_r{0};
+    std::atomic<int> inside_w{0};
+    std::atomic<bool> bad{false};
+    long total = 0;
+    for (int i = 0; i < 32; i++) {
+        net::co_spawn(
+            ioc,
+            [&, i]() -> net::awaitable<void> {
+                for (int k = 0; k < 200; k++) {
+                    if ((i + k) % 4 == 0) {
+                        auto g = co_await m.guard();
+                        if (inside_w.fetch_add(1) != 0 || inside_r.load() != 0) {
+                            bad = true;
+                        }
+                        total++;
+                        inside_w.fetch_sub(1);
+                    } else {
+                        auto g = co_await m.shared_guard();
+                        inside_r.fetch_add(1);
+                        if (inside_w.load() != 0) {
+                            bad = true;
+                        }
+                        co_await net::post(co_await net::this_coro::executor, net::use_awaitable);
+                        inside_r.fetch_sub(1);
+                    }
+                }
+            },
+            net::detached);
+    }
+    std::thread t([&] { ioc.run(); });
+    ioc.run();
+    t.join();
+    EXPECT_FALSE(bad);
+    EXPECT_EQ(total, 32 * 200 / 4);
+}
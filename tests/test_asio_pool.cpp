@@ -0,0 +1,152 @@
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+#include <boost/asio.hpp>
+#include <cc/asio/pool.h>
+#include <gtest/gtest.h>
+
+TEST(asio_pool, shared_mode) {
+    cc::AsioPool pool;
+    EXPECT_FALSE(pool.is_sharded());
+    EXPECT_EQ(pool.size(), 1u);
+    EXPECT_EQ(&pool.next_io_context(), &pool.get_io_context(0));
+    EXPECT_EQ(pool.current_index(), -1);
+
+    std::atomic<int> n{0};
+    std::atomic<bool> bad{false};
+    for (int i = 0; i < 100; i++) {
+        pool.enqueue([&] {
+            if (pool.current_index() != 0) {
+                bad = true;
+            }
+            n++;
+        });
+    }
+    // 没有任务后run()返回
+    pool.run(2);
+    EXPECT_EQ(n.load(), 100);
+    EXPECT_FALSE(bad);
+}
+
+// 池外按轮流分配到各分片, 各分片由各自的线程运行
+TEST(asio_pool, sharded_round_robin) {
+    constexpr int kShards = 4;
+    cc::AsioPool pool(cc::sharded, kShards);
+    EXPECT_TRUE(pool.is_sharded());
+    ASSERT_EQ(pool.size(), static_cast<std::size_t>(kShards));
+
+    std::set<boost::asio::io_context*> ctxs;
+    for (int i = 0; i < kShards; i++) {
+        ctxs.insert(&pool.next_io_context());
+    }
+    EXPECT_EQ(ctxs.size(), static_cast<std::size_t>(kShards));
+    for (int i = 0; i < kShards; i++) {
+        EXPECT_EQ(ctxs.count(&pool.get_io_context(i)), 1u);
+    }
+    EXPECT_THROW(pool.get_io_context(kShards), std::out_of_range);
+
+    std::mutex mtx;
+    std::vector<std::set<std::thread::id>> tids(kShards);
+    std::atomic<int> n{0};
+    std::promise<void> done;
+    for (int i = 0; i < kShards * 25; i++) {
+        pool.enqueue([&] {
+            auto idx = pool.current_index();
+            ASSERT_GE(idx, 0);
+            do {
+                std::unique_lock _lck{mtx};
+                tids[idx].insert(std::this_thread::get_id());
+            } while (0);
+            if (++n == kShards * 25) {
+                done.set_value();
+            }
+        });
+    }
+    std::thread t([&] { pool.run(); });
+    EXPECT_EQ(done.get_future().wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    pool.shutdown();
+    t.join();
+
+    std::set<std::thread::id> all;
+    for (auto& s : tids) {
+        ASSERT_EQ(s.size(), 1u);
+        all.insert(*s.begin());
+    }
+    EXPECT_EQ(all.size(), static_cast<std::size_t>(kShards));
+    EXPECT_EQ(pool.current_index(), -1);
+}
+
+// 池内发起的enqueue/set_timeout/co_spawn/时间轮定时器留在本分片
+TEST(asio_pool, sharded_local) {
+    constexpr int kShards = 3;
+    cc::AsioPool pool(cc::sharded, kShards);
+    std::atomic<int> pending{kShards * 4};
+    std::atomic<bool> bad{false};
+    std::promise<void> done;
+    auto finish = [&](int expected) {
+        if (pool.current_index() != expected) {
+            bad = true;
+        }
+        if (--pending == 0) {
+            done.set_value();
+        }
+    };
+    for (int i = 0; i < kShards; i++) {
+        boost::asio::post(pool.get_io_context(i), [&, i] {
+            EXPECT_EQ(&pool.get_io_context(), &pool.get_io_context(i));
+            EXPECT_EQ(&pool.timer_wheel(), &pool.timer_wheel());
+            pool.enqueue([&, i] { finish(i); });
+            pool.set_timeout(1, [&, i] { finish(i); });
+            pool.set_timeout(1, [&, i] { finish(i); }, cc::use_wheel);
+            auto coro = [&, i]() -> boost::asio::awaitable<void> {
+                finish(i);
+                co_return;
+            };
+            pool.co_spawn(coro);
+        });
+    }
+    std::thread t([&] { pool.run(); });
+    EXPECT_EQ(done.get_future().wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    pool.shutdown();
+    t.join();
+    EXPECT_FALSE(bad);
+}
+
+TEST(asio_pool, least_loaded) {
+    constexpr int kShards = 4;
+    cc::AsioPool pool(cc::sharded, kShards, cc::placement_e::LEAST_LOADED);
+    std::set<boost::asio::io_context*> ctxs;
+    for (int i = 0; i < 1000; i++) {
+        ctxs.insert(&pool.next_io_context());
+    }
+    // 延迟都为0时等同轮流
+    EXPECT_EQ(ctxs.size(), static_cast<std::size_t>(kShards));
+
+    std::atomic<int> n{0};
+    std::promise<void> done;
+    for (int i = 0; i < 100; i++) {
+        pool.enqueue([&] {
+            if (++n == 100) {
+                done.set_value();
+            }
+        });
+    }
+    std::thread t([&] { pool.run(); });
+    EXPECT_EQ(done.get_future().wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    pool.shutdown();
+    t.join();
+}
+
+// 先shutdown时run()直接返回
+TEST(asio_pool, shutdown_before_run) {
+    cc::AsioPool pool(cc::sharded, 2);
+    std::atomic<bool> ran{false};
+    pool.enqueue([&] { ran = true; });
+    pool.shutdown();
+    pool.run();
+    EXPECT_FALSE(ran);
+}
@@ -0,0 +1,129 @@
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/asio.hpp>
+#include <cc/asio/rate_limiter.h>
+#include <cc/signal.h>
+#include <gtest/gtest.h>
+
+TEST(asio_rate_limiter, invalid_args) {
+    EXPECT_THROW(cc::TokenBucket(0, 1), std::invalid_argument);
+    EXPECT_THROW(cc::TokenBucket(-1, 1), std::invalid_argument);
+    EXPECT_THROW(cc::TokenBucket(10, 0.5), std::invalid_argument);
+    EXPECT_THROW(cc::KeyedRateLimiter<int>(10, 0).try_acquire(1), std::invalid_argument);
+
+    // 速率超过每纳秒一个时间隔按1ns算
+    cc::TokenBucket b(1e12, 1);
+    EXPECT_DOUBLE_EQ(b.rate(), 1e9);
+    EXPECT_TRUE(b.try_acquire());
+}
+
+TEST(asio_rate_limiter, burst) {
+    cc::TokenBucket b(10, 3);
+    EXPECT_TRUE(b.idle());
+    for (int i = 0; i < 3; i++) {
+        EXPECT_TRUE(b.try_acquire());
+    }
+    EXPECT_FALSE(b.try_acquire());
+    EXPECT_FALSE(b.idle());
+
+    // 超过max_wait_ns时不预约
+    EXPECT_EQ(b.reserve(1, 1000000), cc::TokenBucket::kRejected);
+    auto wait = b.reserve(1);
+    EXPECT_GT(wait, 0);
+    EXPECT_LE(wait, 100000000);
+}
+
+// 退还的令牌最多把桶补满
+TEST(asio_rate_limiter, refund) {
+    cc::TokenBucket b(1, 2);
+    EXPECT_TRUE(b.try_acquire(2));
+    b.refund();
+    EXPECT_TRUE(b.try_acquire());
+    EXPECT_FALSE(b.try_acquire());
+
+    b.refund(5);
+    EXPECT_TRUE(b.idle());
+    EXPECT_TRUE(b.try_acquire(2));
+    EXPECT_FALSE(b.try_acquire());
+}
+
+TEST(asio_rate_limiter, acquire) {
+    net::io_context ioc;
+    cc::TokenBucket b(100, 1);
+    std::vector<bool> r;
+    long ms = 0;
+    net::co_spawn(
+        ioc,
+        [&]() -> net::awaitable<void> {
+            auto t0 = std::chrono::steady_clock::now();
+            for (int i = 0; i < 5; i++) {
+                co_await b.acquire();
+            }
+            ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                     std::chrono::steady_clock::now() - t0)
+                     .count();
+            r.push_back(co_await b.acquire_for(1));
+            r.push_back(co_await b.acquire_for(100));
+        },
+        net::detached);
+    ioc.run();
+    // 第一个令牌立即可用, 之后每10ms一个
+    EXPECT_GE(ms, 35);
+    EXPECT_LT(ms, 500);
+    EXPECT_EQ(r, (std::vector<bool>{false, true}));
+}
+
+// 本键和上级限速器都满足才放行, 被上级拒绝时不消耗本键的令牌
+TEST(asio_rate_limiter, keyed) {
+    auto parent = std::make_shared<cc::TokenBucket>(1, 3);
+    cc::KeyedRateLimiter<std::string> limiter(1, 2, parent);
+    EXPECT_TRUE(limiter.try_acquire("a"));
+    EXPECT_TRUE(limiter.try_acquire("a"));
+    EXPECT_FALSE(limiter.try_acquire("a"));
+    EXPECT_TRUE(limiter.try_acquire("b"));
+    EXPECT_FALSE(limiter.try_acquire("b"));
+    EXPECT_EQ(limiter.reserve("c", 1, 0), cc::TokenBucket::kRejected);
+    EXPECT_EQ(limiter.size(), 3u);
+
+    // c只被上级拒绝过, 桶还是满的
+    EXPECT_EQ(limiter.sweep(), 1u);
+    EXPECT_EQ(limiter.size(), 2u);
+    parent->refund(3);
+    EXPECT_TRUE(limiter.try_acquire("b"));
+}
+
+// 取得令牌的事件也不在pub里直接回调, 而是都在ex上按顺序执行
+TEST(asio_rate_limiter, signal_sub) {
+    net::io_context ioc;
+    cc::Signal<> sig;
+    auto limiter = std::make_shared<cc::TokenBucket>(20, 2);
+    std::vector<int> got;
+    std::vector<std::thread::id> tids;
+    sig.sub("rate_limited", limiter, ioc.get_executor(), [&](int v) {
+        got.push_back(v);
+        tids.push_back(std::this_thread::get_id());
+    });
+    for (int i = 0; i < 4; i++) {
+        sig.pub("rate_limited", i);
+    }
+    EXPECT_TRUE(got.empty());
+
+    auto t0 = std::chrono::steady_clock::now();
+    std::thread::id tid;
+    std::thread t([&] {
+        tid = std::this_thread::get_id();
+        ioc.run();
+    });
+    t.join();
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                  std::chrono::steady_clock::now() - t0)
+                  .count();
+    EXPECT_EQ(got, (std::vector<int>{0, 1, 2, 3}));
+    EXPECT_EQ(tids, std::vector<std::thread::id>(4, tid));
+    // 超出burst的两个按50ms一个延迟
+    EXPECT_GE(ms, 80);
+}
@@ -0,0 +1,54 @@
+#include <boost/asio.hpp>
+#include <boost/system/system_error.hpp>
+#include <cc/asio/helper.h>
+#include <gtest/gtest.h>
+
+#ifdef SO_REUSEPORT
+
+namespace {
+
+using tcp = net::ip::tcp;
+
+tcp::acceptor open_acceptor(net::io_context& ioc, const tcp::endpoint& ep, bool reuse_port) {
+    tcp::acceptor a(ioc);
+    a.open(ep.protocol());
+    if (reuse_port) {
+        a.set_option(cc::reuse_port(true));
+    }
+    a.bind(ep);
+    a.listen();
+    return a;
+}
+
+}  // namespace
+
+TEST(asio_reuse_port, option) {
+    net::io_context ioc;
+    tcp::acceptor a(ioc);
+    a.open(tcp::v4());
+    cc::reuse_port opt;
+    a.get_option(opt);
+    EXPECT_FALSE(opt.value());
+    a.set_option(cc::reuse_port(true));
+    a.get_option(opt);
+    EXPECT_TRUE(opt);
+}
+
+// 都设置了SO_REUSEPORT的监听可以绑定同一个端口, 都能接受连接
+TEST(asio_reuse_port, listen) {
+    net::io_context ioc;
+    tcp::endpoint ep{net::ip::make_address("127.0.0.1"), 0};
+    auto a1 = open_acceptor(ioc, ep, true);
+    ep.port(a1.local_endpoint().port());
+    auto a2 = open_acceptor(ioc, ep, true);
+    EXPECT_EQ(a2.local_endpoint().port(), ep.port());
+
+    // 没有设置的绑定失败
+    EXPECT_THROW(open_acceptor(ioc, ep, false), boost::system::system_error);
+
+    tcp::socket c(ioc);
+    c.connect(ep);
+    EXPECT_TRUE(c.is_open());
+}
+
+#endif
@@ -0,0 +1,240 @@
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <optional>
+#include <thread>
+#include <variant>
+#include <vector>
+#include <boost/asio.hpp>
+#include <boost/asio/experimental/awaitable_operators.hpp>
+#include <boost/system/system_error.hpp>
+#include <cc/asio/broadcast.h>
+#include <cc/asio/channel.h>
+#include <cc/asio/select.h>
+#include <gtest/gtest.h>
+
+namespace chan = cc::chan;
+
+TEST(asio_select, timeout) {
+    net::io_context ioc;
+    auto [tx, rx]   = chan::bounded::make<int>(4);
+    auto [mtx, mrx] = chan::mpmc::make<int>();
+    std::vector<std::size_t> r;
+    net::co_spawn(
+        ioc,
+        [&]() -> net::awaitable<void> {
+            chan::Select<2> sel;
+            r.push_back(co_await sel.wait_for(5, rx, mrx));
+            tx.try_send(1);
+            r.push_back(co_await sel.wait_for(5, rx, mrx));
+            EXPECT_EQ(rx.try_recv(), 1);
+            mtx.send(2);
+            r.push_back(co_await sel.wait(rx, mrx));
+            // 只等待可读, 不取走消息
+            r.push_back(co_await sel.wait_for(5, rx, mrx));
+            EXPECT_EQ(mrx.try_recv(), std::vector<int>{2});
+        },
+        net::detached);
+    ioc.run();
+    EXPECT_EQ(r, (std::vector<std::size_t>{chan::Select<2>::timeout, 0, 1, 1}));
+}
+
+// 定时器在两次等待之间保持挂起; 提前到期或被缩短时仍按本次的超时返回
+TEST(asio_select, rearm) {
+    net::io_context ioc;
+    auto [tx, rx]   = chan::bounded::make<int>(4);
+    auto [mtx, mrx] = chan::mpmc::make<int>();
+    std::vector<std::size_t> r;
+    long ms = 0;
+    net::co_spawn(
+        ioc,
+        [&]() -> net::awaitable<void> {
+            chan::Select<2> sel;
+            tx.try_send(1);
+            r.push_back(co_await sel.wait_for(1000, rx, mrx));
+            rx.try_recv();
+
+            auto t0 = std::chrono::steady_clock::now();
+            r.push_back(co_await sel.wait_for(5, rx, mrx));
+            r.push_back(co_await sel.wait_for(30, rx, mrx));
+            ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                     std::chrono::steady_clock::now() - t0)
+                     .count();
+
+            auto ex         = co_await net::this_coro::executor;
+            auto send_later = [&]() -> net::awaitable<void> {
+                co_await cc::async_sleep(50);
+                mtx.send(3);
+            };
+            net::co_spawn(ex, send_later, net::detached);
+            r.push_back(co_await sel.wait(rx, mrx));
+        },
+        net::detached);
+    ioc.run();
+    EXPECT_EQ(r, (std::vector<std::size_t>{0, 2, 2, 1}));
+    EXPECT_GE(ms, 35);
+    EXPECT_LT(ms, 500);
+}
+
+// 已关闭的接收者每次都立即触发
+TEST(asio_select, closed) {
+    net::io_context ioc;
+    auto [tx, rx]   = chan::bounded::make<int>(4);
+    auto [wtx, wrx] = chan::watch::make<int>(0);
+    std::vector<std::size_t> r;
+    do {
+        auto sender = std::move(tx);
+    } while (0);
+    net::co_spawn(
+        ioc,
+        [&]() -> net::awaitable<void> {
+            chan::Select<2> sel;
+            r.push_back(co_await sel.wait(wrx, rx));
+            r.push_back(co_await sel.wait_for(1000, wrx, rx));
+            EXPECT_EQ(rx.try_recv(), std::nullopt);
+        },
+        net::detached);
+    ioc.run();
+    EXPECT_EQ(r, (std::vector<std::size_t>{1, 1}));
+}
+
+// 取消挂起的等待: 抛出operation_aborted, 注销钩子, 之后的消息仍留在通道里
+TEST(asio_select, cancel) {
+    net::io_context ioc;
+    auto [tx, rx]   = chan::bounded::make<int>(4);
+    auto [mtx, mrx] = chan::mpmc::make<int>();
+    chan::Select<2> sel;
+    net::cancellation_signal sig;
+    std::exception_ptr err;
+    bool done    = false;
+    auto on_done = [&](std::exception_ptr e, std::size_t) {
+        err  = e;
+        done = true;
+    };
+    net::co_spawn(ioc, sel.wait(rx, mrx), net::bind_cancellation_slot(sig.slot(), on_done));
+    ioc.poll();
+    EXPECT_FALSE(done);
+    sig.emit(net::cancellation_type::terminal);
+    ioc.poll();
+    ASSERT_TRUE(done);
+    ASSERT_TRUE(err);
+    try {
+        std::rethrow_exception(err);
+    } catch (const boost::system::system_error& e) {
+        EXPECT_EQ(e.code(), net::error::operation_aborted);
+    }
+
+    EXPECT_TRUE(tx.try_send(1));
+    EXPECT_TRUE(mtx.send(2));
+    EXPECT_EQ(rx.try_recv(), 1);
+    EXPECT_EQ(mrx.try_recv(), std::vector<int>{2});
+
+    // 同一个Select可以继续使用
+    ioc.restart();
+    std::vector<std::size_t> r;
+    net::co_spawn(
+        ioc,
+        [&]() -> net::awaitable<void> {
+            r.push_back(co_await sel.wait(rx, mrx));
+            EXPECT_EQ(rx.try_recv(), 3);
+        },
+        net::detached);
+    ioc.poll();
+    tx.try_send(3);
+    ioc.run();
+    EXPECT_EQ(r, std::vector<std::size_t>{0});
+}
+
+// 作为||的一方输给定时器时不会一直挂起, 消息留给之后的try_recv
+TEST(asio_select, cancel_by_operator) {
+    using namespace net::experimental::awaitable_operators;
+    net::io_context ioc;
+    auto [tx, rx]   = chan::bounded::make<int>(4);
+    auto [wtx, wrx] = chan::watch::make<int>(0);
+    chan::Select<2> sel;
+    std::optional<std::size_t> which;
+    net::co_spawn(
+        ioc,
+        [&]() -> net::awaitable<void> {
+            auto r = co_await (sel.wait(rx, wrx) || cc::async_sleep(10));
+            which  = r.index();
+            tx.try_send(1);
+        },
+        net::detached);
+    ioc.run();
+    EXPECT_EQ(which, 1u);
+    EXPECT_EQ(rx.try_recv(), 1);
+}
+
+// 四种接收者, 发送方在其他线程上; 每条消息都能通过try_recv取到
+TEST(asio_select, threads) {
+    constexpr int N = 5000;
+    net::io_context ioc;
+    auto [btx, brx] = chan::bounded::make<int>(16);
+    auto [mtx, mrx] = chan::mpmc::make<int>();
+    auto [ctx, crx] = chan::broadcast::make<int>(N);
+    auto [wtx, wrx] = chan::watch::make<int>(0);
+    long sum[3]     = {0, 0, 0};
+    int last_watch  = 0;
+    net::co_spawn(
+        ioc,
+        [&]() -> net::awaitable<void> {
+            chan::Select<4> sel;
+            int got[3] = {0, 0, 0};
+            while (got[0] < N || got[1] < N || got[2] < N || last_watch < N) {
+                auto i = co_await sel.wait_for(20, brx, mrx, crx, wrx);
+                if (i == 0) {
+                    if (auto v = brx.try_recv()) {
+                        sum[0] += *v;
+                        got[0]++;
+                    }
+                } else if (i == 1) {
+                    for (int v : mrx.try_recv()) {
+                        sum[1] += v;
+                        got[1]++;
+                    }
+                } else if (i == 2) {
+                    if (auto v = crx.try_recv()) {
+                        sum[2] += *v;
+                        got[2]++;
+                    }
+                } else if (i == 3) {
+                    last_watch = wrx.get();
+                }
+            }
+        },
+        net::detached);
+
+    std::thread t1([tx = std::move(btx)]() mutable {
+        for (int i = 1; i <= N; i++) {
+            while (!tx.try_send(i)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+    std::thread t2([tx = std::move(mtx)]() mutable {
+        for (int i = 1; i <= N; i++) {
+            tx.send(i);
+        }
+    });
+    std::thread t3([tx = std::move(ctx)]() mutable {
+        for (int i = 1; i <= N; i++) {
+            tx.send(i);
+        }
+    });
+    std::thread t4([tx = std::move(wtx)]() mutable {
+        for (int i = 1; i <= N; i++) {
+            tx.send(i);
+        }
+    });
+    ioc.run();
+    t1.join();
+    t2.join();
+    t3.join();
+    t4.join();
+    long expected = static_cast<long>(N) * (N + 1) / 2;
+    EXPECT_EQ(sum[0], expected);
+    EXPECT_EQ(sum[1], expected);
+    EXPECT_EQ(sum[2], expected);
+    EXPECT_EQ(last_watch, N);
+}
@@ -0,0 +1,181 @@
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <boost/asio.hpp>
+#include <boost/system/system_error.hpp>
+#include <cc/asio/semaphore.h>
+#include <gtest/gtest.h>
+
+namespace {
+
+bool is_aborted(std::exception_ptr e) {
+    try {
+        std::rethrow_exception(e);
+    } catch (const boost::system::system_error& err) {
+        return err.code() == net::error::operation_aborted;
+    } catch (...) {
+    }
+    return false;
+}
+
+}  // namespace
+
+TEST(asio_semaphore, cancel_acquire) {
+    net::io_context ioc;
+    cc::Semaphore<> sem(0);
+    net::cancellation_signal sig;
+    std::exception_ptr err;
+    bool done = false;
+    net::co_spawn(ioc, sem.acquire(),
+                  net::bind_cancellation_slot(sig.slot(), [&](std::exception_ptr e) {
+                      err  = e;
+                      done = true;
+                  }));
+    ioc.poll();
+    EXPECT_FALSE(done);
+
+    sig.emit(net::cancellation_type::terminal);
+    ioc.poll();
+    ASSERT_TRUE(done);
+    EXPECT_TRUE(err && is_aborted(err));
+    // 被取消的等待者不占许可
+    sem.release();
+    EXPECT_EQ(sem.available(), 1u);
+}
+
+// 取消与另一个线程的release同时发生, 许可既不丢失也不重复发放
+TEST(asio_semaphore, cancel_release_race) {
+    constexpr int N = 2000;
+    net::io_context ioc;
+    cc::Semaphore<std::mutex> sem(0);
+    std::vector<net::cancellation_signal> sigs(N);
+    std::atomic<int> acquired{0};
+    std::atomic<int> aborted{0};
+    for (auto& sig : sigs) {
+        net::co_spawn(ioc, sem.acquire(),
+                      net::bind_cancellation_slot(sig.slot(), [&](std::exception_ptr e) {
+                          (e && is_aborted(e) ? aborted : acquired).fetch_add(1);
+                      }));
+    }
+    ioc.poll();
+    for (int i = 0; i < N; i++) {
+        net::post(ioc, [&sigs, i] { sigs[i].emit(net::cancellation_type::terminal); });
+    }
+
+    std::thread t([&] { ioc.run(); });
+    for (int i = 0; i < N; i++) {
+        sem.release();
+    }
+    t.join();
+    EXPECT_EQ(acquired.load() + aborted.load(), N);
+    EXPECT_EQ(sem.available(), static_cast<std::size_t>(N - acquired.load()));
+}
+
+TEST(asio_semaphore, try_acquire) {
+    cc::Semaphore<> sem(3);
+    EXPECT_TRUE(sem.try_acquire(2));
+    EXPECT_FALSE(sem.try_acquire(2));
+    EXPECT_TRUE(sem.try_acquire());
+    EXPECT_EQ(sem.available(), 0u);
+    sem.release(3);
+    EXPECT_EQ(sem.available(), 3u);
+}
+
+// 严格FIFO: 队首请求的数量不够时, 后面请求少的也要等; release(n)一次放行多个
+TEST(asio_semaphore, acquire_fifo) {
+    net::io_context ioc;
+    cc::Semaphore<> sem(1);
+    std::vector<int> order;
+    auto acquire = [&](int id, std::size_t n) {
+        net::co_spawn(
+            ioc,
+            [&sem, &order, id, n]() -> net::awaitable<void> {
+                co_await sem.acquire(n);
+                order.push_back(id);
+            },
+            net::detached);
+        ioc.poll();
+    };
+    acquire(0, 3);
+    acquire(1, 1);
+    EXPECT_TRUE(order.empty());
+    // 有人排队时try_acquire不插队
+    EXPECT_FALSE(sem.try_acquire());
+
+    sem.release(1);
+    ioc.poll();
+    EXPECT_TRUE(order.empty());
+    sem.release(2);
+    ioc.poll();
+    EXPECT_EQ(order, (std::vector<int>{0, 1}));
+    EXPECT_EQ(sem.available(), 0u);
+}
+
+TEST(asio_semaphore, acquire_for) {
+    net::io_context ioc;
+    cc::Semaphore<> sem(1);
+    std::vector<bool> r;
+    net::co_spawn(
+        ioc,
+        [&]() -> net::awaitable<void> {
+            r.push_back(co_await sem.acquire_for(10));
+            r.push_back(co_await sem.acquire_for(10));
+            sem.release();
+            r.push_back(co_await sem.acquire_for(10));
+        },
+        net::detached);
+    ioc.run();
+    EXPECT_EQ(r, (std::vector<bool>{true, false, true}));
+    // 超时的等待者不占许可, 取得的许可由调用方持有
+    EXPECT_EQ(sem.available(), 0u);
+    sem.release();
+    EXPECT_EQ(sem.available(), 1u);
+}
+
+TEST(asio_semaphore, guard_for) {
+    net::io_context ioc;
+    cc::Semaphore<> sem(2);
+    net::co_spawn(
+        ioc,
+        [&]() -> net::awaitable<void> {
+            do {
+                auto p = co_await sem.guard(2);
+                EXPECT_TRUE(p);
+                EXPECT_EQ(p.count(), 2u);
+                auto q = co_await sem.guard_for(10);
+                EXPECT_FALSE(q);
+                EXPECT_EQ(sem.available(), 0u);
+            } while (0);
+            EXPECT_EQ(sem.available(), 2u);
+
+            auto p = co_await sem.guard_for(10);
+            EXPECT_TRUE(p);
+            p.release();
+            EXPECT_FALSE(p);
+            EXPECT_EQ(sem.available(), 2u);
+        },
+        net::detached);
+    ioc.run();
+    EXPECT_EQ(sem.available(), 2u);
+}
+
+// guard_for挂起后在超时前取得许可
+TEST(asio_semaphore, guard_for_wakeup) {
+    net::io_context ioc;
+    cc::Semaphore<> sem(0);
+    bool got = false;
+    net::co_spawn(
+        ioc,
+        [&]() -> net::awaitable<void> {
+            auto p = co_await sem.guard_for(1000);
+            got    = static_cast<bool>(p);
+        },
+        net::detached);
+    ioc.poll();
+    sem.release();
+    ioc.run();
+    EXPECT_TRUE(got);
+    EXPECT_EQ(sem.available(), 1u);
+}
@@ -0,0 +1,153 @@
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <set>
+#include <thread>
+#include <vector>
+#include <boost/asio.hpp>
+#include <cc/asio/pool.h>
+#include <cc/asio/timer_wheel.h>
+#include <gtest/gtest.h>
+
+namespace {
+
+using namespace std::chrono_literals;
+
+std::int64_t elapsed_ms(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now() - t0)
+        .count();
+}
+
+}  // namespace
+
+// 任意时刻启动, 都不早于超时时间触发
+TEST(asio_timer_wheel, lower_bound) {
+    auto base = std::chrono::steady_clock::now();
+    cc::TimerWheel<> wheel(10ms);  // tick从base之后开始计
+    for (int i = 0; i < 5; i++) {
+        // 在tick的末尾启动, 按tick取整时最容易提前触发
+        std::this_thread::sleep_until(base + (i * 5 + 1) * 10ms + 8ms);
+        auto t0         = std::chrono::steady_clock::now();
+        bool fired      = false;
+        std::int64_t ms = 0;
+        wheel.set_timeout(25, [&] {
+            fired = true;
+            ms    = elapsed_ms(t0);
+        });
+        while (!fired) {
+            wheel.poll();
+            std::this_thread::sleep_for(1ms);
+        }
+        EXPECT_GE(ms, 25);
+        EXPECT_LT(ms, 1000);
+    }
+}
+
+TEST(asio_timer_wheel, cancel) {
+    cc::TimerWheel<> wheel;
+    int n  = 0;
+    auto a = wheel.set_timeout(1, [&] { n += 1; });
+    auto b = wheel.set_timeout(1, [&] { n += 10; });
+    EXPECT_EQ(wheel.size(), 2u);
+    EXPECT_TRUE(wheel.cancel(a));
+    EXPECT_FALSE(wheel.cancel(a));
+    EXPECT_EQ(wheel.size(), 1u);
+    std::this_thread::sleep_for(5ms);
+    EXPECT_EQ(wheel.poll(), 1u);
+    EXPECT_EQ(n, 10);
+    // 已触发的和空句柄
+    EXPECT_FALSE(wheel.cancel(b));
+    EXPECT_FALSE(wheel.cancel({}));
+
+    // 节点复用后旧句柄失效
+    auto c = wheel.set_timeout(1, [&] { n += 100; });
+    EXPECT_FALSE(wheel.cancel(a));
+    EXPECT_TRUE(wheel.cancel(c));
+    EXPECT_EQ(wheel.size(), 0u);
+}
+
+// 周期定时器按周期重新启动, 在回调里取消后不再触发
+TEST(asio_timer_wheel, interval) {
+    boost::asio::io_context ioc;
+    cc::TimerWheel<> wheel(ioc);
+    int n = 0;
+    cc::TimerWheel<>::handle_t h;
+    h = wheel.set_interval(10, [&] {
+        if (++n == 5) {
+            EXPECT_FALSE(wheel.cancel(h));
+        }
+    });
+    auto t0 = std::chrono::steady_clock::now();
+    // 没有等待中的定时器后asio定时器不再启动, run()返回
+    ioc.run();
+    EXPECT_EQ(n, 5);
+    EXPECT_EQ(wheel.size(), 0u);
+    EXPECT_GE(elapsed_ms(t0), 50);
+}
+
+// 空闲或只有远期定时器时, 长时间不poll后新定时器仍按时触发
+TEST(asio_timer_wheel, idle) {
+    cc::TimerWheel<> wheel;
+    int n = 0;
+    std::this_thread::sleep_for(30ms);
+    wheel.set_timeout(20, [&] { n++; });
+    EXPECT_EQ(wheel.poll(), 0u);
+    std::this_thread::sleep_for(25ms);
+    EXPECT_EQ(wheel.poll(), 1u);
+
+    auto far = wheel.set_timeout(3600000, [&] { n += 100; });
+    std::this_thread::sleep_for(30ms);
+    wheel.set_timeout(5, [&] { n++; });
+    std::this_thread::sleep_for(10ms);
+    EXPECT_EQ(wheel.poll(), 1u);
+    EXPECT_EQ(n, 2);
+    EXPECT_EQ(wheel.size(), 1u);
+    EXPECT_TRUE(wheel.cancel(far));
+}
+
+// 共用模式的AsioPool只有一个时间轮, 由它的io_context驱动
+TEST(asio_timer_wheel, pool) {
+    cc::AsioPool pool;
+    auto* w = &pool.timer_wheel();
+    std::thread([&] { EXPECT_EQ(&pool.timer_wheel(), w); }).join();
+
+    bool fired = false;
+    pool.set_timeout(5, [&] { fired = true; }, cc::use_wheel);
+    // 没有等待中的定时器后run()返回
+    pool.run(1);
+    EXPECT_TRUE(fired);
+}
+
+// 分片模式下每个io_context一个时间轮, 回调在启动它的分片上执行
+TEST(asio_timer_wheel, per_context) {
+    constexpr int kShards = 3;
+    cc::AsioPool pool(cc::sharded, kShards);
+    std::vector<cc::AsioPool::wheel_t*> wheels(kShards);
+    std::atomic<int> pending{kShards};
+    std::atomic<bool> bad{false};
+    std::promise<void> done;
+    for (int i = 0; i < kShards; i++) {
+        boost::asio::post(pool.get_io_context(i), [&, i] {
+            wheels[i] = &pool.timer_wheel();
+            pool.set_timeout(
+                5,
+                [&, i] {
+                    if (pool.current_index() != i || &pool.timer_wheel() != wheels[i]) {
+                        bad = true;
+                    }
+                    if (--pending == 0) {
+                        done.set_value();
+                    }
+                },
+                cc::use_wheel);
+        });
+    }
+    std::thread t([&] { pool.run(); });
+    EXPECT_EQ(done.get_future().wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    pool.shutdown();
+    t.join();
+    EXPECT_FALSE(bad);
+    EXPECT_EQ(std::set<cc::AsioPool::wheel_t*>(wheels.begin(), wheels.end()).size(),
+              static_cast<std::size_t>(kShards));
+}
@@ -0,0 +1,115 @@
+#ifdef CC_WITH_SQLITE3
+
+#    include <filesystem>
+#    include <stdexcept>
+#    include <string>
+#    include <tuple>
+#    include <cc/historian.h>
+#    include <cc/sqlite3pp.h>
+#    include <gtest/gtest.h>
+
+TEST(historian, append_query) {
+    auto dir = std::filesystem::temp_directory_path() / "cc_test_historian";
+    std::filesystem::remove_all(dir);
+    auto path = (dir / "hist.db").string();
+
+    constexpr std::int64_t t0 = 1700000000000;
+    do {
+        cc::HistorianOptions opts;
+        opts.flush_interval_ms = 3600000;  // 显式flush
+        cc::Historian h(path, opts);
+
+        auto a = h.tag("a");
+        auto b = h.tag("b");
+        EXPECT_EQ(h.tag("a"), a);
+        EXPECT_NE(a, b);
+
+        for (int i = 0; i < 3000; i++) {
+            ASSERT_TRUE(h.append(a, t0 + i, i));
+        }
+        h.append(b, t0, -1);
+        EXPECT_THROW(h.append(b + 100, t0, 0), std::out_of_range);
+        h.flush();
+        EXPECT_EQ(h.written(), 3001u);
+
+        auto raw = h.query(a, t0 + 100, t0 + 200);
+        ASSERT_EQ(raw.size(), 100u);
+        EXPECT_EQ(raw.front().ts, t0 + 100);
+        EXPECT_DOUBLE_EQ(raw.back().value, 199);
+
+        auto sec = h.rollup(a, cc::Historian::SECOND, t0, t0 + 3000);
+        ASSERT_FALSE(sec.empty());
+        std::int64_t count = 0;
+        for (auto& r : sec) {
+            EXPECT_LE(r.min, r.avg);
+            EXPECT_LE(r.avg, r.max);
+            count += r.count;
+        }
+        EXPECT_EQ(count, 3000);
+    } while (0);
+
+    // 重新打开后tag的id不变, 数据仍在
+    do {
+        cc::Historian h(path);
+        EXPECT_EQ(h.tag("b"), 1u);
+        EXPECT_EQ(h.query(0, t0, t0 + 3000).size(), 3000u);
+    } while (0);
+
+    std::filesystem::remove_all(dir);
+}
+
+// 落盘事务失败时样本留在缓冲里, 下次落盘不丢也不重复计入汇总
+TEST(historian, flush_failure) {
+    auto dir = std::filesystem::temp_directory_path() / "cc_test_historian_fail";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    auto path = (dir / "hist.db").string();
+
+    constexpr std::int64_t t0 = 1700000000000;
+    do {
+        cc::HistorianOptions opts;
+        opts.flush_interval_ms = 3600000;
+        cc::Historian h(path, opts);
+        auto a = h.tag("a");
+        for (int i = 0; i < 10; i++) {
+            h.append(a, t0 + i, i);
+        }
+        h.flush();
+        EXPECT_EQ(h.written(), 10u);
+
+        // 另一个连接加触发器, 让汇总的写入失败
+        cc::Sqlite3pp db(path);
+        db.execute(
+            "CREATE TRIGGER hist_fail BEFORE INSERT ON hist_rollup "
+            "BEGIN SELECT RAISE(ABORT, 'injected'); END;");
+        auto b = h.tag("b");
+        for (int i = 10; i < 20; i++) {
+            h.append(a, t0 + i, i);
+        }
+        h.append(b, t0, -1);
+        h.flush();
+        EXPECT_EQ(h.written(), 10u);
+        EXPECT_EQ(h.query(a, t0, t0 + 1000).size(), 10u);
+
+        db.execute("DROP TRIGGER hist_fail;");
+        h.flush();
+        EXPECT_EQ(h.written(), 21u);
+        EXPECT_EQ(h.query(a, t0, t0 + 1000).size(), 20u);
+        EXPECT_EQ(h.query(b, t0, t0 + 1000).size(), 1u);
+
+        auto sec = h.rollup(a, cc::Historian::SECOND, t0, t0 + 1000);
+        ASSERT_EQ(sec.size(), 1u);
+        EXPECT_EQ(sec[0].count, 20);
+        EXPECT_DOUBLE_EQ(sec[0].min, 0);
+        EXPECT_DOUBLE_EQ(sec[0].max, 19);
+
+        using row_t = std::tuple<std::string>;
+        auto names  = db.execute<row_t>("SELECT name FROM hist_tags ORDER BY id;");
+        ASSERT_EQ(names.size(), 2u);
+        EXPECT_EQ(std::get<0>(names[1]), "b");
+    } while (0);
+
+    std::filesystem::remove_all(dir);
+}
+
+#endif
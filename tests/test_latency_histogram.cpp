@@ -0,0 +1,50 @@
+#include <thread>
+#include <vector>
+#include <cc/latency_histogram.h>
+#include <gtest/gtest.h>
+
+TEST(latency_histogram, buckets) {
+    using B = cc::LatencyBuckets<5>;
+    for (std::uint64_t v : {0ull, 1ull, 31ull, 32ull, 33ull, 1000ull, 123456789ull, 1ull << 62}) {
+        auto i = B::index(v);
+        EXPECT_LE(B::lowest(i), v);
+        EXPECT_GE(B::highest(i), v);
+        // 相对误差不超过 2^-5
+        EXPECT_LE(B::highest(i) - B::lowest(i), v / 32);
+    }
+    EXPECT_LT(B::index(~0ull), B::kBuckets);
+}
+
+TEST(latency_histogram, percentile) {
+    cc::LatencyHistogram h;
+    EXPECT_EQ(h.percentile(99), 0);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&] {
+            for (int i = 1; i <= 10000; i++) {
+                h.record(i * 1000);
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    auto s = h.snapshot();
+    EXPECT_EQ(s.count, 40000);
+    EXPECT_EQ(s.min, 1000);
+    EXPECT_EQ(s.max, 10000000);
+    EXPECT_NEAR(s.mean(), 5000500.0, 1.0);
+    EXPECT_NEAR(s.percentile(50), 5000000.0, 5000000.0 / 32);
+    EXPECT_NEAR(s.percentile(99), 9900000.0, 9900000.0 / 32);
+    EXPECT_EQ(s.percentile(100), 10000000);
+
+    do {
+        auto _t = h.scope();
+    } while (0);
+    EXPECT_EQ(h.snapshot().count, 40001);
+
+    h.reset();
+    EXPECT_EQ(h.snapshot().count, 0);
+}
@@ -0,0 +1,85 @@
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cc/asio/pool.h>
+#include <cc/metrics.h>
+#include <cc/signal.h>
+#include <gtest/gtest.h>
+
+TEST(metrics, registry) {
+    auto& r = cc::metrics::Registry::instance();
+    auto& c = r.counter("test_requests_total", "requests", {{"code", "200"}});
+    EXPECT_EQ(&c, &r.counter("test_requests_total", "requests", {{"code", "200"}}));
+    EXPECT_NE(&c, &r.counter("test_requests_total", "requests", {{"code", "404"}}));
+    EXPECT_THROW(r.gauge("test_requests_total", "requests"), std::runtime_error);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 1000; i++) {
+                c.inc();
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    EXPECT_EQ(c.value(), 4000);
+
+    auto& g = r.gauge("test_connections", "connections");
+    g.inc();
+    g.inc();
+    g.dec();
+    EXPECT_EQ(g.value(), 1);
+    g.set(5);
+    EXPECT_EQ(g.value(), 5);
+
+    auto& h = r.histogram("test_latency_seconds", "latency", {{"route", "/a\"b"}});
+    h.observe(2000000);   // 2ms
+    h.observe(30000000);  // 30ms
+
+    auto text = r.scrape();
+    EXPECT_NE(text.find("# TYPE test_requests_total counter\n"), std::string::npos);
+    EXPECT_NE(text.find("test_requests_total{code=\"200\"} 4000\n"), std::string::npos);
+    EXPECT_NE(text.find("test_requests_total{code=\"404\"} 0\n"), std::string::npos);
+    EXPECT_NE(text.find("test_connections 5\n"), std::string::npos);
+    EXPECT_NE(text.find("test_latency_seconds_bucket{route=\"/a\\\"b\",le=\"0.001\"} 0\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("test_latency_seconds_bucket{route=\"/a\\\"b\",le=\"0.0025\"} 1\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("test_latency_seconds_bucket{route=\"/a\\\"b\",le=\"+Inf\"} 2\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("test_latency_seconds_count{route=\"/a\\\"b\"} 2\n"), std::string::npos);
+}
+
+TEST(metrics, signal_topics) {
+    cc::Signal<> sig;
+    for (std::size_t i = 0; i < cc::detail::kMaxTopicSeries + 10; i++) {
+        auto topic = "test_topic_" + std::to_string(i);
+        auto id    = sig.sub(topic, [](int) {});
+        sig.pub(topic, 1);
+        sig.unsub(id);
+    }
+
+    // 超出上限的话题合并到other, 序列数不再增长
+    auto text = cc::metrics::Registry::instance().scrape();
+    EXPECT_NE(text.find("cc_signal_pub_total{topic=\"test_topic_0\"} 1\n"), std::string::npos);
+    EXPECT_EQ(text.find("test_topic_" + std::to_string(cc::detail::kMaxTopicSeries)),
+              std::string::npos);
+    EXPECT_NE(text.find("cc_signal_pub_total{topic=\"other\"} 10\n"), std::string::npos);
+}
+
+// run()不会自行返回时每个分片都导出事件循环延迟
+TEST(metrics, asio_loop_lag) {
+    cc::AsioPool pool(cc::sharded, 2);
+    std::promise<void> started;
+    pool.enqueue([&] { started.set_value(); });
+    std::thread t([&] { pool.run(); });
+    started.get_future().wait();
+    auto text = cc::metrics::Registry::instance().scrape();
+    EXPECT_NE(text.find("cc_asio_loop_lag_seconds{shard=\"0\"}"), std::string::npos);
+    EXPECT_NE(text.find("cc_asio_loop_lag_seconds{shard=\"1\"}"), std::string::npos);
+    pool.shutdown();
+    t.join();
+}
@@ -0,0 +1,131 @@
+#include <atomic>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/core/noncopyable.hpp>
+#include <cc/singleton_provider.h>
+#include <gtest/gtest.h>
+
+namespace {
+
+template <int Tag>
+struct counted_t : boost::noncopyable {
+    static inline std::atomic<int> constructed{0};
+    std::atomic<long> n{0};
+
+    counted_t() { constructed++; }
+};
+
+struct config_t : boost::noncopyable {
+    std::string name;
+    int v;
+
+    config_t(std::string name, int v) : name(std::move(name)), v(v) {}
+};
+
+struct sharded_config_t : config_t {
+    using config_t::config_t;
+};
+
+}  // namespace
+
+// 构造一次, 之后instance()直接返回同一个实例
+TEST(singleton_provider, singleton) {
+    using provider_t = cc::SingletonProvider<counted_t<0>>;
+    std::vector<counted_t<0>*> ptrs(8);
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < ptrs.size(); i++) {
+        threads.emplace_back([&, i] { ptrs[i] = &provider_t::instance(); });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    EXPECT_EQ(std::set<counted_t<0>*>(ptrs.begin(), ptrs.end()).size(), 1u);
+    EXPECT_EQ(&provider_t::instance(), ptrs[0]);
+    EXPECT_EQ(counted_t<0>::constructed.load(), 1);
+
+    // 不能默认构造时需先init, 只有第一次init生效
+    using config_provider_t = cc::SingletonProvider<config_t>;
+    EXPECT_THROW(config_provider_t::instance(), std::runtime_error);
+    config_provider_t::init("a", 1);
+    config_provider_t::init("b", 2);
+    EXPECT_EQ(config_provider_t::instance().name, "a");
+    EXPECT_EQ(config_provider_t::instance().v, 1);
+}
+
+// 每个线程在第一次访问时构造自己的实例
+TEST(singleton_provider, sharded_lazy) {
+    using provider_t = cc::ShardedProvider<counted_t<1>, 8>;
+    EXPECT_EQ(provider_t::size(), 0u);
+    auto* mine = &provider_t::instance();
+    EXPECT_EQ(&provider_t::instance(), mine);
+    EXPECT_EQ(provider_t::size(), 1u);
+
+    counted_t<1>* other = nullptr;
+    std::thread([&] {
+        other = &provider_t::instance();
+        EXPECT_EQ(&provider_t::instance(), other);
+    }).join();
+    EXPECT_NE(other, mine);
+    EXPECT_EQ(provider_t::size(), 2u);
+    EXPECT_EQ(counted_t<1>::constructed.load(), 2);
+}
+
+// init的参数拷贝保存, 每个分片都用它构造
+TEST(singleton_provider, sharded_init) {
+    using provider_t = cc::ShardedProvider<sharded_config_t, 4>;
+    EXPECT_THROW(provider_t::instance(), std::runtime_error);
+    std::string name = "pump";
+    provider_t::init(name, 3);
+    name = "changed";
+    provider_t::init("ignored", 0);
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 3; i++) {
+        threads.emplace_back([] { provider_t::instance(); });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    // 先前抛出异常的主线程也能构造
+    provider_t::instance();
+    EXPECT_EQ(provider_t::size(), 4u);
+    provider_t::visit([](sharded_config_t& c) {
+        EXPECT_EQ(c.name, "pump");
+        EXPECT_EQ(c.v, 3);
+    });
+}
+
+// 线程数超过Shards后按到达顺序与前面的线程共享实例, merge聚合所有分片
+TEST(singleton_provider, sharded_shared) {
+    constexpr int kThreads = 6;
+    constexpr int kCount   = 1000;
+    using provider_t       = cc::ShardedProvider<counted_t<2>, 2>;
+
+    std::vector<counted_t<2>*> ptrs(kThreads);
+    for (int i = 0; i < kThreads; i++) {
+        std::thread([&, i] { ptrs[i] = &provider_t::instance(); }).join();
+    }
+    for (int i = 2; i < kThreads; i++) {
+        EXPECT_EQ(ptrs[i], ptrs[i % 2]);
+    }
+    EXPECT_NE(ptrs[0], ptrs[1]);
+    EXPECT_EQ(provider_t::size(), 2u);
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kThreads; i++) {
+        threads.emplace_back([] {
+            for (int k = 0; k < kCount; k++) {
+                provider_t::instance().n++;
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    auto total = provider_t::merge(0L, [](long acc, counted_t<2>& c) { return acc + c.n; });
+    EXPECT_EQ(total, kThreads * kCount);
+    EXPECT_EQ(counted_t<2>::constructed.load(), 2);
+}
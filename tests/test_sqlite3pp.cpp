@@ -0,0 +1,89 @@
+#ifdef CC_WITH_SQLITE3
+
+#    include <filesystem>
+#    include <stdexcept>
+#    include <string>
+#    include <thread>
+#    include <tuple>
+#    include <vector>
+#    include <cc/sqlite3pp.h>
+#    include <gtest/gtest.h>
+
+namespace {
+
+std::string temp_db(const char* name) {
+    auto path = std::filesystem::temp_directory_path() / name;
+    std::filesystem::remove(path);
+    std::filesystem::remove(path.string() + "-wal");
+    std::filesystem::remove(path.string() + "-shm");
+    return path.string();
+}
+
+}  // namespace
+
+TEST(sqlite3pp, prepare) {
+    cc::Sqlite3pp db(":memory:");
+    db.execute("CREATE TABLE t(id INTEGER PRIMARY KEY, name TEXT);");
+
+    auto insert = db.prepare("INSERT INTO t(id, name) VALUES(?, ?);");
+    for (int i = 0; i < 10; i++) {
+        insert.execute(i, "n" + std::to_string(i));
+    }
+
+    using row_t = std::tuple<int, std::string>;
+    auto select = db.prepare("SELECT id, name FROM t WHERE id >= ? ORDER BY id;");
+    auto rows   = select.execute<row_t>(7);
+    ASSERT_EQ(rows.size(), 3u);
+    EXPECT_EQ(std::get<1>(rows[0]), "n7");
+    // 语句执行后已重置, 可以重新绑定
+    EXPECT_EQ(select.execute<row_t>(9).size(), 1u);
+
+    auto moved = std::move(select);
+    EXPECT_EQ(moved.execute<row_t>(0).size(), 10u);
+    EXPECT_THROW(db.prepare("SELECT * FROM nonexist;"), std::runtime_error);
+}
+
+TEST(sqlite3pp, transaction) {
+    cc::Sqlite3pp db(":memory:");
+    db.execute("CREATE TABLE t(id INTEGER PRIMARY KEY);");
+
+    auto n = db.transaction([&] {
+        db.execute("INSERT INTO t VALUES(1);");
+        db.execute("INSERT INTO t VALUES(2);");
+        return 2;
+    });
+    EXPECT_EQ(n, 2);
+
+    // 抛出异常时回滚
+    EXPECT_THROW(db.transaction([&] {
+        db.execute("INSERT INTO t VALUES(3);");
+        db.execute("INSERT INTO t VALUES(1);");  // 主键冲突
+    }),
+                 std::runtime_error);
+
+    using row_t = std::tuple<int>;
+    auto rows   = db.execute<row_t>("SELECT count(*) FROM t;");
+    EXPECT_EQ(std::get<0>(rows.at(0)), 2);
+}
+
+TEST(sqlite3pp, connections) {
+    auto path = temp_db("cc_test_sqlite3pp.db");
+    do {
+        cc::Sqlite3pp db(path);
+        db.execute("CREATE TABLE t(id INTEGER PRIMARY KEY);");
+        db.execute("INSERT INTO t VALUES(1);");
+
+        // 每个线程各有一个连接, 都由db持有
+        std::thread([&] { db.execute("INSERT INTO t VALUES(2);"); }).join();
+
+        using row_t = std::tuple<int>;
+        db.close();
+        EXPECT_EQ(std::get<0>(db.execute<row_t>("SELECT count(*) FROM t;").at(0)), 2);
+    } while (0);
+
+    // 析构时所有线程的连接都已关闭, 文件可以删除
+    EXPECT_TRUE(std::filesystem::remove(path));
+    EXPECT_FALSE(std::filesystem::exists(path + "-wal"));
+}
+
+#endif
@@ -0,0 +1,320 @@
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <cc/st.h>
+#include <cc/st/compiler.h>
+#include <cc/st/event_timers.h>
+#include <cc/st/process_image.h>
+#include <cc/st/retainer.h>
+#include <gtest/gtest.h>
+
+TEST(process_image, snapshot) {
+    cc::st::ProcessImage<> pi;
+    auto level = pi.declare_input<double>("level");
+    auto start = pi.declare_input<bool>("start");
+    auto pump  = pi.declare_output<bool>("pump");
+    EXPECT_EQ(pi.input<double>("level").index, level.index);
+    EXPECT_THROW(pi.input<int>("level"), std::runtime_error);
+
+    pi.write_inputs([&](auto& w) {
+        w.set(level, 1.5);
+        w.set(start, true);
+    });
+
+    {
+        auto scan = pi.begin_scan();
+        // 扫描期间的输入更新对本周期不可见
+        pi.set_input(level, 2.5);
+        EXPECT_EQ(scan.get(level), 1.5);
+        EXPECT_TRUE(scan.get(start));
+        scan.set(pump, scan.get(start) && scan.get(level) > 1.0);
+        EXPECT_FALSE(pi.get_output(pump));
+    }
+    EXPECT_TRUE(pi.get_output(pump));
+
+    {
+        auto scan = pi.begin_scan();
+        EXPECT_EQ(scan.get(level), 2.5);
+        // 未写的tag保留上个周期的输入
+        EXPECT_TRUE(scan.get(start));
+        EXPECT_TRUE(scan.get(pump));
+    }
+    EXPECT_EQ(pi.scans(), 2);
+    EXPECT_THROW(pi.declare_input<int>("late"), std::runtime_error);
+
+    // 保持型输出
+    std::vector<char> retained;
+    pi.snapshot(retained);
+    cc::st::ProcessImage<> pi2;
+    auto speed = pi2.declare_output<double>("speed");
+    auto pump2 = pi2.declare_output<bool>("pump");
+    EXPECT_TRUE(pi2.restore(retained));
+    EXPECT_TRUE(pi2.get_output(pump2));
+    EXPECT_EQ(pi2.get_output(speed), 0.0);
+}
+
+// 保持数据按tag名和IEC类型名匹配, 枚举按底层类型
+TEST(process_image, retain_types) {
+    enum class mode_e : std::int32_t { OFF, AUTO };
+
+    cc::st::ProcessImage<> pi;
+    auto mode  = pi.declare_output<mode_e>("mode");
+    auto count = pi.declare_output<std::int32_t>("count");
+    auto level = pi.declare_output<double>("level");
+    {
+        auto scan = pi.begin_scan();
+        scan.set(mode, mode_e::AUTO);
+        scan.set(count, 7);
+        scan.set(level, 1.5);
+    }
+    std::vector<char> retained;
+    pi.snapshot(retained);
+
+    std::vector<std::string> keys;
+    EXPECT_TRUE(cc::st::detail::retain_parse(
+        retained.data(), retained.size(),
+        [&](std::string_view type, std::string_view name, const char*, std::uint16_t) {
+            keys.push_back(std::string(type) + ":" + std::string(name));
+        }));
+    EXPECT_EQ(keys, (std::vector<std::string>{"DINT:mode", "DINT:count", "LREAL:level"}));
+
+    cc::st::ProcessImage<> pi2;
+    auto mode2  = pi2.declare_output<std::int32_t>("mode");
+    auto count2 = pi2.declare_output<mode_e>("count");
+    auto level2 = pi2.declare_output<float>("level");
+    EXPECT_TRUE(pi2.restore(retained));
+    EXPECT_EQ(pi2.get_output(mode2), 1);
+    EXPECT_EQ(pi2.get_output(count2), static_cast<mode_e>(7));
+    // 类型不同的不恢复
+    EXPECT_EQ(pi2.get_output(level2), 0.0f);
+}
+
+TEST(st_timer, event_driven) {
+    // 扫描线程自己驱动时间轮
+    cc::TimerWheel<> wheel;
+    cc::st::EV_TON<cc::TimerWheel<>> ton(wheel);
+    cc::st::EV_TOF<cc::TimerWheel<>> tof(wheel);
+
+    EXPECT_EQ(ton(1, 2), 0);
+    EXPECT_EQ(tof(1, 2), 1);
+    EXPECT_EQ(tof(0, 2), 1);
+    EXPECT_EQ(wheel.size(), 2u);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    EXPECT_EQ(ton(1, 2), 0);  // 未poll前不会置位
+    EXPECT_EQ(wheel.poll(), 2u);
+    EXPECT_EQ(ton(1, 2), 1);
+    EXPECT_EQ(ton.ET(), 2);
+    EXPECT_EQ(tof(0, 2), 0);
+
+    // 计时中复位会取消定时器
+    EXPECT_EQ(ton(0, 2), 0);
+    EXPECT_EQ(ton(1, 100), 0);
+    EXPECT_EQ(ton(0, 100), 0);
+    EXPECT_EQ(wheel.size(), 0u);
+}
+
+TEST(st_retain, snapshot) {
+    std::vector<char> data;
+    do {
+        cc::StFactory<> f;
+        f.ctu("c1")(1, 0, 10);
+        f.sr("latch")(1, 0);
+        f.snapshot(data);
+    } while (0);
+    // 类型名是固定的字符串, 不同编译器生成的快照可以互相恢复
+    EXPECT_NE(std::string(data.begin(), data.end()).find("CTU"), std::string::npos);
+
+    cc::StFactory<> f;
+    ASSERT_TRUE(f.restore(data));
+    EXPECT_EQ(std::get<1>(f.ctu("c1")(0, 0, 10)), 1);
+    EXPECT_EQ(f.sr("latch")(0, 0), 1);
+    EXPECT_EQ(f.rs("latch")(0, 0), 0);
+}
+
+#ifdef __linux__
+TEST(st_retain, restore) {
+    auto path = std::filesystem::temp_directory_path() / "cc_test_st_retain.bin";
+    std::filesystem::remove(path);
+
+    do {
+        cc::StFactory<> f;
+        cc::st::Retainer<cc::st::MmapRetainStore> retainer(2, path.string());
+        for (int i = 0; i < 3; i++) {
+            f.ctu("c1")(1, 0, 10);
+            f.ctu("c1")(0, 0, 10);
+        }
+        f.sr("latch")(1, 0);
+        f.ton("t1")(1, 100);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        f.ton("t1")(1, 100);
+
+        EXPECT_FALSE(retainer.on_scan(f));
+        EXPECT_TRUE(retainer.on_scan(f));
+    } while (0);
+
+    cc::StFactory<> f;
+    f.ctu("c1");  // 已创建的块立即恢复, 其余的在创建时恢复
+    cc::st::Retainer<cc::st::MmapRetainStore> retainer(2, path.string());
+    ASSERT_TRUE(retainer.restore(f));
+
+    EXPECT_EQ(std::get<1>(f.ctu("c1")(0, 0, 10)), 3);
+    EXPECT_EQ(f.sr("latch")(0, 0), 1);
+    EXPECT_EQ(f.rs("latch")(0, 0), 0);  // 类型不同, 不会误恢复
+    EXPECT_GE(f.ton("t1").ET, 20);
+    auto [Q, ET] = f.ton("t1")(1, 100);
+    EXPECT_FALSE(Q);
+    EXPECT_GE(ET, 20);
+
+    std::filesystem::remove(path);
+}
+#endif
+
+TEST(st_vm, statements) {
+    auto prog = cc::st::compile(R"(
+        PROGRAM demo
+        VAR
+            i, n : INT;
+            sum : INT := 0;
+            avg : REAL;
+            big, odd : BOOL;
+        END_VAR
+        (* 1 + 2 + ... + n *)
+        sum := 0;
+        FOR i := 1 TO n DO
+            sum := sum + i;
+        END_FOR;
+        avg := sum / MAX(n, 1.0);
+        IF sum > 100 THEN big := TRUE; ELSIF sum > 10 THEN big := FALSE; ELSE big := FALSE; END_IF;
+        odd := n MOD 2 = 1;
+        WHILE TRUE DO
+            n := n - 1;
+            IF n < 5 THEN EXIT; END_IF;
+        END_WHILE;
+        END_PROGRAM
+    )");
+
+    cc::st::Vm vm(prog);
+    vm.set("n", 20);
+    vm.scan();
+    EXPECT_EQ(vm.get<int>("sum"), 210);
+    EXPECT_DOUBLE_EQ(vm.get<double>("avg"), 10.5);
+    EXPECT_TRUE(vm.get<bool>("big"));
+    EXPECT_FALSE(vm.get<bool>("odd"));
+    EXPECT_EQ(vm.get<int>("n"), 4);
+}
+
+TEST(st_vm, function_blocks) {
+    auto prog = cc::st::compile(R"(
+        VAR start : BOOL; edge : R_TRIG; t : TON; count : INT; done : BOOL; END_VAR
+        edge(CLK := start);
+        IF edge.Q THEN count := count + 1; END_IF;
+        t(IN := start, PT := T#1ms);
+        done := t.Q;
+    )");
+
+    cc::st::Vm vm(prog);
+    vm.set("start", true);
+    vm.scan();
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    vm.scan();
+    EXPECT_EQ(vm.get<int>("count"), 1);
+    EXPECT_TRUE(vm.get<bool>("done"));
+
+    // 热替换: 同名变量与功能块状态保留
+    vm.load(cc::st::compile(R"(
+        VAR start : BOOL; edge : R_TRIG; count : INT; END_VAR
+        edge(CLK := start);
+        IF edge.Q THEN count := count + 10; END_IF;
+    )"));
+    vm.scan();
+    EXPECT_EQ(vm.get<int>("count"), 1);
+    vm.set("start", false);
+    vm.scan();
+    vm.set("start", true);
+    vm.scan();
+    EXPECT_EQ(vm.get<int>("count"), 11);
+}
+
+TEST(st_vm, counter_latch) {
+    auto prog = cc::st::compile(R"(
+        VAR pulse, reset, set_on, stop : BOOL; up : CTU; down : CTD; run : SR; lock : RS;
+            done, empty : BOOL; n, left : INT; END_VAR
+        up(CU := pulse, R := reset, PV := 3);
+        down(CD := pulse, LD := reset, PV := 2);
+        done := up.Q; n := up.CV;
+        empty := down.Q; left := down.CV;
+        run(S1 := set_on, R := stop);
+        lock(S := set_on, R1 := stop);
+    )");
+
+    cc::st::Vm vm(prog);
+    vm.set("reset", true);
+    vm.scan();
+    EXPECT_EQ(vm.get<int>("left"), 2);
+    vm.set("reset", false);
+    // 只在上升沿计数
+    for (int i = 0; i < 3; i++) {
+        vm.set("pulse", true);
+        vm.scan();
+        vm.scan();
+        vm.set("pulse", false);
+        vm.scan();
+    }
+    EXPECT_EQ(vm.get<int>("n"), 3);
+    EXPECT_TRUE(vm.get<bool>("done"));
+    EXPECT_EQ(vm.get<int>("left"), -1);
+    EXPECT_TRUE(vm.get<bool>("empty"));
+    EXPECT_EQ(vm.get<int>("up.CV"), 3);
+
+    vm.set("reset", true);
+    vm.scan();
+    EXPECT_EQ(vm.get<int>("n"), 0);
+    EXPECT_FALSE(vm.get<bool>("done"));
+    EXPECT_FALSE(vm.get<bool>("empty"));
+
+    // 置位后保持; 同时置位复位时SR置位优先, RS复位优先
+    vm.set("set_on", true);
+    vm.scan();
+    vm.set("set_on", false);
+    vm.scan();
+    EXPECT_TRUE(vm.get<bool>("run.Q1"));
+    EXPECT_TRUE(vm.get<bool>("lock.Q1"));
+    vm.set("set_on", true);
+    vm.set("stop", true);
+    vm.scan();
+    EXPECT_TRUE(vm.get<bool>("run.Q1"));
+    EXPECT_FALSE(vm.get<bool>("lock.Q1"));
+    vm.set("set_on", false);
+    vm.scan();
+    EXPECT_FALSE(vm.get<bool>("run.Q1"));
+    EXPECT_FALSE(vm.get<bool>("lock.Q1"));
+}
+
+TEST(st_vm, errors) {
+    EXPECT_THROW(cc::st::compile("VAR a : INT; END_VAR a := 1.5;"), std::runtime_error);
+    EXPECT_THROW(cc::st::compile("VAR a : INT; END_VAR b := 1;"), std::runtime_error);
+    EXPECT_THROW(cc::st::compile("VAR t : TON; END_VAR t.Q := TRUE;"), std::runtime_error);
+    EXPECT_THROW(cc::st::compile("VAR a : INT; END_VAR IF a THEN a := 1; END_IF"),
+                 std::runtime_error);
+
+    auto loop = cc::st::compile("VAR a : INT; END_VAR WHILE TRUE DO a := a + 1; END_WHILE");
+    cc::st::Vm vm(loop, 100);
+    EXPECT_THROW(vm.scan(), std::runtime_error);
+}
+
+TEST(st_vm, not_bool) {
+    auto prog = cc::st::compile("VAR a, b : BOOL; END_VAR b := NOT a;");
+    cc::st::Vm vm(prog);
+    vm.set("a", 2);  // 外部写入的非0值也是TRUE
+    vm.scan();
+    EXPECT_FALSE(vm.get<bool>("b"));
+    EXPECT_EQ(vm.get<int>("b"), 0);
+    vm.set("a", 0);
+    vm.scan();
+    EXPECT_EQ(vm.get<int>("b"), 1);
+}
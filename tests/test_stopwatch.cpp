@@ -0,0 +1,97 @@
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <thread>
+#include <cc/stopwatch.h>
+#include <gtest/gtest.h>
+
+namespace {
+
+/// 手动设定当前时刻的时钟, 1 tick = 1ps
+struct FakeClock {
+    using rep = std::int64_t;
+
+    static inline rep current = 0;
+
+    static rep now() noexcept { return current; }
+    static double to_seconds(rep t) noexcept { return t * 1e-12; }
+    static std::int64_t to_ns(rep t) noexcept { return t / 1000; }
+    static rep from_seconds(double s) noexcept { return static_cast<rep>(s * 1e12); }
+};
+
+}  // namespace
+
+// 只在CPU声明invariant TSC时使用TSC, 否则退化为SteadyClock
+TEST(stopwatch, tsc_detection) {
+    bool invariant = false;
+#ifdef CC_HAS_TSC
+    unsigned a, b, c, d;
+    if (__get_cpuid(0x80000000, &a, &b, &c, &d) && a >= 0x80000007) {
+        __get_cpuid(0x80000007, &a, &b, &c, &d);
+        invariant = d & (1u << 8);
+    }
+#endif
+    EXPECT_EQ(cc::TscClock::is_tsc(), invariant);
+    EXPECT_GT(cc::TscClock::frequency(), 0);
+
+    if (!cc::TscClock::is_tsc()) {
+        EXPECT_DOUBLE_EQ(cc::TscClock::frequency(), 1e9);
+        EXPECT_EQ(cc::TscClock::to_ns(12345), 12345);
+        auto d = cc::TscClock::now() - cc::SteadyClock::now();
+        EXPECT_LT(std::abs(d), 1000000);
+    }
+}
+
+// 标定后的TSC与steady_clock走得一样快
+TEST(stopwatch, tsc_calibration) {
+    cc::TscClock::calibrate();
+    auto s0 = cc::SteadyClock::now();
+    auto t0 = cc::TscClock::now();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    auto t1 = cc::TscClock::now();
+    auto s1 = cc::SteadyClock::now();
+
+    double steady = static_cast<double>(s1 - s0);
+    EXPECT_NEAR(cc::TscClock::to_ns(t1 - t0) / steady, 1.0, 0.02);
+    EXPECT_NEAR(cc::TscClock::to_seconds(t1 - t0), steady * 1e-9, steady * 1e-9 * 0.02);
+    EXPECT_NEAR(static_cast<double>(cc::TscClock::from_seconds(1.0)),
+                cc::TscClock::frequency(), cc::TscClock::frequency() * 1e-9);
+}
+
+TEST(stopwatch, elapsed) {
+    cc::StopWatch sw;
+    cc::TscStopWatch tsw;
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    auto tns = tsw.elapsed_ns();
+    auto ns  = sw.elapsed_ns();
+    EXPECT_GE(ns, 50000000);
+    EXPECT_NEAR(static_cast<double>(tns), static_cast<double>(ns), ns * 0.02 + 1000000);
+    EXPECT_NEAR(static_cast<double>(tsw.elapsed_ms()), static_cast<double>(sw.elapsed_ms()), 2);
+    EXPECT_NEAR(tsw.elapsed(), sw.elapsed(), 0.002);
+
+    // 恢复保持型计时
+    tsw.reset(1.5);
+    EXPECT_NEAR(tsw.elapsed(), 1.5, 0.01);
+    EXPECT_GE(tsw.elapsed_ms(), 1500);
+}
+
+// min()/max()在任意时刻、任意时钟频率下都不溢出
+TEST(stopwatch, min_max) {
+    using watch_t          = cc::BasicStopWatch<FakeClock>;
+    constexpr auto kLimit  = std::numeric_limits<std::int64_t>::max();
+    constexpr auto kOffset = kLimit / 4;
+    for (auto t : {std::int64_t(0), kLimit / 2, -kLimit / 2}) {
+        FakeClock::current = t;
+        EXPECT_EQ(watch_t::min().elapsed_ticks(), kOffset);
+        EXPECT_EQ(watch_t::max().elapsed_ticks(), -kOffset);
+        // 1ps一个tick时仍有几十天
+        EXPECT_GT(watch_t::min().elapsed(), 86400 * 20);
+        EXPECT_LT(watch_t::max().elapsed(), -86400 * 20);
+    }
+
+    EXPECT_GT(cc::StopWatch::min().elapsed(), 86400.0 * 365 * 50);
+    EXPECT_LT(cc::StopWatch::max().elapsed_ms(), 0);
+    EXPECT_GT(cc::TscStopWatch::min().elapsed_ms(), 86400000);
+    EXPECT_LT(cc::TscStopWatch::max().elapsed(), 0);
+}
@@ -0,0 +1,78 @@
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cc/trace.h>
+#include <gtest/gtest.h>
+
+TEST(trace, spans) {
+    cc::trace::clear();
+    do {
+        CC_TRACE_SCOPE("disabled");
+    } while (0);
+
+    cc::trace::enable();
+    std::uint64_t parent = 0;
+    do {
+        cc::trace::AsyncSpan root("root");
+        parent = root.id();
+        std::thread t([&] {
+            CC_TRACE_CO_SCOPE("child", parent);
+            CC_TRACE_SCOPE("work");
+        });
+        t.join();
+    } while (0);
+    cc::trace::enable(false);
+
+    std::vector<std::string> seq;
+    std::uint32_t tid = 0;
+    cc::trace::collect([&](const auto& thread, const cc::trace::event_t& ev) {
+        EXPECT_NE(std::string(ev.name), "disabled");
+        if (ev.ph != 'X') {
+            EXPECT_EQ(ev.id, parent);
+        } else {
+            EXPECT_GE(ev.dur, 0);
+            EXPECT_NE(thread.tid, tid);
+        }
+        if (std::string(ev.name) == "root" && ev.ph == 'b') {
+            tid = thread.tid;
+        }
+        seq.push_back(std::string(1, ev.ph) + ev.name);
+    });
+    std::sort(seq.begin(), seq.end());
+    EXPECT_EQ(seq, (std::vector<std::string>{"Xwork", "bchild", "broot", "echild", "eroot"}));
+}
+
+TEST(trace, retire) {
+    cc::trace::enable();
+    auto& registry = cc::trace::detail::Registry::instance();
+    auto before    = registry.buffers().size();
+    for (int i = 0; i < 40; i++) {
+        std::thread([] { CC_TRACE_SCOPE("short-lived"); }).join();
+    }
+
+    // 只保留最近退出的线程的缓冲
+    auto count = 0;
+    cc::trace::collect([&](const auto&, const cc::trace::event_t& ev) {
+        count += std::string(ev.name) == "short-lived";
+    });
+    EXPECT_EQ(count, static_cast<int>(cc::trace::detail::Registry::kMaxRetired));
+    EXPECT_LE(registry.buffers().size(), before + cc::trace::detail::Registry::kMaxRetired);
+
+    // 写入与导出并发
+    std::atomic<bool> stop{false};
+    std::thread writer([&] {
+        while (!stop.load(std::memory_order_relaxed)) {
+            CC_TRACE_SCOPE("busy");
+        }
+    });
+    for (int i = 0; i < 100; i++) {
+        cc::trace::collect([&](const auto&, const cc::trace::event_t& ev) {
+            EXPECT_NE(ev.name, nullptr);
+        });
+    }
+    stop = true;
+    writer.join();
+    cc::trace::enable(false);
+}